@@ -3,6 +3,7 @@
 #include <boost/pending/disjoint_sets.hpp>
 #include "nifty/xtensor/xtensor.hxx"
 #include "nifty/graph/undirected_list_graph.hxx"
+#include "nifty/ufd/ufd.hxx"
 
 
 namespace nifty {
@@ -10,6 +11,14 @@ namespace carving {
 
 
     // we provide implementations with kruskal and prim
+    //
+    // for interactive sessions without bias, the incremental mode (setSeed / updateSeeds)
+    // keeps the kruskal merge tree of the minimum spanning forest built from the sorted edges:
+    // seeded kruskal only ever accepts edges of this forest, and a merge is refused iff
+    // both merged clusters contain seeds. Hence a seed edit only changes the seed counts
+    // on the path from its leaf to the root and the labels of the unseeded clusters
+    // hanging off this path (contiguous ranges in the leaf order of the tree).
+    // The labels are identical to running kruskal from scratch.
     template<class GRAPH>
     class CarvingSegmenter {
         public:
@@ -62,6 +71,91 @@ namespace carving {
                 return edgesSorted_;
             }
 
+            // set all seeds of the incremental mode, only the changed seeds are updated
+            // (or everything is relabeled if too many seeds changed);
+            // returns the number of changed seeds
+            template<class NODES>
+            inline std::size_t updateSeeds(const NODES & seeds) {
+                NIFTY_CHECK_OP(seeds.size(), ==, nNodes_, "Number of nodes does not agree");
+                initIncremental();
+                std::vector<std::size_t> changed;
+                for(std::size_t node = 0; node < nNodes_; ++node) {
+                    if(uint64_t(seeds[node]) != currentSeeds_[node]) {
+                        changed.push_back(node);
+                    }
+                }
+                // each edit walks to the root of the merge tree,
+                // for many edits a full relabeling is cheaper
+                if(changed.size() * 64 > nNodes_) {
+                    for(std::size_t node = 0; node < nNodes_; ++node) {
+                        currentSeeds_[node] = seeds[node];
+                    }
+                    relabelAll();
+                }
+                else {
+                    for(const auto node : changed) {
+                        setSeed(node, seeds[node]);
+                    }
+                }
+                return changed.size();
+            }
+
+            // set (or remove with seed = 0) a single seed in the incremental mode
+            inline void setSeed(const std::size_t node, const uint64_t seed) {
+                initIncremental();
+                const uint64_t oldSeed = currentSeeds_[node];
+                if(oldSeed == seed) {
+                    return;
+                }
+                currentSeeds_[node] = seed;
+
+                // update the seed counts from the leaf to the root
+                if((oldSeed == 0) != (seed == 0)) {
+                    for(int64_t c = node; c != -1; c = treeParents_[c]) {
+                        if(seed == 0) {
+                            --seedCounts_[c];
+                        } else {
+                            ++seedCounts_[c];
+                        }
+                    }
+                }
+
+                if(seed != 0) {
+                    currentLabels_[node] = seed;
+                }
+
+                // relabel bottom up along the path: when a path cluster is seeded,
+                // all labels below are final and unseeded siblings take the label of the
+                // endpoint of their merge edge; an unseeded path cluster takes the label
+                // of the endpoint in its seeded sibling
+                int64_t c = node;
+                for(int64_t m = treeParents_[c]; m != -1; c = m, m = treeParents_[m]) {
+                    const std::size_t k = m - nNodes_;
+                    const std::size_t side = treeChildren_[2 * k] == uint64_t(c) ? 0 : 1;
+                    const uint64_t sibling = treeChildren_[2 * k + 1 - side];
+                    if(seedCounts_[c] > 0) {
+                        if(seedCounts_[sibling] == 0) {
+                            const uint64_t label = currentLabels_[treeEndpoints_[2 * k + side]];
+                            if(currentLabels_[leafOrder_[treeBegin_[sibling]]] != label) {
+                                fillCluster(sibling, label);
+                            }
+                        }
+                    }
+                    else if(seedCounts_[sibling] > 0) {
+                        fillCluster(c, currentLabels_[treeEndpoints_[2 * k + 1 - side]]);
+                    }
+                }
+                // the tree has no seeds at all
+                if(seedCounts_[c] == 0) {
+                    fillCluster(c, 0);
+                }
+            }
+
+            // labels of the incremental mode
+            inline const std::vector<uint64_t> & labels() const {
+                return currentLabels_;
+            }
+
         private:
             // argsort the edges
             inline void sortEdgeIndices() {
@@ -227,11 +321,134 @@ namespace carving {
                 }
             }
 
+            // build the kruskal merge tree of the minimum spanning forest:
+            // leaves are the nodes, internal node n + k is the k-th accepted edge
+            inline void initIncremental() {
+                if(!treeParents_.empty()) {
+                    return;
+                }
+                NIFTY_CHECK_OP(edgesSorted_.size(), ==, graph_.numberOfEdges(),
+                               "The incremental mode needs sorted edges");
+
+                nifty::ufd::Ufd<uint64_t> ufd(nNodes_);
+                std::vector<uint64_t> clusters(nNodes_);
+                std::iota(clusters.begin(), clusters.end(), 0);
+                treeParents_.assign(nNodes_, -1);
+                treeParents_.reserve(2 * nNodes_);
+                for(const std::size_t edgeId : edgesSorted_) {
+                    const uint64_t u = graph_.u(edgeId);
+                    const uint64_t v = graph_.v(edgeId);
+                    const uint64_t ru = ufd.find(u);
+                    const uint64_t rv = ufd.find(v);
+                    if(ru == rv) {
+                        continue;
+                    }
+                    const uint64_t internal = treeParents_.size();
+                    treeParents_[clusters[ru]] = internal;
+                    treeParents_[clusters[rv]] = internal;
+                    treeParents_.push_back(-1);
+                    treeChildren_.push_back(clusters[ru]);
+                    treeChildren_.push_back(clusters[rv]);
+                    treeEndpoints_.push_back(u);
+                    treeEndpoints_.push_back(v);
+                    ufd.merge(ru, rv);
+                    clusters[ufd.find(ru)] = internal;
+                }
+
+                // leaf order such that every cluster is a contiguous range
+                const std::size_t nTreeNodes = treeParents_.size();
+                treeBegin_.resize(nTreeNodes);
+                treeEnd_.resize(nTreeNodes);
+                leafOrder_.clear();
+                leafOrder_.reserve(nNodes_);
+                std::vector<std::pair<uint64_t, bool>> stack;
+                for(std::size_t root = 0; root < nTreeNodes; ++root) {
+                    if(treeParents_[root] != -1) {
+                        continue;
+                    }
+                    stack.emplace_back(root, false);
+                    while(!stack.empty()) {
+                        const auto top = stack.back();
+                        stack.pop_back();
+                        const uint64_t c = top.first;
+                        if(top.second) {
+                            treeEnd_[c] = leafOrder_.size();
+                        }
+                        else if(c < nNodes_) {
+                            treeBegin_[c] = leafOrder_.size();
+                            leafOrder_.push_back(c);
+                            treeEnd_[c] = leafOrder_.size();
+                        }
+                        else {
+                            treeBegin_[c] = leafOrder_.size();
+                            const std::size_t k = c - nNodes_;
+                            stack.emplace_back(c, true);
+                            stack.emplace_back(treeChildren_[2 * k + 1], false);
+                            stack.emplace_back(treeChildren_[2 * k], false);
+                        }
+                    }
+                }
+
+                seedCounts_.assign(nTreeNodes, 0);
+                currentSeeds_.assign(nNodes_, 0);
+                currentLabels_.assign(nNodes_, 0);
+            }
+
+            inline void fillCluster(const uint64_t cluster, const uint64_t label) {
+                for(std::size_t i = treeBegin_[cluster]; i < treeEnd_[cluster]; ++i) {
+                    currentLabels_[leafOrder_[i]] = label;
+                }
+            }
+
+            // seeded kruskal on the edges of the merge tree
+            inline void relabelAll() {
+                std::fill(seedCounts_.begin(), seedCounts_.end(), 0);
+                for(std::size_t node = 0; node < nNodes_; ++node) {
+                    seedCounts_[node] = currentSeeds_[node] != 0;
+                }
+                // children are created before their parents
+                for(std::size_t c = 0; c < treeParents_.size(); ++c) {
+                    if(treeParents_[c] != -1) {
+                        seedCounts_[treeParents_[c]] += seedCounts_[c];
+                    }
+                }
+
+                nifty::ufd::Ufd<uint64_t> ufd(nNodes_);
+                currentLabels_ = currentSeeds_;
+                const std::size_t nInternal = treeChildren_.size() / 2;
+                for(std::size_t k = 0; k < nInternal; ++k) {
+                    if(seedCounts_[treeChildren_[2 * k]] > 0 && seedCounts_[treeChildren_[2 * k + 1]] > 0) {
+                        continue;
+                    }
+                    const uint64_t ru = ufd.find(treeEndpoints_[2 * k]);
+                    const uint64_t rv = ufd.find(treeEndpoints_[2 * k + 1]);
+                    const uint64_t label = std::max(currentLabels_[ru], currentLabels_[rv]);
+                    ufd.merge(ru, rv);
+                    currentLabels_[ufd.find(ru)] = label;
+                }
+                for(std::size_t node = 0; node < nNodes_; ++node) {
+                    if(currentSeeds_[node] == 0) {
+                        currentLabels_[node] = currentLabels_[ufd.find(node)];
+                    }
+                }
+            }
+
         private:
             const GRAPH & graph_;
             std::size_t nNodes_;
             std::vector<float> edgeWeights_;
             std::vector<std::size_t> edgesSorted_;
+
+            // incremental mode
+            std::vector<int64_t> treeParents_;
+            std::vector<uint64_t> treeChildren_;
+            std::vector<uint64_t> treeEndpoints_;
+            std::vector<uint64_t> treeBegin_;
+            std::vector<uint64_t> treeEnd_;
+            std::vector<uint64_t> leafOrder_;
+            std::vector<uint64_t> seedCounts_;
+            std::vector<uint64_t> currentSeeds_;
+            std::vector<uint64_t> currentLabels_;
     };
 
 
@@ -0,0 +1,631 @@
+#pragma once
+
+#include <atomic>
+#include <numeric>
+
+#include "nifty/ufd/concurrent_ufd.hxx"
+#include "nifty/graph/undirected_list_graph.hxx"
+#include "nifty/graph/agglo/agglomerative_clustering.hxx"
+#include "nifty/graph/agglo/cluster_policies/mala_cluster_policy.hxx"
+#include "nifty/distributed/graph_extraction.hxx"
+
+namespace fs = boost::filesystem;
+
+namespace nifty {
+namespace distributed {
+
+
+    ///
+    // Out-of-core agglomeration on the serialized block graphs
+    // (as produced by `computeMergeableRegionGraph`, `mergeSubgraphs` and `mapEdgeIds`)
+    // and the merged edge features (as produced by `mergeFeatureBlocks`).
+    //
+    // 1.) `agglomerateInBlocks`: agglomerate the inner edges of each block,
+    //      only one block graph per thread is in memory.
+    // 2.) `agglomerateAlongBlockBoundaries`: stream the edges of the merged graph,
+    //      contract them with the result of 1.) and agglomerate the (much smaller) contracted graph;
+    //      the contracted graph is sharded by segment id and spilled to disk,
+    //      so at most a given number of edges is in memory.
+    //
+    // The union find of both steps is persisted as node labeling (uint64 dataset of size nodeMaxId + 1),
+    // where each node is mapped to the smallest node of its segment; it can be mapped
+    // to the pixels with `nodeLabelingToPixels`.
+    // Both steps use the mala policy (median of the edge weights, which need to be in [0, 1])
+    // and stop when the lowest weight reaches the threshold.
+    //
+    // The edge features are read from a float64 dataset, either 1d (one weight per edge)
+    // or 2d, with the mean in the first and the size (pixel count) in the last column.
+    ///
+
+
+    typedef double WeightType;
+    typedef nifty::graph::UndirectedGraph<> AgglomerationGraph;
+    typedef nifty::ufd::ConcurrentUfd<NodeType> AgglomerationUfd;
+
+
+    // weights and sizes of the edges [edgeBegin, edgeEnd)
+    template<class DS>
+    inline void loadEdgeWeightsAndSizes(DS & featureDs,
+                                        const std::size_t edgeBegin,
+                                        const std::size_t edgeEnd,
+                                        std::vector<WeightType> & weights,
+                                        std::vector<WeightType> & sizes) {
+        const std::size_t nEdges = edgeEnd - edgeBegin;
+        weights.resize(nEdges);
+        sizes.resize(nEdges);
+        if(featureDs->shape().size() == 1) {
+            const std::vector<std::size_t> offset({edgeBegin});
+            xt::xtensor<WeightType, 1> tmp({nEdges});
+            z5::multiarray::readSubarray<WeightType>(featureDs, tmp, offset.begin());
+            std::copy(tmp.begin(), tmp.end(), weights.begin());
+            std::fill(sizes.begin(), sizes.end(), 1.);
+        } else {
+            const std::size_t nFeatures = featureDs->shape(1);
+            const std::vector<std::size_t> offset({edgeBegin, 0});
+            xt::xtensor<WeightType, 2> tmp({nEdges, nFeatures});
+            z5::multiarray::readSubarray<WeightType>(featureDs, tmp, offset.begin());
+            for(std::size_t edge = 0; edge < nEdges; ++edge) {
+                weights[edge] = tmp(edge, 0);
+                sizes[edge] = tmp(edge, nFeatures - 1);
+            }
+        }
+    }
+
+
+    // weights and sizes of the (scattered) edges 'edgeIds';
+    // only the chunks of the feature dataset that contain one of the edges are loaded
+    template<class DS>
+    inline void loadEdgeWeightsAndSizes(DS & featureDs,
+                                        const std::vector<EdgeIndexType> & edgeIds,
+                                        std::vector<WeightType> & weights,
+                                        std::vector<WeightType> & sizes) {
+        const std::size_t nEdges = edgeIds.size();
+        weights.resize(nEdges);
+        sizes.resize(nEdges);
+
+        std::vector<std::size_t> order(nEdges);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](const std::size_t a, const std::size_t b){
+            return edgeIds[a] < edgeIds[b];
+        });
+
+        const std::size_t chunkSize = featureDs->maxChunkShape()[0];
+        const std::size_t nEdgesTotal = featureDs->shape(0);
+        std::vector<WeightType> chunkWeights, chunkSizes;
+        std::size_t ii = 0;
+        while(ii < nEdges) {
+            const std::size_t chunkBegin = (edgeIds[order[ii]] / chunkSize) * chunkSize;
+            const std::size_t chunkEnd = std::min(chunkBegin + chunkSize, nEdgesTotal);
+            loadEdgeWeightsAndSizes(featureDs, chunkBegin, chunkEnd, chunkWeights, chunkSizes);
+            for(; ii < nEdges && static_cast<std::size_t>(edgeIds[order[ii]]) < chunkEnd; ++ii) {
+                const std::size_t edge = order[ii];
+                weights[edge] = chunkWeights[edgeIds[edge] - chunkBegin];
+                sizes[edge] = chunkSizes[edgeIds[edge] - chunkBegin];
+            }
+        }
+    }
+
+
+    // agglomerate the graph given by the dense uv-ids with the mala policy,
+    // the result maps each node to the representative node of its segment
+    inline void agglomerateGraph(const std::size_t numberOfNodes,
+                                 const std::vector<EdgeType> & uvIds,
+                                 const std::vector<WeightType> & weights,
+                                 const std::vector<WeightType> & sizes,
+                                 const double threshold,
+                                 std::vector<NodeType> & representatives) {
+        typedef nifty::graph::agglo::MalaClusterPolicy<AgglomerationGraph, false> PolicyType;
+        typedef nifty::graph::agglo::AgglomerativeClustering<PolicyType> AgglomerationType;
+
+        AgglomerationGraph graph(numberOfNodes, uvIds.size());
+        for(const auto & uv : uvIds) {
+            graph.insertEdge(uv.first, uv.second);
+        }
+        const std::vector<WeightType> nodeSizes(numberOfNodes, 1.);
+
+        typename PolicyType::SettingsType settings;
+        settings.threshold = threshold;
+        PolicyType policy(graph, weights, sizes, nodeSizes, settings);
+        AgglomerationType agglomeration(policy);
+        agglomeration.run();
+
+        representatives.resize(numberOfNodes);
+        agglomeration.result(representatives);
+    }
+
+
+    // write the segment of each node (the smallest node in its set) to the node labeling
+    template<class DS>
+    inline void serializeNodeLabeling(const AgglomerationUfd & ufd,
+                                      DS & labelingDs,
+                                      nifty::parallel::ThreadPool & threadpool) {
+        const std::size_t nNodes = labelingDs->shape(0);
+        const std::size_t chunkSize = labelingDs->maxChunkShape()[0];
+        const std::size_t nChunks = (nNodes + chunkSize - 1) / chunkSize;
+        nifty::parallel::parallel_foreach(threadpool, nChunks, [&](const int tid,
+                                                                   const std::size_t chunkId){
+            const std::size_t nodeBegin = chunkId * chunkSize;
+            const std::size_t nodeEnd = std::min(nodeBegin + chunkSize, nNodes);
+            Tensor1 labels({nodeEnd - nodeBegin});
+            for(std::size_t node = nodeBegin; node < nodeEnd; ++node) {
+                labels(node - nodeBegin) = ufd.find(node);
+            }
+            const std::vector<std::size_t> offset({nodeBegin});
+            z5::multiarray::writeSubarray<NodeType>(labelingDs, labels, offset.begin());
+        });
+    }
+
+
+    inline void agglomerateInBlocks(const std::string & graphBlockPrefix,
+                                    const std::string & edgeFeaturesPath,
+                                    const std::vector<std::size_t> & blockIds,
+                                    const std::string & nodeLabelingOut,
+                                    const double threshold,
+                                    const int numberOfThreads=1) {
+        nifty::parallel::ThreadPool threadpool(numberOfThreads);
+
+        auto featureDs = z5::openDataset(edgeFeaturesPath);
+        auto labelingDs = z5::openDataset(nodeLabelingOut);
+        AgglomerationUfd ufd(labelingDs->shape(0));
+
+        const std::size_t nBlocks = blockIds.size();
+        nifty::parallel::parallel_foreach(threadpool, nBlocks, [&](const int tid,
+                                                                   const std::size_t blockIndex){
+            const std::string blockPath = graphBlockPrefix + std::to_string(blockIds[blockIndex]);
+
+            std::vector<EdgeType> edges;
+            if(!loadEdges(blockPath, edges, 0)) {
+                return;
+            }
+            std::vector<EdgeIndexType> edgeIds;
+            loadEdgeIndices(blockPath, edgeIds, 0);
+            // the nodes are serialized in sorted order
+            std::vector<NodeType> nodes;
+            loadNodes(blockPath, nodes, 0);
+
+            // the inner edges of the block, i.e. the edges that do not
+            // connect to a node of the increased roi
+            std::vector<EdgeType> innerUvIds;
+            std::vector<EdgeIndexType> innerEdgeIds;
+            for(std::size_t edge = 0; edge < edges.size(); ++edge) {
+                const auto uIt = std::lower_bound(nodes.begin(), nodes.end(), edges[edge].first);
+                const auto vIt = std::lower_bound(nodes.begin(), nodes.end(), edges[edge].second);
+                if(uIt == nodes.end() || *uIt != edges[edge].first ||
+                   vIt == nodes.end() || *vIt != edges[edge].second) {
+                    continue;
+                }
+                innerUvIds.emplace_back(uIt - nodes.begin(), vIt - nodes.begin());
+                innerEdgeIds.push_back(edgeIds[edge]);
+            }
+            if(innerUvIds.empty()) {
+                return;
+            }
+
+            std::vector<WeightType> weights, sizes;
+            loadEdgeWeightsAndSizes(featureDs, innerEdgeIds, weights, sizes);
+
+            std::vector<NodeType> representatives;
+            agglomerateGraph(nodes.size(), innerUvIds, weights, sizes, threshold, representatives);
+            for(std::size_t node = 0; node < nodes.size(); ++node) {
+                if(representatives[node] != node) {
+                    ufd.merge(nodes[node], nodes[representatives[node]]);
+                }
+            }
+        });
+
+        serializeNodeLabeling(ufd, labelingDs, threadpool);
+    }
+
+
+    // an edge of the contracted graph, the weights are accumulated weighted by the size
+    struct ContractedEdge {
+        NodeType u;
+        NodeType v;
+        WeightType weightedSum;
+        WeightType size;
+
+        bool operator<(const ContractedEdge & other) const {
+            return u < other.u || (u == other.u && v < other.v);
+        }
+    };
+
+
+    // contract the edges with the node labeling (u < v in the result),
+    // edges inside of a segment are dropped
+    template<class UV_IDS, class LABELING>
+    inline void contractEdges(const UV_IDS & uvIds,
+                              const std::vector<WeightType> & weights,
+                              const std::vector<WeightType> & sizes,
+                              const LABELING & labeling,
+                              std::vector<ContractedEdge> & contractedEdges) {
+        for(std::size_t edge = 0; edge < weights.size(); ++edge) {
+            const NodeType lU = labeling[uvIds(edge, 0)];
+            const NodeType lV = labeling[uvIds(edge, 1)];
+            if(lU == lV) {
+                continue;
+            }
+            contractedEdges.push_back(ContractedEdge{std::min(lU, lV), std::max(lU, lV),
+                                                     sizes[edge] * weights[edge], sizes[edge]});
+        }
+    }
+
+
+    // sort the contracted edges and sum up parallel edges
+    inline void reduceContractedEdges(std::vector<ContractedEdge> & contractedEdges) {
+        std::sort(contractedEdges.begin(), contractedEdges.end());
+        std::size_t out = 0;
+        for(std::size_t edge = 0; edge < contractedEdges.size(); ++edge) {
+            const auto & contracted = contractedEdges[edge];
+            if(out > 0 && contractedEdges[out - 1].u == contracted.u && contractedEdges[out - 1].v == contracted.v) {
+                contractedEdges[out - 1].weightedSum += contracted.weightedSum;
+                contractedEdges[out - 1].size += contracted.size;
+            } else {
+                contractedEdges[out] = contracted;
+                ++out;
+            }
+        }
+        contractedEdges.resize(out);
+    }
+
+
+    // the output of `contractEdgeTable`: the contracted edges are sharded by their smaller segment,
+    // shard s contains the segments [nodeBegin[s], nodeBegin[s + 1])
+    // and is stored in the rows [rowBegin[s], rowBegin[s + 1])
+    struct ContractedShards {
+        std::vector<NodeType> nodeBegin;
+        std::vector<std::size_t> rowBegin;
+
+        std::size_t numberOfShards() const {
+            return nodeBegin.size() - 1;
+        }
+
+        std::size_t numberOfEdges() const {
+            return rowBegin.back();
+        }
+    };
+
+
+    // Contract the edge table given by 'edgeDs' (uv-ids) and 'featureDs' (see `loadEdgeWeightsAndSizes`)
+    // with the node labeling and write the contracted graph, sorted by (u, v), to the group 'outPath':
+    // "edges" (uv-ids), "features" (mean weight and size) and the attribute "numberOfEdges".
+    // The segments are split into shards with at most 'maxNumberOfEdges' contracted edges
+    // (unless a single segment has more), such that only the edges of one shard and
+    // one chunk of the table per thread are in memory:
+    // the contracted edges of each chunk are spilled to 'outPath/spill/<chunk>/<shard>'
+    // and gathered per shard, so each shard only reads its own spilled rows.
+    template<class EDGE_DS, class FEATURE_DS>
+    inline ContractedShards contractEdgeTable(EDGE_DS & edgeDs,
+                                              FEATURE_DS & featureDs,
+                                              const std::size_t numberOfEdges,
+                                              const std::vector<NodeType> & labeling,
+                                              const std::string & outPath,
+                                              const std::size_t maxNumberOfEdges,
+                                              nifty::parallel::ThreadPool & threadpool) {
+        const std::size_t nThreads = std::max<std::size_t>(threadpool.nThreads(), 1);
+        const std::size_t nNodes = labeling.size();
+        const std::size_t chunkSize = edgeDs->maxChunkShape()[0];
+        const std::size_t nChunks = (numberOfEdges + chunkSize - 1) / chunkSize;
+
+        const auto loadUvIds = [&](const std::size_t chunkId, Tensor2 & uvIds){
+            const std::size_t edgeBegin = chunkId * chunkSize;
+            const std::size_t edgeEnd = std::min(edgeBegin + chunkSize, numberOfEdges);
+            uvIds = Tensor2({edgeEnd - edgeBegin, 2});
+            const std::vector<std::size_t> offset({edgeBegin, 0});
+            z5::multiarray::readSubarray<NodeType>(edgeDs, uvIds, offset.begin());
+        };
+
+        // count the contracted edges of each segment and find the shards
+        std::vector<std::atomic<std::size_t>> counts(nNodes);
+        nifty::parallel::parallel_foreach(threadpool, nChunks, [&](const int tid, const std::size_t chunkId){
+            Tensor2 uvIds;
+            loadUvIds(chunkId, uvIds);
+            for(std::size_t edge = 0; edge < uvIds.shape()[0]; ++edge) {
+                const NodeType lU = labeling[uvIds(edge, 0)];
+                const NodeType lV = labeling[uvIds(edge, 1)];
+                if(lU != lV) {
+                    counts[std::min(lU, lV)].fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+
+        ContractedShards shards;
+        shards.nodeBegin.push_back(0);
+        std::size_t shardCount = 0;
+        for(NodeType node = 0; node < nNodes; ++node) {
+            const std::size_t count = counts[node].load(std::memory_order_relaxed);
+            if(shardCount > 0 && shardCount + count > maxNumberOfEdges) {
+                shards.nodeBegin.push_back(node);
+                shardCount = 0;
+            }
+            shardCount += count;
+        }
+        shards.nodeBegin.push_back(nNodes);
+        std::vector<std::atomic<std::size_t>>().swap(counts);
+        const std::size_t nShards = shards.numberOfShards();
+
+        // contract the chunks and spill the contracted edges, sorted by shard
+        z5::handle::Group out(outPath);
+        z5::createGroup(out, false);
+        const std::string spillPath = outPath + "/spill";
+        z5::handle::Group spill(spillPath);
+        z5::createGroup(spill, false);
+        const auto spillShardPath = [&](const std::size_t chunkId, const std::size_t shard){
+            return spillPath + "/" + std::to_string(chunkId) + "/" + std::to_string(shard);
+        };
+
+        std::vector<std::vector<std::size_t>> spillOffsets(nChunks);
+        nifty::parallel::parallel_foreach(threadpool, nChunks, [&](const int tid, const std::size_t chunkId){
+            Tensor2 uvIds;
+            loadUvIds(chunkId, uvIds);
+            const std::size_t edgeBegin = chunkId * chunkSize;
+            std::vector<WeightType> weights, sizes;
+            loadEdgeWeightsAndSizes(featureDs, edgeBegin, edgeBegin + uvIds.shape()[0], weights, sizes);
+
+            std::vector<ContractedEdge> contractedEdges;
+            contractEdges(uvIds, weights, sizes, labeling, contractedEdges);
+            reduceContractedEdges(contractedEdges);
+
+            auto & offsets = spillOffsets[chunkId];
+            offsets.resize(nShards + 1);
+            for(std::size_t shard = 0; shard <= nShards; ++shard) {
+                const NodeType node = shards.nodeBegin[shard];
+                offsets[shard] = std::lower_bound(contractedEdges.begin(), contractedEdges.end(), node,
+                                                  [](const ContractedEdge & edge, const NodeType n){
+                                                      return edge.u < n;
+                                                  }) - contractedEdges.begin();
+            }
+            if(contractedEdges.empty()) {
+                return;
+            }
+
+            // each shard of the chunk is spilled to its own datasets,
+            // so that gathering a shard only reads the rows of this shard
+            z5::handle::Group chunkGroup(spillPath + "/" + std::to_string(chunkId));
+            z5::createGroup(chunkGroup, false);
+            const std::vector<std::size_t> zero2Coord({0, 0});
+            for(std::size_t shard = 0; shard < nShards; ++shard) {
+                const std::size_t rowBegin = offsets[shard];
+                const std::size_t nRows = offsets[shard + 1] - rowBegin;
+                if(nRows == 0) {
+                    continue;
+                }
+                Tensor2 contractedUvIds({nRows, 2});
+                xt::xtensor<WeightType, 2> contractedFeatures({nRows, 2});
+                for(std::size_t row = 0; row < nRows; ++row) {
+                    const auto & edge = contractedEdges[rowBegin + row];
+                    contractedUvIds(row, 0) = edge.u;
+                    contractedUvIds(row, 1) = edge.v;
+                    contractedFeatures(row, 0) = edge.weightedSum;
+                    contractedFeatures(row, 1) = edge.size;
+                }
+                z5::handle::Group shardGroup(spillShardPath(chunkId, shard));
+                z5::createGroup(shardGroup, false);
+                const std::vector<std::size_t> shape({nRows, 2});
+                auto spillEdgeDs = z5::createDataset(shardGroup, "edges", "uint64", shape, shape, false);
+                z5::multiarray::writeSubarray<NodeType>(spillEdgeDs, contractedUvIds, zero2Coord.begin());
+                auto spillFeatureDs = z5::createDataset(shardGroup, "features", "float64", shape, shape, false);
+                z5::multiarray::writeSubarray<WeightType>(spillFeatureDs, contractedFeatures, zero2Coord.begin());
+            }
+        });
+
+        // gather the spilled edges of each shard, reduce them and write them to the output table
+        std::size_t maxContracted = 0;
+        for(const auto & offsets : spillOffsets) {
+            maxContracted += offsets.back();
+        }
+        shards.rowBegin.assign(1, 0);
+        if(maxContracted > 0) {
+            const std::vector<std::size_t> outShape({maxContracted, 2});
+            const std::vector<std::size_t> outChunks({std::min(chunkSize, maxContracted), 2});
+            auto outEdgeDs = z5::createDataset(out, "edges", "uint64", outShape, outChunks, false);
+            auto outFeatureDs = z5::createDataset(out, "features", "float64", outShape, outChunks, false);
+
+            std::vector<std::vector<ContractedEdge>> perThreadEdges(nThreads);
+            for(std::size_t shard = 0; shard < nShards; ++shard) {
+                nifty::parallel::parallel_foreach(threadpool, nChunks, [&](const int tid, const std::size_t chunkId){
+                    const auto & offsets = spillOffsets[chunkId];
+                    const std::size_t rowBegin = offsets[shard];
+                    const std::size_t rowEnd = offsets[shard + 1];
+                    if(rowBegin == rowEnd) {
+                        return;
+                    }
+                    z5::handle::Group shardGroup(spillShardPath(chunkId, shard));
+                    const std::vector<std::size_t> zero2Coord({0, 0});
+                    Tensor2 uvIds({rowEnd - rowBegin, 2});
+                    auto spillEdgeDs = z5::openDataset(shardGroup, "edges");
+                    z5::multiarray::readSubarray<NodeType>(spillEdgeDs, uvIds, zero2Coord.begin());
+                    xt::xtensor<WeightType, 2> features({rowEnd - rowBegin, 2});
+                    auto spillFeatureDs = z5::openDataset(shardGroup, "features");
+                    z5::multiarray::readSubarray<WeightType>(spillFeatureDs, features, zero2Coord.begin());
+
+                    auto & threadEdges = perThreadEdges[tid];
+                    for(std::size_t row = 0; row < rowEnd - rowBegin; ++row) {
+                        threadEdges.push_back(ContractedEdge{uvIds(row, 0), uvIds(row, 1),
+                                                             features(row, 0), features(row, 1)});
+                    }
+                });
+
+                std::vector<ContractedEdge> shardEdges;
+                shardEdges.swap(perThreadEdges[0]);
+                for(std::size_t t = 1; t < nThreads; ++t) {
+                    shardEdges.insert(shardEdges.end(), perThreadEdges[t].begin(), perThreadEdges[t].end());
+                    std::vector<ContractedEdge>().swap(perThreadEdges[t]);
+                }
+                reduceContractedEdges(shardEdges);
+
+                const std::size_t nShardEdges = shardEdges.size();
+                if(nShardEdges > 0) {
+                    Tensor2 uvIds({nShardEdges, 2});
+                    xt::xtensor<WeightType, 2> features({nShardEdges, 2});
+                    for(std::size_t edge = 0; edge < nShardEdges; ++edge) {
+                        uvIds(edge, 0) = shardEdges[edge].u;
+                        uvIds(edge, 1) = shardEdges[edge].v;
+                        features(edge, 0) = shardEdges[edge].weightedSum / shardEdges[edge].size;
+                        features(edge, 1) = shardEdges[edge].size;
+                    }
+                    const std::vector<std::size_t> offset({shards.rowBegin.back(), 0});
+                    z5::multiarray::writeSubarray<NodeType>(outEdgeDs, uvIds, offset.begin());
+                    z5::multiarray::writeSubarray<WeightType>(outFeatureDs, features, offset.begin());
+                }
+                shards.rowBegin.push_back(shards.rowBegin.back() + nShardEdges);
+            }
+        } else {
+            shards.rowBegin.resize(nShards + 1, 0);
+        }
+        fs::remove_all(spillPath);
+
+        nlohmann::json attrs;
+        attrs["numberOfEdges"] = shards.numberOfEdges();
+        z5::writeAttributes(out, attrs);
+        return shards;
+    }
+
+
+    // agglomerate the contracted edges in the rows [rowBegin, rowEnd) of the table,
+    // that connect two segments smaller than 'nodeEnd' and merge the result into the union find;
+    // returns whether any segments were merged
+    template<class EDGE_DS, class FEATURE_DS>
+    inline bool agglomerateContractedEdges(EDGE_DS & edgeDs,
+                                           FEATURE_DS & featureDs,
+                                           const std::size_t rowBegin,
+                                           const std::size_t rowEnd,
+                                           const NodeType nodeEnd,
+                                           const double threshold,
+                                           AgglomerationUfd & ufd) {
+        Tensor2 rowUvIds({rowEnd - rowBegin, 2});
+        const std::vector<std::size_t> offset({rowBegin, 0});
+        z5::multiarray::readSubarray<NodeType>(edgeDs, rowUvIds, offset.begin());
+        std::vector<WeightType> rowWeights, rowSizes;
+        loadEdgeWeightsAndSizes(featureDs, rowBegin, rowEnd, rowWeights, rowSizes);
+
+        std::vector<NodeType> segments;
+        std::vector<std::size_t> rows;
+        for(std::size_t row = 0; row < rowEnd - rowBegin; ++row) {
+            if(rowUvIds(row, 1) < nodeEnd) {
+                rows.push_back(row);
+                segments.push_back(rowUvIds(row, 0));
+                segments.push_back(rowUvIds(row, 1));
+            }
+        }
+        if(rows.empty()) {
+            return false;
+        }
+        std::sort(segments.begin(), segments.end());
+        segments.erase(std::unique(segments.begin(), segments.end()), segments.end());
+        const auto denseSegment = [&](const NodeType segment){
+            return static_cast<NodeType>(std::lower_bound(segments.begin(), segments.end(), segment) - segments.begin());
+        };
+
+        std::vector<EdgeType> uvIds;
+        std::vector<WeightType> weights, sizes;
+        uvIds.reserve(rows.size());
+        weights.reserve(rows.size());
+        sizes.reserve(rows.size());
+        for(const auto row : rows) {
+            uvIds.emplace_back(denseSegment(rowUvIds(row, 0)), denseSegment(rowUvIds(row, 1)));
+            weights.push_back(rowWeights[row]);
+            sizes.push_back(rowSizes[row]);
+        }
+
+        std::vector<NodeType> representatives;
+        agglomerateGraph(segments.size(), uvIds, weights, sizes, threshold, representatives);
+        bool merged = false;
+        for(std::size_t segment = 0; segment < segments.size(); ++segment) {
+            if(representatives[segment] != segment) {
+                ufd.merge(segments[segment], segments[representatives[segment]]);
+                merged = true;
+            }
+        }
+        return merged;
+    }
+
+
+    // Agglomerate along the block boundaries with at most 'maxNumberOfEdges' edges in memory:
+    // the edges of the merged graph are contracted with the current labeling (see `contractEdgeTable`),
+    // if the contracted graph has more than 'maxNumberOfEdges' edges, the edges inside of each shard
+    // are agglomerated and the contracted graph is contracted again, until it fits into memory
+    // or no more segments are merged (so segments that are only connected across shards may stay split
+    // if 'maxNumberOfEdges' is too small). Intermediate results are written to 'tmpPath'.
+    // Peak memory is O(number of nodes + maxNumberOfEdges + number of threads * chunk size).
+    inline void agglomerateAlongBlockBoundaries(const std::string & graphPath,
+                                                const std::string & edgeFeaturesPath,
+                                                const std::string & nodeLabelingPath,
+                                                const std::string & tmpPath,
+                                                const double threshold,
+                                                const std::size_t maxNumberOfEdges,
+                                                const int numberOfThreads=1) {
+        nifty::parallel::ThreadPool threadpool(numberOfThreads);
+
+        // load the node labeling of the previous agglomeration
+        auto labelingDs = z5::openDataset(nodeLabelingPath);
+        const std::size_t nNodes = labelingDs->shape(0);
+        std::vector<NodeType> labeling(nNodes);
+        {
+            Tensor1 tmpLabeling({nNodes});
+            const std::vector<std::size_t> zero1Coord({0});
+            z5::multiarray::readSubarray<NodeType>(labelingDs, tmpLabeling, zero1Coord.begin(), numberOfThreads);
+            std::copy(tmpLabeling.begin(), tmpLabeling.end(), labeling.begin());
+        }
+        AgglomerationUfd ufd(nNodes);
+        nifty::parallel::parallel_foreach(threadpool, nNodes, [&](const int tid, const std::size_t node){
+            if(labeling[node] != node) {
+                ufd.merge(node, labeling[node]);
+            }
+        });
+
+        z5::handle::Group graph(graphPath);
+        nlohmann::json j;
+        z5::readAttributes(graph, {"numberOfEdges"}, j);
+        std::size_t nEdges = j["numberOfEdges"];
+        auto edgeDs = z5::openDataset(graph, "edges");
+        auto featureDs = z5::openDataset(edgeFeaturesPath);
+
+        z5::handle::Group tmp(tmpPath);
+        z5::createGroup(tmp, false);
+        std::string previousLevelPath;
+        for(std::size_t level = 0; nEdges > 0; ++level) {
+            const std::string levelPath = tmpPath + "/level" + std::to_string(level);
+            const auto shards = contractEdgeTable(edgeDs, featureDs, nEdges, labeling,
+                                                  levelPath, maxNumberOfEdges, threadpool);
+            if(!previousLevelPath.empty()) {
+                fs::remove_all(previousLevelPath);
+            }
+            previousLevelPath = levelPath;
+            nEdges = shards.numberOfEdges();
+            if(nEdges == 0) {
+                break;
+            }
+
+            z5::handle::Group levelGroup(levelPath);
+            edgeDs = z5::openDataset(levelGroup, "edges");
+            featureDs = z5::openDataset(levelGroup, "features");
+            if(nEdges <= maxNumberOfEdges) {
+                agglomerateContractedEdges(edgeDs, featureDs, 0, nEdges, nNodes, threshold, ufd);
+                break;
+            }
+
+            bool merged = false;
+            for(std::size_t shard = 0; shard < shards.numberOfShards(); ++shard) {
+                if(shards.rowBegin[shard] == shards.rowBegin[shard + 1]) {
+                    continue;
+                }
+                merged |= agglomerateContractedEdges(edgeDs, featureDs,
+                                                     shards.rowBegin[shard], shards.rowBegin[shard + 1],
+                                                     shards.nodeBegin[shard + 1], threshold, ufd);
+            }
+            if(!merged) {
+                break;
+            }
+            nifty::parallel::parallel_foreach(threadpool, nNodes, [&](const int tid, const std::size_t node){
+                labeling[node] = ufd.find(node);
+            });
+        }
+        if(!previousLevelPath.empty()) {
+            fs::remove_all(previousLevelPath);
+        }
+
+        serializeNodeLabeling(ufd, labelingDs, threadpool);
+    }
+
+}
+}
@@ -2,6 +2,7 @@
 
 #include <unordered_set>
 #include <set>
+#include <limits>
 #include <boost/functional/hash.hpp>
 
 #include "xtensor/xtensor.hpp"
@@ -15,6 +16,7 @@
 #include "nifty/array/static_array.hxx"
 #include "nifty/xtensor/xtensor.hxx"
 #include "nifty/tools/for_each_coordinate.hxx"
+#include "nifty/tools/radix_sort.hxx"
 
 namespace fs = boost::filesystem;
 
@@ -136,6 +138,32 @@ namespace distributed {
     }
 
 
+    // get the range of global edge ids [edgeIdBegin, edgeIdEnd) of a block graph,
+    // from the attributes written by `mapEdgeIds` or by loading the edge ids;
+    // returns false if the block does not have edges
+    inline bool loadEdgeIdRange(const std::string & graphPath,
+                                EdgeIndexType & edgeIdBegin,
+                                EdgeIndexType & edgeIdEnd) {
+        z5::handle::Group graph(graphPath);
+        nlohmann::json j;
+        z5::readAttributes(graph, j);
+        const std::size_t numberOfEdges = j["numberOfEdges"];
+        if(numberOfEdges == 0) {
+            return false;
+        }
+        if(j.find("edgeIdBegin") != j.end()) {
+            edgeIdBegin = j["edgeIdBegin"];
+            edgeIdEnd = j["edgeIdEnd"];
+            return true;
+        }
+        std::vector<EdgeIndexType> edgeIndices;
+        loadEdgeIndices(graphPath, edgeIndices, 0);
+        edgeIdBegin = edgeIndices.front();
+        edgeIdEnd = edgeIndices.back() + 1;
+        return true;
+    }
+
+
     template<class EDGES>
     inline bool loadEdges(const std::string & graphPath,
                           EDGES & edges) {
@@ -331,8 +359,8 @@ namespace distributed {
                              const std::string & keyToLabels,
                              const COORD & roiBegin,
                              const COORD & roiEnd,
-                             NodeSet & nodes,
-                             EdgeSet & edges,
+                             std::vector<NodeType> & nodes,
+                             std::vector<EdgeType> & edges,
                              const bool ignoreLabel=false,
                              const bool increaseRoi=true) {
 
@@ -357,60 +385,81 @@ namespace distributed {
 
         // load the roi
         Shape3Type shape;
-        CoordType blockShape, coord2;
-
         for(int axis = 0; axis < 3; ++axis) {
             shape[axis] = roiEnd[axis] - actualRoiBegin[axis];
-            blockShape[axis] = shape[axis];
         }
         Tensor3 labels(shape);
         z5::multiarray::readSubarray<NodeType>(ds, labels, actualRoiBegin.begin());
 
-        // iterate over the the roi and extract all graph nodes and edges
-        // we want ordered iteration over nodes and edges in the end,
-        // so we use a normal set instead of an unordered one
-
-        NodeType lU, lV;
-        nifty::tools::forEachCoordinate(blockShape,[&](const CoordType & coord) {
-
-            lU = xtensor::read(labels, coord.asStdArray());
-            // we don't add the nodes in the increased roi
-            if(increaseRoi) {
-                bool insertNode = true;
-                for(int axis = 0; axis < 3; ++axis) {
-                    if(coord[axis] == 0 && roiIncreasedAxis[axis]) {
-                        insertNode = false;
-                        break;
+        // we collect the nodes and edges in flat vectors and sort and unique them in the end,
+        // which is much faster than inserting every voxel into a set.
+        // most duplicates are filtered right away by small direct mapped caches
+        // of the last seen nodes / edges
+        const std::array<std::size_t, 3> strides = {shape[1] * shape[2], shape[2], 1};
+        const NodeType * labelsData = &labels(0, 0, 0);
+        const NodeType invalidNode = std::numeric_limits<NodeType>::max();
+        const std::size_t cacheBits = 14;
+        std::vector<NodeType> nodeCache(1 << cacheBits, invalidNode);
+        std::vector<EdgeType> edgeCache(1 << cacheBits, std::make_pair(invalidNode, invalidNode));
+
+        nodes.clear();
+        edges.clear();
+        for(std::size_t z = 0; z < shape[0]; ++z) {
+            for(std::size_t y = 0; y < shape[1]; ++y) {
+                // we don't add the nodes in the increased roi
+                const bool insertRow = !((z == 0 && roiIncreasedAxis[0]) ||
+                                         (y == 0 && roiIncreasedAxis[1]));
+                const std::size_t rowOffset = z * strides[0] + y * strides[1];
+
+                for(std::size_t x = 0; x < shape[2]; ++x) {
+                    const std::size_t pos = rowOffset + x;
+                    const NodeType lU = labelsData[pos];
+                    if(insertRow && !(x == 0 && roiIncreasedAxis[2])) {
+                        auto & cached = nodeCache[lU & ((1 << cacheBits) - 1)];
+                        if(cached != lU) {
+                            nodes.push_back(lU);
+                            cached = lU;
+                        }
                     }
-                }
-                if(insertNode) {
-                    nodes.insert(lU);
-                }
-            }
-            else {
-                nodes.insert(lU);
-            }
 
-            // skip edges to zero if we have an ignoreLabel
-            if(ignoreLabel && (lU == 0)) {
-                return;
-            }
+                    // skip edges to zero if we have an ignoreLabel
+                    if(ignoreLabel && (lU == 0)) {
+                        continue;
+                    }
 
-            for(std::size_t axis = 0; axis < 3; ++axis){
-                makeCoord2(coord, coord2, axis);
-                if(coord2[axis] < blockShape[axis]){
-                    lV = xtensor::read(labels, coord2.asStdArray());
-                    // skip zero if we have an ignoreLabel
-                    if(ignoreLabel && (lV == 0)) {
-                        return;
+                    // returns false if the neighbor is the ignore label,
+                    // this also skips the remaining axes for this coordinate
+                    // (consistent with the feature accumulation)
+                    const auto visitNeighbor = [&](const NodeType lV) {
+                        if(ignoreLabel && (lV == 0)) {
+                            return false;
+                        }
+                        if(lU != lV) {
+                            const EdgeType edge = std::make_pair(std::min(lU, lV), std::max(lU, lV));
+                            auto & cached = edgeCache[(((edge.first << 32) ^ edge.second) * 0x9E3779B97F4A7C15ULL) >> (64 - cacheBits)];
+                            if(cached != edge) {
+                                edges.push_back(edge);
+                                cached = edge;
+                            }
+                        }
+                        return true;
+                    };
+                    if(z + 1 < shape[0] && !visitNeighbor(labelsData[pos + strides[0]])) {
+                        continue;
+                    }
+                    if(y + 1 < shape[1] && !visitNeighbor(labelsData[pos + strides[1]])) {
+                        continue;
                     }
-                    if(lU != lV){
-                        edges.insert(std::make_pair(std::min(lU, lV),
-                                     std::max(lU, lV)));
+                    if(x + 1 < shape[2]) {
+                        visitNeighbor(labelsData[pos + 1]);
                     }
                 }
             }
-        });
+        }
+
+        // we want ordered nodes and edges in the end
+        nifty::tools::radixSortUnique(nodes);
+        nifty::tools::radixSortUnique(edges);
     }
 
 
@@ -424,8 +473,8 @@ namespace distributed {
                                      const bool ignoreLabel=false,
                                      const bool increaseRoi=false) {
         // extract graph nodes and edges from roi
-        NodeSet nodes;
-        EdgeSet edges;
+        std::vector<NodeType> nodes;
+        std::vector<EdgeType> edges;
         extractGraphFromRoi(pathToLabels, keyToLabels,
                             roiBegin, roiEnd,
                             nodes, edges,
@@ -687,6 +736,13 @@ namespace distributed {
             z5::handle::Group block(blockPath.string());
             auto dsIds = z5::createDataset(block, "edgeIds", "int64", idShape, idShape, false);
             z5::multiarray::writeSubarray<EdgeIndexType>(dsIds, idView, zero1Coord.begin());
+
+            // store the (sorted) id range, so that we can find the blocks
+            // containing an edge range without loading the ids
+            nlohmann::json attrs;
+            attrs["edgeIdBegin"] = edgeIds.front();
+            attrs["edgeIdEnd"] = edgeIds.back() + 1;
+            z5::writeAttributes(block, attrs);
         });
     }
 
@@ -1,6 +1,5 @@
 #pragma once
 
-#include "boost/pending/disjoint_sets.hpp"
 #include "z5/util/for_each.hxx"
 #include "z5/util/util.hxx"
 
@@ -8,6 +7,8 @@
 #include "nifty/distributed/graph_extraction.hxx"
 #include "nifty/distributed/distributed_graph.hxx"
 #include "nifty/tools/blocking.hxx"
+#include "nifty/ufd/concurrent_ufd.hxx"
+#include "nifty/parallel/threadpool.hxx"
 
 namespace fs = boost::filesystem;
 
@@ -379,11 +380,18 @@ namespace distributed {
     }
 
 
+    // Label the connected components of the graph, where two nodes are connected
+    // if their edge has the label 0 (in accordance with cut edges being 1).
+    // Each node is labeled with the smallest node id in its component.
+    // If ignoreLabel is true, edges to node 0 are not used, so that node 0 is the only node with label 0.
+    // The edges are merged in parallel with a concurrent union find, the labels
+    // do not depend on the number of threads.
     template<class EDGES, class NODES>
     void connectedComponents(const Graph & graph,
                              const xt::xexpression<EDGES> & edges_exp,
                              const bool ignoreLabel,
-                             xt::xexpression<NODES> & labels_exp) {
+                             xt::xexpression<NODES> & labels_exp,
+                             const int numberOfThreads=1) {
         const auto & edges = edges_exp.derived_cast();
         auto & labels = labels_exp.derived_cast();
 
@@ -392,63 +400,27 @@ namespace distributed {
 
         // we need the number of nodes if nodes were dense
         const std::size_t nNodes = graph.nodeMaxId() + 1;
+        nifty::ufd::ConcurrentUfd<NodeType> ufd(nNodes);
+        nifty::parallel::ThreadPool threadpool(numberOfThreads);
 
-        // make union find
-        std::vector<NodeType> rank(nNodes);
-        std::vector<NodeType> parent(nNodes);
-        boost::disjoint_sets<NodeType*, NodeType*> sets(&rank[0], &parent[0]);
-        for(NodeType node_id = 0; node_id < nNodes; ++node_id) {
-            sets.make_set(node_id);
-        }
-
-        // First pass:
-        // iterate over each node and create new label at node
-        // or assign representative of the neighbor node
-        NodeType currentLabel = 0;
-        for(const NodeType node : nodes){
-
-            if(ignoreLabel && (node == 0)) {
-                continue;
-            }
-
-            // iterate over the nodes in the neighborhood
-            // and collect the nodes that are connected
-            const auto & nhood = graph.nodeAdjacency(node);
-            std::set<NodeType> ngbLabels;
-            for(auto nhIt = nhood.begin(); nhIt != nhood.end(); ++nhIt) {
-                const NodeType nhNode = nhIt->first;
-                const EdgeIndexType nhEdge = nhIt->second;
-
-                // nodes are connected if the edge has the value 0
-                // this is in accordance with cut edges being 1
-                if(!edges(nhEdge)) {
-                    ngbLabels.insert(nhNode);
-                }
+        // merge the nodes of all uncut edges
+        const auto & uvIds = graph.edges();
+        nifty::parallel::parallel_foreach(threadpool, uvIds.size(), [&](const int tid, const int64_t edgeId){
+            if(edges(edgeId)) {
+                return;
             }
-
-            // check if we are connected to any of the neighbors
-            // and if the neighbor labels need to be merged
-            if(ngbLabels.size() == 0) {
-                // no connection -> make new label @ current pixel
-                labels(node) = ++currentLabel;
-            } else if (ngbLabels.size() == 1) {
-                // only single label -> we assign its representative to the current pixel
-                labels(node) = sets.find_set(*ngbLabels.begin());
-            } else {
-                // multiple labels -> we merge them and assign representative to the current pixel
-                std::vector<NodeType> tmp_labels(ngbLabels.begin(), ngbLabels.end());
-                for(unsigned ii = 1; ii < tmp_labels.size(); ++ii) {
-                    sets.link(tmp_labels[ii - 1], tmp_labels[ii]);
-                }
-                labels(node) = sets.find_set(tmp_labels[0]);
+            const auto & uv = uvIds[edgeId];
+            if(ignoreLabel && (uv.first == 0 || uv.second == 0)) {
+                return;
             }
-        }
+            ufd.merge(uv.first, uv.second);
+        });
 
-        // Second pass:
-        // Assign representative to each pixel
-        for(const NodeType node : nodes){
-            labels(node) = sets.find_set(labels(node));
-        }
+        // assign the representative to each node
+        nifty::parallel::parallel_foreach(threadpool, nodes.size(), [&](const int tid, const int64_t nodeIndex){
+            const NodeType node = nodes[nodeIndex];
+            labels(node) = ufd.find(node);
+        });
     }
 
 }
@@ -1,5 +1,11 @@
 #pragma once
 
+#include <array>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <future>
+
 #include "vigra/accumulator.hxx"
 #include "nifty/distributed/distributed_graph.hxx"
 
@@ -43,6 +49,418 @@ namespace distributed {
     }
 
 
+    ///
+    // exactly mergeable edge feature sketches
+    ///
+
+
+    // Sketch of the values accumulated for each edge:
+    // histogram over [dataMin, dataMax] (values outside are counted in the first / last bin)
+    // and the moments sum, sum of squares, min and max.
+    // Unlike the final features, the sketches of different blocks can be merged exactly.
+    // The features (mean, variance, quantiles, count) are computed once from the merged sketches,
+    // the quantiles are interpolated from the histogram like vigra's StandardQuantiles.
+    // The histograms are merged exactly and the moments in double precision.
+    // The serialized histogram of each edge only stores its range of non-empty bins,
+    // the counts as variable length integers (1 byte below 128, 2 bytes below 16384, ...),
+    // so a serialized edge takes 33 bytes for the moments and the histogram size
+    // plus about one byte per bin in its range (the dense table of the 10 features takes 80 bytes).
+    class EdgeFeatureSketches {
+    public:
+        static const std::size_t numberOfBins = 40;
+        static const std::size_t numberOfMoments = 4;
+        typedef uint32_t CountType;
+
+        EdgeFeatureSketches(const std::size_t numberOfEdges,
+                            const FeatureType dataMin,
+                            const FeatureType dataMax)
+            : histograms_(Shape2Type({numberOfEdges, numberOfBins})),
+              moments_(Shape2Type({numberOfEdges, numberOfMoments})),
+              dataMin_(dataMin),
+              dataMax_(dataMax),
+              binScale_(numberOfBins / (dataMax - dataMin)) {
+            std::fill(histograms_.begin(), histograms_.end(), 0);
+            for(std::size_t edge = 0; edge < numberOfEdges; ++edge) {
+                moments_(edge, 0) = 0.;
+                moments_(edge, 1) = 0.;
+                moments_(edge, 2) = std::numeric_limits<FeatureType>::infinity();
+                moments_(edge, 3) = -std::numeric_limits<FeatureType>::infinity();
+            }
+        }
+
+        std::size_t numberOfEdges() const {
+            return histograms_.shape()[0];
+        }
+
+        const xt::xtensor<CountType, 2> & histograms() const {
+            return histograms_;
+        }
+
+        const xt::xtensor<FeatureType, 2> & moments() const {
+            return moments_;
+        }
+
+        FeatureType dataMin() const {
+            return dataMin_;
+        }
+
+        FeatureType dataMax() const {
+            return dataMax_;
+        }
+
+        inline void update(const EdgeIndexType edge, const FeatureType val) {
+            const int64_t bin = static_cast<int64_t>((val - dataMin_) * binScale_);
+            ++histograms_(edge, std::min(std::max(bin, int64_t(0)), int64_t(numberOfBins - 1)));
+            moments_(edge, 0) += val;
+            moments_(edge, 1) += val * val;
+            moments_(edge, 2) = std::min(moments_(edge, 2), val);
+            moments_(edge, 3) = std::max(moments_(edge, 3), val);
+        }
+
+        // merge the sketch of 'otherEdge' (row in the other histograms / moments) into 'edge'
+        template<class HISTOGRAMS, class MOMENTS>
+        inline void merge(const EdgeIndexType edge,
+                          const HISTOGRAMS & otherHistograms,
+                          const MOMENTS & otherMoments,
+                          const EdgeIndexType otherEdge) {
+            for(std::size_t bin = 0; bin < numberOfBins; ++bin) {
+                histograms_(edge, bin) += otherHistograms(otherEdge, bin);
+            }
+            moments_(edge, 0) += otherMoments(otherEdge, 0);
+            moments_(edge, 1) += otherMoments(otherEdge, 1);
+            moments_(edge, 2) = std::min(moments_(edge, 2), static_cast<FeatureType>(otherMoments(otherEdge, 2)));
+            moments_(edge, 3) = std::max(moments_(edge, 3), static_cast<FeatureType>(otherMoments(otherEdge, 3)));
+        }
+
+        inline void merge(const EdgeIndexType edge,
+                          const EdgeFeatureSketches & other,
+                          const EdgeIndexType otherEdge) {
+            merge(edge, other.histograms_, other.moments_, otherEdge);
+        }
+
+        // merge a single histogram (numberOfBins counts) and the corresponding moments into 'edge'
+        inline void merge(const EdgeIndexType edge,
+                          const CountType * histogram,
+                          const FeatureType sum,
+                          const FeatureType sumOfSquares,
+                          const FeatureType min,
+                          const FeatureType max) {
+            for(std::size_t bin = 0; bin < numberOfBins; ++bin) {
+                histograms_(edge, bin) += histogram[bin];
+            }
+            moments_(edge, 0) += sum;
+            moments_(edge, 1) += sumOfSquares;
+            moments_(edge, 2) = std::min(moments_(edge, 2), min);
+            moments_(edge, 3) = std::max(moments_(edge, 3), max);
+        }
+
+        // compute the 10 default features (same layout as `serializeDefaultEdgeFeatures`)
+        template<class FEATURES>
+        inline void computeFeatures(const EdgeIndexType edge,
+                                    FEATURES & features,
+                                    const EdgeIndexType featureRow) const {
+            FeatureType count = 0;
+            for(std::size_t bin = 0; bin < numberOfBins; ++bin) {
+                count += histograms_(edge, bin);
+            }
+            if(count == 0) {
+                for(std::size_t featId = 0; featId < 10; ++featId) {
+                    features(featureRow, featId) = 0.;
+                }
+                return;
+            }
+
+            const FeatureType mean = moments_(edge, 0) / count;
+            features(featureRow, 0) = mean;
+            features(featureRow, 1) = std::max(moments_(edge, 1) / count - mean * mean, 0.);
+
+            // keypoints of the cumulative histogram (in bin coordinates),
+            // starting / ending at the exact min / max
+            std::vector<FeatureType> keypoints, cumulativeCounts;
+            keypoints.reserve(2 * numberOfBins + 1);
+            cumulativeCounts.reserve(2 * numberOfBins + 1);
+            keypoints.push_back((moments_(edge, 2) - dataMin_) * binScale_);
+            cumulativeCounts.push_back(0);
+            FeatureType cumulative = 0;
+            for(std::size_t bin = 0; bin < numberOfBins; ++bin) {
+                const auto binCount = histograms_(edge, bin);
+                if(binCount == 0) {
+                    continue;
+                }
+                if(keypoints.back() < bin) {
+                    keypoints.push_back(bin);
+                    cumulativeCounts.push_back(cumulative);
+                }
+                cumulative += binCount;
+                keypoints.push_back(bin + 1);
+                cumulativeCounts.push_back(cumulative);
+            }
+            keypoints.back() = (moments_(edge, 3) - dataMin_) * binScale_;
+
+            // min and max are exact, the other quantiles are interpolated
+            features(featureRow, 2) = moments_(edge, 2);
+            features(featureRow, 8) = moments_(edge, 3);
+            const std::array<FeatureType, 5> quantiles = {.1, .25, .5, .75, .9};
+            std::size_t point = 0;
+            for(std::size_t qi = 0; qi < quantiles.size(); ++qi) {
+                const FeatureType target = quantiles[qi] * count;
+                while(cumulativeCounts[point] < target) {
+                    ++point;
+                }
+                FeatureType keypoint = keypoints[point];
+                if(cumulativeCounts[point] != target) {
+                    const FeatureType t = (target - cumulativeCounts[point - 1]) /
+                                          (cumulativeCounts[point] - cumulativeCounts[point - 1]);
+                    keypoint = keypoints[point - 1] + t * (keypoints[point] - keypoints[point - 1]);
+                }
+                features(featureRow, 3 + qi) = replaceIfNotFinite(keypoint / binScale_ + dataMin_, mean);
+            }
+            features(featureRow, 9) = count;
+        }
+
+        // serialize to a group with the datasets
+        // 'moments' (float64, one row per edge),
+        // 'histogramSizes' (uint8, the number of encoded histogram bytes per edge) and
+        // 'histograms' (uint8, the encoded histograms of all edges, see `encodeHistogram`)
+        inline void serialize(const std::string & path) const {
+            z5::handle::Group group(path);
+            z5::createGroup(group, false);
+
+            const std::size_t nEdges = numberOfEdges();
+            std::vector<uint8_t> encoded;
+            xt::xtensor<uint8_t, 1> sizes(Shape1Type({nEdges}));
+            for(std::size_t edge = 0; edge < nEdges; ++edge) {
+                sizes(edge) = encodeHistogram(edge, encoded);
+            }
+
+            // z5 does not support empty datasets
+            const std::vector<std::size_t> zero1Coord({0});
+            const std::vector<std::size_t> histogramShape = {std::max<std::size_t>(encoded.size(), 1)};
+            xt::xtensor<uint8_t, 1> histograms(Shape1Type({histogramShape[0]}));
+            std::fill(histograms.begin(), histograms.end(), 0);
+            std::copy(encoded.begin(), encoded.end(), histograms.begin());
+            auto histogramDs = z5::createDataset(group, "histograms", "uint8",
+                                                 histogramShape, histogramShape, false);
+            z5::multiarray::writeSubarray<uint8_t>(histogramDs, histograms, zero1Coord.begin());
+
+            const std::vector<std::size_t> sizeShape = {nEdges};
+            auto sizeDs = z5::createDataset(group, "histogramSizes", "uint8", sizeShape, sizeShape, false);
+            z5::multiarray::writeSubarray<uint8_t>(sizeDs, sizes, zero1Coord.begin());
+
+            const std::vector<std::size_t> zero2Coord({0, 0});
+            const std::vector<std::size_t> momentShape = {nEdges, numberOfMoments};
+            auto momentDs = z5::createDataset(group, "moments", "float64", momentShape, momentShape, false);
+            z5::multiarray::writeSubarray<FeatureType>(momentDs, moments_, zero2Coord.begin());
+
+            nlohmann::json attrs;
+            attrs["dataMin"] = dataMin_;
+            attrs["dataMax"] = dataMax_;
+            z5::writeAttributes(group, attrs);
+        }
+
+        // merge the serialized sketches of a block; 'blockEdgeIndices' are the
+        // (sorted) global edge ids of the block, only edges in
+        // [edgeIdBegin, edgeIdBegin + numberOfEdges()) are merged
+        inline void mergeSerialized(const std::string & path,
+                                    const std::vector<EdgeIndexType> & blockEdgeIndices,
+                                    const EdgeIndexType edgeIdBegin) {
+            z5::handle::Group group(path);
+            // only load the (contiguous) rows of the edges in our range
+            const EdgeIndexType edgeIdEnd = edgeIdBegin + numberOfEdges();
+            const std::size_t rowBegin = std::lower_bound(blockEdgeIndices.begin(), blockEdgeIndices.end(),
+                                                          edgeIdBegin) - blockEdgeIndices.begin();
+            const std::size_t rowEnd = std::lower_bound(blockEdgeIndices.begin() + rowBegin, blockEdgeIndices.end(),
+                                                        edgeIdEnd) - blockEdgeIndices.begin();
+            if(rowBegin == rowEnd) {
+                return;
+            }
+
+            // the encoded histograms of our rows start after the ones of the previous rows
+            const std::vector<std::size_t> zero1Coord({0});
+            xt::xtensor<uint8_t, 1> sizes(Shape1Type({rowEnd}));
+            auto sizeDs = z5::openDataset(group, "histogramSizes");
+            z5::multiarray::readSubarray<uint8_t>(sizeDs, sizes, zero1Coord.begin());
+            const std::size_t byteBegin = std::accumulate(sizes.begin(), sizes.begin() + rowBegin, std::size_t(0));
+            const std::size_t byteEnd = std::accumulate(sizes.begin() + rowBegin, sizes.end(), byteBegin);
+
+            const std::vector<std::size_t> byteOffset({byteBegin});
+            xt::xtensor<uint8_t, 1> encoded(Shape1Type({byteEnd - byteBegin}));
+            if(byteEnd > byteBegin) {
+                auto histogramDs = z5::openDataset(group, "histograms");
+                z5::multiarray::readSubarray<uint8_t>(histogramDs, encoded, byteOffset.begin());
+            }
+
+            const std::vector<std::size_t> rowOffset({rowBegin, 0});
+            xt::xtensor<FeatureType, 2> moments(Shape2Type({rowEnd - rowBegin, numberOfMoments}));
+            auto momentDs = z5::openDataset(group, "moments");
+            z5::multiarray::readSubarray<FeatureType>(momentDs, moments, rowOffset.begin());
+
+            std::array<CountType, numberOfBins> histogram;
+            const uint8_t * bytes = encoded.size() == 0 ? nullptr : &encoded(0);
+            for(std::size_t row = rowBegin; row < rowEnd; ++row) {
+                bytes = decodeHistogram(bytes, sizes(row), histogram);
+                const std::size_t momentRow = row - rowBegin;
+                merge(blockEdgeIndices[row] - edgeIdBegin, histogram.data(),
+                      moments(momentRow, 0), moments(momentRow, 1),
+                      moments(momentRow, 2), moments(momentRow, 3));
+            }
+        }
+
+    private:
+        // append the histogram of 'edge' to 'encoded' and return the number of appended bytes:
+        // the first non-empty bin followed by the counts of the bins up to the last non-empty bin
+        // as variable length integers (7 bits per byte, the high bit marks that more bytes follow);
+        // empty histograms take no bytes and at most 1 + 40 * 5 bytes are appended
+        inline uint8_t encodeHistogram(const EdgeIndexType edge, std::vector<uint8_t> & encoded) const {
+            std::size_t binBegin = 0, binEnd = numberOfBins;
+            while(binBegin < numberOfBins && histograms_(edge, binBegin) == 0) {
+                ++binBegin;
+            }
+            if(binBegin == numberOfBins) {
+                return 0;
+            }
+            while(histograms_(edge, binEnd - 1) == 0) {
+                --binEnd;
+            }
+            const std::size_t sizeBefore = encoded.size();
+            encoded.push_back(static_cast<uint8_t>(binBegin));
+            for(std::size_t bin = binBegin; bin < binEnd; ++bin) {
+                CountType count = histograms_(edge, bin);
+                while(count >= 0x80) {
+                    encoded.push_back(static_cast<uint8_t>(count & 0x7F) | 0x80);
+                    count >>= 7;
+                }
+                encoded.push_back(static_cast<uint8_t>(count));
+            }
+            return static_cast<uint8_t>(encoded.size() - sizeBefore);
+        }
+
+        // decode a histogram of 'size' bytes written by `encodeHistogram`
+        // and return the pointer past its last byte
+        static inline const uint8_t * decodeHistogram(const uint8_t * bytes, const std::size_t size,
+                                                      std::array<CountType, numberOfBins> & histogram) {
+            histogram.fill(0);
+            if(size == 0) {
+                return bytes;
+            }
+            const uint8_t * end = bytes + size;
+            std::size_t bin = *bytes++;
+            while(bytes < end) {
+                CountType count = 0;
+                unsigned shift = 0;
+                uint8_t byte;
+                do {
+                    byte = *bytes++;
+                    count |= static_cast<CountType>(byte & 0x7F) << shift;
+                    shift += 7;
+                } while(byte & 0x80);
+                histogram[bin++] = count;
+            }
+            return end;
+        }
+
+        xt::xtensor<CountType, 2> histograms_;
+        xt::xtensor<FeatureType, 2> moments_;
+        FeatureType dataMin_;
+        FeatureType dataMax_;
+        FeatureType binScale_;
+    };
+
+
+    // the input is accumulated as FeatureType, uint8 input is normalized to [0, 1]
+    template<class T>
+    inline FeatureType normalizeInput(const T val) {
+        return static_cast<FeatureType>(val);
+    }
+
+
+    inline FeatureType normalizeInput(const uint8_t val) {
+        return static_cast<FeatureType>(val) / 255.;
+    }
+
+
+    // Integer accumulation of uint8 input (values are normalized to [0, 1] by 255).
+    // The per edge statistics are stored as structure of arrays: a flat histogram table
+    // and exact integer sums, sums of squares, min and max.
+    // The histogram bin of each of the 256 possible values is precomputed,
+    // so no value is promoted to floating point during accumulation.
+    // The features are only computed at serialization, via `EdgeFeatureSketches`:
+    // mean, variance, min, max and count are the same as with the vigra accumulators,
+    // the quantiles are interpolated differently and agree within one histogram bin,
+    // i.e. (dataMax - dataMin) / 40. This is the default for uint8 input in
+    // `accumulateBoundaryMap` / `accumulateAffinityMap`, 'vigraFeatures' opts out.
+    class ByteEdgeAccumulators {
+    public:
+        static const std::size_t numberOfBins = EdgeFeatureSketches::numberOfBins;
+        typedef EdgeFeatureSketches::CountType CountType;
+
+        ByteEdgeAccumulators(const std::size_t numberOfEdges,
+                             const FeatureType dataMin,
+                             const FeatureType dataMax)
+            : histograms_(numberOfEdges * numberOfBins, 0),
+              sums_(numberOfEdges, 0),
+              sumsOfSquares_(numberOfEdges, 0),
+              mins_(numberOfEdges, std::numeric_limits<uint8_t>::max()),
+              maxs_(numberOfEdges, 0) {
+            // same binning as `EdgeFeatureSketches::update` for the normalized values
+            const FeatureType binScale = numberOfBins / (dataMax - dataMin);
+            for(std::size_t val = 0; val < binLookup_.size(); ++val) {
+                const int64_t bin = static_cast<int64_t>((static_cast<FeatureType>(val) / 255. - dataMin) * binScale);
+                binLookup_[val] = std::min(std::max(bin, int64_t(0)), int64_t(numberOfBins - 1));
+            }
+        }
+
+        std::size_t numberOfEdges() const {
+            return sums_.size();
+        }
+
+        inline void update(const EdgeIndexType edge, const uint8_t val) {
+            ++histograms_[edge * numberOfBins + binLookup_[val]];
+            sums_[edge] += val;
+            sumsOfSquares_[edge] += static_cast<uint32_t>(val) * val;
+            mins_[edge] = std::min(mins_[edge], val);
+            maxs_[edge] = std::max(maxs_[edge], val);
+        }
+
+        // merge the (normalized) statistics of all edges with values into the sketches,
+        // normalized like `normalizeInput`
+        inline void mergeInto(EdgeFeatureSketches & sketches) const {
+            for(std::size_t edge = 0; edge < numberOfEdges(); ++edge) {
+                if(mins_[edge] > maxs_[edge]) {
+                    continue;
+                }
+                sketches.merge(edge, &histograms_[edge * numberOfBins],
+                               sums_[edge] / 255.,
+                               sumsOfSquares_[edge] / (255. * 255.),
+                               normalizeInput(mins_[edge]),
+                               normalizeInput(maxs_[edge]));
+            }
+        }
+
+    private:
+        std::array<uint8_t, 256> binLookup_;
+        std::vector<CountType> histograms_;
+        std::vector<uint64_t> sums_;
+        std::vector<uint64_t> sumsOfSquares_;
+        std::vector<uint8_t> mins_;
+        std::vector<uint8_t> maxs_;
+    };
+
+
+    inline void updateEdgeAccumulator(AccumulatorVector & accumulators,
+                                      const EdgeIndexType edge,
+                                      const FeatureType val) {
+        accumulators[edge].updatePassN(val, 1);
+    }
+
+
+    inline void updateEdgeAccumulator(EdgeFeatureSketches & sketches,
+                                      const EdgeIndexType edge,
+                                      const FeatureType val) {
+        sketches.update(edge, val);
+    }
+
+
     template<class FEATURE_ACCUMULATOR>
     inline void extractBlockFeaturesImpl(const std::string & blockPrefix,
                                          const std::string & dataPath,
@@ -149,50 +567,82 @@ namespace distributed {
     }
 
 
+    // serialize the default edge features computed from the sketches
+    inline void serializeSketchFeatures(const EdgeFeatureSketches & sketches,
+                                        const std::string & blockStoragePath) {
+        const std::vector<std::size_t> zero2Coord({0, 0});
+        const std::size_t numberOfEdges = sketches.numberOfEdges();
+        xt::xtensor<FeatureType, 2> values(Shape2Type({numberOfEdges, 10}));
+        for(std::size_t edgeId = 0; edgeId < numberOfEdges; ++edgeId) {
+            sketches.computeFeatures(edgeId, values, edgeId);
+        }
+
+        std::vector<std::size_t> shape = {numberOfEdges, 10};
+        auto ds = z5::createDataset(blockStoragePath, "float64", shape, shape, false);
+        z5::multiarray::writeSubarray<FeatureType>(ds, values, zero2Coord.begin());
+    }
+
+
+    // integer kernel for byte boundary maps, iterates over the flat (row-major) arrays
+    // and caches the last edge lookup per axis, because consecutive boundary voxels
+    // mostly belong to the same edge
     template<class INPUT, class LABELS>
     inline void accumulateBoundariesImplByte(const Graph & graph,
                                              const xt::xtensor<INPUT, 3> & data,
                                              const xt::xtensor<LABELS, 3> & labels,
                                              const CoordType & blockShape,
                                              const bool ignoreLabel,
-                                             AccumulatorVector & accumulators) {
-        const int pass = 1;
-        nifty::tools::forEachCoordinate(blockShape,[&](const CoordType & coord) {
-            const NodeType lU = xtensor::read(labels, coord.asStdArray());
-            if(lU == 0 && ignoreLabel) {
-                return;
-            }
-            CoordType coord2;
-            for(std::size_t axis = 0; axis < 3; ++axis){
-                makeCoord2(coord, coord2, axis);
-                if(coord2[axis] < blockShape[axis]){
-                    const NodeType lV = xtensor::read(labels, coord2.asStdArray());
-                    if(lV == 0 && ignoreLabel) {
-                        return;
+                                             ByteEdgeAccumulators & accumulators) {
+        const std::array<int64_t, 3> strides = {blockShape[1] * blockShape[2], blockShape[2], 1};
+        const LABELS * labelsPtr = &labels(0, 0, 0);
+        const INPUT * dataPtr = &data(0, 0, 0);
+
+        std::array<NodeType, 3> lastU = {0, 0, 0};
+        std::array<NodeType, 3> lastV = {0, 0, 0};
+        std::array<EdgeIndexType, 3> lastEdge = {-1, -1, -1};
+
+        std::array<int64_t, 3> coord;
+        int64_t pos = 0;
+        for(coord[0] = 0; coord[0] < blockShape[0]; ++coord[0]) {
+            for(coord[1] = 0; coord[1] < blockShape[1]; ++coord[1]) {
+                for(coord[2] = 0; coord[2] < blockShape[2]; ++coord[2], ++pos) {
+                    const NodeType lU = labelsPtr[pos];
+                    if(lU == 0 && ignoreLabel) {
+                        continue;
                     }
-                    if(lU != lV){
-                        const EdgeIndexType edge = graph.findEdge(lU, lV);
-                        const auto fU = xtensor::read(data, coord.asStdArray());
-                        const auto fV = xtensor::read(data, coord2.asStdArray());
-                        FeatureType fUf = static_cast<FeatureType>(fU);
-                        FeatureType fVf = static_cast<FeatureType>(fV);
-                        accumulators[edge].updatePassN(fUf / 255., pass);
-                        accumulators[edge].updatePassN(fVf / 255., pass);
+                    for(std::size_t axis = 0; axis < 3; ++axis) {
+                        if(coord[axis] + 1 >= blockShape[axis]) {
+                            continue;
+                        }
+                        const int64_t pos2 = pos + strides[axis];
+                        const NodeType lV = labelsPtr[pos2];
+                        // as in the graph extraction, an ignore label neighbor skips the remaining axes
+                        if(lV == 0 && ignoreLabel) {
+                            break;
+                        }
+                        if(lU != lV) {
+                            if(lU != lastU[axis] || lV != lastV[axis]) {
+                                lastU[axis] = lU;
+                                lastV[axis] = lV;
+                                lastEdge[axis] = graph.findEdge(lU, lV);
+                            }
+                            accumulators.update(lastEdge[axis], static_cast<uint8_t>(dataPtr[pos]));
+                            accumulators.update(lastEdge[axis], static_cast<uint8_t>(dataPtr[pos2]));
+                        }
                     }
                 }
             }
-        });
+        }
     }
 
 
-    template<class INPUT, class LABELS>
+    template<class INPUT, class LABELS, class ACCUMULATORS>
     inline void accumulateBoundariesImplFloat(const Graph & graph,
                                               const INPUT & data,
                                               const LABELS & labels,
                                               const CoordType & blockShape,
                                               const bool ignoreLabel,
-                                              AccumulatorVector & accumulators) {
-        const int pass = 1;
+                                              ACCUMULATORS & accumulators) {
         nifty::tools::forEachCoordinate(blockShape,[&](const CoordType & coord) {
             const NodeType lU = xtensor::read(labels, coord.asStdArray());
             if(lU == 0 && ignoreLabel) {
@@ -210,10 +660,8 @@ namespace distributed {
                         const EdgeIndexType edge = graph.findEdge(lU, lV);
                         const auto fU = xtensor::read(data, coord.asStdArray());
                         const auto fV = xtensor::read(data, coord2.asStdArray());
-                        FeatureType fUf = static_cast<FeatureType>(fU);
-                        FeatureType fVf = static_cast<FeatureType>(fV);
-                        accumulators[edge].updatePassN(fUf, pass);
-                        accumulators[edge].updatePassN(fVf, pass);
+                        updateEdgeAccumulator(accumulators, edge, normalizeInput(fU));
+                        updateEdgeAccumulator(accumulators, edge, normalizeInput(fV));
                     }
                 }
             }
@@ -221,7 +669,9 @@ namespace distributed {
     }
 
 
-    // accumulate simple boundary map
+    // accumulate simple boundary map;
+    // uint8 input is accumulated with the integer kernel and the features are computed from the sketches
+    // (see `ByteEdgeAccumulators`), unless 'vigraFeatures' requests the vigra accumulators
     template<class InputType>
     inline void accumulateBoundaryMap(const Graph & graph,
                                       std::unique_ptr<z5::Dataset> dataDs,
@@ -232,7 +682,9 @@ namespace distributed {
                                       const FeatureType dataMin,
                                       const FeatureType dataMax,
                                       const bool ignoreLabel,
-                                      const bool increaseRoi=false) {
+                                      const bool increaseRoi=false,
+                                      const bool asSketches=false,
+                                      const bool vigraFeatures=false) {
         // xtensor typedegs
         typedef xt::xtensor<NodeType, 3> LabelArray;
         typedef xt::xtensor<InputType, 3> DataArray;
@@ -263,6 +715,33 @@ namespace distributed {
         z5::multiarray::readSubarray<InputType>(dataDs, data, actualRoiBegin.begin());
         z5::multiarray::readSubarray<NodeType>(labelsDs, labels, actualRoiBegin.begin());
 
+        const bool byteInput = typeid(InputType) == typeid(uint8_t);
+
+        // integer accumulation for byte input,
+        // the features are computed from the sketches
+        if(byteInput && !vigraFeatures) {
+            ByteEdgeAccumulators byteAccumulators(graph.numberOfEdges(), dataMin, dataMax);
+            accumulateBoundariesImplByte(graph, data, labels, blockShape,
+                                         ignoreLabel, byteAccumulators);
+            EdgeFeatureSketches sketches(graph.numberOfEdges(), dataMin, dataMax);
+            byteAccumulators.mergeInto(sketches);
+            if(asSketches) {
+                sketches.serialize(blockStoragePath);
+            } else {
+                serializeSketchFeatures(sketches, blockStoragePath);
+            }
+            return;
+        }
+
+        // accumulate and serialize the mergeable sketches
+        if(asSketches) {
+            EdgeFeatureSketches sketches(graph.numberOfEdges(), dataMin, dataMax);
+            accumulateBoundariesImplFloat(graph, data, labels, blockShape,
+                                          ignoreLabel, sketches);
+            sketches.serialize(blockStoragePath);
+            return;
+        }
+
         // create nifty accumulator vector
         AccumulatorVector accumulators(graph.numberOfEdges());
         HistogramOptions histogramOpts;
@@ -271,22 +750,17 @@ namespace distributed {
             accumulator.setHistogramOptions(histogramOpts);
         }
 
-        const bool byteInput = typeid(InputType) == typeid(uint8_t);
-
         // accumulate
-        if(byteInput) {
-            accumulateBoundariesImplByte(graph, data, labels, blockShape,
-                                         ignoreLabel, accumulators);
-        } else {
-            accumulateBoundariesImplFloat(graph, data, labels, blockShape,
-                                          ignoreLabel, accumulators);
-        }
+        accumulateBoundariesImplFloat(graph, data, labels, blockShape,
+                                      ignoreLabel, accumulators);
 
         // serialize the accumulators
         serializeDefaultEdgeFeatures(accumulators, blockStoragePath);
     }
 
 
+    // integer kernel for byte affinity maps, iterates over the flat (row-major) arrays
+    // channel by channel and caches the last edge lookup
     template<class AFFS, class LABELS>
     inline void accumulateAffinitiesImplByte(const Graph & graph,
                                              const AFFS & affs,
@@ -294,55 +768,61 @@ namespace distributed {
                                              const AffCoordType & affBlockShape,
                                              const std::vector<OffsetType> & offsets,
                                              const bool ignoreLabel,
-                                             AccumulatorVector & accumulators) {
-        const int pass = 1;
-        // accumulate
-        nifty::tools::forEachCoordinate(affBlockShape, [&](const AffCoordType & affCoord) {
-
-            CoordType coord, coord2;
-            // the 0th affinitiy coordinate gives the channel index
-            const auto & offset = offsets[affCoord[0]];
+                                             ByteEdgeAccumulators & accumulators) {
+        const std::array<int64_t, 3> strides = {affBlockShape[2] * affBlockShape[3], affBlockShape[3], 1};
+        const int64_t channelSize = affBlockShape[1] * strides[0];
+        const auto * labelsPtr = &labels(0, 0, 0);
+        const auto * affsPtr = &affs(0, 0, 0, 0);
+
+        for(int64_t channel = 0; channel < affBlockShape[0]; ++channel) {
+            // the range of coordinates for which the offset coordinate is in the block
+            const auto & offset = offsets[channel];
+            std::array<int64_t, 3> begin, end;
+            int64_t offsetPos = 0;
             for(unsigned axis = 0; axis < 3; ++axis) {
-                coord[axis] = affCoord[axis + 1];
-                coord2[axis] = affCoord[axis + 1] + offset[axis];
-
-                // bounds check
-                if(coord2[axis] < 0 || coord2[axis] > affBlockShape[axis + 1]) {
-                    return;
-                }
-            }
-
-            const NodeType lU = xtensor::read(labels, coord.asStdArray());
-            const NodeType lV = xtensor::read(labels, coord2.asStdArray());
-
-            if(ignoreLabel && (lU == 0 || lV == 0)) {
-                return;
+                begin[axis] = std::max(-static_cast<int64_t>(offset[axis]), int64_t(0));
+                end[axis] = std::min(affBlockShape[axis + 1] - offset[axis], affBlockShape[axis + 1]);
+                offsetPos += offset[axis] * strides[axis];
             }
 
-            if(lU != lV){
-                // for long range affinites, the uv pair may not be part of the region graph
-                // so we need to check if the edge actually exists
-                const EdgeIndexType edge = graph.findEdge(lU, lV);
-                if(edge != -1) {
-                    uint8_t data = xtensor::read(affs, affCoord.asStdArray());
-                    FeatureType dataF = static_cast<FeatureType>(data) / 255.;
-                    accumulators[edge].updatePassN(dataF, pass);
+            NodeType lastU = 0, lastV = 0;
+            EdgeIndexType lastEdge = -1;
+            const auto * channelPtr = affsPtr + channel * channelSize;
+            for(int64_t z = begin[0]; z < end[0]; ++z) {
+                for(int64_t y = begin[1]; y < end[1]; ++y) {
+                    for(int64_t x = begin[2]; x < end[2]; ++x) {
+                        const int64_t pos = z * strides[0] + y * strides[1] + x;
+                        const NodeType lU = labelsPtr[pos];
+                        const NodeType lV = labelsPtr[pos + offsetPos];
+                        if(lU == lV || (ignoreLabel && (lU == 0 || lV == 0))) {
+                            continue;
+                        }
+                        // for long range affinites, the uv pair may not be part of the region graph
+                        // so we need to check if the edge actually exists
+                        if(lU != lastU || lV != lastV) {
+                            lastU = lU;
+                            lastV = lV;
+                            lastEdge = graph.findEdge(lU, lV);
+                        }
+                        if(lastEdge != -1) {
+                            accumulators.update(lastEdge, static_cast<uint8_t>(channelPtr[pos]));
+                        }
+                    }
                 }
             }
-        });
+        }
     }
 
 
-    template<class AFFS, class LABELS>
+    template<class AFFS, class LABELS, class ACCUMULATORS>
     inline void accumulateAffinitiesImplFloat(const Graph & graph,
                                               const AFFS & affs,
                                               const LABELS & labels,
                                               const AffCoordType & affBlockShape,
                                               const std::vector<OffsetType> & offsets,
                                               const bool ignoreLabel,
-                                              AccumulatorVector & accumulators) {
+                                              ACCUMULATORS & accumulators) {
         // accumulate
-        const int pass = 1;
         nifty::tools::forEachCoordinate(affBlockShape, [&](const AffCoordType & affCoord) {
 
             CoordType coord, coord2;
@@ -353,7 +833,7 @@ namespace distributed {
                 coord2[axis] = affCoord[axis + 1] + offset[axis];
 
                 // bounds check
-                if(coord2[axis] < 0 || coord2[axis] > affBlockShape[axis + 1]) {
+                if(coord2[axis] < 0 || coord2[axis] >= affBlockShape[axis + 1]) {
                     return;
                 }
             }
@@ -370,14 +850,16 @@ namespace distributed {
                 // so we need to check if the edge actually exists
                 const EdgeIndexType edge = graph.findEdge(lU, lV);
                 if(edge != -1) {
-                    accumulators[edge].updatePassN(xtensor::read(affs, affCoord.asStdArray()), pass);
+                    updateEdgeAccumulator(accumulators, edge, normalizeInput(xtensor::read(affs, affCoord.asStdArray())));
                 }
             }
         });
     }
 
 
-    // accumulate affinity maps
+    // accumulate affinity maps;
+    // uint8 input is accumulated with the integer kernel and the features are computed from the sketches
+    // (see `ByteEdgeAccumulators`), unless 'vigraFeatures' requests the vigra accumulators
     template<class InputType>
     inline void accumulateAffinityMap(const Graph & graph,
                                       std::unique_ptr<z5::Dataset> dataDs,
@@ -390,7 +872,9 @@ namespace distributed {
                                       const std::vector<std::size_t> & haloEnd,
                                       const FeatureType dataMin,
                                       const FeatureType dataMax,
-                                      const bool ignoreLabel) {
+                                      const bool ignoreLabel,
+                                      const bool asSketches=false,
+                                      const bool vigraFeatures=false) {
         // xtensor typedegs
         typedef xt::xtensor<NodeType, 3> LabelArray;
         typedef xt::xtensor<InputType, 4> DataArray;
@@ -426,29 +910,47 @@ namespace distributed {
         z5::multiarray::readSubarray<InputType>(dataDs, affs, affsBegin.begin());
         z5::multiarray::readSubarray<NodeType>(labelsDs, labels, beginWithHalo.begin());
 
-        // create nifty accumulator vector
-        AccumulatorVector accumulators(graph.numberOfEdges());
-        const int pass = 1;
-        HistogramOptions histogramOpts;
-        histogramOpts = histogramOpts.setMinMax(dataMin, dataMax);
-        for(auto & accumulator : accumulators) {
-            accumulator.setHistogramOptions(histogramOpts);
-        }
-
         const bool byteInput = typeid(InputType) == typeid(uint8_t);
 
-        // We need different accumulation for byte and float input
-        if(byteInput) {
+        // integer accumulation for byte input,
+        // the features are computed from the sketches
+        if(byteInput && !vigraFeatures) {
+            ByteEdgeAccumulators byteAccumulators(graph.numberOfEdges(), dataMin, dataMax);
             accumulateAffinitiesImplByte(graph, affs, labels,
                                          affBlockShape, offsets,
-                                         ignoreLabel, accumulators);
+                                         ignoreLabel, byteAccumulators);
+            EdgeFeatureSketches sketches(graph.numberOfEdges(), dataMin, dataMax);
+            byteAccumulators.mergeInto(sketches);
+            if(asSketches) {
+                sketches.serialize(blockStoragePath);
+            } else {
+                serializeSketchFeatures(sketches, blockStoragePath);
+            }
+            return;
         }
-        else {
+
+        // accumulate and serialize the mergeable sketches
+        if(asSketches) {
+            EdgeFeatureSketches sketches(graph.numberOfEdges(), dataMin, dataMax);
             accumulateAffinitiesImplFloat(graph, affs, labels,
                                           affBlockShape, offsets,
-                                          ignoreLabel, accumulators);
+                                          ignoreLabel, sketches);
+            sketches.serialize(blockStoragePath);
+            return;
+        }
+
+        // create nifty accumulator vector
+        AccumulatorVector accumulators(graph.numberOfEdges());
+        HistogramOptions histogramOpts;
+        histogramOpts = histogramOpts.setMinMax(dataMin, dataMax);
+        for(auto & accumulator : accumulators) {
+            accumulator.setHistogramOptions(histogramOpts);
         }
 
+        accumulateAffinitiesImplFloat(graph, affs, labels,
+                                      affBlockShape, offsets,
+                                      ignoreLabel, accumulators);
+
         // serialize the accumulators
         serializeDefaultEdgeFeatures(accumulators, blockStoragePath);
     }
@@ -469,10 +971,12 @@ namespace distributed {
                                                      const std::string & tmpFeatureStorage,
                                                      const FeatureType dataMin=0,
                                                      const FeatureType dataMax=1,
-                                                     const bool increaseRoi=false) {
+                                                     const bool increaseRoi=false,
+                                                     const bool asSketches=false,
+                                                     const bool vigraFeatures=false) {
 
         // TODO could also use the std::bind pattern and std::function
-        auto accumulator = [dataMin, dataMax, increaseRoi](
+        auto accumulator = [dataMin, dataMax, increaseRoi, asSketches, vigraFeatures](
                 const Graph & graph,
                 std::unique_ptr<z5::Dataset> dataDs,
                 std::unique_ptr<z5::Dataset> labelsDs,
@@ -484,7 +988,7 @@ namespace distributed {
             accumulateBoundaryMap<InputType>(graph, std::move(dataDs), std::move(labelsDs),
                                              roiBegin, roiEnd, blockStoragePath,
                                              dataMin, dataMax, ignoreLabel,
-                                             increaseRoi);
+                                             increaseRoi, asSketches, vigraFeatures);
         };
 
         extractBlockFeaturesImpl(blockPrefix,
@@ -505,7 +1009,9 @@ namespace distributed {
                                                      const std::string & tmpFeatureStorage,
                                                      const std::vector<OffsetType> & offsets,
                                                      const FeatureType dataMin=0,
-                                                     const FeatureType dataMax=1) {
+                                                     const FeatureType dataMax=1,
+                                                     const bool asSketches=false,
+                                                     const bool vigraFeatures=false) {
         // calculate max halos from the offsets
         std::vector<std::size_t> haloBegin(3), haloEnd(3);
         for(const auto & offset : offsets) {
@@ -520,7 +1026,7 @@ namespace distributed {
 
         // TODO could also use the std::bind pattern and std::function
         // TODO capture additional arguments that we need for serialization
-        auto accumulator = [dataMin, dataMax, &offsets, &haloBegin, &haloEnd](
+        auto accumulator = [dataMin, dataMax, asSketches, vigraFeatures, &offsets, &haloBegin, &haloEnd](
                 const Graph & graph,
                 std::unique_ptr<z5::Dataset> dataDs,
                 std::unique_ptr<z5::Dataset> labelsDs,
@@ -532,7 +1038,7 @@ namespace distributed {
             accumulateAffinityMap<InputType>(graph, std::move(dataDs), std::move(labelsDs),
                                              roiBegin, roiEnd, blockStoragePath,
                                              offsets, haloBegin, haloEnd,
-                                             dataMin, dataMax, ignoreLabel);
+                                             dataMin, dataMax, ignoreLabel, asSketches, vigraFeatures);
         };
 
         extractBlockFeaturesImpl(blockPrefix,
@@ -556,6 +1062,44 @@ namespace distributed {
     }
 
 
+    // the features of the block edges that map into [edgeIdBegin, edgeIdEnd)
+    struct BlockFeatureRows {
+        std::vector<EdgeIndexType> edgeIds;
+        xt::xtensor<FeatureType, 2> features;
+    };
+
+
+    // load the ids of the block edges in [edgeIdBegin, edgeIdEnd) and only the corresponding rows
+    // of the block features; the block edge ids are sorted (see `mapEdgeIds`),
+    // so these rows are contiguous
+    inline void loadBlockFeatureRows(const std::string & blockGraphPath,
+                                     const std::string & blockFeaturePath,
+                                     const std::size_t edgeIdBegin,
+                                     const std::size_t edgeIdEnd,
+                                     const std::size_t nFeatures,
+                                     BlockFeatureRows & rows) {
+        rows.edgeIds.clear();
+        if(!loadEdgeIndices(blockGraphPath, rows.edgeIds, 0)) {
+            return;
+        }
+        auto & edgeIds = rows.edgeIds;
+        const std::size_t rowBegin = std::lower_bound(edgeIds.begin(), edgeIds.end(),
+                                                      static_cast<EdgeIndexType>(edgeIdBegin)) - edgeIds.begin();
+        const std::size_t rowEnd = std::lower_bound(edgeIds.begin() + rowBegin, edgeIds.end(),
+                                                    static_cast<EdgeIndexType>(edgeIdEnd)) - edgeIds.begin();
+        edgeIds.erase(edgeIds.begin() + rowEnd, edgeIds.end());
+        edgeIds.erase(edgeIds.begin(), edgeIds.begin() + rowBegin);
+        if(edgeIds.empty()) {
+            return;
+        }
+
+        rows.features.resize({rowEnd - rowBegin, nFeatures});
+        const std::vector<std::size_t> rowOffset({rowBegin, 0});
+        auto featDs = z5::openDataset(blockFeaturePath);
+        z5::multiarray::readSubarray<FeatureType>(featDs, rows.features, rowOffset.begin());
+    }
+
+
     inline void mergeFeatType(const xt::xtensor<FeatureType, 2> & tmpFeatures,
                               xt::xtensor<FeatureType, 2> & targetFeatures,
                               const EdgeIndexType tmpId,  const EdgeIndexType targetId,
@@ -643,6 +1187,38 @@ namespace distributed {
     }
 
 
+    // write the features of the edges [edgeIdBegin, edgeIdBegin + features.shape()[0])
+    // to the output dataset, chunk by chunk in parallel
+    inline void serializeFeatureRange(const xt::xtensor<FeatureType, 2> & features,
+                                      const std::string & featuresOut,
+                                      const std::size_t edgeIdBegin,
+                                      nifty::parallel::ThreadPool & threadpool) {
+        auto dsOut = z5::openDataset(featuresOut);
+        const std::size_t nEdges = features.shape()[0];
+        const std::size_t nFeatures = features.shape()[1];
+        if(nEdges == 0) {
+            return;
+        }
+        const std::size_t chunkSize = dsOut->maxChunkShape()[0];
+        const std::size_t chunkBegin = edgeIdBegin / chunkSize;
+        const std::size_t chunkEnd = (edgeIdBegin + nEdges - 1) / chunkSize + 1;
+        nifty::parallel::parallel_foreach(threadpool, chunkEnd - chunkBegin, [&](const int tId,
+                                                                                const std::size_t chunkIndex){
+            const std::size_t chunkId = chunkBegin + chunkIndex;
+            const std::size_t edgeBegin = std::max(chunkId * chunkSize, edgeIdBegin);
+            const std::size_t edgeEnd = std::min((chunkId + 1) * chunkSize, edgeIdBegin + nEdges);
+            xt::xtensor<FeatureType, 2> chunkFeatures(Shape2Type({edgeEnd - edgeBegin, nFeatures}));
+            for(std::size_t edge = edgeBegin; edge < edgeEnd; ++edge) {
+                for(std::size_t featId = 0; featId < nFeatures; ++featId) {
+                    chunkFeatures(edge - edgeBegin, featId) = features(edge - edgeIdBegin, featId);
+                }
+            }
+            const std::vector<std::size_t> featOffset({edgeBegin, 0});
+            z5::multiarray::writeSubarray<FeatureType>(dsOut, chunkFeatures, featOffset.begin());
+        });
+    }
+
+
     inline void mergeEdgeFeaturesForBlocks(const std::string & graphBlockPrefix,
                                            const std::string & featureBlockPrefix,
                                            const std::size_t edgeIdBegin,
@@ -654,73 +1230,52 @@ namespace distributed {
         //
         const std::size_t nEdges = edgeIdEnd - edgeIdBegin;
         Shape2Type fShape = {nEdges, nFeatures};
-        Shape2Type tmpInit = {1, nFeatures};
 
         // initialize per thread data
-        const std::size_t nThreads = threadpool.nThreads();
+        const std::size_t nThreads = std::max<std::size_t>(threadpool.nThreads(), 1);
         struct PerThreadData {
             xt::xtensor<FeatureType, 2> features;
-            xt::xtensor<FeatureType, 2> tmpFeatures;
             std::vector<bool> edgeHasFeatures;
         };
         std::vector<PerThreadData> perThreadDataVector(nThreads);
         nifty::parallel::parallel_foreach(threadpool, nThreads, [&](const int t, const int tId){
             auto & ptd = perThreadDataVector[tId];
             ptd.features = xt::xtensor<FeatureType, 2>(fShape);
-            ptd.tmpFeatures = xt::xtensor<FeatureType, 2>(tmpInit);
             ptd.edgeHasFeatures = std::vector<bool>(nEdges, false);
         });
 
-        // iterate over the block ids
+        // each task merges a contiguous slice of the blocks and loads the rows
+        // of the next block asynchronously while merging the current one
         const std::size_t nBlocks = blockIds.size();
-        nifty::parallel::parallel_foreach(threadpool, nBlocks, [&](const int tId,
-                                                                   const int blockIndex){
-
+        const std::size_t nSlices = std::min(nThreads, nBlocks);
+        const auto loadRows = [&](const std::size_t blockIndex) {
             const std::size_t blockId = blockIds[blockIndex];
-
+            BlockFeatureRows rows;
+            loadBlockFeatureRows(graphBlockPrefix + std::to_string(blockId),
+                                 featureBlockPrefix + std::to_string(blockId),
+                                 edgeIdBegin, edgeIdEnd, nFeatures, rows);
+            return rows;
+        };
+        nifty::parallel::parallel_foreach(threadpool, nSlices, [&](const int tId,
+                                                                   const int sliceId){
             auto & perThreadData = perThreadDataVector[tId];
             auto & features = perThreadData.features;
             auto & hasFeatures = perThreadData.edgeHasFeatures;
-            auto & blockFeatures = perThreadData.tmpFeatures;
 
-            // load edge ids for the block
-            const std::string blockGraphPath = graphBlockPrefix + std::to_string(blockId);
-            std::vector<EdgeIndexType> blockEdgeIndices;
-            loadEdgeIndices(blockGraphPath, blockEdgeIndices, 0);
-            const std::size_t nEdgesBlock = blockEdgeIndices.size();
-
-            // get mapping to dense edge ids for this block
-            std::unordered_map<EdgeIndexType, EdgeIndexType> toDenseBlockId;
-            std::size_t denseBlockId = 0;
-            for(EdgeIndexType edgeId : blockEdgeIndices) {
-                toDenseBlockId[edgeId] = denseBlockId;
-                ++denseBlockId;
-            }
-
-            // load features for the block
-            // first resize the tmp features, if necessary
-            const std::string blockFeaturePath = featureBlockPrefix + std::to_string(blockId);
-            if(blockFeatures.shape()[0] != nEdgesBlock) {
-                blockFeatures.resize({nEdgesBlock, nFeatures});
-            }
-
-            loadBlockFeatures(blockFeaturePath, blockFeatures);
-
-            // iterate over the edges in this block and merge edge features
-            // if they are in our edge range
-            for(EdgeIndexType edgeId : blockEdgeIndices) {
-                // only merge if we are in the edge range
-                if(edgeId >= edgeIdBegin && edgeId < edgeIdEnd) {
-                    // find the corresponding ids in the dense block edges
-                    // and in the dense edge range
-                    const EdgeIndexType rangeEdgeId = edgeId - edgeIdBegin;
-                    const EdgeIndexType blockEdgeId = toDenseBlockId[edgeId];
-
-                    mergeFeaturesForSingleEdge(blockFeatures, features,
-                                               blockEdgeId, rangeEdgeId, hasFeatures);
+            const std::size_t blockBegin = sliceId * nBlocks / nSlices;
+            const std::size_t blockEnd = (sliceId + 1) * nBlocks / nSlices;
+            auto nextRows = std::async(std::launch::async, loadRows, blockBegin);
+            for(std::size_t blockIndex = blockBegin; blockIndex < blockEnd; ++blockIndex) {
+                const BlockFeatureRows rows = nextRows.get();
+                if(blockIndex + 1 < blockEnd) {
+                    nextRows = std::async(std::launch::async, loadRows, blockIndex + 1);
+                }
+                // merge the edge features of the rows in our edge range
+                for(std::size_t row = 0; row < rows.edgeIds.size(); ++row) {
+                    mergeFeaturesForSingleEdge(rows.features, features,
+                                               row, rows.edgeIds[row] - edgeIdBegin, hasFeatures);
                 }
             }
-
         });
 
         // merge features for each edge
@@ -728,7 +1283,7 @@ namespace distributed {
         auto & hasFeatureVector = perThreadDataVector[0].edgeHasFeatures;
         nifty::parallel::parallel_foreach(threadpool, nEdges, [&](const int tId,
                                                                   const EdgeIndexType edgeId){
-            for(int threadId = 1; threadId < nThreads; ++threadId) {
+            for(std::size_t threadId = 1; threadId < nThreads; ++threadId) {
                 auto & perThreadData = perThreadDataVector[threadId];
                 if(perThreadData.edgeHasFeatures[edgeId]) {
                     mergeFeaturesForSingleEdge(perThreadData.features, features,
@@ -737,11 +1292,8 @@ namespace distributed {
             }
         });
 
-        // TODO we could parallelize this over the out chunks
         // serialize the edge features
-        auto dsOut = z5::openDataset(featuresOut);
-        const std::vector<std::size_t> featOffset({edgeIdBegin, 0});
-        z5::multiarray::writeSubarray<FeatureType>(dsOut, features, featOffset.begin());
+        serializeFeatureRange(features, featuresOut, edgeIdBegin, threadpool);
     }
 
 
@@ -752,58 +1304,27 @@ namespace distributed {
                                    nifty::parallel::ThreadPool & threadpool,
                                    std::vector<std::size_t> & relevantBlocks) {
 
-        const std::size_t nThreads = threadpool.nThreads();
-        std::vector<std::set<std::size_t>> perThreadData(nThreads);
-
+        // check for each block if its edge id range overlaps with ours
         const std::size_t numberOfBlocks = blockIds.size();
-
+        std::vector<uint8_t> isRelevant(numberOfBlocks, 0);
         nifty::parallel::parallel_foreach(threadpool, numberOfBlocks, [&](const int tId,
                                                                           const int blockIndex) {
-
-            const std::size_t blockId = blockIds[blockIndex];
-
-            const std::string blockPath = graphBlockPrefix + std::to_string(blockId);
-            std::vector<EdgeIndexType> blockEdgeIndices;
-            bool haveEdges = loadEdgeIndices(blockPath, blockEdgeIndices, 0);
-            if(!haveEdges) {
+            const std::string blockPath = graphBlockPrefix + std::to_string(blockIds[blockIndex]);
+            EdgeIndexType blockEdgeIdBegin, blockEdgeIdEnd;
+            if(!loadEdgeIdRange(blockPath, blockEdgeIdBegin, blockEdgeIdEnd)) {
                 return;
             }
-
-            // first we check, if the block has overlap with at least one of our edges
-            // (and thus if it is relevant) by a simple range check
-            // this is a bit tricky, because we have a dense input edge id range,
-            // however the id range in the block is not dense.
-            // hence, we project to a dense range in the block, which is fine for 
-            // just determining whether we have overlap
-
-            auto minmax = std::minmax_element(blockEdgeIndices.begin(), blockEdgeIndices.end());
-            EdgeIndexType blockMinEdge = *minmax.first;
-            EdgeIndexType blockMaxEdge = *minmax.second;
-
-            // TODO these things might be off by one index ...
-            // range check
-            bool rangeBeginIsBiggerBlock  = (edgeIdBegin > blockMinEdge) && (edgeIdBegin >= blockMaxEdge);
-            bool rangeBeginIsSmallerBlock = (edgeIdBegin < blockMinEdge) && (edgeIdBegin <= blockMaxEdge);
-
-            bool rangeEndIsBiggerBlock  = (edgeIdEnd > blockMinEdge) && (edgeIdEnd >= blockMaxEdge);
-            bool rangeEndIsSmallerBlock = (edgeIdEnd < blockMinEdge) && (edgeIdEnd <= blockMaxEdge);
-
-            if((rangeBeginIsBiggerBlock && rangeEndIsBiggerBlock) || ((rangeBeginIsSmallerBlock && rangeEndIsSmallerBlock))) {
-                return;
-            }
-
-            perThreadData[tId].insert(blockId);
+            isRelevant[blockIndex] = blockEdgeIdBegin < static_cast<EdgeIndexType>(edgeIdEnd) &&
+                                     blockEdgeIdEnd > static_cast<EdgeIndexType>(edgeIdBegin);
         });
 
-        // merge the relevant blocks
-        auto & relevantBlocksSet = perThreadData[0];
-        for(int tId = 1; tId < nThreads; ++tId) {
-            relevantBlocksSet.insert(perThreadData[tId].begin(), perThreadData[tId].end());
+        relevantBlocks.clear();
+        for(std::size_t blockIndex = 0; blockIndex < numberOfBlocks; ++blockIndex) {
+            if(isRelevant[blockIndex]) {
+                relevantBlocks.push_back(blockIds[blockIndex]);
+            }
         }
-
-        // write to the out vector
-        relevantBlocks.resize(relevantBlocksSet.size());
-        std::copy(relevantBlocksSet.begin(), relevantBlocksSet.end(), relevantBlocks.begin());
+        std::sort(relevantBlocks.begin(), relevantBlocks.end());
     }
 
 
@@ -833,6 +1354,71 @@ namespace distributed {
     }
 
 
+    // merge the feature sketches of the blocks (extracted with `asSketches`)
+    // for the edges in [edgeIdBegin, edgeIdEnd) and serialize the resulting
+    // 10 default features; in contrast to `mergeFeatureBlocks` this is exact
+    inline void mergeFeatureSketchBlocks(const std::string & graphBlockPrefix,
+                                         const std::string & featureBlockPrefix,
+                                         const std::string & featuresOut,
+                                         const std::vector<std::size_t> & blockIds,
+                                         const std::size_t edgeIdBegin,
+                                         const std::size_t edgeIdEnd,
+                                         const int numberOfThreads=1) {
+        // construct threadpool
+        nifty::parallel::ThreadPool threadpool(numberOfThreads);
+        const std::size_t nThreads = std::max<std::size_t>(threadpool.nThreads(), 1);
+
+        // find all the blocks that contain edges in the current range
+        std::vector<std::size_t> relevantBlocks;
+        findRelevantBlocks(graphBlockPrefix, blockIds,
+                           edgeIdBegin, edgeIdEnd, threadpool,
+                           relevantBlocks);
+        if(relevantBlocks.empty()) {
+            return;
+        }
+
+        // the histogram range is stored with the block sketches
+        const std::vector<std::string> keys = {"dataMin", "dataMax"};
+        nlohmann::json j;
+        z5::handle::Group group(featureBlockPrefix + std::to_string(relevantBlocks[0]));
+        z5::readAttributes(group, keys, j);
+        const FeatureType dataMin = j[keys[0]];
+        const FeatureType dataMax = j[keys[1]];
+
+        // merge the block sketches
+        const std::size_t nEdges = edgeIdEnd - edgeIdBegin;
+        std::vector<std::unique_ptr<EdgeFeatureSketches>> perThreadSketches(nThreads);
+        nifty::parallel::parallel_foreach(threadpool, nThreads, [&](const int t, const int tId){
+            perThreadSketches[tId].reset(new EdgeFeatureSketches(nEdges, dataMin, dataMax));
+        });
+
+        const std::size_t nBlocks = relevantBlocks.size();
+        nifty::parallel::parallel_foreach(threadpool, nBlocks, [&](const int tId,
+                                                                   const int blockIndex){
+            const std::size_t blockId = relevantBlocks[blockIndex];
+            const std::string blockGraphPath = graphBlockPrefix + std::to_string(blockId);
+            std::vector<EdgeIndexType> blockEdgeIndices;
+            loadEdgeIndices(blockGraphPath, blockEdgeIndices, 0);
+            perThreadSketches[tId]->mergeSerialized(featureBlockPrefix + std::to_string(blockId),
+                                                    blockEdgeIndices, edgeIdBegin);
+        });
+
+        // merge the sketches of the threads and compute the features
+        auto & sketches = *perThreadSketches[0];
+        xt::xtensor<FeatureType, 2> features(Shape2Type({nEdges, 10}));
+        nifty::parallel::parallel_foreach(threadpool, nEdges, [&](const int tId,
+                                                                  const EdgeIndexType edgeId){
+            for(std::size_t threadId = 1; threadId < nThreads; ++threadId) {
+                sketches.merge(edgeId, *perThreadSketches[threadId], edgeId);
+            }
+            sketches.computeFeatures(edgeId, features, edgeId);
+        });
+
+        // serialize the edge features
+        serializeFeatureRange(features, featuresOut, edgeIdBegin, threadpool);
+    }
+
+
     template<class INPUT, class LABELS, class FEATURES>
     inline void accumulateInput(const Graph & graph,
                                 const xt::xexpression<INPUT> & inputExp,
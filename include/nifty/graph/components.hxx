@@ -2,10 +2,12 @@
 
 
 #include <unordered_map>
+#include <vector>
 
 #include "nifty/graph/subgraph_mask.hxx"
 #include "nifty/graph/breadth_first_search.hxx"
-#include "nifty/ufd/ufd.hxx"
+#include "nifty/ufd/concurrent_ufd.hxx"
+#include "nifty/parallel/threadpool.hxx"
 
 
 namespace nifty{
@@ -32,51 +34,41 @@ public:
 
     template<class NODE_LABELS>
     uint64_t buildFromLabels(const NODE_LABELS & nodeLabels){
-        if(needsReset_)
-            this->reset();
-        for(auto edge : graph_.edges()){
-            const auto u = graph_.u(edge);
-            const auto v = graph_.v(edge);
-            if(nodeLabels[u] == nodeLabels[v]){
-                ufd_.merge(u,v);
-            }
-        }
-        needsReset_ = true;
-        return ufd_.numberOfSets() - offset_;
+        parallel::ThreadPool threadpool(0);
+        return buildFromLabels(nodeLabels, threadpool);
     }
+
+    template<class NODE_LABELS>
+    uint64_t buildFromLabels(const NODE_LABELS & nodeLabels, parallel::ThreadPool & threadpool){
+        return buildImpl(threadpool, [&](const uint64_t edge, const uint64_t u, const uint64_t v){
+            return nodeLabels[u] == nodeLabels[v];
+        });
+    }
+
     template<class EDGE_LABELS>
-    uint64_t buildFromEdgeLabels(
-        const EDGE_LABELS & edgeLabels
-    ){
-        if(needsReset_)
-            this->reset();
-        for(auto edge : graph_.edges()){
-            if(edgeLabels[edge] == 0){
-                const auto u = graph_.u(edge);
-                const auto v = graph_.v(edge);
-                ufd_.merge(u,v); 
-            }
-        }
-        needsReset_ = true;
-        return ufd_.numberOfSets() - offset_;
+    uint64_t buildFromEdgeLabels(const EDGE_LABELS & edgeLabels){
+        parallel::ThreadPool threadpool(0);
+        return buildFromEdgeLabels(edgeLabels, threadpool);
     }
 
+    template<class EDGE_LABELS>
+    uint64_t buildFromEdgeLabels(const EDGE_LABELS & edgeLabels, parallel::ThreadPool & threadpool){
+        return buildImpl(threadpool, [&](const uint64_t edge, const uint64_t u, const uint64_t v){
+            return edgeLabels[edge] == 0;
+        });
+    }
 
     template<class SUBGRAPH_MASK>
     uint64_t build(const SUBGRAPH_MASK & mask){
-        if(needsReset_)
-            this->reset();
-        for(auto edge : graph_.edges()){
-            if(mask.useEdge(edge)){
-                const auto u = graph_.u(edge);
-                const auto v = graph_.v(edge);
-                if(mask.useNode(u) && mask.useNode(v)){
-                    ufd_.merge(u,v);
-                }
-            }
-        }
-        needsReset_ = true;
-        return ufd_.numberOfSets() - offset_;
+        parallel::ThreadPool threadpool(0);
+        return build(mask, threadpool);
+    }
+
+    template<class SUBGRAPH_MASK>
+    uint64_t build(const SUBGRAPH_MASK & mask, parallel::ThreadPool & threadpool){
+        return buildImpl(threadpool, [&](const uint64_t edge, const uint64_t u, const uint64_t v){
+            return mask.useEdge(edge) && mask.useNode(u) && mask.useNode(v);
+        });
     }
 
     void reset(){
@@ -144,6 +136,34 @@ public:
     
     }
 
+    // parallel dense relabeling, gives the same labels as the serial one
+    template<class NODE_MAP>
+    void denseRelabeling(
+        NODE_MAP & nodeMap,
+        parallel::ThreadPool & threadpool
+    )const{
+
+        std::vector<uint64_t> denseLabels(ufd_.numberOfElements());
+        ufd_.representativeLabeling(denseLabels, threadpool);
+
+        forEachNodeImpl(threadpool, [&](const uint64_t node){
+            nodeMap[node] = denseLabels[this->componentLabel(node)] - offset_;
+        });
+    }
+
+    template<class NODE_MAP,class COMP_SIZE>
+    void denseRelabeling(
+        NODE_MAP & nodeMap,
+        COMP_SIZE & compSize,
+        parallel::ThreadPool & threadpool
+    )const{
+
+        denseRelabeling(nodeMap, threadpool);
+        for(const auto node : graph_.nodes()){
+            compSize[nodeMap[node]] += 1;
+        }
+    }
+
     const GraphType & graph()const{
         return graph_;
     }
@@ -151,8 +171,54 @@ public:
 
 
 private:
+
+    // merge u and v for all edges with f(edge, u, v) == true;
+    // the ufd supports concurrent merges, so the edges are
+    // processed in parallel if the edge ids are dense
+    template<class F>
+    uint64_t buildImpl(parallel::ThreadPool & threadpool, F && f){
+        if(needsReset_)
+            ufd_.reset(threadpool);
+        const auto mergeEdge = [&](const uint64_t edge){
+            const auto u = graph_.u(edge);
+            const auto v = graph_.v(edge);
+            if(f(edge, u, v)){
+                ufd_.merge(u, v);
+            }
+        };
+        const uint64_t nEdges = graph_.numberOfEdges();
+        if(threadpool.nThreads() > 1 && nEdges == uint64_t(graph_.edgeIdUpperBound() + 1)){
+            parallel::parallel_foreach(threadpool, nEdges, [&](const int tid, const int64_t edge){
+                mergeEdge(edge);
+            });
+        }
+        else{
+            for(const auto edge : graph_.edges()){
+                mergeEdge(edge);
+            }
+        }
+        needsReset_ = true;
+        return ufd_.numberOfSets() - offset_;
+    }
+
+    // call f(node) for all nodes, in parallel if the node ids are dense
+    template<class F>
+    void forEachNodeImpl(parallel::ThreadPool & threadpool, F && f)const{
+        const uint64_t nNodes = graph_.numberOfNodes();
+        if(threadpool.nThreads() > 1 && nNodes == uint64_t(graph_.nodeIdUpperBound() + 1)){
+            parallel::parallel_foreach(threadpool, nNodes, [&](const int tid, const int64_t node){
+                f(node);
+            });
+        }
+        else{
+            for(const auto node : graph_.nodes()){
+                f(node);
+            }
+        }
+    }
+
     const GraphType & graph_;
-    nifty::ufd::Ufd< > ufd_;
+    nifty::ufd::ConcurrentUfd< > ufd_;
     uint64_t offset_;
     bool needsReset_;
 };
@@ -164,10 +164,11 @@ namespace detail_watersheds_segmentation{
             ++c;
         }
 
-        // sort
+        // sort, ties are broken by the edge id to make the result
+        // deterministic (and equal to parallelEdgeWeightedWatershedsSegmentation)
         std::sort(indexedWeights.begin(), indexedWeights.end(), 
             [](const IndexedWeight & a, const IndexedWeight & b) {
-                return a.second < b.second;   
+                return a.second < b.second || (a.second == b.second && a.first < b.first);
             }
         ); 
 
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "nifty/tools/logging.hxx"
+#include "nifty/graph/opt/common/visitor_base.hxx"
+
+
+namespace nifty{
+namespace graph{
+namespace opt{
+namespace common{
+
+
+    // stopping rules of a chain of solvers
+    // (shared by the multicut and lifted multicut ChainedSolvers)
+    struct ChainedSolversSettings{
+        // time limit in seconds for the whole chain, it is checked between the solvers
+        // and passed to the solvers through the visitor
+        double timeLimit{std::numeric_limits<double>::infinity()};
+        // stop once the energy is at most targetEnergy
+        double targetEnergy{-std::numeric_limits<double>::infinity()};
+        // stop after this many consecutive solvers that improved the
+        // energy by no more than minImprovement
+        std::size_t maxNumberOfStagesWithoutImprovement{std::numeric_limits<std::size_t>::max()};
+        double minImprovement{0.0};
+        // if a solver returns a worse solution than its warm start, the warm start is kept
+        bool restoreBest{true};
+    };
+
+
+    // forwards everything but begin and end to the visitor
+    // and stops the current solver once the time limit of the chain is exceeded
+    template<class SOLVER_BASE>
+    class NoBeginEndVisitor : public VisitorBase<SOLVER_BASE>{
+    public:
+        typedef SOLVER_BASE SolverBaseType;
+        typedef VisitorBase<SolverBaseType> VisitorBaseType;
+        typedef std::chrono::steady_clock ClockType;
+
+        NoBeginEndVisitor(VisitorBaseType * visitor,
+                          const ClockType::time_point & startTime,
+                          const double timeLimit)
+        :   visitor_(visitor),
+            startTime_(startTime),
+            timeLimit_(timeLimit){
+        }
+
+        virtual void begin(SolverBaseType * solver) {
+            // nothing
+        }
+        virtual bool visit(SolverBaseType * solver) {
+            const bool runOpt = visitor_ != nullptr ? visitor_->visit(solver) : true;
+            return runOpt && !timeLimitExceeded();
+        }
+        bool timeLimitExceeded() const{
+            return std::chrono::duration<double>(ClockType::now() - startTime_).count() >= timeLimit_;
+        }
+        virtual void end(SolverBaseType * solver)   {
+            // nothing
+        }
+
+        virtual void clearLogNames(){
+            if(visitor_ != nullptr)
+                visitor_->clearLogNames();
+        }
+        virtual void addLogNames(std::initializer_list<std::string> logNames){
+            if(visitor_ != nullptr)
+                visitor_->addLogNames(logNames);
+        }
+
+        virtual void setLogValue(const std::size_t logIndex, double logValue){
+            if(visitor_ != nullptr)
+                visitor_->setLogValue(logIndex, logValue);
+        }
+
+        virtual void printLog(const nifty::logging::LogLevel logLevel, const std::string & logString){
+            if(visitor_ != nullptr)
+                visitor_->printLog(logLevel, logString);
+        }
+
+    private:
+        VisitorBaseType * visitor_;
+        ClockType::time_point startTime_;
+        double timeLimit_;
+    };
+
+
+    // Run the solvers created by the factories one after another on the objective of 'chain',
+    // each solver is warm started with the best node labeling so far.
+    // The chain stops early according to the settings.
+    template<class SOLVER_BASE, class FACTORY_PTR>
+    void optimizeChainedSolvers(
+        SOLVER_BASE * chain,
+        const std::vector<FACTORY_PTR> & factories,
+        const ChainedSolversSettings & settings,
+        typename SOLVER_BASE::NodeLabelsType & nodeLabels,
+        typename SOLVER_BASE::VisitorBaseType * visitor
+    ){
+        typedef typename SOLVER_BASE::NodeLabelsType NodeLabelsType;
+        typedef NoBeginEndVisitor<SOLVER_BASE> NoBeginEndVisitorType;
+
+        const auto & objective = chain->objective();
+        typename SOLVER_BASE::VisitorProxyType visitorProxy(visitor);
+        NoBeginEndVisitorType noBeginEndVisitor(visitor, NoBeginEndVisitorType::ClockType::now(), settings.timeLimit);
+        // a visitor is only passed to the solvers if there is one or if it enforces the time limit
+        const bool useVisitor = visitor != nullptr || settings.timeLimit < std::numeric_limits<double>::infinity();
+
+        visitorProxy.begin(chain);
+
+        double bestEnergy = objective.evalNodeLabels(nodeLabels);
+        NodeLabelsType bestNodeLabels(nodeLabels);
+        std::size_t stagesWithoutImprovement = 0;
+
+        for(auto & factory : factories){
+
+            if(noBeginEndVisitor.timeLimitExceeded()){
+                visitorProxy.printLog(nifty::logging::LogLevel::INFO, "Time limit of the chain exceeded");
+                break;
+            }
+            if(bestEnergy <= settings.targetEnergy){
+                visitorProxy.printLog(nifty::logging::LogLevel::INFO, "Target energy reached");
+                break;
+            }
+            if(stagesWithoutImprovement >= settings.maxNumberOfStagesWithoutImprovement){
+                visitorProxy.printLog(nifty::logging::LogLevel::INFO, "Solvers stopped improving");
+                break;
+            }
+
+            auto solver = factory->create(objective);
+            visitorProxy.printLog(nifty::logging::LogLevel::INFO,
+                std::string("Starting Solver: ")+solver->name());
+
+            if(visitor != nullptr){
+                visitor->clearLogNames();
+            }
+            solver->optimize(nodeLabels, useVisitor ? &noBeginEndVisitor : nullptr);
+            delete solver;
+
+            // the next solver is warm started with the best solution so far
+            const double energy = objective.evalNodeLabels(nodeLabels);
+            if(bestEnergy - energy > settings.minImprovement){
+                stagesWithoutImprovement = 0;
+            }
+            else{
+                ++stagesWithoutImprovement;
+            }
+            if(energy <= bestEnergy || !settings.restoreBest){
+                bestEnergy = energy;
+                std::copy(nodeLabels.begin(), nodeLabels.end(), bestNodeLabels.begin());
+            }
+            else{
+                std::copy(bestNodeLabels.begin(), bestNodeLabels.end(), nodeLabels.begin());
+            }
+        }
+
+        visitorProxy.end(chain);
+    }
+
+
+} // namespace nifty::graph::opt::common
+} // namespace nifty::graph::opt
+} // namespace nifty::graph
+} // namespace nifty
@@ -336,6 +336,246 @@ namespace detail_kernighang_lin{
 
 
 
+    // Variant of TwoCut which keeps all scratch data in compact
+    // arrays indexed by the position of a node in A + B instead of
+    // graph sized node maps. It never writes the global vertex labels,
+    // the caller has to assign labelA / labelB to the nodes in A / B
+    // after the call. Therefore one instance per thread can work
+    // on disjoint pairs of partitions at the same time.
+    //
+    // A node is only considered part of the pair if its
+    // (read only) global label is labelA or labelB and it can
+    // be found in A + B, all other nodes are treated as foreign.
+    // The shared localIndex map is only written for nodes in A + B.
+    template<class OBJECTIVE>
+    class CompactTwoCut{
+    public:
+        typedef OBJECTIVE ObjectiveType;
+        typedef typename ObjectiveType::GraphType GraphType;
+        typedef typename ObjectiveType::WeightsMap WeightsMap;
+        typedef typename ObjectiveType::LiftedGraphType LiftedGraphType;
+        typedef typename TwoCut<ObjectiveType>::SettingsType SettingsType;
+
+        struct Move{
+            int64_t v { -1 };
+            double difference { std::numeric_limits<double>::lowest() };
+            uint8_t newSide;
+
+            void updateDifference(const uint64_t var, const double diff){
+                if(diff > difference){
+                    v = var;
+                    difference = diff;
+                }
+            }
+        };
+
+        CompactTwoCut(
+            const ObjectiveType & objective,
+            const SettingsType & settings = SettingsType()
+        )
+        :   settings_(settings),
+            graph_(objective.graph()),
+            liftedGraph_(objective.liftedGraph()),
+            weights_(objective.weights()),
+            nodes_(),
+            differences_(),
+            isMoved_(),
+            referencedBy_(),
+            side_(),
+            border_(),
+            moves_(){
+        }
+
+        template<class VERTEX_LABELS, class LOCAL_INDEX>
+        double optimizeTwoCut(
+            std::vector<uint64_t> & A,
+            std::vector<uint64_t> & B,
+            const uint64_t labelA,
+            const uint64_t labelB,
+            const VERTEX_LABELS & vertexLabels,
+            LOCAL_INDEX & localIndex
+        ){
+            if (A.empty()){
+                return .0;
+            }
+
+            // fill the compact buffers, A is side 0, B is side 1
+            const std::size_t sizeA = A.size();
+            const std::size_t nLocal = sizeA + B.size();
+            nodes_.resize(nLocal);
+            differences_.resize(nLocal);
+            isMoved_.resize(nLocal);
+            referencedBy_.resize(nLocal);
+            side_.resize(nLocal);
+            for(std::size_t i = 0; i < nLocal; ++i){
+                const auto node = i < sizeA ? A[i] : B[i - sizeA];
+                nodes_[i] = node;
+                side_[i] = i < sizeA ? 0 : 1;
+                localIndex[node] = i;
+            }
+
+            // local index of a node or -1 if the node is not in A + B
+            auto localOf = [&](const uint64_t node) -> int64_t {
+                const auto label = vertexLabels[node];
+                if(label != labelA && label != labelB){
+                    return -1;
+                }
+                const std::size_t i = localIndex[node];
+                return (i < nLocal && nodes_[i] == node) ? int64_t(i) : int64_t(-1);
+            };
+
+            auto gainFromMerging = 0.0;
+            for(std::size_t i = 0; i < nLocal; ++i){
+                const auto var = nodes_[i];
+                double diffExt = 0.0;
+                double diffInt = 0.0;
+                uint64_t refCnt = 0;
+
+                for(auto adj : liftedGraph_.adjacency(var)){
+                    const auto j = localOf(adj.node());
+                    if(j < 0){
+                        continue;
+                    }
+                    if(side_[j] == side_[i]){
+                        diffInt += weights_[adj.edge()];
+                    }
+                    else{
+                        diffExt += weights_[adj.edge()];
+                    }
+                }
+
+                for(auto adj : graph_.adjacency(var)){
+                    const auto j = localOf(adj.node());
+                    if(j >= 0 && side_[j] != side_[i])
+                        ++refCnt;
+                }
+
+                differences_[i] = diffExt - diffInt;
+                referencedBy_[i] = refCnt;
+                isMoved_[i] = 0;
+                gainFromMerging += diffExt;
+            }
+            gainFromMerging /= 2.0;
+
+            // compute border
+            border_.clear();
+            for(std::size_t i = 0; i < nLocal; ++i)
+                if (referencedBy_[i] > 0)
+                    border_.push_back(i);
+
+            moves_.clear();
+            double cumulativeDiff = .0;
+            std::pair<double, std::size_t> maxMove { std::numeric_limits<double>::lowest(), 0 };
+
+            for (std::size_t k = 0; k < settings_.numberOfIterations; ++k){
+
+                Move m;
+                if(B.empty() && k == 0){
+                    for(std::size_t i = 0; i < sizeA; ++i){
+                        m.updateDifference(i, differences_[i]);
+                    }
+                }
+                else{
+                    uint64_t borderSize =  border_.size();
+                    for (std::size_t i = 0; i < borderSize; ){
+                        if (referencedBy_[border_[i]] == 0)
+                            std::swap(border_[i], border_[--borderSize]);
+                        else{
+                            m.updateDifference(border_[i], differences_[border_[i]]);
+                            ++i;
+                        }
+                    }
+                    border_.erase(border_.begin() + borderSize, border_.end());
+                }
+
+                if(m.v == -1)
+                    break;
+
+                const auto oldSide = side_[m.v];
+                m.newSide = 1 - oldSide;
+
+                // update differences and references
+                for(const auto adj : liftedGraph_.adjacency(nodes_[m.v])){
+                    const auto j = localOf(adj.node());
+                    if(j < 0 || isMoved_[j])
+                        continue;
+                    if (side_[j] == m.newSide)
+                        differences_[j] -= 2.0*weights_[adj.edge()];
+                    else
+                        differences_[j] += 2.0*weights_[adj.edge()];
+                }
+
+                for(const auto adj : graph_.adjacency(nodes_[m.v])){
+                    const auto j = localOf(adj.node());
+                    if(j < 0 || isMoved_[j])
+                        continue;
+                    if (side_[j] == m.newSide)
+                        --referencedBy_[j];
+                    else{
+                        ++referencedBy_[j];
+                        if (referencedBy_[j] == 1)
+                            border_.push_back(j);
+                    }
+                }
+
+                side_[m.v] = m.newSide;
+                referencedBy_[m.v] = 0;
+                differences_[m.v] = std::numeric_limits<double>::lowest();
+                isMoved_[m.v] = 1;
+                moves_.push_back(m);
+
+                cumulativeDiff += m.difference;
+                if (cumulativeDiff > maxMove.first){
+                    maxMove = std::make_pair(cumulativeDiff, moves_.size());
+                }
+            }
+
+            if (gainFromMerging > maxMove.first && gainFromMerging > settings_.epsilon)
+            {
+                A.insert(A.end(), B.begin(), B.end());
+                B.clear();
+                return gainFromMerging;
+            }
+            else if (maxMove.first > settings_.epsilon)
+            {
+                // revert the moves after the best prefix
+                for (std::size_t i = maxMove.second; i < moves_.size(); ++i)
+                    isMoved_[moves_[i].v] = 0;
+
+                A.clear();
+                B.clear();
+                for(std::size_t i = 0; i < nLocal; ++i)
+                    if(!isMoved_[i])
+                        (i < sizeA ? A : B).push_back(nodes_[i]);
+
+                for (std::size_t i = 0; i < maxMove.second; ++i)
+                    // move vertex to the other set
+                    if (moves_[i].newSide == 1)
+                        B.push_back(nodes_[moves_[i].v]);
+                    else
+                        A.push_back(nodes_[moves_[i].v]);
+
+                return maxMove.first;
+            }
+            return .0;
+        }
+
+    private:
+        SettingsType settings_;
+        const GraphType & graph_;
+        const LiftedGraphType & liftedGraph_;
+        const WeightsMap & weights_;
+
+        std::vector<uint64_t> nodes_;
+        std::vector<double>   differences_;
+        std::vector<uint8_t>  isMoved_;
+        std::vector<uint64_t> referencedBy_;
+        std::vector<uint8_t>  side_;
+        std::vector<uint64_t> border_;
+        std::vector<Move> moves_;
+    };
+
+
 } // end namespace detail_kernighang_lin   
 // \endcond
 
@@ -14,6 +14,7 @@
 #include "nifty/tools/changable_priority_queue.hxx"
 
 #include "nifty/tools/runtime_check.hxx"
+#include "nifty/parallel/threadpool.hxx"
 #include "nifty/ufd/ufd.hxx"
 #include "nifty/graph/detail/adjacency.hxx"
 #include "nifty/graph/opt/lifted_multicut/lifted_multicut_base.hxx"
@@ -50,6 +51,7 @@ namespace lifted_multicut{
         typedef detail_kernighang_lin::TwoCut<ObjectiveType> TwoCutType;
         typedef ComponentsUfd<GraphType> ComponentsType;
         typedef detail_kernighang_lin::TwoCutBuffers<GraphType> TwoCutBuffersType;
+        typedef detail_kernighang_lin::CompactTwoCut<ObjectiveType> CompactTwoCutType;
 
         typedef subgraph_masks::SubgraphWithCutFromNodeLabels<GraphType, NodeLabelsType> SubgraphWithCut;
 
@@ -62,6 +64,9 @@ namespace lifted_multicut{
             std::size_t numberOfInnerIterations { std::numeric_limits<std::size_t>::max() };
             std::size_t numberOfOuterIterations { 100 };
             double epsilon { 1e-7 };
+            // with more than one thread, non-overlapping pairs of
+            // partitions are improved concurrently
+            int numberOfThreads { 1 };
         };
 
 
@@ -81,8 +86,10 @@ namespace lifted_multicut{
         void initializePartiton();
         void buildRegionAdjacencyGraph();
         void optimizePairs(double & energyDecrease);
+        void optimizePairsParallel(double & energyDecrease);
 
         void introduceNewPartitions(double & energyDecrease);
+        void introduceNewPartitionsParallel(double & energyDecrease);
         void connectedComponentLabeling();
         bool hasChanges();
 
@@ -114,6 +121,15 @@ namespace lifted_multicut{
         std::vector<std::unordered_set<uint64_t> > edges_;
 
         uint64_t numberOfComponents_;
+
+        nifty::parallel::ParallelOptions parallelOptions_;
+        nifty::parallel::ThreadPool threadPool_;
+
+        // per thread two-cut with compact scratch buffers
+        std::vector<CompactTwoCutType> compactTwoCuts_;
+
+        // position of a node within the pair it is currently optimized in
+        typename GraphType:: template NodeMap<uint64_t>  localIndex_;
     };
 
     
@@ -138,9 +154,19 @@ namespace lifted_multicut{
         visited_(objective.graph()),
         changed_(),
         edges_(),
-        numberOfComponents_(0)
+        numberOfComponents_(0),
+        parallelOptions_(settings.numberOfThreads),
+        threadPool_(parallelOptions_),
+        compactTwoCuts_(),
+        localIndex_(objective.graph(), 0)
     {
-
+        const auto numberOfThreads = parallelOptions_.getActualNumThreads();
+        if(numberOfThreads > 1){
+            compactTwoCuts_.reserve(numberOfThreads);
+            for(auto t = 0; t < numberOfThreads; ++t){
+                compactTwoCuts_.emplace_back(objective);
+            }
+        }
     }
 
     template<class OBJECTIVE>
@@ -171,8 +197,14 @@ namespace lifted_multicut{
             auto energyDecrease = 0.0;
 
             this->buildRegionAdjacencyGraph();
-            this->optimizePairs(energyDecrease);
-            this->introduceNewPartitions(energyDecrease);
+            if(parallelOptions_.getActualNumThreads() == 1){
+                this->optimizePairs(energyDecrease);
+                this->introduceNewPartitions(energyDecrease);
+            }
+            else{
+                this->optimizePairsParallel(energyDecrease);
+                this->introduceNewPartitionsParallel(energyDecrease);
+            }
 
             if(energyDecrease == .0)
                 break;
@@ -318,6 +350,107 @@ namespace lifted_multicut{
     }
 
 
+    // The pairs of adjacent partitions are scheduled in rounds
+    // such that no partition is used twice within one round (greedy edge coloring
+    // of the partition adjacency graph). Within a round all pairs
+    // are independent: a two-cut only changes the cost of edges
+    // inside the pair, so the energy decreases add up exactly.
+    // The labels of a round are written after all pairs of the
+    // round are finished, hence every two-cut sees a fixed labeling
+    // of the foreign nodes.
+    template<class OBJECTIVE>
+    inline void 
+    LiftedMulticutKernighanLin<OBJECTIVE>::
+    optimizePairsParallel(
+        double & energyDecrease
+    ){
+        typedef std::pair<uint64_t, uint64_t> PairType;
+
+        std::vector<PairType> pending;
+        for(uint64_t piU=0; piU<numberOfComponents_; ++piU){
+            if(!partitions_[piU].empty()){
+                for(const auto piV : edges_[piU]){
+                    if(!partitions_[piV].empty()){
+                        pending.emplace_back(piU, piV);
+                    }
+                }
+            }
+        }
+
+        const uint64_t noRound = std::numeric_limits<uint64_t>::max();
+        std::vector<uint64_t> usedInRound(numberOfComponents_, noRound);
+        std::vector<PairType> round;
+        std::vector<PairType> rest;
+        std::vector<uint64_t> labelsA, labelsB;
+        std::vector<double> gains;
+
+        for(uint64_t roundIndex = 0; !pending.empty(); ++roundIndex){
+
+            // greedily select non-overlapping pairs
+            round.clear();
+            rest.clear();
+            for(const auto & p : pending){
+                if(partitions_[p.first].empty() || partitions_[p.second].empty()){
+                    continue;
+                }
+                if(usedInRound[p.first] != roundIndex && usedInRound[p.second] != roundIndex &&
+                   (changed_[p.first] || changed_[p.second])){
+                    usedInRound[p.first]  = roundIndex;
+                    usedInRound[p.second] = roundIndex;
+                    round.push_back(p);
+                }
+                else{
+                    rest.push_back(p);
+                }
+            }
+            if(round.empty()){
+                break;
+            }
+            std::swap(pending, rest);
+
+            const auto nPairs = round.size();
+            labelsA.resize(nPairs);
+            labelsB.resize(nPairs);
+            gains.resize(nPairs);
+            for(std::size_t i = 0; i < nPairs; ++i){
+                labelsA[i] = twoCutBuffers_.vertexLabels[partitions_[round[i].first].front()];
+                labelsB[i] = twoCutBuffers_.vertexLabels[partitions_[round[i].second].front()];
+            }
+
+            // optimize the pairs of this round concurrently
+            parallel::parallel_foreach(threadPool_, nPairs, [&](const int tid, const int64_t i){
+                gains[i] = compactTwoCuts_[tid].optimizeTwoCut(
+                    partitions_[round[i].first], partitions_[round[i].second],
+                    labelsA[i], labelsB[i], twoCutBuffers_.vertexLabels, localIndex_
+                );
+            });
+
+            // write the labels of the changed pairs
+            parallel::parallel_foreach(threadPool_, nPairs, [&](const int tid, const int64_t i){
+                if(gains[i] > 0.0){
+                    for(const auto a : partitions_[round[i].first])
+                        twoCutBuffers_.vertexLabels[a] = labelsA[i];
+                    for(const auto b : partitions_[round[i].second])
+                        twoCutBuffers_.vertexLabels[b] = labelsB[i];
+                }
+            });
+
+            for(std::size_t i = 0; i < nPairs; ++i){
+                if(gains[i] > settings_.epsilon){
+                    changed_[round[i].first]  = 1;
+                    changed_[round[i].second] = 1;
+                }
+                energyDecrease += gains[i];
+            }
+        }
+
+        // remove partitions that became empty after the previous step
+        auto partionF =  [](const std::vector<uint64_t>& s) { return !s.empty(); };
+        auto newEnd = std::partition(partitions_.begin(), partitions_.end(), partionF);
+        partitions_.resize(newEnd - partitions_.begin());
+    }
+
+
     template<class OBJECTIVE>
     inline void 
     LiftedMulticutKernighanLin<OBJECTIVE>::
@@ -346,6 +479,48 @@ namespace lifted_multicut{
     }
 
     
+    // Each partition is split independently, the new partitions
+    // get their labels after all partitions are processed.
+    template<class OBJECTIVE>
+    inline void 
+    LiftedMulticutKernighanLin<OBJECTIVE>::
+    introduceNewPartitionsParallel(
+        double & energyDecrease
+    ){
+        const auto pSize = partitions_.size();
+        const uint64_t unusedLabel = std::numeric_limits<uint64_t>::max();
+
+        std::vector<std::vector<std::vector<uint64_t> > > newSets(pSize);
+        std::vector<double> gains(pSize, 0.0);
+
+        parallel::parallel_foreach(threadPool_, pSize, [&](const int tid, const int64_t i){
+            if (!changed_[i] || partitions_[i].empty())
+                return;
+
+            const auto label = twoCutBuffers_.vertexLabels[partitions_[i].front()];
+            auto & twoCut = compactTwoCuts_[tid];
+            for(;;){
+                std::vector<uint64_t> newSet;
+                gains[i] += twoCut.optimizeTwoCut(partitions_[i], newSet, label, unusedLabel,
+                                                  twoCutBuffers_.vertexLabels, localIndex_);
+                if(newSet.empty())
+                    break;
+                newSets[i].emplace_back(std::move(newSet));
+            }
+        });
+
+        for(std::size_t i = 0; i < pSize; ++i){
+            energyDecrease += gains[i];
+            for(auto & newSet : newSets[i]){
+                const auto newLabel = twoCutBuffers_.maxNotUsedLabel++;
+                for(const auto node : newSet)
+                    twoCutBuffers_.vertexLabels[node] = newLabel;
+                partitions_.emplace_back(std::move(newSet));
+            }
+        }
+    }
+
+    
     template<class OBJECTIVE>
     inline void 
     LiftedMulticutKernighanLin<OBJECTIVE>::
@@ -1,9 +1,12 @@
 #pragma once
 
+#include <memory>
+#include <vector>
 
 #include "nifty/tools/runtime_check.hxx"
 
 #include "nifty/graph/opt/common/solver_factory_base.hxx"
+#include "nifty/graph/opt/common/chained_solvers.hxx"
 #include "nifty/graph/opt/multicut/multicut_base.hxx"
 #include "nifty/graph/opt/multicut/multicut_objective.hxx"
 
@@ -40,56 +43,10 @@ namespace multicut{
 
 
 
-        class NoBeginEndVisitor : public VisitorBaseType{
-        public:
-
-            NoBeginEndVisitor(VisitorBaseType * visitor)
-            :   visitor_(visitor){
-            }
-
-            virtual void begin(BaseType * solver) {
-                // nothing
-            }
-            virtual bool visit(BaseType * solver) {
-                if(visitor_ != nullptr){
-                    return visitor_->visit(solver);
-                }
-                else{
-                    return true;
-                }
-            }
-            virtual void end(BaseType * solver)   {
-                // nothing
-            }
-
-            virtual void clearLogNames(){
-                if(visitor_ != nullptr)
-                    visitor_->clearLogNames();
-            }
-            virtual void addLogNames(std::initializer_list<std::string> logNames){
-                if(visitor_ != nullptr)
-                    visitor_->addLogNames(logNames);
-            }
-
-            virtual void setLogValue(const std::size_t logIndex, double logValue){
-                if(visitor_ != nullptr)
-                    visitor_->setLogValue(logIndex, logValue);
-            }
-
-            virtual void printLog(const nifty::logging::LogLevel logLevel, const std::string & logString){
-                if(visitor_ != nullptr)
-                    visitor_->printLog(logLevel, logString);
-            }
-
-
-        private:
-            VisitorBaseType * visitor_;
-        };
-
-
     public:
 
-        struct SettingsType{
+        // the stopping rules are described in common::ChainedSolversSettings
+        struct SettingsType : public nifty::graph::opt::common::ChainedSolversSettings{
             std::vector<
                 std::shared_ptr<McFactoryBase>
             > multicutFactories;
@@ -148,43 +105,10 @@ namespace multicut{
     optimize(
         NodeLabelsType & nodeLabels,  VisitorBaseType * visitor
     ){
-
-
-
-        VisitorProxyType visitorProxy(visitor);
-        NoBeginEndVisitor noBeginEndVisitor(visitor);
-
-
-
         currentBest_ = &nodeLabels;
-        //currentBestEnergy_ = objective_.evalNodeLabels(nodeLabels);
-
-        visitorProxy.begin(this);
-
-        for(auto & mcFactory : settings_.multicutFactories){
-
-
-
-
-
-
-
-            auto solver = mcFactory->create(objective_);
-            visitorProxy.printLog(nifty::logging::LogLevel::INFO,
-                std::string("Starting Solver: ")+solver->name());
-
-
-            if(visitor != nullptr){
-                visitor->clearLogNames();
-                solver->optimize(nodeLabels, &noBeginEndVisitor);
-            }
-            else{
-                solver->optimize(nodeLabels, nullptr);
-            }
-            delete solver;
-        }
-
-        visitorProxy.end(this);
+        nifty::graph::opt::common::optimizeChainedSolvers<BaseType>(
+            this, settings_.multicutFactories, settings_, nodeLabels, visitor
+        );
     }
 
     template<class OBJECTIVE>
@@ -0,0 +1,445 @@
+#pragma once
+
+#include <atomic>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/parallel/threadpool.hxx"
+#include "nifty/ufd/concurrent_ufd.hxx"
+#include "nifty/graph/opt/multicut/multicut_base.hxx"
+
+
+namespace nifty{
+namespace graph{
+namespace opt{
+namespace multicut{
+
+
+    /// Approximate greedy additive edge contraction.
+    ///
+    /// Instead of contracting the single heaviest edge at a time (see MulticutGreedyAdditive),
+    /// the clustering proceeds in parallel rounds on a cluster graph in compressed sparse row form.
+    /// In each round every cluster selects its heaviest edge, an edge selected by both
+    /// of its clusters is contracted if its weight is in the bucket
+    /// [w - epsilon * (w - weightStopCond), w], where w is the highest weight
+    /// within two edges of it. The contracted edges are a matching,
+    /// the weights of parallel edges are summed when the cluster graph is rebuilt.
+    ///
+    /// For epsilon = 0 only edges which are the heaviest in their neighborhood are contracted,
+    /// larger values of epsilon trade energy for fewer rounds.
+    /// The labeling does not depend on the number of threads.
+    /// If a round would contract more edges than the node number stop condition allows,
+    /// only the heaviest of its edges are contracted, so the clustering stops at exactly
+    /// that number of clusters (provided enough edges are above weightStopCond).
+    template<class OBJECTIVE>
+    class MulticutApproximateGreedyAdditive : public MulticutBase<OBJECTIVE>
+    {
+    public:
+
+        typedef OBJECTIVE ObjectiveType;
+        typedef typename ObjectiveType::GraphType GraphType;
+        typedef typename ObjectiveType::WeightsMap WeightsMap;
+        typedef MulticutBase<OBJECTIVE> BaseType;
+        typedef typename BaseType::VisitorBaseType VisitorBaseType;
+        typedef typename BaseType::VisitorProxyType VisitorProxyType;
+        typedef typename BaseType::NodeLabelsType NodeLabelsType;
+
+        struct SettingsType{
+            double weightStopCond{0.0};
+            double nodeNumStopCond{-1};
+            double epsilon{0.25};
+            int numberOfThreads{1};
+            int visitNth{1};
+        };
+
+        virtual ~MulticutApproximateGreedyAdditive(){}
+        MulticutApproximateGreedyAdditive(const ObjectiveType & objective, const SettingsType & settings = SettingsType());
+        virtual void optimize(NodeLabelsType & nodeLabels, VisitorBaseType * visitor);
+        virtual const ObjectiveType & objective() const;
+
+        virtual const NodeLabelsType & currentBestNodeLabels( ){
+            return *currentBest_;
+        }
+
+        virtual std::string name()const{
+            return std::string("MulticutApproximateGreedyAdditive");
+        }
+
+        virtual void weightsChanged(){
+        }
+
+    private:
+
+        // an edge {u, v} of the cluster graph with u < v,
+        // the edges are grouped by u (compressed sparse row),
+        // within a group they are in no particular order
+        struct ClusterEdge{
+            uint64_t v;
+            double weight;
+        };
+
+        void initClusterGraph();
+        uint64_t contractRound(const uint64_t maxContractions, parallel::ThreadPool & threadpool);
+        double maxWeight(parallel::ThreadPool & threadpool) const;
+        void relabel(const uint64_t numberOfNewClusters, parallel::ThreadPool & threadpool);
+
+        bool isBetterEdge(const uint64_t e, const uint64_t f) const{
+            return f == noEdge() || edges_[e].weight > edges_[f].weight ||
+                (edges_[e].weight == edges_[f].weight && e < f);
+        }
+
+        static uint64_t noEdge(){
+            return std::numeric_limits<uint64_t>::max();
+        }
+
+        const ObjectiveType & objective_;
+        const GraphType & graph_;
+        SettingsType settings_;
+        NodeLabelsType * currentBest_;
+
+        // cluster graph
+        uint64_t numberOfClusters_;
+        std::vector<uint64_t> edgeU_;
+        std::vector<ClusterEdge> edges_;
+
+        // the cluster of a node is baseCluster_[clusterOf_[node]],
+        // clusterOf_ is only updated once the number of clusters has halved
+        std::vector<uint64_t> clusterOf_;
+        std::vector<uint64_t> baseCluster_;
+
+        // buffers which are reused in all rounds
+        std::unique_ptr<std::atomic<uint64_t>[]> bestEdge_;
+        std::unique_ptr<std::atomic<uint64_t>[]> neighborhoodBestEdge_;
+        std::unique_ptr<std::atomic<uint64_t>[]> bucketCursor_;
+        std::vector<uint64_t> matchedEdges_;
+        std::vector<uint64_t> newCluster_;
+        std::vector<uint64_t> bucketOffsets_;
+        std::vector<uint64_t> bucketSizes_;
+        std::vector<std::pair<uint64_t, uint64_t>> buckets_;
+        std::vector<double> bucketWeights_;
+        std::vector<uint64_t> newEdgeU_;
+        std::vector<ClusterEdge> newEdges_;
+    };
+
+
+    template<class OBJECTIVE>
+    MulticutApproximateGreedyAdditive<OBJECTIVE>::
+    MulticutApproximateGreedyAdditive(
+        const ObjectiveType & objective,
+        const SettingsType & settings
+    )
+    :   objective_(objective),
+        graph_(objective.graph()),
+        settings_(settings),
+        currentBest_(nullptr),
+        numberOfClusters_(0)
+    {
+        NIFTY_CHECK(settings_.epsilon >= 0.0 && settings_.epsilon <= 1.0, "epsilon must be in [0, 1]");
+    }
+
+    template<class OBJECTIVE>
+    void MulticutApproximateGreedyAdditive<OBJECTIVE>::
+    optimize(
+        NodeLabelsType & nodeLabels,  VisitorBaseType * visitor
+    ){
+        VisitorProxyType visitorProxy(visitor);
+        visitorProxy.addLogNames({"#nodes","topWeight"});
+
+        currentBest_ = &nodeLabels;
+        parallel::ThreadPool threadpool(settings_.numberOfThreads);
+        initClusterGraph();
+
+        const auto writeLabels = [&](){
+            for(const auto node : graph_.nodes()){
+                nodeLabels[node] = baseCluster_[clusterOf_[node]];
+            }
+        };
+        writeLabels();
+        visitorProxy.begin(this);
+
+        // the node number stop condition
+        uint64_t currentNodeNum = graph_.numberOfNodes();
+        const auto nnsc = settings_.nodeNumStopCond;
+        uint64_t minNodeNum = 1;
+        if(nnsc >= 1.0){
+            minNodeNum = static_cast<uint64_t>(nnsc);
+        }
+        else if(nnsc > 0.0){
+            minNodeNum = static_cast<uint64_t>(double(graph_.numberOfNodes())*nnsc +0.5);
+        }
+
+        int round = 1;
+        while(!edges_.empty() && currentNodeNum > minNodeNum){
+
+            const auto nContracted = contractRound(currentNodeNum - minNodeNum, threadpool);
+            if(nContracted == 0){
+                break;
+            }
+            currentNodeNum -= nContracted;
+
+            if(visitorProxy && round % settings_.visitNth == 0){
+                writeLabels();
+                visitorProxy.setLogValue(0, currentNodeNum);
+                visitorProxy.setLogValue(1, maxWeight(threadpool));
+                if(!visitorProxy.visit(this)){
+                    break;
+                }
+            }
+            ++round;
+        }
+
+        writeLabels();
+        visitorProxy.end(this);
+    }
+
+    template<class OBJECTIVE>
+    const typename MulticutApproximateGreedyAdditive<OBJECTIVE>::ObjectiveType &
+    MulticutApproximateGreedyAdditive<OBJECTIVE>::
+    objective()const{
+        return objective_;
+    }
+
+    template<class OBJECTIVE>
+    void MulticutApproximateGreedyAdditive<OBJECTIVE>::
+    initClusterGraph(){
+        // each node is a cluster
+        numberOfClusters_ = graph_.nodeIdUpperBound() + 1;
+        clusterOf_.resize(numberOfClusters_);
+        std::iota(clusterOf_.begin(), clusterOf_.end(), uint64_t(0));
+        baseCluster_ = clusterOf_;
+
+        std::vector<uint64_t> offsets(numberOfClusters_ + 1, 0);
+        for(const auto edge : graph_.edges()){
+            ++offsets[std::min(graph_.u(edge), graph_.v(edge)) + 1];
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        edges_.resize(offsets.back());
+        edgeU_.resize(offsets.back());
+        const auto & weights = objective_.weights();
+        for(const auto edge : graph_.edges()){
+            const uint64_t u = std::min(graph_.u(edge), graph_.v(edge));
+            const uint64_t v = std::max(graph_.u(edge), graph_.v(edge));
+            const auto pos = offsets[u]++;
+            edgeU_[pos] = u;
+            edges_[pos] = ClusterEdge{v, weights[edge]};
+        }
+
+        bestEdge_.reset(new std::atomic<uint64_t>[numberOfClusters_]);
+        neighborhoodBestEdge_.reset(new std::atomic<uint64_t>[numberOfClusters_]);
+        bucketCursor_.reset(new std::atomic<uint64_t>[numberOfClusters_ + 1]);
+        matchedEdges_.resize(numberOfClusters_ / 2);
+        newCluster_.resize(numberOfClusters_);
+        bucketOffsets_.resize(numberOfClusters_ + 1);
+        bucketSizes_.resize(numberOfClusters_ + 1);
+    }
+
+    template<class OBJECTIVE>
+    double MulticutApproximateGreedyAdditive<OBJECTIVE>::
+    maxWeight(
+        parallel::ThreadPool & threadpool
+    ) const {
+        std::vector<double> threadMax(std::max<std::size_t>(threadpool.nThreads(), 1),
+                                      -std::numeric_limits<double>::infinity());
+        parallel::parallel_foreach(threadpool, edges_.size(), [&](const int tid, const int64_t e){
+            threadMax[tid] = std::max(threadMax[tid], edges_[e].weight);
+        });
+        return *std::max_element(threadMax.begin(), threadMax.end());
+    }
+
+    // contract a matching of at most maxContractions edges which are the heaviest edges
+    // of both of their clusters and return the number of contracted edges
+    template<class OBJECTIVE>
+    uint64_t MulticutApproximateGreedyAdditive<OBJECTIVE>::
+    contractRound(
+        const uint64_t maxContractions,
+        parallel::ThreadPool & threadpool
+    ){
+        const uint64_t nEdges = edges_.size();
+        const auto stopWeight = settings_.weightStopCond;
+
+        const auto select = [&](std::atomic<uint64_t> & best, const uint64_t e){
+            auto current = best.load(std::memory_order_relaxed);
+            while(isBetterEdge(e, current)){
+                if(best.compare_exchange_weak(current, e, std::memory_order_relaxed)){
+                    break;
+                }
+            }
+        };
+
+        // the heaviest edge of each cluster (ties are broken by the edge index)
+        parallel::parallel_foreach(threadpool, numberOfClusters_, [&](const int tid, const int64_t c){
+            bestEdge_[c].store(noEdge(), std::memory_order_relaxed);
+        });
+        parallel::parallel_foreach(threadpool, nEdges, [&](const int tid, const int64_t e){
+            if(edges_[e].weight > stopWeight){
+                select(bestEdge_[edgeU_[e]], e);
+                select(bestEdge_[edges_[e].v], e);
+            }
+        });
+
+        // the heaviest edge of each cluster and its neighbors
+        parallel::parallel_foreach(threadpool, numberOfClusters_, [&](const int tid, const int64_t c){
+            neighborhoodBestEdge_[c].store(bestEdge_[c].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        });
+        parallel::parallel_foreach(threadpool, nEdges, [&](const int tid, const int64_t e){
+            const auto u = edgeU_[e];
+            const auto v = edges_[e].v;
+            const auto bestU = bestEdge_[u].load(std::memory_order_relaxed);
+            const auto bestV = bestEdge_[v].load(std::memory_order_relaxed);
+            if(bestU != noEdge()){
+                select(neighborhoodBestEdge_[v], bestU);
+            }
+            if(bestV != noEdge()){
+                select(neighborhoodBestEdge_[u], bestV);
+            }
+        });
+
+        // collect the edges which are selected by both clusters and are in the bucket
+        // of the heaviest edge within two edges, this contains at least the heaviest edge
+        const auto alpha = 1.0 - settings_.epsilon;
+        std::atomic<uint64_t> nMatched(0);
+        parallel::parallel_foreach(threadpool, nEdges, [&](const int tid, const int64_t e){
+            const auto u = edgeU_[e];
+            const auto v = edges_[e].v;
+            if(bestEdge_[u].load(std::memory_order_relaxed) == uint64_t(e) &&
+               bestEdge_[v].load(std::memory_order_relaxed) == uint64_t(e)){
+                const auto reachU = neighborhoodBestEdge_[u].load(std::memory_order_relaxed);
+                const auto reachV = neighborhoodBestEdge_[v].load(std::memory_order_relaxed);
+                const auto reach = isBetterEdge(reachU, reachV) ? reachU : reachV;
+                if(edges_[e].weight - stopWeight >= alpha * (edges_[reach].weight - stopWeight)){
+                    matchedEdges_[nMatched.fetch_add(1, std::memory_order_relaxed)] = e;
+                }
+            }
+        });
+        uint64_t nContracted = nMatched.load();
+        if(nContracted == 0){
+            return 0;
+        }
+
+        // do not contract below the node number stop condition,
+        // isBetterEdge is a total order, so the heaviest edges do not depend on the number of threads
+        if(nContracted > maxContractions){
+            std::nth_element(matchedEdges_.begin(), matchedEdges_.begin() + maxContractions,
+                             matchedEdges_.begin() + nContracted,
+                             [&](const uint64_t e, const uint64_t f){
+                                 return isBetterEdge(e, f);
+                             });
+            nContracted = maxContractions;
+        }
+
+        // the edges are a matching, so each merge joins two clusters
+        nifty::ufd::ConcurrentUfd<uint64_t> ufd(numberOfClusters_);
+        parallel::parallel_foreach(threadpool, nContracted, [&](const int tid, const int64_t i){
+            const auto e = matchedEdges_[i];
+            ufd.merge(edgeU_[e], edges_[e].v);
+        });
+
+        // dense labels of the new clusters
+        const uint64_t nNewClusters = ufd.representativeLabeling(newCluster_, threadpool);
+        parallel::parallel_foreach(threadpool, numberOfClusters_, [&](const int tid, const int64_t c){
+            if(!ufd.isRepresentative(c)){
+                newCluster_[c] = newCluster_[ufd.find(c)];
+            }
+        });
+
+        // rebuild the cluster graph:
+        // bucket the remaining edges by their smaller new cluster,
+        // the position in the bucket is arbitrary, so the edge index is kept
+        // to make the order of the summation of parallel edges deterministic
+        parallel::parallel_foreach(threadpool, nNewClusters + 1, [&](const int tid, const int64_t c){
+            bucketCursor_[c].store(0, std::memory_order_relaxed);
+        });
+        parallel::parallel_foreach(threadpool, nEdges, [&](const int tid, const int64_t e){
+            const auto u = newCluster_[edgeU_[e]];
+            const auto v = newCluster_[edges_[e].v];
+            if(u != v){
+                bucketCursor_[std::min(u, v) + 1].fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+        bucketOffsets_[0] = 0;
+        for(uint64_t c = 0; c < nNewClusters; ++c){
+            bucketOffsets_[c + 1] = bucketOffsets_[c] + bucketCursor_[c + 1].load(std::memory_order_relaxed);
+            bucketCursor_[c].store(bucketOffsets_[c], std::memory_order_relaxed);
+        }
+
+        buckets_.resize(bucketOffsets_[nNewClusters]);
+        bucketWeights_.resize(buckets_.size());
+        parallel::parallel_foreach(threadpool, nEdges, [&](const int tid, const int64_t e){
+            const auto u = newCluster_[edgeU_[e]];
+            const auto v = newCluster_[edges_[e].v];
+            if(u != v){
+                const auto pos = bucketCursor_[std::min(u, v)].fetch_add(1, std::memory_order_relaxed);
+                buckets_[pos] = std::make_pair(std::max(u, v), uint64_t(e));
+            }
+        });
+
+        // sort each bucket and merge parallel edges in place
+        bucketSizes_[0] = 0;
+        parallel::parallel_foreach(threadpool, nNewClusters, [&](const int tid, const int64_t c){
+            const auto begin = bucketOffsets_[c];
+            const auto end = bucketOffsets_[c + 1];
+            std::sort(buckets_.begin() + begin, buckets_.begin() + end);
+            auto out = begin;
+            for(auto i = begin; i < end; ++i){
+                const auto w = edges_[buckets_[i].second].weight;
+                if(i > begin && buckets_[i].first == buckets_[out - 1].first){
+                    bucketWeights_[out - 1] += w;
+                }
+                else{
+                    buckets_[out].first = buckets_[i].first;
+                    bucketWeights_[out] = w;
+                    ++out;
+                }
+            }
+            bucketSizes_[c + 1] = out - begin;
+        });
+        std::partial_sum(bucketSizes_.begin(), bucketSizes_.begin() + nNewClusters + 1, bucketSizes_.begin());
+
+        newEdgeU_.resize(bucketSizes_[nNewClusters]);
+        newEdges_.resize(bucketSizes_[nNewClusters]);
+        parallel::parallel_foreach(threadpool, nNewClusters, [&](const int tid, const int64_t c){
+            auto out = bucketSizes_[c];
+            for(auto i = bucketOffsets_[c]; out < bucketSizes_[c + 1]; ++i, ++out){
+                newEdgeU_[out] = c;
+                newEdges_[out] = ClusterEdge{buckets_[i].first, bucketWeights_[i]};
+            }
+        });
+        edgeU_.swap(newEdgeU_);
+        edges_.swap(newEdges_);
+
+        relabel(nNewClusters, threadpool);
+        return nContracted;
+    }
+
+    template<class OBJECTIVE>
+    void MulticutApproximateGreedyAdditive<OBJECTIVE>::
+    relabel(
+        const uint64_t numberOfNewClusters,
+        parallel::ThreadPool & threadpool
+    ){
+        parallel::parallel_foreach(threadpool, baseCluster_.size(), [&](const int tid, const int64_t b){
+            baseCluster_[b] = newCluster_[baseCluster_[b]];
+        });
+        numberOfClusters_ = numberOfNewClusters;
+
+        // update the clusters of the nodes, this keeps the
+        // cost of the relabeling proportional to the number of clusters
+        if(2 * numberOfClusters_ < baseCluster_.size()){
+            parallel::parallel_foreach(threadpool, clusterOf_.size(), [&](const int tid, const int64_t node){
+                clusterOf_[node] = baseCluster_[clusterOf_[node]];
+            });
+            baseCluster_.resize(numberOfClusters_);
+            std::iota(baseCluster_.begin(), baseCluster_.end(), uint64_t(0));
+        }
+    }
+
+
+} // namespace nifty::graph::opt::multicut
+} // namespace nifty::graph::opt
+} // namespace nifty::graph
+} // namespace nifty
@@ -1,6 +1,13 @@
 #pragma once
 
+#include <atomic>
+#include <algorithm>
+#include <memory>
+#include <numeric>
+
 #include "nifty/tools/runtime_check.hxx"
+#include "nifty/parallel/threadpool.hxx"
+#include "nifty/ufd/concurrent_ufd.hxx"
 #include "nifty/graph/components.hxx"
 
 #include "nifty/graph/opt/multicut/multicut_base.hxx"
@@ -44,10 +51,18 @@ namespace multicut{
 
     public:
 
+        // Components without repulsive edges are solved in closed form (all nodes joined).
+        // The remaining components are solved in parallel, largest first:
+        // components with at most smallSubmodelSize nodes are solved with the
+        // smallSubmodelFactory (e.g. an exact ilp), if given, all others with the submodelFactory.
+        // The factories are called from several threads concurrently if numberOfThreads != 1,
+        // so they must not be implemented in python in this case.
         struct SettingsType{
             std::shared_ptr<SubmodelFactoryBase> submodelFactory;
             std::shared_ptr<FactoryBase>         fallthroughFactory;
-            
+            std::shared_ptr<SubmodelFactoryBase> smallSubmodelFactory;
+            std::size_t smallSubmodelSize{0};
+            int numberOfThreads{1};
         };
 
         virtual ~MulticutDecomposer(){
@@ -136,10 +151,11 @@ namespace multicut{
 
 
         // build the connected components
+        parallel::ThreadPool threadpool(settings_.numberOfThreads);
         NodeLabelsType denseLabels(graph_);
-        const auto nComponents = components_.build(SubgraphWithCut(weights_));
+        const auto nComponents = components_.build(SubgraphWithCut(weights_), threadpool);
         std::vector<std::size_t> componentsSize(nComponents,0);
-        components_.denseRelabeling(denseLabels, componentsSize);
+        components_.denseRelabeling(denseLabels, componentsSize, threadpool);
 
 
         visitorProxy.printLog(nifty::logging::LogLevel::INFO, 
@@ -155,148 +171,132 @@ namespace multicut{
             visitorProxy.addLogNames({std::string("modelSize")});
 
 
-
-            //visitorProxy.printLog(nifty::logging::LogLevel::INFO, "alloc subgraphs");
-            // first pass :
-            // - allocate the sub graphs
-            // - sparse to dense
-            std::vector<SubmodelGraph *> subGraphVec(nComponents);
-            for(std::size_t i=0; i<nComponents; ++i){
-                NIFTY_CHECK_OP(componentsSize[i],>,0,"");
-                if(componentsSize[i]>1)
-                    subGraphVec[i] = new SubmodelGraph(componentsSize[i]);
-            }
-
-
-            //visitorProxy.printLog(nifty::logging::LogLevel::INFO, "global to local mappin");
-            // map from global variables to
-            // subproblem variables
-            std::vector< std::unordered_map<uint64_t, uint64_t>  > nodeToSubNodeVec(nComponents);
-            for(const auto node : graph_.nodes()){
-                const auto subgraphId = denseLabels[node];
-                auto & nodeToSubNode = nodeToSubNodeVec[subgraphId];
-                const auto subVarId = nodeToSubNode.size();
-                nodeToSubNode[node] = subVarId;
+            // map from global nodes to subproblem nodes,
+            // the sub nodes are numbered in the order of the global node ids
+            typename GraphType:: template NodeMap<uint64_t> nodeToSubNode(graph_);
+            {
+                std::vector<uint64_t> subNodeCounter(nComponents, 0);
+                for(const auto node : graph_.nodes()){
+                    nodeToSubNode[node] = subNodeCounter[denseLabels[node]]++;
+                }
             }
 
-
-            //visitorProxy.printLog(nifty::logging::LogLevel::INFO, "add edges");
-            // add edges to subproblems
+            // partition the inner edges of the components:
+            // the inner edges of component c are
+            // componentEdges[componentEdgeOffsets[c]] ... componentEdges[componentEdgeOffsets[c+1]-1]
+            // (in the order of the global edge ids)
+            std::vector<std::size_t> componentEdgeOffsets(nComponents + 1, 0);
+            std::vector<unsigned char> hasRepulsiveEdge(nComponents, false);
             for(const auto edge : graph_.edges()){
-
-                const auto u = graph_.u(edge);
-                const auto v = graph_.v(edge);
-                const auto lu = denseLabels[u];
-
-                if(componentsSize[lu]>1){
-                    if(lu == denseLabels[v]){
-
-                        NIFTY_CHECK_OP(lu,<,nComponents,"");
-
-                        const auto & nodeToSubNode = nodeToSubNodeVec[lu];
-
-                        const auto findU = nodeToSubNode.find(u);
-                        const auto findV = nodeToSubNode.find(v);
-
-                        NIFTY_CHECK(findU != nodeToSubNode.end(),"");
-                        NIFTY_CHECK(findV != nodeToSubNode.end(),"");
-
-                        const auto su = findU->second;
-                        const auto sv = findV->second;
-
-                        NIFTY_CHECK_OP(su,<,subGraphVec[lu]->numberOfNodes(),"");
-                        NIFTY_CHECK_OP(sv,<,subGraphVec[lu]->numberOfNodes(),"");
-
-                        subGraphVec[lu]->insertEdge(su,sv);
+                const auto lu = denseLabels[graph_.u(edge)];
+                if(lu == denseLabels[graph_.v(edge)]){
+                    ++componentEdgeOffsets[lu + 1];
+                    if(weights_[edge] < 0.0){
+                        hasRepulsiveEdge[lu] = true;
                     }
                 }
             }
-
-            //visitorProxy.printLog(nifty::logging::LogLevel::INFO, "build sub-objectives");
-            // build the sub mc objectives
-            std::vector<SubmodelObjective *> subObjectiveVec(nComponents);
-            for(std::size_t i=0; i<nComponents; ++i){
-                if(componentsSize[i]>1)
-                    subObjectiveVec[i] = new SubmodelObjective(*subGraphVec[i]);
-            }
-
-            for(const auto edge : graph_.edges()){
-                const auto u = graph_.u(edge);
-                const auto v = graph_.v(edge);
-                const auto lu = denseLabels[u];
-                if(componentsSize[lu]>1){
-                    if(lu == denseLabels[v]){
-                        const auto & nodeToSubNode = nodeToSubNodeVec[lu];
-                        const auto su = nodeToSubNode.find(u)->second;
-                        const auto sv = nodeToSubNode.find(v)->second;
-                        const auto subEdge = subGraphVec[lu]->findEdge(su,sv);
-                        subObjectiveVec[lu]->weights()[subEdge] = weights_[edge];
+            std::partial_sum(componentEdgeOffsets.begin(), componentEdgeOffsets.end(),
+                             componentEdgeOffsets.begin());
+            std::vector<uint64_t> componentEdges(componentEdgeOffsets.back());
+            {
+                std::vector<std::size_t> edgeCounter(componentEdgeOffsets.begin(),
+                                                     componentEdgeOffsets.end() - 1);
+                for(const auto edge : graph_.edges()){
+                    const auto lu = denseLabels[graph_.u(edge)];
+                    if(lu == denseLabels[graph_.v(edge)]){
+                        componentEdges[edgeCounter[lu]++] = edge;
                     }
                 }
             }
 
-            //visitorProxy.printLog(nifty::logging::LogLevel::INFO, "optimize subproblems");
-            // optimize the subproblems
-            // and delete stuff we do not need anymore
-            std::vector<SubmodelNodeLabels *> subNodeLabelsVec(nComponents);
-
-            // //////////////////////////////////////////////
-            // solving and partial cleanup
-            // //////////////////////////////////////////////
-            for(std::size_t i=0; i<nComponents; ++i){
-                if(componentsSize[i]>1){
-                    const auto & subObj = *subObjectiveVec[i];
-                    const auto & subGraph = *subGraphVec[i];
-                    const auto nSubGraphNodes = subGraph.numberOfNodes();
-                    std::cout<<"#Nodes "<<nSubGraphNodes<<" "<<float(nSubGraphNodes)/float(graph_.numberOfNodes())<<"\n";
-                  
-                    subNodeLabelsVec[i] = new SubmodelNodeLabels(subGraph);
-
-                    // create solver and optimize 
-                    auto subSolver = settings_.submodelFactory->create(subObj);
-                    subSolver->optimize(*subNodeLabelsVec[i], nullptr);
-                    delete subSolver;
-                    delete subObjectiveVec[i];
-                    delete subGraphVec[i];
+            // the sub solutions are mapped to the global solution by
+            // merging the nodes of all inner edges that are not cut
+            nifty::ufd::ConcurrentUfd< > ufd(graph_.nodeIdUpperBound()+1);
+
+            // components without repulsive edges are solved in closed form:
+            // all nodes are joined, the remaining ones need a solver
+            std::vector<uint64_t> solverComponents;
+            for(std::size_t c=0; c<nComponents; ++c){
+                NIFTY_CHECK_OP(componentsSize[c],>,0,"");
+                if(hasRepulsiveEdge[c]){
+                    solverComponents.push_back(c);
                 }
             }
+            parallel::parallel_foreach(threadpool, componentEdges.size(), [&](const int tid, const int64_t i){
+                const auto edge = componentEdges[i];
+                if(!hasRepulsiveEdge[denseLabels[graph_.u(edge)]]){
+                    ufd.merge(graph_.u(edge), graph_.v(edge));
+                }
+            });
 
-            //visitorProxy.printLog(nifty::logging::LogLevel::INFO, "map sub to global");
-            // map from the sub solutions to global solution
-            {
-                nifty::ufd::Ufd< > ufd(graph_.nodeIdUpperBound()+1);
-                for(const auto edge : graph_.edges()){
+            visitorProxy.printLog(nifty::logging::LogLevel::INFO,
+                std::to_string(solverComponents.size()) + std::string(" sub-models need a solver"));
+
+            // largest first, so the large sub-models do not end up in the tail
+            std::sort(solverComponents.begin(), solverComponents.end(),
+                [&](const uint64_t a, const uint64_t b){
+                    return componentsSize[a] > componentsSize[b];
+                }
+            );
+
+            const auto solveComponent = [&](const uint64_t c){
 
-                    const auto u = graph_.u(edge);
-                    const auto v = graph_.v(edge);
-                    const auto lu = denseLabels[u];
-
-                    if(componentsSize[lu]>1){
-                        if(lu == denseLabels[v]){
-
-                            const auto & nodeToSubNode = nodeToSubNodeVec[lu];
-                            const auto & subNodeLabels = *subNodeLabelsVec[lu];
-                            const auto su = nodeToSubNode.find(u)->second;
-                            const auto sv = nodeToSubNode.find(v)->second;
-                            if(subNodeLabels[su] == subNodeLabels[sv]){
-                                ufd.merge(u, v);
-                            }
-                        }
+                const auto edgesBegin = componentEdgeOffsets[c];
+                const auto edgesEnd = componentEdgeOffsets[c + 1];
+
+                // build the sub graph in bulk, the sub edge ids are given by the
+                // position in the edge partition since all edges are distinct
+                SubmodelGraph subGraph(componentsSize[c], edgesEnd - edgesBegin);
+                for(auto i = edgesBegin; i < edgesEnd; ++i){
+                    const auto edge = componentEdges[i];
+                    subGraph.insertEdge(nodeToSubNode[graph_.u(edge)], nodeToSubNode[graph_.v(edge)]);
+                }
+                SubmodelObjective subObj(subGraph);
+                auto & subWeights = subObj.weights();
+                for(auto i = edgesBegin; i < edgesEnd; ++i){
+                    subWeights[i - edgesBegin] = weights_[componentEdges[i]];
+                }
+
+                // create solver and optimize
+                const bool isSmall = bool(settings_.smallSubmodelFactory) &&
+                                     componentsSize[c] <= settings_.smallSubmodelSize;
+                const auto & factory = isSmall ? settings_.smallSubmodelFactory : settings_.submodelFactory;
+                SubmodelNodeLabels subNodeLabels(subGraph);
+                std::unique_ptr<SubmodelMulticutBaseType> subSolver(factory->create(subObj));
+                subSolver->optimize(subNodeLabels, nullptr);
+
+                // map from the sub solution to global solution
+                for(auto i = edgesBegin; i < edgesEnd; ++i){
+                    if(subNodeLabels[subGraph.u(i - edgesBegin)] == subNodeLabels[subGraph.v(i - edgesBegin)]){
+                        const auto edge = componentEdges[i];
+                        ufd.merge(graph_.u(edge), graph_.v(edge));
                     }
                 }
-                
-                for(const auto node : graph_.nodes()){
-                    nodeLabels[node] = ufd.find(node);
+            };
+
+            // each worker pulls the next largest component;
+            // with a single thread the components are solved in the calling thread,
+            // so factories that are implemented in python keep working
+            if(threadpool.nThreads() <= 1){
+                for(const auto c : solverComponents){
+                    solveComponent(c);
                 }
             }
+            else{
+                const std::size_t nWorkers = std::min<std::size_t>(threadpool.nThreads(), solverComponents.size());
+                std::atomic<std::size_t> nextComponent(0);
+                parallel::parallel_foreach(threadpool, nWorkers, [&](const int tid, const int64_t worker){
+                    for(auto i = nextComponent++; i < solverComponents.size(); i = nextComponent++){
+                        solveComponent(solverComponents[i]);
+                    }
+                });
+            }
 
-            //visitorProxy.printLog(nifty::logging::LogLevel::INFO, "cleanup");
-            // final cleanup
-            for(std::size_t i=0; i<nComponents; ++i){
-                if(componentsSize[i]>1){
-                    delete subNodeLabelsVec[i];
-                }
+            for(const auto node : graph_.nodes()){
+                nodeLabels[node] = ufd.find(node);
             }
+
             visitorProxy.clearLogNames();
         }
         else{
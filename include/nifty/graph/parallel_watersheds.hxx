@@ -0,0 +1,360 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/tools/timer.hxx"
+#include "nifty/parallel/threadpool.hxx"
+#include "nifty/ufd/concurrent_ufd.hxx"
+
+namespace nifty{
+namespace graph{
+
+    /// \brief throughput of a parallel watershed run
+    struct WatershedsStatistics{
+        WatershedsStatistics()
+        :   numberOfNodes(0),
+            numberOfEdges(0),
+            numberOfRounds(0),
+            numberOfForestEdges(0),
+            secondsInitialization(0),
+            secondsRounds(0),
+            secondsLabeling(0){
+        }
+
+        double seconds() const {
+            return secondsInitialization + secondsRounds + secondsLabeling;
+        }
+        double edgesPerSecond() const {
+            return seconds() > 0 ? double(numberOfEdges) / seconds() : 0.0;
+        }
+        double nodesPerSecond() const {
+            return seconds() > 0 ? double(numberOfNodes) / seconds() : 0.0;
+        }
+
+        uint64_t numberOfNodes;
+        uint64_t numberOfEdges;
+        uint64_t numberOfRounds;
+        uint64_t numberOfForestEdges;
+        double secondsInitialization;
+        double secondsRounds;
+        double secondsLabeling;
+    };
+
+// \cond SUPPRESS_DOXYGEN
+namespace detail_watersheds_segmentation{
+
+    // Seeded Kruskal (see edgeWeightedWatershedsSegmentationKruskalImpl) accepts exactly
+    // the edges of the minimum spanning forest of the graph in which all seeds are
+    // contracted to a single node: an edge is refused iff both sides are already seeded,
+    // i.e. iff it closes a cycle through the contracted seeds.
+    // With the total order (weight, edge id) this forest is unique, so we can compute
+    // it with Boruvka, where every round is parallel:
+    //  - every component selects its cheapest outgoing edge (atomic minimum per root)
+    //  - all selected edges are merged in a concurrent union find
+    //  - edges within one component are dropped
+    // The labels are the seeds of the trees of the forest without the contracted seeds.
+    template<
+        class GRAPH,
+        class EDGE_WEIGHT_FUNCTOR,
+        class SEEDS,
+        class LABELS
+    >
+    void parallelWatershedsSegmentationImpl(
+        const GRAPH & g,
+        const EDGE_WEIGHT_FUNCTOR & edgeWeight,
+        const SEEDS & seeds,
+        parallel::ThreadPool & threadpool,
+        LABELS & labels,
+        WatershedsStatistics * statistics
+    ){
+        typedef typename LABELS::value_type LabelType;
+        typedef ufd::ConcurrentUfd<uint64_t> UfdType;
+
+        const uint64_t numberOfNodes = g.nodeIdUpperBound() + 1;
+        const uint64_t numberOfEdges = g.edgeIdUpperBound() + 1;
+        NIFTY_CHECK_OP(numberOfNodes, ==, g.numberOfNodes(), "parallel watersheds need dense node ids");
+        NIFTY_CHECK_OP(numberOfEdges, ==, g.numberOfEdges(), "parallel watersheds need dense edge ids");
+
+        const std::size_t nThreads = std::max(threadpool.nThreads(), std::size_t(1));
+        WatershedsStatistics stats;
+        stats.numberOfNodes = numberOfNodes;
+        stats.numberOfEdges = numberOfEdges;
+        tools::Timer timer;
+        timer.start();
+
+        // the total order of the edges
+        auto lessEdge = [&](const int64_t a, const int64_t b){
+            const auto wa = edgeWeight(a);
+            const auto wb = edgeWeight(b);
+            return wa < wb || (wa == wb && a < b);
+        };
+
+        // split [0, n) in chunks, such that every chunk writes its own output
+        auto forEachChunk = [&](const std::size_t n, auto && f){
+            const std::size_t nChunks = std::min<std::size_t>(std::max<std::size_t>(n / 4096, 1), 8 * nThreads);
+            const std::size_t chunkSize = (n + nChunks - 1) / nChunks;
+            parallel::parallel_foreach(threadpool, nChunks, [&](const int tid, const int64_t chunk){
+                const std::size_t begin = chunk * chunkSize;
+                const std::size_t end = std::min(begin + chunkSize, n);
+                f(tid, chunk, begin, end);
+            });
+            return nChunks;
+        };
+
+        // contract all seeds to their smallest node
+        UfdType ufd(numberOfNodes);
+        std::atomic<int64_t> firstSeed(-1);
+        forEachChunk(numberOfNodes, [&](const int tid, const int64_t chunk, const std::size_t begin, const std::size_t end){
+            for(std::size_t node = begin; node < end; ++node){
+                if(seeds[node] != 0){
+                    int64_t current = firstSeed.load();
+                    while((current == -1 || int64_t(node) < current) &&
+                          !firstSeed.compare_exchange_weak(current, int64_t(node))){
+                    }
+                }
+            }
+        });
+        if(firstSeed.load() >= 0){
+            forEachChunk(numberOfNodes, [&](const int tid, const int64_t chunk, const std::size_t begin, const std::size_t end){
+                for(std::size_t node = begin; node < end; ++node){
+                    if(seeds[node] != 0){
+                        ufd.merge(uint64_t(firstSeed.load()), node);
+                    }
+                }
+            });
+        }
+
+        // initial active edges: all edges not within the contracted seeds
+        std::vector<std::vector<uint64_t>> chunkEdges(8 * nThreads);
+        std::vector<uint64_t> activeEdges;
+        auto collectChunks = [&](const std::size_t nChunks, std::vector<uint64_t> & out){
+            std::size_t size = 0;
+            for(std::size_t c = 0; c < nChunks; ++c){
+                size += chunkEdges[c].size();
+            }
+            out.resize(size);
+            std::size_t offset = 0;
+            for(std::size_t c = 0; c < nChunks; ++c){
+                std::copy(chunkEdges[c].begin(), chunkEdges[c].end(), out.begin() + offset);
+                offset += chunkEdges[c].size();
+                chunkEdges[c].clear();
+            }
+        };
+        {
+            const auto nChunks = forEachChunk(numberOfEdges, [&](const int tid, const int64_t chunk, const std::size_t begin, const std::size_t end){
+                auto & out = chunkEdges[chunk];
+                for(std::size_t edge = begin; edge < end; ++edge){
+                    const auto uv = g.uv(edge);
+                    if(seeds[uv.first] == 0 || seeds[uv.second] == 0){
+                        out.push_back(edge);
+                    }
+                }
+            });
+            collectChunks(nChunks, activeEdges);
+        }
+        stats.secondsInitialization = timer.stop().elapsedSeconds();
+        timer.reset().start();
+
+        // boruvka rounds
+        std::unique_ptr<std::atomic<int64_t>[]> bestEdge(new std::atomic<int64_t>[numberOfNodes]);
+        parallel::parallel_foreach(threadpool, numberOfNodes, [&](const int tid, const int64_t node){
+            bestEdge[node].store(-1, std::memory_order_relaxed);
+        });
+        std::vector<std::vector<uint64_t>> chunkRoots(8 * nThreads);
+        std::vector<std::vector<uint64_t>> threadForestEdges(nThreads);
+        std::vector<uint64_t> roots;
+
+        auto selectEdge = [&](const uint64_t root, const int64_t edge, std::vector<uint64_t> & newRoots){
+            int64_t current = bestEdge[root].load(std::memory_order_relaxed);
+            while(current == -1 || lessEdge(edge, current)){
+                if(bestEdge[root].compare_exchange_weak(current, edge)){
+                    if(current == -1){
+                        newRoots.push_back(root);
+                    }
+                    return;
+                }
+            }
+        };
+
+        while(!activeEdges.empty()){
+            ++stats.numberOfRounds;
+
+            // select the cheapest outgoing edge of every component
+            // and drop the edges within components
+            const auto nChunks = forEachChunk(activeEdges.size(), [&](const int tid, const int64_t chunk, const std::size_t begin, const std::size_t end){
+                auto & out = chunkEdges[chunk];
+                auto & newRoots = chunkRoots[chunk];
+                for(std::size_t i = begin; i < end; ++i){
+                    const auto edge = activeEdges[i];
+                    const auto uv = g.uv(edge);
+                    const auto ru = ufd.find(uv.first);
+                    const auto rv = ufd.find(uv.second);
+                    if(ru != rv){
+                        selectEdge(ru, edge, newRoots);
+                        selectEdge(rv, edge, newRoots);
+                        out.push_back(edge);
+                    }
+                }
+            });
+            collectChunks(nChunks, activeEdges);
+            roots.clear();
+            for(std::size_t c = 0; c < nChunks; ++c){
+                roots.insert(roots.end(), chunkRoots[c].begin(), chunkRoots[c].end());
+                chunkRoots[c].clear();
+            }
+            if(roots.empty()){
+                break;
+            }
+
+            // merge along the selected edges, an edge selected by
+            // both of its components is merged only once
+            parallel::parallel_foreach(threadpool, roots.size(), [&](const int tid, const int64_t i){
+                const auto root = roots[i];
+                const auto edge = bestEdge[root].load(std::memory_order_relaxed);
+                const auto uv = g.uv(edge);
+                if(ufd.merge(uv.first, uv.second)){
+                    threadForestEdges[tid].push_back(edge);
+                }
+            });
+            parallel::parallel_foreach(threadpool, roots.size(), [&](const int tid, const int64_t i){
+                bestEdge[roots[i]].store(-1, std::memory_order_relaxed);
+            });
+        }
+        stats.secondsRounds = timer.stop().elapsedSeconds();
+        timer.reset().start();
+
+        // label the trees of the forest (without the contracted seeds)
+        ufd.reset(threadpool);
+        parallel::parallel_foreach(threadpool, nThreads, [&](const int tid, const int64_t t){
+            for(const auto edge : threadForestEdges[t]){
+                const auto uv = g.uv(edge);
+                ufd.merge(uv.first, uv.second);
+            }
+        });
+        for(const auto & forestEdges : threadForestEdges){
+            stats.numberOfForestEdges += forestEdges.size();
+        }
+
+        // every tree contains at most one seed
+        std::vector<LabelType> rootLabels(numberOfNodes, LabelType(0));
+        forEachChunk(numberOfNodes, [&](const int tid, const int64_t chunk, const std::size_t begin, const std::size_t end){
+            for(std::size_t node = begin; node < end; ++node){
+                if(seeds[node] != 0){
+                    rootLabels[ufd.find(node)] = seeds[node];
+                }
+            }
+        });
+        forEachChunk(numberOfNodes, [&](const int tid, const int64_t chunk, const std::size_t begin, const std::size_t end){
+            for(std::size_t node = begin; node < end; ++node){
+                labels[node] = rootLabels[ufd.find(node)];
+            }
+        });
+        stats.secondsLabeling = timer.stop().elapsedSeconds();
+
+        if(statistics != nullptr){
+            *statistics = stats;
+        }
+    }
+
+} // end namespace detail_watersheds_segmentation
+// \endcond
+
+
+    /// \brief parallel edge weighted watersheds segmentation
+    ///
+    /// The result is identical to edgeWeightedWatershedsSegmentation (Kruskal),
+    /// independent of the number of threads. The graph needs dense node and edge ids.
+    ///
+    /// \param g: input graph
+    /// \param edgeWeights : edge weights / edge indicator
+    /// \param seeds : seeds, 0 means no seed
+    /// \param threadpool : threadpool
+    /// \param[out] labels : resulting  nodeLabeling (not necessarily dense)
+    /// \param[out] statistics : optional timings of the phases
+    template<class GRAPH,class EDGE_WEIGHTS,class SEEDS,class LABELS>
+    void parallelEdgeWeightedWatershedsSegmentation(
+        const GRAPH & g,
+        const EDGE_WEIGHTS & edgeWeights,
+        const SEEDS        & seeds,
+        parallel::ThreadPool & threadpool,
+        LABELS             & labels,
+        WatershedsStatistics * statistics = nullptr
+    ){
+        auto edgeWeight = [&](const int64_t edge){
+            return edgeWeights[edge];
+        };
+        detail_watersheds_segmentation::parallelWatershedsSegmentationImpl(
+            g, edgeWeight, seeds, threadpool, labels, statistics);
+    }
+
+    template<class GRAPH,class EDGE_WEIGHTS,class SEEDS,class LABELS>
+    void parallelEdgeWeightedWatershedsSegmentation(
+        const GRAPH & g,
+        const EDGE_WEIGHTS & edgeWeights,
+        const SEEDS        & seeds,
+        LABELS             & labels,
+        const int numberOfThreads = -1,
+        WatershedsStatistics * statistics = nullptr
+    ){
+        parallel::ThreadPool threadpool(numberOfThreads);
+        parallelEdgeWeightedWatershedsSegmentation(g, edgeWeights, seeds, threadpool, labels, statistics);
+    }
+
+
+    /// \brief parallel node weighted watersheds segmentation
+    ///
+    /// Kruskal watershed on the edge weights max(w(u), w(v)), where the seeds
+    /// do not contribute their weight (the flooding enters a node with its own weight).
+    /// In contrast to the priority queue flooding of nodeWeightedWatershedsSegmentation,
+    /// the result does not depend on the order in which equal weights are processed.
+    ///
+    /// \param g: input graph
+    /// \param nodeWeights : node weights / node height
+    /// \param seeds : seeds, 0 means no seed
+    /// \param threadpool : threadpool
+    /// \param[out] labels : resulting  nodeLabeling (not necessarily dense)
+    /// \param[out] statistics : optional timings of the phases
+    template<class GRAPH,class NODE_WEIGHTS,class SEEDS,class LABELS>
+    void parallelNodeWeightedWatershedsSegmentation(
+        const GRAPH & g,
+        const NODE_WEIGHTS & nodeWeights,
+        const SEEDS        & seeds,
+        parallel::ThreadPool & threadpool,
+        LABELS             & labels,
+        WatershedsStatistics * statistics = nullptr
+    ){
+        typedef typename std::decay<decltype(nodeWeights[0])>::type WeightType;
+        auto edgeWeight = [&](const int64_t edge){
+            const auto uv = g.uv(edge);
+            if(seeds[uv.first] != 0){
+                return WeightType(nodeWeights[uv.second]);
+            }
+            if(seeds[uv.second] != 0){
+                return WeightType(nodeWeights[uv.first]);
+            }
+            return WeightType(std::max(nodeWeights[uv.first], nodeWeights[uv.second]));
+        };
+        detail_watersheds_segmentation::parallelWatershedsSegmentationImpl(
+            g, edgeWeight, seeds, threadpool, labels, statistics);
+    }
+
+    template<class GRAPH,class NODE_WEIGHTS,class SEEDS,class LABELS>
+    void parallelNodeWeightedWatershedsSegmentation(
+        const GRAPH & g,
+        const NODE_WEIGHTS & nodeWeights,
+        const SEEDS        & seeds,
+        LABELS             & labels,
+        const int numberOfThreads = -1,
+        WatershedsStatistics * statistics = nullptr
+    ){
+        parallel::ThreadPool threadpool(numberOfThreads);
+        parallelNodeWeightedWatershedsSegmentation(g, nodeWeights, seeds, threadpool, labels, statistics);
+    }
+
+} // namespace nifty::graph
+} // namespace nifty
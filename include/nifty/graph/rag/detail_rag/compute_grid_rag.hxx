@@ -9,6 +9,7 @@
 #include "nifty/container/boost_flat_set.hxx"
 #include "nifty/array/arithmetic_array.hxx"
 #include "nifty/tools/for_each_block.hxx"
+#include "nifty/tools/scanline.hxx"
 
 #include "nifty/graph/undirected_list_graph.hxx"
 
@@ -77,11 +78,8 @@ struct ComputeRag<GridRag<DIM, LABELS>> {
             perThreadDataVec[i].adjacency.resize(rag.numberOfLabels());
         });
 
-        auto makeCoord2 = [](const Coord & coord,const std::size_t axis){
-            Coord coord2 = coord;
-            coord2[axis] += 1;
-            return coord2;
-        };
+        // the blocks are read into the front of the per-thread arrays
+        const Coord storageStrides = tools::rowMajorStrides<DIM>(blockShapeWithBorder);
 
         const Coord overlapBegin(0), overlapEnd(1);
         const Coord zeroCoord(0);
@@ -101,18 +99,11 @@ struct ComputeRag<GridRag<DIM, LABELS>> {
             tools::readSubarray(labels, blockBegin, blockEnd, blockLabels);
 
             auto & adjacency = perThreadDataVec[tid].adjacency;
-            nifty::tools::forEachCoordinate(actualBlockShape,[&](const Coord & coord){
-                const auto lU = xtensor::read(blockLabels, coord.asStdArray());
-                for(std::size_t axis=0; axis<DIM; ++axis){
-                    const auto coord2 = makeCoord2(coord, axis);
-                    if(coord2[axis] < actualBlockShape[axis]){
-                        const auto lV = xtensor::read(blockLabels, coord2.asStdArray());
-                        if(lU != lV){
-                            adjacency[lV].insert(lU);
-                            adjacency[lU].insert(lV);
-                        }
-                    }
-                }
+            tools::forEachLabelTransition(xtensor::dataPointer(blockView), storageStrides, actualBlockShape, actualBlockShape,
+            [&](const Coord & coord, const int64_t offset, const std::size_t axis,
+                const value_type lU, const value_type lV){
+                adjacency[lV].insert(lU);
+                adjacency[lU].insert(lV);
             });
         });
 
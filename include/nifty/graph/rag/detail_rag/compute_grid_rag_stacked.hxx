@@ -1,14 +1,16 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <future>
 #include <vector>
 
 #include "nifty/container/boost_flat_set.hxx"
 #include "nifty/array/arithmetic_array.hxx"
 #include "nifty/parallel/threadpool.hxx"
-#include "nifty/tools/timer.hxx"
-#include "nifty/tools/for_each_coordinate.hxx"
-#include "nifty/tools/for_each_block.hxx"
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/tools/scanline.hxx"
 
 #include "nifty/graph/undirected_list_graph.hxx"
 
@@ -38,25 +40,114 @@ template< class GRID_RAG>
 struct ComputeRag;
 
 
+// an edge (u < v) and the number of pixel faces along it
+struct StackedEdgeLength{
+    uint64_t u;
+    uint64_t v;
+    uint64_t length;
+    bool operator<(const StackedEdgeLength & other) const {
+        return u < other.u || (u == other.u && v < other.v);
+    }
+};
+typedef std::vector<StackedEdgeLength> StackedEdgeLengthRun;
+
+
+// append a face, consecutive faces of the same edge are counted in place
+inline void pushStackedEdgeLength(StackedEdgeLengthRun & run, uint64_t u, uint64_t v){
+    if(u > v){
+        std::swap(u, v);
+    }
+    if(!run.empty() && run.back().u == u && run.back().v == v){
+        ++run.back().length;
+    }
+    else{
+        run.push_back(StackedEdgeLength{u, v, 1});
+    }
+}
+
+
+// sort a run and sum up the lengths of duplicate edges
+inline void compressStackedEdgeLengthRun(StackedEdgeLengthRun & run){
+    std::sort(run.begin(), run.end());
+    std::size_t nUnique = 0;
+    for(std::size_t i = 0; i < run.size(); ++i){
+        if(nUnique > 0 && run[nUnique - 1].u == run[i].u && run[nUnique - 1].v == run[i].v){
+            run[nUnique - 1].length += run[i].length;
+        }
+        else{
+            run[nUnique++] = run[i];
+        }
+    }
+    run.resize(nUnique);
+}
+
+
+// merge sorted runs pairwise (in parallel) into a single sorted run
+inline void mergeStackedEdgeLengthRuns(parallel::ThreadPool & threadpool,
+                                       std::vector<StackedEdgeLengthRun> & runs,
+                                       StackedEdgeLengthRun & result){
+    while(runs.size() > 1){
+        std::vector<StackedEdgeLengthRun> merged((runs.size() + 1) / 2);
+        parallel::parallel_foreach(threadpool, merged.size(), [&](const int tid, const int64_t i){
+            auto & runA = runs[2 * i];
+            auto & out = merged[i];
+            if(std::size_t(2 * i + 1) == runs.size()){
+                out.swap(runA);
+                return;
+            }
+            auto & runB = runs[2 * i + 1];
+            out.reserve(runA.size() + runB.size());
+            auto a = runA.begin();
+            auto b = runB.begin();
+            while(a != runA.end() && b != runB.end()){
+                if(*a < *b){
+                    out.push_back(*a++);
+                }
+                else if(*b < *a){
+                    out.push_back(*b++);
+                }
+                else{
+                    out.push_back(*a++);
+                    out.back().length += (b++)->length;
+                }
+            }
+            out.insert(out.end(), a, runA.end());
+            out.insert(out.end(), b, runB.end());
+            StackedEdgeLengthRun().swap(runA);
+            StackedEdgeLengthRun().swap(runB);
+        });
+        runs.swap(merged);
+    }
+    result.clear();
+    if(!runs.empty()){
+        result.swap(runs.front());
+    }
+    runs.clear();
+}
+
+
 template<class LABELS>
 struct ComputeRag<GridRagStacked2D<LABELS>> {
 
     typedef LABELS LabelsType;
+    typedef typename LabelsType::value_type value_type;
     typedef GridRagStacked2D<LABELS> RagType;
-    typedef typename RagType::BlockStorageType BlockStorageType;
     typedef typename RagType::NodeAdjacency NodeAdjacency;
     typedef typename RagType::EdgeStorage EdgeStorage;
 
 
+    // The slices are processed one after another, every slice is split into
+    // tiles of settings.blockShape[1] rows which are processed in parallel.
+    // Each tile produces a sorted run of (u, v, length) for its in-slice faces
+    // and one for the faces to the previous slice; the runs are merged per slice.
+    // While a slice is processed, the next one is read in the background.
     template<class S>
     static void computeRag(RagType & rag,
                            const S & settings){
-        //std::cout<<"\nphase 0\n";
 
         typedef array::StaticArray<int64_t, 3> Coord;
         typedef array::StaticArray<int64_t, 2> Coord2;
-        typedef std::map<EdgeStorage, std::size_t> EdgeLengthsType;
-        typedef std::vector<EdgeLengthsType> EdgeLenghtsStorage;
+        typedef std::pair<value_type, value_type> MinMax;
 
         const auto & labels = rag.labels();
         const auto & shape = rag.shape();
@@ -65,265 +156,211 @@ struct ComputeRag<GridRagStacked2D<LABELS>> {
 
         nifty::parallel::ParallelOptions pOpts(settings.numberOfThreads);
         nifty::parallel::ThreadPool threadpool(pOpts);
-        const auto nThreads = pOpts.getActualNumThreads();
 
-        uint64_t numberOfSlices = shape[0];
-        Coord2 sliceShape2({shape[1], shape[2]});
-        Coord sliceShape3({static_cast<int64_t>(1), shape[1], shape[2]});
+        const int64_t numberOfSlices = shape[0];
+        const int64_t sliceRows = shape[1];
+        const int64_t sliceCols = shape[2];
+        const int64_t tileRows = std::max(int64_t(1), int64_t(settings.blockShape[1]));
+        const int64_t numberOfTiles = (sliceRows + tileRows - 1) / tileRows;
+        const Coord2 sliceStrides({sliceCols, int64_t(1)});
 
         auto & perSliceDataVec = rag.perSliceDataVec_;
 
         const auto haveIgnoreLabel = settings.haveIgnoreLabel;
-        const auto ignoreLabel = settings.ignoreLabel;
+        const value_type ignoreLabel = settings.ignoreLabel;
+        auto isIgnored = [&](const value_type l){
+            return haveIgnoreLabel && l == ignoreLabel;
+        };
 
-        /*
-         * Parallel IO version
-        */
-        EdgeLenghtsStorage edgeLenStorage(numberOfSlices);
+        // sorted (u, v, length) runs for the edges in each slice
+        // and for the edges between each slice and the next one
+        std::vector<StackedEdgeLengthRun> inSliceEdges(numberOfSlices);
+        std::vector<StackedEdgeLengthRun> toNextSliceEdges(numberOfSlices);
 
         /////////////////////////////////////////////////////
-        // Phase 1 : In slice node adjacency and edge count
+        // Phase 1 : edges and edge lengths
         /////////////////////////////////////////////////////
-        //std::cout<<"phase 1\n";
         {
-            BlockStorageType sliceLabelsStorage(threadpool, sliceShape3, nThreads);
-
-            parallel::parallel_foreach(threadpool, numberOfSlices, [&](const int tid, const int64_t sliceIndex){
-                auto & sliceData  = perSliceDataVec[sliceIndex];
-                auto & edgeLens   = edgeLenStorage[sliceIndex];
-
-
-                //
-                auto sliceLabelsFlat3DView = sliceLabelsStorage.getView(tid);
-
-                // fetch the data for the slice
-                const Coord blockBegin({sliceIndex, static_cast<int64_t>(0), static_cast<int64_t>(0)});
-                const Coord blockEnd({sliceIndex+1, sliceShape2[0], sliceShape2[1]});
-                tools::readSubarray(labels, blockBegin, blockEnd, sliceLabelsFlat3DView);
-                //
-                auto sliceLabels = xtensor::squeezedView(sliceLabelsFlat3DView);
-
-                // do the thing
-                nifty::tools::forEachCoordinate(sliceShape2,[&](const Coord2 & coord){
-                    const auto lU = xtensor::read(sliceLabels, coord.asStdArray());
-                    // if we have ignore labels, we check if this is an ignore label
-                    if(haveIgnoreLabel && lU == ignoreLabel) {
-                        return;
-                    }
+            // previous slice, current slice and the slice that is read in the background
+            typedef xt::xtensor<value_type, 3> SliceType;
+            const typename SliceType::shape_type sliceShape3({std::size_t(1), std::size_t(sliceRows), std::size_t(sliceCols)});
+            std::vector<SliceType> sliceBuffers(3);
+            for(auto & buffer : sliceBuffers){
+                buffer.resize(sliceShape3);
+            }
+            auto readSlice = [&](const int64_t sliceIndex){
+                const Coord sliceBegin({sliceIndex, int64_t(0), int64_t(0)});
+                const Coord sliceEnd({sliceIndex + 1, sliceRows, sliceCols});
+                tools::readSubarray(labels, sliceBegin, sliceEnd, sliceBuffers[sliceIndex % 3]);
+            };
+
+            // the first numberOfTiles runs are the in-slice runs,
+            // the others the runs to the previous slice
+            std::vector<StackedEdgeLengthRun> tileRuns(2 * numberOfTiles);
+            std::vector<MinMax> tileMinMax(numberOfTiles);
+
+            std::future<void> nextSlice;
+            if(numberOfSlices > 0){
+                nextSlice = std::async(std::launch::async, readSlice, int64_t(0));
+            }
+            for(int64_t sliceIndex = 0; sliceIndex < numberOfSlices; ++sliceIndex){
+                nextSlice.get();
+                if(sliceIndex + 1 < numberOfSlices){
+                    nextSlice = std::async(std::launch::async, readSlice, sliceIndex + 1);
+                }
 
-                    sliceData.minInSliceNode = std::min(sliceData.minInSliceNode, lU);
-                    sliceData.maxInSliceNode = std::max(sliceData.maxInSliceNode, lU);
-                    for(std::size_t axis=0; axis<2; ++axis) {
-                        Coord2 coord2 = coord;
-                        ++coord2[axis];
-                        if(coord2[axis] < sliceShape2[axis]){
-                            const auto lV = xtensor::read(sliceLabels, coord2.asStdArray());
-                            // if we have ignore labels, we check if this is an ignore label
-                            if(haveIgnoreLabel && lV == ignoreLabel) {
-                                return;
+                const value_type * slice = xtensor::dataPointer(sliceBuffers[sliceIndex % 3]);
+                const value_type * prevSlice = xtensor::dataPointer(sliceBuffers[(sliceIndex + 2) % 3]);
+                const int64_t numberOfTasks = sliceIndex > 0 ? 2 * numberOfTiles : numberOfTiles;
+
+                parallel::parallel_foreach(threadpool, numberOfTasks, [&](const int tid, const int64_t task){
+                    const int64_t tile = task % numberOfTiles;
+                    const int64_t rowBegin = tile * tileRows;
+                    const int64_t rowEnd = std::min(rowBegin + tileRows, sliceRows);
+                    const int64_t offsetBegin = rowBegin * sliceCols;
+                    const int64_t offsetEnd = rowEnd * sliceCols;
+                    auto & run = tileRuns[task];
+                    run.clear();
+
+                    if(task < numberOfTiles){
+                        auto & minMax = tileMinMax[tile];
+                        minMax = MinMax(value_type(rag.numberOfLabels()), value_type(0));
+                        for(int64_t i = offsetBegin; i < offsetEnd; ++i){
+                            const value_type l = slice[i];
+                            if(!isIgnored(l)){
+                                minMax.first = std::min(minMax.first, l);
+                                minMax.second = std::max(minMax.second, l);
                             }
-                            if(lU != lV){
-
-                                sliceData.minInSliceNode = std::min(sliceData.minInSliceNode, lV);
-                                sliceData.maxInSliceNode = std::max(sliceData.maxInSliceNode, lV);
-
-                                // add up the len
-                                // map insert cf.: http://stackoverflow.com/questions/97050/stdmap-insert-or-stdmap-find
-                                auto e = EdgeStorage(std::min(lU,lV),std::max(lU,lV));
-                                auto findEdge = edgeLens.lower_bound(e);
-                                if( findEdge != edgeLens.end() && !(edgeLens.key_comp()(e, findEdge->first)) )
-                                    ++(findEdge->second);
-                                else
-                                    edgeLens.insert(findEdge, std::make_pair(e,1));
-
-                                if(rag.insertEdgeOnlyInNodeAdj(lU, lV)){
-                                    ++perSliceDataVec[sliceIndex].numberOfInSliceEdges;
-                                }
+                        }
+                        // the tile sees the first row of the next tile
+                        const Coord2 tileShape({std::min(rowEnd + 1, sliceRows) - rowBegin, sliceCols});
+                        const Coord2 tileCoreShape({rowEnd - rowBegin, sliceCols});
+                        tools::forEachLabelTransition(slice + offsetBegin, sliceStrides, tileShape, tileCoreShape,
+                        [&](const Coord2 & coord, const int64_t offset, const std::size_t axis,
+                            const value_type lU, const value_type lV){
+                            if(!isIgnored(lU) && !isIgnored(lV)){
+                                pushStackedEdgeLength(run, lU, lV);
+                            }
+                        });
+                    }
+                    else{
+                        for(int64_t i = offsetBegin; i < offsetEnd; ++i){
+                            const value_type lU = prevSlice[i];
+                            const value_type lV = slice[i];
+                            if(!isIgnored(lU) && !isIgnored(lV)){
+                                pushStackedEdgeLength(run, lU, lV);
                             }
                         }
                     }
+                    compressStackedEdgeLengthRun(run);
                 });
-            });
-        }
-
-        //std::cout<<"phase 2\n";
-        /////////////////////////////////////////////////////
-        // Phase 2 : set up the in slice edge offsets
-        /////////////////////////////////////////////////////
-        {
-
-            for(auto sliceIndex=1; sliceIndex<numberOfSlices; ++sliceIndex){
-                const auto prevOffset = perSliceDataVec[sliceIndex-1].inSliceEdgeOffset;
-                const auto prevEdgeNum = perSliceDataVec[sliceIndex-1].numberOfInSliceEdges;
-                perSliceDataVec[sliceIndex].inSliceEdgeOffset =  prevOffset + prevEdgeNum;
-
-                NIFTY_CHECK_OP(perSliceDataVec[sliceIndex-1].maxInSliceNode + 1, == , perSliceDataVec[sliceIndex].minInSliceNode,
-                    "unusable supervoxels for GridRagStacked2D");
-            }
-            const auto & lastSlice =  perSliceDataVec.back();
-            rag.numberOfInSliceEdges_ = lastSlice.inSliceEdgeOffset + lastSlice.numberOfInSliceEdges;
-
-        }
 
-        //std::cout<<"phase 3\n";
-        /////////////////////////////////////////////////////
-        // Phase 3 : set up in slice edge indices
-        /////////////////////////////////////////////////////
-        {
-            // temp. resize the edge vec and edge lens
-            auto & edges = rag.edges_;
-            auto & edgeLengths = rag.edgeLengths_;
-            edges.resize(      rag.numberOfInSliceEdges_);
-            edgeLengths.resize(rag.numberOfInSliceEdges_);
+                auto & sliceData = perSliceDataVec[sliceIndex];
+                for(const auto & minMax : tileMinMax){
+                    sliceData.minInSliceNode = std::min(sliceData.minInSliceNode, minMax.first);
+                    sliceData.maxInSliceNode = std::max(sliceData.maxInSliceNode, minMax.second);
+                }
 
-            parallel::parallel_foreach(threadpool, numberOfSlices, [&](const int tid, const int64_t sliceIndex){
-                auto & sliceData  = perSliceDataVec[sliceIndex];
-                const auto & edgeLensSlice = edgeLenStorage[sliceIndex];
-
-                auto edgeIndex = sliceData.inSliceEdgeOffset;
-                const auto startNode = sliceData.minInSliceNode;
-                const auto endNode = sliceData.maxInSliceNode+1;
-
-                for(uint64_t u = startNode; u< endNode; ++u){
-                    for(auto & vAdj : rag.nodes_[u]){
-                        const auto v = vAdj.node();
-                        if(u < v){
-                            // set the edge indices in this slice
-                            auto e = EdgeStorage(u, v);
-                            edges[edgeIndex] = e;
-                            vAdj.changeEdgeIndex(edgeIndex);
-                            auto fres =  rag.nodes_[v].find(NodeAdjacency(u));
-                            fres->changeEdgeIndex(edgeIndex);
-                            // set the edge lens
-                            edgeLengths[edgeIndex] = edgeLensSlice.at(e);
-                            // increase the edge index
-                            ++edgeIndex;
-                        }
+                std::vector<StackedEdgeLengthRun> runs(numberOfTiles);
+                for(int64_t tile = 0; tile < numberOfTiles; ++tile){
+                    runs[tile].swap(tileRuns[tile]);
+                }
+                mergeStackedEdgeLengthRuns(threadpool, runs, inSliceEdges[sliceIndex]);
+                if(sliceIndex > 0){
+                    runs.resize(numberOfTiles);
+                    for(int64_t tile = 0; tile < numberOfTiles; ++tile){
+                        runs[tile].swap(tileRuns[numberOfTiles + tile]);
                     }
+                    mergeStackedEdgeLengthRuns(threadpool, runs, toNextSliceEdges[sliceIndex - 1]);
                 }
-                NIFTY_CHECK_OP(edgeIndex, ==, sliceData.inSliceEdgeOffset + sliceData.numberOfInSliceEdges,"");
-            });
+            }
         }
 
-        //std::cout<<"phase 4\n";
         /////////////////////////////////////////////////////
-        // Phase 4 : between slice edges
+        // Phase 2 : edge offsets
         /////////////////////////////////////////////////////
         {
-
-            BlockStorageType sliceAStorage(threadpool, sliceShape3, nThreads);
-            BlockStorageType sliceBStorage(threadpool, sliceShape3, nThreads);
-            for(auto & edgeLen : edgeLenStorage)
-                edgeLen.clear();
-
-            for(auto startIndex : {0, 1}){
-                parallel::parallel_foreach(threadpool, numberOfSlices-1, [&](const int tid, const int64_t sliceAIndex){
-
-                    // this seems super ugly...
-                    // there must be a better way to loop in parallel
-                    // over first the odd then the even coordinates
-                    const auto oddIndex = bool(sliceAIndex%2);
-                    if((startIndex==0 && !oddIndex) || (startIndex==1 && oddIndex )){
-
-                        const int64_t sliceBIndex = sliceAIndex + 1;
-                        auto & edgeLens = edgeLenStorage[sliceAIndex];
-
-                        // fetch the data for the slice
-                        const Coord beginA({sliceAIndex, static_cast<int64_t>(0), static_cast<int64_t>(0)});
-                        const Coord beginB({sliceBIndex, static_cast<int64_t>(0), static_cast<int64_t>(0)});
-                        const Coord endA({sliceAIndex+1,shape[1],shape[2]});
-                        const Coord endB({sliceBIndex+1,shape[1],shape[2]});
-
-                        auto sliceAView = sliceAStorage.getView(tid);
-                        auto sliceBView = sliceBStorage.getView(tid);
-
-                        tools::readSubarray(labels, beginA, endA, sliceAView);
-                        tools::readSubarray(labels, beginB, endB, sliceBView);
-
-                        auto sliceALabels = xtensor::squeezedView(sliceAView);
-                        auto sliceBLabels = xtensor::squeezedView(sliceBView);
-
-                        nifty::tools::forEachCoordinate(sliceShape2,[&](const Coord2 & coord){
-                            const auto lU = xtensor::read(sliceALabels, coord.asStdArray());
-                            const auto lV = xtensor::read(sliceBLabels, coord.asStdArray());
-
-                            if(haveIgnoreLabel) {
-                                if(lV == ignoreLabel || lU == ignoreLabel) {
-                                    return;
-                                }
-                            }
-
-                            // add up the len
-                            // map insert cf.: http://stackoverflow.com/questions/97050/stdmap-insert-or-stdmap-find
-                            auto e = EdgeStorage(std::min(lU,lV),std::max(lU,lV));
-                            auto findEdge = edgeLens.lower_bound(e);
-                            if( findEdge != edgeLens.end() && !(edgeLens.key_comp()(e, findEdge->first)) )
-                                ++(findEdge->second);
-                            else
-                                edgeLens.insert(findEdge, std::make_pair(e,1));
-
-                            if(rag.insertEdgeOnlyInNodeAdj(lU, lV)){
-                                ++perSliceDataVec[sliceAIndex].numberOfToNextSliceEdges;
-                            }
-                        });
-                    }
-                });
+            for(int64_t sliceIndex = 0; sliceIndex < numberOfSlices; ++sliceIndex){
+                auto & sliceData = perSliceDataVec[sliceIndex];
+                sliceData.numberOfInSliceEdges = inSliceEdges[sliceIndex].size();
+                sliceData.numberOfToNextSliceEdges = toNextSliceEdges[sliceIndex].size();
+                if(sliceIndex > 0){
+                    const auto & prevData = perSliceDataVec[sliceIndex - 1];
+                    sliceData.inSliceEdgeOffset = prevData.inSliceEdgeOffset + prevData.numberOfInSliceEdges;
+                    NIFTY_CHECK_OP(prevData.maxInSliceNode + 1, == , sliceData.minInSliceNode,
+                        "unusable supervoxels for GridRagStacked2D");
+                }
             }
-        }
+            const auto & lastSlice = perSliceDataVec.back();
+            rag.numberOfInSliceEdges_ = lastSlice.inSliceEdgeOffset + lastSlice.numberOfInSliceEdges;
 
-        //std::cout<<"phase 5\n";
-        /////////////////////////////////////////////////////
-        // Phase 5 : set up the between slice edge offsets
-        /////////////////////////////////////////////////////
-        {
-            rag.numberOfInBetweenSliceEdges_ += perSliceDataVec[0].numberOfToNextSliceEdges;
             perSliceDataVec[0].toNextSliceEdgeOffset = rag.numberOfInSliceEdges_;
-            for(auto sliceIndex=1; sliceIndex<numberOfSlices; ++sliceIndex){
-                const auto prevOffset = perSliceDataVec[sliceIndex-1].toNextSliceEdgeOffset;
-                const auto prevEdgeNum = perSliceDataVec[sliceIndex-1].numberOfToNextSliceEdges;
-                perSliceDataVec[sliceIndex].toNextSliceEdgeOffset =  prevOffset + prevEdgeNum;
-
-                rag.numberOfInBetweenSliceEdges_ +=  perSliceDataVec[sliceIndex].numberOfToNextSliceEdges;
+            rag.numberOfInBetweenSliceEdges_ = perSliceDataVec[0].numberOfToNextSliceEdges;
+            for(int64_t sliceIndex = 1; sliceIndex < numberOfSlices; ++sliceIndex){
+                const auto & prevData = perSliceDataVec[sliceIndex - 1];
+                auto & sliceData = perSliceDataVec[sliceIndex];
+                sliceData.toNextSliceEdgeOffset = prevData.toNextSliceEdgeOffset + prevData.numberOfToNextSliceEdges;
+                rag.numberOfInBetweenSliceEdges_ += sliceData.numberOfToNextSliceEdges;
             }
         }
 
-        //std::cout<<"phase 6\n";
         /////////////////////////////////////////////////////
-        // Phase 6 : set up between slice edge indices
+        // Phase 3 : edges, edge lengths and node adjacencies
         /////////////////////////////////////////////////////
         {
-            // temp. resize the edge vec
             auto & edges = rag.edges_;
             auto & nodes = rag.nodes_;
             auto & edgeLengths = rag.edgeLengths_;
-            edges.resize(      rag.numberOfInSliceEdges_ + rag.numberOfInBetweenSliceEdges_);
-            edgeLengths.resize(rag.numberOfInSliceEdges_ + rag.numberOfInBetweenSliceEdges_);
-
-            parallel::parallel_foreach(threadpool, numberOfSlices-1, [&](const int tid, const int64_t sliceIndex){
-                auto & sliceData  = perSliceDataVec[sliceIndex];
-                const auto & edgeLensSlice = edgeLenStorage[sliceIndex];
-
-                auto edgeIndex = sliceData.toNextSliceEdgeOffset;
-                const auto startNode = sliceData.minInSliceNode;
-                const auto endNode = sliceData.maxInSliceNode+1;
-
-                for(uint64_t u = startNode; u< endNode; ++u){
-                    for(auto & vAdj : rag.nodes_[u]){
-                        const auto v = vAdj.node();
-                        if(u < v && v >= endNode){
-                            auto e = EdgeStorage(u, v);
-                            edges[edgeIndex] = e;
-                            vAdj.changeEdgeIndex(edgeIndex);
-                            auto fres =  nodes[v].find(NodeAdjacency(u));
-                            fres->changeEdgeIndex(edgeIndex);
-                            // set lens
-                            edgeLengths[edgeIndex] = edgeLensSlice.at(e);
-                            // increase the edge index
-                            ++edgeIndex;
-                        }
+            const auto numberOfEdges = rag.numberOfInSliceEdges_ + rag.numberOfInBetweenSliceEdges_;
+            edges.resize(numberOfEdges);
+            edgeLengths.resize(numberOfEdges);
+
+            // the edges are sorted by (u, v) within each slice and within each pair of slices,
+            // the nodes of different slices are disjoint, hence each slice
+            // can fill the adjacencies of its own nodes
+            parallel::parallel_foreach(threadpool, numberOfSlices, [&](const int tid, const int64_t sliceIndex){
+                const auto & sliceData = perSliceDataVec[sliceIndex];
+
+                // (node, adjacent node, edge)
+                std::vector<std::array<uint64_t, 3>> adjacencies;
+                const auto & inSlice = inSliceEdges[sliceIndex];
+                const auto & toNext = toNextSliceEdges[sliceIndex];
+                adjacencies.reserve(2 * inSlice.size() + toNext.size() +
+                                    (sliceIndex > 0 ? toNextSliceEdges[sliceIndex - 1].size() : 0));
+
+                auto edge = sliceData.inSliceEdgeOffset;
+                for(const auto & e : inSlice){
+                    edges[edge] = EdgeStorage(e.u, e.v);
+                    edgeLengths[edge] = e.length;
+                    adjacencies.push_back({{e.u, e.v, edge}});
+                    adjacencies.push_back({{e.v, e.u, edge}});
+                    ++edge;
+                }
+                edge = sliceData.toNextSliceEdgeOffset;
+                for(const auto & e : toNext){
+                    edges[edge] = EdgeStorage(e.u, e.v);
+                    edgeLengths[edge] = e.length;
+                    adjacencies.push_back({{e.u, e.v, edge}});
+                    ++edge;
+                }
+                if(sliceIndex > 0){
+                    edge = perSliceDataVec[sliceIndex - 1].toNextSliceEdgeOffset;
+                    for(const auto & e : toNextSliceEdges[sliceIndex - 1]){
+                        adjacencies.push_back({{e.v, e.u, edge}});
+                        ++edge;
+                    }
+                }
+
+                std::sort(adjacencies.begin(), adjacencies.end());
+                std::vector<NodeAdjacency> nodeAdjacencies;
+                for(auto begin = adjacencies.begin(); begin != adjacencies.end(); ){
+                    const auto node = (*begin)[0];
+                    nodeAdjacencies.clear();
+                    for(; begin != adjacencies.end() && (*begin)[0] == node; ++begin){
+                        nodeAdjacencies.emplace_back((*begin)[1], (*begin)[2]);
                     }
+                    nodes[node].insert(nodeAdjacencies.begin(), nodeAdjacencies.end());
                 }
-                //NIFTY_CHECK_OP(edgeIndex, ==, sliceData.inSliceEdgeOffset + sliceData.numberOfInSliceEdges,"");
             });
         }
     }
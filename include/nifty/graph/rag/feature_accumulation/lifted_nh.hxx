@@ -1,8 +1,16 @@
 #pragma once
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #include "nifty/parallel/threadpool.hxx"
 #include "nifty/tools/array_tools.hxx"
+#include "nifty/tools/blocking.hxx"
+#include "nifty/tools/for_each_coordinate.hxx"
+#include "nifty/tools/scanline.hxx"
 #include "nifty/graph/undirected_list_graph.hxx"
+#include "nifty/xtensor/xtensor.hxx"
 
 namespace nifty {
 namespace graph {
@@ -12,7 +20,6 @@ class LiftedNh : public UndirectedGraph<>{
 
 // TODO
 // - make ready for 2d stacked
-// - out of core
 public:
     typedef RAG Rag;
     typedef UndirectedGraph<> BaseType;
@@ -21,94 +28,186 @@ public:
     typedef array::StaticArray<int64_t, 3> Coord3;
     typedef array::StaticArray<int64_t, 2> Coord2;
 
-    // compute lifted nh from affinities
+    // compute lifted nh from affinities;
+    // the labels are processed in blocks of blockShape (plus a halo
+    // given by the offsets), so they may be stored out of core (hdf5 / z5)
     template<typename ITER>
     LiftedNh(
         const RAG & rag,
         ITER offsetsIterBegin,
         ITER offsetsIterEnd,
-        const int numberOfThreads=-1
+        const int numberOfThreads=-1,
+        const Coord3 & blockShape=Coord3(64)
     ) : offsets_(offsetsIterBegin, offsetsIterEnd)
     {
-        initLiftedNh(rag, numberOfThreads);
+        initLiftedNh(rag, numberOfThreads, blockShape);
     }
 
     const std::vector<std::vector<int>> & offsets() const {return offsets_;}
 
 private:
+    typedef std::pair<uint64_t, uint64_t> EdgeType;
+    typedef std::vector<EdgeType> EdgeRun;
+
     void initLiftedNh(
-        const Rag & labels, const int numberOfThreads);
+        const Rag & labels, const int numberOfThreads, const Coord3 & blockShape);
+
+    static void mergeRuns(std::vector<EdgeRun> & runs, parallel::ThreadPool & threadpool);
 
     std::vector<std::vector<int>> offsets_;
 };
 
 
-// TODO use block storage mechanism to make out of core
+// The lifted edges of every block are collected for the voxels in the
+// block's core, the halo makes sure that all partners of these voxels are
+// available. Each block produces a sorted and unique run of (u, v) pairs
+// that are not part of the rag, the runs are merged pairwise in parallel.
+// Edges are inserted in sorted order, so the edge ids do not depend on
+// the blocking or the number of threads.
 template<class RAG>
 void LiftedNh<RAG>::initLiftedNh(
-    const RAG & rag, const int numberOfThreads
+    const RAG & rag, const int numberOfThreads, const Coord3 & blockShape
 ) {
+    typedef typename RAG::value_type LabelType;
+    typedef tools::Blocking<3> BlockingType;
 
-    //typedef tools::BlockStorage<LabelType> LabelStorage;
     const auto & labels = rag.labels();
 
     // set the number of nodes in the graph == number of labels
-    auto numberOfLabels = rag.numberOfLabels();
+    const auto numberOfLabels = rag.numberOfLabels();
     BaseType::assign(numberOfLabels);
-    Coord3 shape;
-    Coord4 affShape;
-    affShape[0] = offsets_.size();
+
+    const std::size_t nOffsets = offsets_.size();
+    Coord3 shape, haloBegin(0), haloEnd(0);
     for(int d = 0; d < 3; ++d) {
         shape[d] = labels.shape()[d];
-        affShape[d+1] = labels.shape()[d];
+    }
+    for(const auto & offset : offsets_) {
+        for(int d = 0; d < 3; ++d) {
+            haloBegin[d] = std::max(haloBegin[d], int64_t(-offset[d]));
+            haloEnd[d] = std::max(haloEnd[d], int64_t(offset[d]));
+        }
     }
 
-    // TODO parallelize properly
-    // threadpool and actual number of threads
-    nifty::parallel::ThreadPool threadpool(numberOfThreads);
-    const std::size_t nThreads = threadpool.nThreads();
-
-    // per thread data for adjacencies
-    struct PerThread{
-        std::vector< container::BoostFlatSet<uint64_t> > adjacency;
-    };
-    std::vector<PerThread> threadAdjacencies(nThreads);
-    parallel::parallel_foreach(threadpool, nThreads, [&](int tid, int threadId) {
-        threadAdjacencies[threadId].adjacency.resize(numberOfLabels);
-    });
+    nifty::parallel::ParallelOptions pOpts(numberOfThreads);
+    nifty::parallel::ThreadPool threadpool(pOpts);
+    const std::size_t nThreads = pOpts.getActualNumThreads();
 
-    tools::parallelForEachCoordinate(threadpool, affShape, [&](int tid, const Coord4 & affCoord) {
+    const BlockingType blocking(Coord3(0), shape, blockShape);
+    const std::size_t nBlocks = blocking.numberOfBlocks();
 
-        Coord3 cU, cV;
-        const auto & offset = offsets_[affCoord[0]];
+    // the blocks with halo are read into the front of the per-thread arrays
+    Coord3 maxOuterShape;
+    for(int d = 0; d < 3; ++d) {
+        maxOuterShape[d] = std::min(blockShape[d] + haloBegin[d] + haloEnd[d], shape[d]);
+    }
+    const Coord3 storageStrides = tools::rowMajorStrides<3>(maxOuterShape);
+    typename xt::xtensor<LabelType, 3>::shape_type arrayShape;
+    std::copy(maxOuterShape.begin(), maxOuterShape.end(), arrayShape.begin());
 
-        for(int d = 0; d < 3; ++d) {
-            cU[d] = affCoord[d+1];
-            cV[d] = affCoord[d+1] + offset[d];
-            // range check
-            if(cV[d] < 0 || cV[d] >= shape[d]) {
-                return;
+    std::vector<xt::xtensor<LabelType, 3>> blockLabelsVec(nThreads);
+    parallel::parallel_foreach(threadpool, nThreads, [&](const int tid, const int i){
+        blockLabelsVec[i].resize(arrayShape);
+    });
+
+    std::vector<EdgeRun> runs(nBlocks);
+    const Coord3 zeroCoord(0);
+    parallel::parallel_foreach(threadpool, nBlocks, [&](const int tid, const int64_t blockId){
+        const auto blockWithHalo = blocking.getBlockWithHalo(blockId, haloBegin, haloEnd);
+        const auto & outerBlock = blockWithHalo.outerBlock();
+        const auto & innerLocal = blockWithHalo.innerBlockLocal();
+        const Coord3 outerShape = outerBlock.shape();
+
+        auto & blockView = blockLabelsVec[tid];
+        xt::slice_vector slice;
+        xtensor::sliceFromRoi(slice, zeroCoord, outerShape);
+        auto blockLabels = xt::strided_view(blockView, slice);
+        tools::readSubarray(labels, outerBlock.begin(), outerBlock.end(), blockLabels);
+        const LabelType * data = xtensor::dataPointer(blockView);
+
+        auto & run = runs[blockId];
+        for(std::size_t io = 0; io < nOffsets; ++io) {
+            const auto & offset = offsets_[io];
+
+            // core voxels whose partner is inside the volume, which
+            // is equivalent to being inside the block with halo
+            Coord3 begin, end;
+            int64_t ngbOffset = 0;
+            bool empty = false;
+            for(int d = 0; d < 3; ++d) {
+                begin[d] = std::max(innerLocal.begin()[d], int64_t(-offset[d]));
+                end[d] = std::min(innerLocal.end()[d], outerShape[d] - offset[d]);
+                empty = empty || end[d] <= begin[d];
+                ngbOffset += offset[d] * storageStrides[d];
             }
+            if(empty) {
+                continue;
+            }
+
+            // compare whole lines along the last axis with the shifted lines
+            const std::size_t lineLength = end[2] - begin[2];
+            Coord3 lineEnd = end;
+            lineEnd[2] = begin[2] + 1;
+            tools::forEachCoordinateWithOffset(begin, lineEnd, storageStrides,
+            [&](const Coord3 & coord, const int64_t lineOffset){
+                const LabelType * lineU = data + lineOffset;
+                const LabelType * lineV = lineU + ngbOffset;
+                tools::forEachDifference(lineU, lineV, lineLength, [&](const std::size_t i){
+                    const uint64_t lU = lineU[i];
+                    const uint64_t lV = lineV[i];
+                    const EdgeType edge(std::min(lU, lV), std::max(lU, lV));
+                    // skip the most common case of repeated pairs right away
+                    if(run.empty() || run.back() != edge) {
+                        run.push_back(edge);
+                    }
+                });
+            });
         }
 
-        const auto u = xtensor::read(labels, cU.asStdArray());
-        const auto v = xtensor::read(labels, cV.asStdArray());
+        std::sort(run.begin(), run.end());
+        run.erase(std::unique(run.begin(), run.end()), run.end());
+        // only add an edge to the lifted nh if it is not in the local one
+        run.erase(std::remove_if(run.begin(), run.end(), [&](const EdgeType & edge){
+            return rag.findEdge(edge.first, edge.second) != -1;
+        }), run.end());
+        run.shrink_to_fit();
+    });
+
+    mergeRuns(runs, threadpool);
+
+    const auto & edges = runs.front();
+    BaseType::assign(numberOfLabels, edges.size());
+    for(const auto & edge : edges) {
+        BaseType::insertEdge(edge.first, edge.second);
+    }
+}
 
-        // only do stuff if the labels are different
-        if(u != v) {
 
-            // only add an edge to the lifted nh if it is not
-            // in the local one
-            if(rag.findEdge(u, v) != -1) {
+// merge sorted and unique runs pairwise until a single run is left
+template<class RAG>
+void LiftedNh<RAG>::mergeRuns(
+    std::vector<EdgeRun> & runs, parallel::ThreadPool & threadpool
+) {
+    if(runs.empty()) {
+        runs.resize(1);
+    }
+    for(std::size_t step = 1; step < runs.size(); step *= 2) {
+        const std::size_t nMerges = (runs.size() + 2 * step - 1) / (2 * step);
+        parallel::parallel_foreach(threadpool, nMerges, [&](const int tid, const int64_t i){
+            const std::size_t a = 2 * step * i;
+            const std::size_t b = a + step;
+            if(b >= runs.size()) {
                 return;
             }
-            auto & adjacency = threadAdjacencies[tid].adjacency;
-            adjacency[v].insert(u);
-            adjacency[u].insert(v);
-        }
-    });
-
-    BaseType::mergeAdjacencies(threadAdjacencies, threadpool);
+            EdgeRun merged;
+            merged.reserve(runs[a].size() + runs[b].size());
+            std::set_union(runs[a].begin(), runs[a].end(),
+                           runs[b].begin(), runs[b].end(),
+                           std::back_inserter(merged));
+            runs[a].swap(merged);
+            EdgeRun().swap(runs[b]);
+        });
+    }
 }
 
 
@@ -6,6 +6,7 @@
 
 #include "nifty/graph/rag/grid_rag.hxx"
 #include "nifty/tools/for_each_block.hxx"
+#include "nifty/tools/scanline.hxx"
 #include "nifty/parallel/threadpool.hxx"
 #include "vigra/accumulator.hxx"
 
@@ -75,6 +76,7 @@ namespace graph{
         typedef typename DATA::value_type DataType;
         typedef typename vigra::MultiArrayShape<DIM>::type VigraCoord;
         typedef typename GridRag<DIM, LabelsType>::BlockStorageType LabelBlockStorage;
+        typedef typename LabelsType::value_type LabelType;
         typedef tools::BlockStorage<DataType> DataBlockStorage;
 
         typedef array::StaticArray<int64_t, DIM> Coord;
@@ -116,6 +118,7 @@ namespace graph{
             // LOOP IN PARALLEL OVER ALL BLOCKS WITH A CERTAIN OVERLAP
             const Coord overlapBegin(0), overlapEnd(1);
             const Coord storageShape = blockShape + overlapEnd;
+            const Coord storageStrides = tools::rowMajorStrides<DIM>(storageShape);
             LabelBlockStorage labelsBlockStorage(threadpool, storageShape, actualNumberOfThreads);
             DataBlockStorage dataBlockStorage(threadpool, storageShape, actualNumberOfThreads);
             tools::parallelForEachBlockWithOverlap(threadpool,shape, blockShape, overlapBegin, overlapEnd,
@@ -139,32 +142,24 @@ namespace graph{
                 tools::readSubarray(rag.labels(), blockBegin, blockEnd, labelsBlockView);
                 tools::readSubarray(data, blockBegin, blockEnd, dataBlockView);
 
-                // loop over all coordinates in block
-                nifty::tools::forEachCoordinate(nonOlBlockShape,[&](const Coord & coordU){
-                    const auto lU = xtensor::read(labelsBlockView, coordU.asStdArray());
-                    for(std::size_t axis=0; axis<DIM; ++axis){
-                        auto coordV = makeCoord2(coordU, axis);
-                        if(coordV[axis] < actualBlockShape[axis]){
-                            const auto lV = xtensor::read(labelsBlockView, coordV.asStdArray());
-                            if(lU != lV){
-                                const auto edge = rag.findEdge(lU,lV);
-
-                                const auto dataU = xtensor::read(dataBlockView, coordU.asStdArray());
-                                const auto dataV = xtensor::read(dataBlockView, coordV.asStdArray());
-
-                                VigraCoord vigraCoordU;
-                                VigraCoord vigraCoordV;
-
-                                for(std::size_t d=0; d<DIM; ++d){
-                                    vigraCoordU[d] = coordU[d]+blockBegin[d];
-                                    vigraCoordV[d] = coordV[d]+blockBegin[d];
-                                }
-
-                                accVec[edge].updatePassN(dataU, vigraCoordU, pass);
-                                accVec[edge].updatePassN(dataV, vigraCoordV, pass);
-                            }
-                        }
+                // loop over all label transitions in block
+                const auto * labelsPtr = xtensor::dataPointer(labelsBlockStorage.getView(tid));
+                const auto * dataPtr = xtensor::dataPointer(dataBlockStorage.getView(tid));
+                tools::forEachLabelTransition(labelsPtr, storageStrides, actualBlockShape, nonOlBlockShape,
+                [&](const Coord & coordU, const int64_t offsetU, const std::size_t axis,
+                    const LabelType lU, const LabelType lV){
+                    const auto edge = rag.findEdge(lU,lV);
+
+                    VigraCoord vigraCoordU;
+                    VigraCoord vigraCoordV;
+                    for(std::size_t d=0; d<DIM; ++d){
+                        vigraCoordU[d] = coordU[d]+blockBegin[d];
+                        vigraCoordV[d] = vigraCoordU[d];
                     }
+                    ++vigraCoordV[axis];
+
+                    accVec[edge].updatePassN(dataPtr[offsetU], vigraCoordU, pass);
+                    accVec[edge].updatePassN(dataPtr[offsetU + storageStrides[axis]], vigraCoordV, pass);
                 });
             });
         }
@@ -206,6 +201,7 @@ namespace graph{
         typedef typename DATA::value_type DataType;
         typedef typename vigra::MultiArrayShape<DIM>::type  VigraCoord;
         typedef typename GridRag<DIM, LabelsType>::BlockStorageType LabelBlockStorage;
+        typedef typename LabelsType::value_type LabelType;
         typedef tools::BlockStorage<DataType> DataBlockStorage;
 
         typedef array::StaticArray<int64_t, DIM> Coord;
@@ -260,6 +256,7 @@ namespace graph{
             // LOOP IN PARALLEL OVER ALL BLOCKS WITH A CERTAIN OVERLAP
             const Coord overlapBegin(0), overlapEnd(1);
             const Coord storageShape = blockShape + overlapEnd;
+            const Coord storageStrides = tools::rowMajorStrides<DIM>(storageShape);
             LabelBlockStorage labelsBlockStorage(threadpool, storageShape, actualNumberOfThreads);
             DataBlockStorage dataBlockStorage(threadpool, storageShape, actualNumberOfThreads);
             tools::parallelForEachBlockWithOverlap(threadpool,shape, blockShape, overlapBegin, overlapEnd,
@@ -282,42 +279,41 @@ namespace graph{
                 tools::readSubarray(rag.labels(), blockBegin, blockEnd, labelsBlockView);
                 tools::readSubarray(data, blockBegin, blockEnd, dataBlockView);
 
-                // loop over all coordinates in block
-                nifty::tools::forEachCoordinate(nonOlBlockShape,[&](const Coord & coordU){
-
-                    const auto lU = xtensor::read(labelsBlockView, coordU.asStdArray());
-                    const auto dataU = xtensor::read(dataBlockView, coordU.asStdArray());
-
-                    VigraCoord vigraCoordU;
-                    for(std::size_t d=0; d<DIM; ++d)
-                        vigraCoordU[d] = coordU[d] + blockBegin[d];
-
-                    if(pass <= numberOfNodePasses)
-                        nodeAccMap[lU].updatePassN(dataU, vigraCoordU, pass);
-
-                    // accumulate the edge features
-                    if(pass <= numberOfEdgePasses){
-                        for(std::size_t axis=0; axis<DIM; ++axis){
-                            auto coordV = makeCoord2(coordU, axis);
-                            if(coordV[axis] < actualBlockShape[axis]){
-                                const auto lV = xtensor::read(labelsBlockView, coordV.asStdArray());
-                                if(lU != lV){
-
-                                    const auto edge = rag.findEdge(lU,lV);
-                                    const auto dataV = xtensor::read(dataBlockView, coordV.asStdArray());
-
-                                    VigraCoord vigraCoordV;
-                                    for(std::size_t d=0; d<DIM; ++d)
-                                        vigraCoordV[d] = coordV[d] + blockBegin[d];
+                const auto * labelsPtr = xtensor::dataPointer(labelsBlockStorage.getView(tid));
+                const auto * dataPtr = xtensor::dataPointer(dataBlockStorage.getView(tid));
+
+                // accumulate the node features line by line
+                if(pass <= numberOfNodePasses){
+                    tools::forEachScanline(nonOlBlockShape, storageStrides,
+                    [&](const Coord & lineCoord, const int64_t lineOffset){
+                        VigraCoord vigraCoordU;
+                        for(std::size_t d=0; d<DIM; ++d)
+                            vigraCoordU[d] = lineCoord[d] + blockBegin[d];
+                        for(int64_t i = 0; i < nonOlBlockShape[DIM-1]; ++i, ++vigraCoordU[DIM-1]){
+                            nodeAccMap[labelsPtr[lineOffset + i]].updatePassN(dataPtr[lineOffset + i], vigraCoordU, pass);
+                        }
+                    });
+                }
 
-                                    edgeAccMap[edge].updatePassN(dataU, vigraCoordU, pass);
-                                    edgeAccMap[edge].updatePassN(dataV, vigraCoordV, pass);
-                                }
-                            }
+                // accumulate the edge features
+                if(pass <= numberOfEdgePasses){
+                    tools::forEachLabelTransition(labelsPtr, storageStrides, actualBlockShape, nonOlBlockShape,
+                    [&](const Coord & coordU, const int64_t offsetU, const std::size_t axis,
+                        const LabelType lU, const LabelType lV){
+                        const auto edge = rag.findEdge(lU,lV);
+
+                        VigraCoord vigraCoordU;
+                        VigraCoord vigraCoordV;
+                        for(std::size_t d=0; d<DIM; ++d){
+                            vigraCoordU[d] = coordU[d]+blockBegin[d];
+                            vigraCoordV[d] = vigraCoordU[d];
                         }
-                    }
+                        ++vigraCoordV[axis];
 
-                });
+                        edgeAccMap[edge].updatePassN(dataPtr[offsetU], vigraCoordU, pass);
+                        edgeAccMap[edge].updatePassN(dataPtr[offsetU + storageStrides[axis]], vigraCoordV, pass);
+                    });
+                }
             });
         }
 
@@ -376,6 +372,7 @@ namespace graph{
         typedef typename DATA::value_type DataType;
         typedef typename vigra::MultiArrayShape<DIM>::type   VigraCoord;
         typedef typename GridRag<DIM, LabelsType>::BlockStorageType LabelBlockStorage;
+        typedef typename LabelsType::value_type LabelType;
         typedef tools::BlockStorage<DataType> DataBlockStorage;
 
         typedef array::StaticArray<int64_t, DIM> Coord;
@@ -444,6 +441,7 @@ namespace graph{
             // LOOP IN PARALLEL OVER ALL BLOCKS WITH A CERTAIN OVERLAP
             const Coord overlapBegin(0), overlapEnd(1);
             const Coord storageShape = blockShape + overlapEnd;
+            const Coord storageStrides = tools::rowMajorStrides<DIM>(storageShape);
             LabelBlockStorage labelsBlockStorage(threadpool, storageShape, actualNumberOfThreads);
             DataBlockStorage dataBlockStorage(threadpool, storageShape, actualNumberOfThreads);
             tools::parallelForEachBlockWithOverlap(threadpool,shape, blockShape, overlapBegin, overlapEnd,
@@ -473,47 +471,41 @@ namespace graph{
                 //std::cout<<"E4 2\n";
                 tools::readSubarray(data, blockBegin, blockEnd, dataBlockView);
 
-                //std::cout<<"E5\n";
-                // loop over all coordinates in block
-                nifty::tools::forEachCoordinate(nonOlBlockShape,[&](const Coord & coordU){
-
-                    const auto lU = xtensor::read(labelsBlockView, coordU.asStdArray());
-                    const auto dataU = xtensor::read(dataBlockView, coordU.asStdArray());
-
-                    VigraCoord vigraCoordU;
-                    for(std::size_t d=0; d<DIM; ++d){
-                        vigraCoordU[d] = coordU[d] + blockBegin[d];
-                        NIFTY_CHECK_OP(vigraCoordU[d], < ,shape[d],"");
-                    }
+                const auto * labelsPtr = xtensor::dataPointer(labelsBlockStorage.getView(tid));
+                const auto * dataPtr = xtensor::dataPointer(dataBlockStorage.getView(tid));
+
+                // accumulate the node features line by line
+                if(pass <= numberOfNodePasses){
+                    tools::forEachScanline(nonOlBlockShape, storageStrides,
+                    [&](const Coord & lineCoord, const int64_t lineOffset){
+                        VigraCoord vigraCoordU;
+                        for(std::size_t d=0; d<DIM; ++d)
+                            vigraCoordU[d] = lineCoord[d] + blockBegin[d];
+                        for(int64_t i = 0; i < nonOlBlockShape[DIM-1]; ++i, ++vigraCoordU[DIM-1]){
+                            nodeAccVec[labelsPtr[lineOffset + i]].updatePassN(dataPtr[lineOffset + i], vigraCoordU, pass);
+                        }
+                    });
+                }
 
-                    if(pass <= numberOfNodePasses)
-                        nodeAccVec[lU].updatePassN(dataU, vigraCoordU, pass);
-
-                    // accumulate the edge features
-                    if(pass <= numberOfEdgePasses){
-                        for(std::size_t axis=0; axis<DIM; ++axis){
-                            auto coordV = makeCoord2(coordU, axis);
-                            if(coordV[axis] < actualBlockShape[axis]){
-                                const auto lV = xtensor::read(labelsBlockView, coordV.asStdArray());
-                                if(lU != lV){
-
-                                    const auto edge = rag.findEdge(lU,lV);
-                                    const auto dataV = xtensor::read(dataBlockView, coordV.asStdArray());
-
-                                    VigraCoord vigraCoordV;
-                                    for(std::size_t d=0; d<DIM; ++d){
-                                        vigraCoordV[d] = coordV[d] + blockBegin[d];
-                                        NIFTY_CHECK_OP(vigraCoordV[d], < ,shape[d],"");
-                                    }
-
-                                    edgeAccVec[edge].updatePassN(dataU, vigraCoordU, pass);
-                                    edgeAccVec[edge].updatePassN(dataV, vigraCoordV, pass);
-                                }
-                            }
+                // accumulate the edge features
+                if(pass <= numberOfEdgePasses){
+                    tools::forEachLabelTransition(labelsPtr, storageStrides, actualBlockShape, nonOlBlockShape,
+                    [&](const Coord & coordU, const int64_t offsetU, const std::size_t axis,
+                        const LabelType lU, const LabelType lV){
+                        const auto edge = rag.findEdge(lU,lV);
+
+                        VigraCoord vigraCoordU;
+                        VigraCoord vigraCoordV;
+                        for(std::size_t d=0; d<DIM; ++d){
+                            vigraCoordU[d] = coordU[d]+blockBegin[d];
+                            vigraCoordV[d] = vigraCoordU[d];
                         }
-                    }
+                        ++vigraCoordV[axis];
 
-                });
+                        edgeAccVec[edge].updatePassN(dataPtr[offsetU], vigraCoordU, pass);
+                        edgeAccVec[edge].updatePassN(dataPtr[offsetU + storageStrides[axis]], vigraCoordV, pass);
+                    });
+                }
             });
         }
 
@@ -559,6 +551,7 @@ namespace graph{
         typedef LABELS LabelsType;
         typedef typename vigra::MultiArrayShape<DIM>::type   VigraCoord;
         typedef typename GridRag<DIM, LabelsType>::BlockStorageType LabelBlockStorage;
+        typedef typename LabelsType::value_type LabelType;
 
         typedef array::StaticArray<int64_t, DIM> Coord;
 
@@ -590,6 +583,7 @@ namespace graph{
             // LOOP IN PARALLEL OVER ALL BLOCKS WITH A CERTAIN OVERLAP
             const Coord overlapBegin(0), overlapEnd(1);
             const Coord storageShape = blockShape + overlapEnd;
+            const Coord storageStrides = tools::rowMajorStrides<DIM>(storageShape);
             LabelBlockStorage labelsBlockStorage(threadpool, storageShape, actualNumberOfThreads);
             tools::parallelForEachBlockWithOverlap(threadpool,shape, blockShape, overlapBegin, overlapEnd,
             [&](
@@ -609,42 +603,40 @@ namespace graph{
                 auto labelsBlockView = labelsBlockStorage.getView(actualBlockShape, tid);
                 tools::readSubarray(rag.labels(), blockBegin, blockEnd, labelsBlockView);
 
-                // loop over all coordinates in block
-                nifty::tools::forEachCoordinate(nonOlBlockShape,[&](const Coord & coordU){
-
-                    const auto lU = xtensor::read(labelsBlockView, coordU.asStdArray());
-                    const auto dataU = 0.0;
-
-                    VigraCoord vigraCoordU;
-                    for(std::size_t d=0; d<DIM; ++d)
-                        vigraCoordU[d] = coordU[d] + blockBegin[d];
-
-                    if(pass <= numberOfNodePasses)
-                        nodeAccVec[lU].updatePassN(dataU, vigraCoordU, pass);
-
-                    // accumulate the edge features
-                    if(pass <= numberOfEdgePasses){
-                        for(std::size_t axis=0; axis<DIM; ++axis){
-                            auto coordV = makeCoord2(coordU, axis);
-                            if(coordV[axis] < actualBlockShape[axis]){
-                                const auto lV = xtensor::read(labelsBlockView, coordV.asStdArray());
-                                if(lU != lV){
-
-                                    const auto edge = rag.findEdge(lU,lV);
-                                    const auto dataV = 0.0;
-
-                                    VigraCoord vigraCoordV;
-                                    for(std::size_t d=0; d<DIM; ++d)
-                                        vigraCoordV[d] = coordV[d] + blockBegin[d];
+                const auto * labelsPtr = xtensor::dataPointer(labelsBlockStorage.getView(tid));
+
+                // accumulate the node features line by line
+                if(pass <= numberOfNodePasses){
+                    tools::forEachScanline(nonOlBlockShape, storageStrides,
+                    [&](const Coord & lineCoord, const int64_t lineOffset){
+                        VigraCoord vigraCoordU;
+                        for(std::size_t d=0; d<DIM; ++d)
+                            vigraCoordU[d] = lineCoord[d] + blockBegin[d];
+                        for(int64_t i = 0; i < nonOlBlockShape[DIM-1]; ++i, ++vigraCoordU[DIM-1]){
+                            nodeAccVec[labelsPtr[lineOffset + i]].updatePassN(0.0, vigraCoordU, pass);
+                        }
+                    });
+                }
 
-                                    edgeAccVec[edge].updatePassN(dataU, vigraCoordU, pass);
-                                    edgeAccVec[edge].updatePassN(dataV, vigraCoordV, pass);
-                                }
-                            }
+                // accumulate the edge features
+                if(pass <= numberOfEdgePasses){
+                    tools::forEachLabelTransition(labelsPtr, storageStrides, actualBlockShape, nonOlBlockShape,
+                    [&](const Coord & coordU, const int64_t offsetU, const std::size_t axis,
+                        const LabelType lU, const LabelType lV){
+                        const auto edge = rag.findEdge(lU,lV);
+
+                        VigraCoord vigraCoordU;
+                        VigraCoord vigraCoordV;
+                        for(std::size_t d=0; d<DIM; ++d){
+                            vigraCoordU[d] = coordU[d]+blockBegin[d];
+                            vigraCoordV[d] = vigraCoordU[d];
                         }
-                    }
+                        ++vigraCoordV[axis];
 
-                });
+                        edgeAccVec[edge].updatePassN(0.0, vigraCoordU, pass);
+                        edgeAccVec[edge].updatePassN(0.0, vigraCoordV, pass);
+                    });
+                }
             });
         }
 
@@ -34,11 +34,41 @@ void projectScalarNodeDataToPixels(const GridRag<DIM, LABELS> & graph,
     // if scalar
     auto pOpt = nifty::parallel::ParallelOptions(numberOfThreads);
     nifty::parallel::ThreadPool threadpool(pOpt);
-    nifty::tools::parallelForEachCoordinate(threadpool, shape,
-    [&](int tid, const Coord & coord){
-        const auto node = xtensor::read(labels, coord.asStdArray());
-        xtensor::write(pixelData, coord.asStdArray(), nodeData[node]);
-    });
+
+    int64_t size = 1;
+    for(unsigned d = 0; d < DIM; ++d) {
+        size *= shape[d];
+    }
+    if(size == 0) {
+        return;
+    }
+
+    // if labels and pixel data have the same memory layout (e.g. both are c-contiguous)
+    // we can access both with the linear offset
+    Coord strides;
+    bool sameStrides = true;
+    for(unsigned d = 0; d < DIM; ++d) {
+        strides[d] = labels.strides()[d];
+        if(strides[d] != int64_t(pixelData.strides()[d])) {
+            sameStrides = false;
+        }
+    }
+
+    if(sameStrides) {
+        const auto * labelsPtr = xtensor::dataPointer(labels);
+        auto * pixelPtr = xtensor::dataPointer(pixelData);
+        nifty::tools::parallelForEachCoordinateTiled(threadpool, shape, strides,
+        [&](int tid, const Coord & coord, const int64_t offset){
+            pixelPtr[offset] = nodeData[labelsPtr[offset]];
+        });
+    }
+    else {
+        nifty::tools::parallelForEachCoordinateTiled(threadpool, shape,
+        [&](int tid, const Coord & coord, const int64_t offset){
+            const auto node = xtensor::read(labels, coord.asStdArray());
+            xtensor::write(pixelData, coord.asStdArray(), nodeData[node]);
+        });
+    }
 
 }
 
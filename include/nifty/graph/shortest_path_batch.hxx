@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/parallel/threadpool.hxx"
+#include "nifty/graph/shortest_path_dijkstra.hxx"
+
+namespace nifty{
+namespace graph{
+
+    // Run many single source shortest path searches in parallel.
+    //
+    // Every thread owns one ShortestPathDijkstra which is reused
+    // for all sources processed by this thread. Since the dijkstra
+    // only resets the nodes it has touched in its previous run,
+    // a batch of local searches (early stopping at a target or a bounded
+    // radius) costs only as much as the explored neighbourhoods,
+    // not the number of sources times the size of the graph.
+    //
+    // The results are handed to a callback f(threadId, sourceIndex, shortestPath),
+    // which has to extract what it needs before the solver of this
+    // thread is reused for the next source.
+    template<class GRAPH, class WEIGHT_TYPE>
+    class BatchedShortestPathDijkstra{
+    public:
+        typedef GRAPH GraphType;
+        typedef WEIGHT_TYPE WeightType;
+        typedef ShortestPathDijkstra<GraphType, WeightType> ShortestPathType;
+
+        BatchedShortestPathDijkstra(
+            const GraphType & g,
+            const int numberOfThreads = -1
+        )
+        :   g_(g),
+            threadpool_(numberOfThreads),
+            shortestPaths_()
+        {
+            const std::size_t nThreads = std::max(threadpool_.nThreads(), std::size_t(1));
+            for(std::size_t t=0; t<nThreads; ++t){
+                shortestPaths_.emplace_back(new ShortestPathType(g_));
+            }
+        }
+
+        // all nodes within maxDistance of each source
+        template<class EDGE_WEIGHTS, class F>
+        void runSingleSource(
+            const EDGE_WEIGHTS & edgeWeights,
+            const std::vector<int64_t> & sources,
+            const WeightType maxDistance,
+            F && f
+        ){
+            parallel::parallel_foreach(threadpool_, sources.size(), [&](const int tid, const int64_t i){
+                auto & sp = *shortestPaths_[tid];
+                sp.runSingleSource(edgeWeights, sources[i], maxDistance);
+                f(tid, i, static_cast<const ShortestPathType &>(sp));
+            });
+        }
+
+        // all nodes reachable from each source
+        template<class EDGE_WEIGHTS, class F>
+        void runSingleSource(
+            const EDGE_WEIGHTS & edgeWeights,
+            const std::vector<int64_t> & sources,
+            F && f
+        ){
+            runSingleSource(edgeWeights, sources, std::numeric_limits<WeightType>::infinity(), f);
+        }
+
+        // the i-th search stops as soon as targets[i] is reached
+        template<class EDGE_WEIGHTS, class F>
+        void runSingleSourceSingleTarget(
+            const EDGE_WEIGHTS & edgeWeights,
+            const std::vector<int64_t> & sources,
+            const std::vector<int64_t> & targets,
+            F && f
+        ){
+            NIFTY_CHECK_OP(sources.size(), ==, targets.size(), "need one target per source");
+            parallel::parallel_foreach(threadpool_, sources.size(), [&](const int tid, const int64_t i){
+                auto & sp = *shortestPaths_[tid];
+                sp.runSingleSourceSingleTarget(edgeWeights, sources[i], targets[i]);
+                f(tid, i, static_cast<const ShortestPathType &>(sp));
+            });
+        }
+
+        // every search stops as soon as all targets are reached
+        template<class EDGE_WEIGHTS, class F>
+        void runSingleSourceMultiTarget(
+            const EDGE_WEIGHTS & edgeWeights,
+            const std::vector<int64_t> & sources,
+            const std::vector<int64_t> & targets,
+            F && f
+        ){
+            parallel::parallel_foreach(threadpool_, sources.size(), [&](const int tid, const int64_t i){
+                auto & sp = *shortestPaths_[tid];
+                sp.runSingleSourceMultiTarget(edgeWeights, sources[i], targets);
+                f(tid, i, static_cast<const ShortestPathType &>(sp));
+            });
+        }
+
+        // the i-th search stops as soon as all targets[i] are reached
+        template<class EDGE_WEIGHTS, class F>
+        void runSingleSourceMultiTarget(
+            const EDGE_WEIGHTS & edgeWeights,
+            const std::vector<int64_t> & sources,
+            const std::vector<std::vector<int64_t>> & targets,
+            F && f
+        ){
+            NIFTY_CHECK_OP(sources.size(), ==, targets.size(), "need one target vector per source");
+            parallel::parallel_foreach(threadpool_, sources.size(), [&](const int tid, const int64_t i){
+                auto & sp = *shortestPaths_[tid];
+                sp.runSingleSourceMultiTarget(edgeWeights, sources[i], targets[i]);
+                f(tid, i, static_cast<const ShortestPathType &>(sp));
+            });
+        }
+
+        std::size_t numberOfThreads() const {
+            return shortestPaths_.size();
+        }
+
+        const GraphType & graph() const {
+            return g_;
+        }
+
+    private:
+        const GraphType & g_;
+        parallel::ThreadPool threadpool_;
+        std::vector<std::unique_ptr<ShortestPathType>> shortestPaths_;
+    };
+
+} // namespace nifty::graph
+} // namespace nifty
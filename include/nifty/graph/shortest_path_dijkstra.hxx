@@ -1,5 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <limits>
+#include <vector>
+
 #include "nifty/graph/subgraph_mask.hxx"
 #include "nifty/tools/changable_priority_queue.hxx"
 
@@ -22,7 +26,10 @@ namespace graph{
         :   g_(g),
             pq_(g.nodeIdUpperBound()+1),
             predMap_(g),
-            distMap_(g){
+            distMap_(g),
+            touchedNodes_(),
+            isInitialized_(false),
+            maxDistance_(std::numeric_limits<WeightType>::infinity()){
         }
 
         // run single source single target
@@ -60,20 +67,19 @@ namespace graph{
             // subgraph mask
             DefaultSubgraphMask<GraphType> subgraphMask;
             // visitor
+            sortedTargets_.assign(targets.begin(), targets.end());
+            std::sort(sortedTargets_.begin(), sortedTargets_.end());
+            sortedTargets_.erase(std::unique(sortedTargets_.begin(), sortedTargets_.end()), sortedTargets_.end());
             std::size_t trgtsFound = 0;
-            auto visitor = [&targets, &trgtsFound]
+            auto visitor = [this, &trgtsFound]
             (
                 int64_t topNode,
                 const DistanceMap     & distances,
                 const PredecessorsMap & predecessors
             ){
-                if( std::find(targets.begin(), targets.end(), topNode) != targets.end() )
+                if(std::binary_search(sortedTargets_.begin(), sortedTargets_.end(), topNode))
                     ++trgtsFound;
-                if( trgtsFound >= targets.size() ) {
-                    trgtsFound = 0;
-                    return false;
-                }
-                return true;
+                return trgtsFound < sortedTargets_.size();
             };
 
             this->initializeMaps(&source, &source +1);
@@ -101,6 +107,19 @@ namespace graph{
             runImpl(edgeWeights, subgraphMask, visitor);
         }
 
+        // run single source, all targets within maxDistance;
+        // nodes further away keep the predecessor -1
+        template<class EDGE_WEIGHTS>
+        void runSingleSource(
+            const EDGE_WEIGHTS & edgeWeights,
+            const int64_t source,
+            const WeightType maxDistance
+        ){
+            maxDistance_ = maxDistance;
+            runSingleSource(edgeWeights, source);
+            maxDistance_ = std::numeric_limits<WeightType>::infinity();
+        }
+
         template<class EDGE_WEIGHTS, class SOURCE_ITER, class SUBGRAPH_MASK, class VISITOR>
         void run(
             const EDGE_WEIGHTS & edgeWeights,
@@ -124,6 +143,13 @@ namespace graph{
         const GraphType & graph() const {
             return g_;
         }
+
+        // all nodes that got a predecessor in the last run
+        // (the ones that are still -1 were only tentatively reached),
+        // only these are reset for the next run
+        const std::vector<int64_t> & touchedNodes() const {
+            return touchedNodes_;
+        }
     private:
 
         template<
@@ -150,7 +176,7 @@ namespace graph{
                     for(auto adj : g_.adjacency(topNode)){
                         auto otherNode = adj.node();
                         const auto edge = adj.edge();
-                        if(subgraphMask.useNode(otherNode) && subgraphMask.useEdge(otherNode)){
+                        if(subgraphMask.useNode(otherNode) && subgraphMask.useEdge(edge)){
                             if(pq_.contains(otherNode)){
                                 const WeightType currentDist     = distMap_[otherNode];
                                 const WeightType alternativeDist = distMap_[topNode]+edgeWeights[edge];
@@ -162,12 +188,12 @@ namespace graph{
                             }
                             else if(predMap_[otherNode]==-1){
                                 const WeightType initialDist = distMap_[topNode]+edgeWeights[edge];
-                                //if(initialDist<=maxDistance)
-                                //{
-                                pq_.push(otherNode,initialDist);
-                                distMap_[otherNode]=initialDist;
-                                predMap_[otherNode]=topNode;
-                                //}
+                                if(initialDist<=maxDistance_){
+                                    pq_.push(otherNode,initialDist);
+                                    distMap_[otherNode]=initialDist;
+                                    predMap_[otherNode]=topNode;
+                                    touchedNodes_.push_back(otherNode);
+                                }
                             }
                         }
                     }
@@ -181,18 +207,31 @@ namespace graph{
         }
 
 
+        // the predecessors are only reset for the nodes touched in the
+        // last run, so many runs that explore small parts of a large graph
+        // do not pay for the size of the graph
         template<class SOURCE_ITER>
         void initializeMaps(SOURCE_ITER sourceBegin, SOURCE_ITER sourceEnd){
-                
-            for(auto node : g_.nodes()){
-                predMap_[node] = -1;
+
+            if(isInitialized_){
+                for(const auto node : touchedNodes_){
+                    predMap_[node] = -1;
+                }
+            }
+            else{
+                for(auto node : g_.nodes()){
+                    predMap_[node] = -1;
+                }
+                isInitialized_ = true;
             }
+            touchedNodes_.clear();
 
             for( ; sourceBegin!=sourceEnd; ++sourceBegin){
                 auto n = *sourceBegin;
                 distMap_[n] = static_cast<WeightType>(0);
                 predMap_[n] = n;
                 pq_.push(n,static_cast<WeightType>(0));
+                touchedNodes_.push_back(n);
             }
         }
 
@@ -200,6 +239,10 @@ namespace graph{
         PqType pq_;
         PredecessorsMap predMap_;
         DistanceMap     distMap_;
+        std::vector<int64_t> touchedNodes_;
+        std::vector<int64_t> sortedTargets_;
+        bool isInitialized_;
+        WeightType maxDistance_;
     };
 
 } // namespace nifty::graph
@@ -0,0 +1,347 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+#include "nifty/tools/changable_priority_queue.hxx"
+
+namespace nifty{
+namespace graph{
+
+    // Single pair shortest paths (source -> target) for non-negative edge weights.
+    //
+    // Both searches below reuse their maps between runs and only reset
+    // the nodes they touched in the previous run, so that many single pair queries
+    // on a large graph (e.g. a grid graph of a volume) stay cheap.
+
+
+    // Admissible heuristic for 4/6-neighbourhood grid graphs:
+    // every step along an axis costs at least the minimal edge weight,
+    // hence the L1 distance of the pixel coordinates times the minimal
+    // edge weight is a lower bound of the remaining path length.
+    template<class GRID_GRAPH, class WEIGHT_TYPE>
+    class GridGraphL1Heuristic{
+    public:
+        typedef GRID_GRAPH GraphType;
+        typedef WEIGHT_TYPE WeightType;
+
+        GridGraphL1Heuristic(const GraphType & g, const WeightType minEdgeWeight)
+        :   g_(g),
+            minEdgeWeight_(minEdgeWeight){
+        }
+
+        WeightType operator()(const int64_t node, const int64_t target) const {
+            const auto cNode = g_.nodeToCoordinate(node);
+            const auto cTarget = g_.nodeToCoordinate(target);
+            int64_t l1 = 0;
+            for(std::size_t d=0; d<cNode.size(); ++d){
+                l1 += std::abs(cNode[d] - cTarget[d]);
+            }
+            return minEdgeWeight_ * static_cast<WeightType>(l1);
+        }
+    private:
+        const GraphType & g_;
+        WeightType minEdgeWeight_;
+    };
+
+
+    // A* search, the heuristic h(node, target) must be consistent (monotone),
+    // with h == 0 it is a dijkstra with early stopping.
+    template<class GRAPH, class WEIGHT_TYPE>
+    class ShortestPathAStar{
+    public:
+        typedef GRAPH GraphType;
+        typedef WEIGHT_TYPE WeightType;
+
+        typedef typename GraphType:: template NodeMap<int64_t>     PredecessorsMap;
+        typedef typename GraphType:: template NodeMap<WeightType>  DistanceMap;
+    private:
+        typedef nifty::tools::ChangeablePriorityQueue<WeightType>    PqType;
+        typedef typename GraphType:: template NodeMap<uint8_t>     StateMap;
+        enum NodeState{ Unvisited = 0, Open = 1, Closed = 2 };
+    public:
+        ShortestPathAStar(const GraphType & g)
+        :   g_(g),
+            pq_(g.nodeIdUpperBound()+1),
+            predMap_(g, -1),
+            distMap_(g),
+            stateMap_(g, Unvisited),
+            touchedNodes_(),
+            source_(-1),
+            target_(-1){
+        }
+
+        // returns false if the target is not reachable
+        template<class EDGE_WEIGHTS, class HEURISTIC>
+        bool run(
+            const EDGE_WEIGHTS & edgeWeights,
+            const int64_t source,
+            const int64_t target,
+            const HEURISTIC & heuristic
+        ){
+            reset();
+            source_ = source;
+            target_ = target;
+            open(source, source, 0, heuristic(source, target));
+
+            while(!pq_.empty()){
+                const int64_t u = pq_.top();
+                pq_.pop();
+                stateMap_[u] = Closed;
+                if(u == target){
+                    pq_.clear();
+                    return true;
+                }
+                const WeightType du = distMap_[u];
+                for(auto adj : g_.adjacency(u)){
+                    const int64_t v = adj.node();
+                    if(stateMap_[v] == Closed){
+                        continue;
+                    }
+                    const WeightType dv = du + edgeWeights[adj.edge()];
+                    if(stateMap_[v] == Unvisited){
+                        open(v, u, dv, dv + heuristic(v, target));
+                    }
+                    else if(dv < distMap_[v]){
+                        distMap_[v] = dv;
+                        predMap_[v] = u;
+                        pq_.push(v, dv + heuristic(v, target));
+                    }
+                }
+            }
+            return false;
+        }
+
+        // only valid if the last run found the target
+        WeightType distance() const {
+            return distMap_[target_];
+        }
+
+        // node path from source to target
+        void path(std::vector<int64_t> & nodes) const {
+            nodes.clear();
+            if(target_ < 0 || stateMap_[target_] != Closed){
+                return;
+            }
+            for(int64_t node = target_; ; node = predMap_[node]){
+                nodes.push_back(node);
+                if(node == source_){
+                    break;
+                }
+            }
+            std::reverse(nodes.begin(), nodes.end());
+        }
+
+        // number of nodes touched in the last run
+        std::size_t numberOfTouchedNodes() const {
+            return touchedNodes_.size();
+        }
+
+        const GraphType & graph() const {
+            return g_;
+        }
+
+    private:
+        void open(const int64_t node, const int64_t pred, const WeightType dist, const WeightType priority){
+            stateMap_[node] = Open;
+            distMap_[node] = dist;
+            predMap_[node] = pred;
+            pq_.push(node, priority);
+            touchedNodes_.push_back(node);
+        }
+
+        void reset(){
+            for(const auto node : touchedNodes_){
+                stateMap_[node] = Unvisited;
+                predMap_[node] = -1;
+            }
+            touchedNodes_.clear();
+        }
+
+        const GraphType & g_;
+        PqType pq_;
+        PredecessorsMap predMap_;
+        DistanceMap distMap_;
+        StateMap stateMap_;
+        std::vector<int64_t> touchedNodes_;
+        int64_t source_;
+        int64_t target_;
+    };
+
+
+    // Bidirectional dijkstra for undirected graphs: a search from the source and one
+    // from the target are expanded alternately (always the one with the smaller top
+    // priority) until the sum of both top priorities exceeds the best path through
+    // a node reached by both searches.
+    // On grid graphs this roughly halves the radius, i.e. explores ~2 / 2^DIM
+    // of the nodes a single dijkstra would settle.
+    template<class GRAPH, class WEIGHT_TYPE>
+    class ShortestPathBidirectionalDijkstra{
+    public:
+        typedef GRAPH GraphType;
+        typedef WEIGHT_TYPE WeightType;
+
+        typedef typename GraphType:: template NodeMap<int64_t>     PredecessorsMap;
+        typedef typename GraphType:: template NodeMap<WeightType>  DistanceMap;
+    private:
+        typedef nifty::tools::ChangeablePriorityQueue<WeightType>    PqType;
+        typedef typename GraphType:: template NodeMap<uint8_t>     StateMap;
+        enum NodeState{ Unvisited = 0, Open = 1, Closed = 2 };
+
+        struct Search{
+            Search(const GraphType & g)
+            :   pq(g.nodeIdUpperBound()+1),
+                predMap(g, -1),
+                distMap(g),
+                stateMap(g, Unvisited){
+            }
+            PqType pq;
+            PredecessorsMap predMap;
+            DistanceMap distMap;
+            StateMap stateMap;
+        };
+    public:
+        ShortestPathBidirectionalDijkstra(const GraphType & g)
+        :   g_(g),
+            forward_(g),
+            backward_(g),
+            touchedNodes_(),
+            meetingNode_(-1),
+            distance_(std::numeric_limits<WeightType>::infinity()){
+        }
+
+        // returns false if the target is not reachable
+        template<class EDGE_WEIGHTS>
+        bool run(
+            const EDGE_WEIGHTS & edgeWeights,
+            const int64_t source,
+            const int64_t target
+        ){
+            reset();
+            open(forward_, source, source, 0);
+            open(backward_, target, target, 0);
+            if(source == target){
+                meetingNode_ = source;
+                distance_ = 0;
+                forward_.pq.clear();
+                backward_.pq.clear();
+                return true;
+            }
+
+            while(!forward_.pq.empty() && !backward_.pq.empty()){
+                if(forward_.pq.topPriority() + backward_.pq.topPriority() >= distance_){
+                    break;
+                }
+                if(forward_.pq.topPriority() <= backward_.pq.topPriority()){
+                    expand(edgeWeights, forward_, backward_);
+                }
+                else{
+                    expand(edgeWeights, backward_, forward_);
+                }
+            }
+            forward_.pq.clear();
+            backward_.pq.clear();
+            return meetingNode_ >= 0;
+        }
+
+        // only valid if the last run found the target
+        WeightType distance() const {
+            return distance_;
+        }
+
+        // node path from source to target
+        void path(std::vector<int64_t> & nodes) const {
+            nodes.clear();
+            if(meetingNode_ < 0){
+                return;
+            }
+            for(int64_t node = meetingNode_; ; node = forward_.predMap[node]){
+                nodes.push_back(node);
+                if(forward_.predMap[node] == node){
+                    break;
+                }
+            }
+            std::reverse(nodes.begin(), nodes.end());
+            for(int64_t node = meetingNode_; backward_.predMap[node] != node; ){
+                node = backward_.predMap[node];
+                nodes.push_back(node);
+            }
+        }
+
+        // number of nodes touched (by either search) in the last run
+        std::size_t numberOfTouchedNodes() const {
+            return touchedNodes_.size();
+        }
+
+        const GraphType & graph() const {
+            return g_;
+        }
+
+    private:
+        template<class EDGE_WEIGHTS>
+        void expand(const EDGE_WEIGHTS & edgeWeights, Search & search, const Search & other){
+            const int64_t u = search.pq.top();
+            search.pq.pop();
+            search.stateMap[u] = Closed;
+            const WeightType du = search.distMap[u];
+            for(auto adj : g_.adjacency(u)){
+                const int64_t v = adj.node();
+                if(search.stateMap[v] == Closed){
+                    continue;
+                }
+                const WeightType dv = du + edgeWeights[adj.edge()];
+                if(search.stateMap[v] == Unvisited){
+                    open(search, v, u, dv);
+                }
+                else if(dv < search.distMap[v]){
+                    search.distMap[v] = dv;
+                    search.predMap[v] = u;
+                    search.pq.push(v, dv);
+                }
+                else{
+                    continue;
+                }
+                // v got a better distance, check if it connects both searches
+                if(other.stateMap[v] != Unvisited){
+                    const WeightType d = dv + other.distMap[v];
+                    if(d < distance_){
+                        distance_ = d;
+                        meetingNode_ = v;
+                    }
+                }
+            }
+        }
+
+        void open(Search & search, const int64_t node, const int64_t pred, const WeightType dist){
+            search.stateMap[node] = Open;
+            search.distMap[node] = dist;
+            search.predMap[node] = pred;
+            search.pq.push(node, dist);
+            touchedNodes_.push_back(node);
+        }
+
+        void reset(){
+            for(const auto node : touchedNodes_){
+                forward_.stateMap[node] = Unvisited;
+                forward_.predMap[node] = -1;
+                backward_.stateMap[node] = Unvisited;
+                backward_.predMap[node] = -1;
+            }
+            touchedNodes_.clear();
+            meetingNode_ = -1;
+            distance_ = std::numeric_limits<WeightType>::infinity();
+        }
+
+        const GraphType & g_;
+        Search forward_;
+        Search backward_;
+        std::vector<int64_t> touchedNodes_;
+        int64_t meetingNode_;
+        WeightType distance_;
+    };
+
+} // namespace nifty::graph
+} // namespace nifty
@@ -0,0 +1,422 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <type_traits>
+
+#include <boost/iterator/counting_iterator.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/graph/undirected_graph_base.hxx"
+#include "nifty/graph/detail/adjacency.hxx"
+#include "nifty/graph/graph_tags.hxx"
+
+
+namespace nifty{
+namespace graph{
+
+
+// Binary graph snapshot:
+// a versioned file with the graph in CSR form that can be memory-mapped
+// and used read-only without rebuilding any adjacency (see `MappedUndirectedGraph`).
+//
+// Layout (native byte order, all sections are 8 byte aligned):
+//   header          SnapshotHeader
+//   offsets         int64[numberOfNodes + 1]        CSR offsets into the adjacency
+//   adjacency       (int64 node, int64 edge)[2 * numberOfEdges], sorted by node for each node
+//   uvs             int64[numberOfEdges][2]
+//   map table       SnapshotMapEntry[numberOfMaps]
+//   map data        one array per map, padded to 8 bytes
+namespace detail_graph_snapshot{
+
+    const char magic[8] = {'N', 'I', 'F', 'T', 'Y', 'G', 'S', '\0'};
+    const uint64_t currentVersion = 1;
+    const uint64_t byteOrderMark = 0x0102030405060708ULL;
+    const std::size_t maxMapNameLength = 47;
+
+    enum MapKind : uint64_t {EdgeMapKind = 0, NodeMapKind = 1};
+
+    struct SnapshotHeader{
+        char magic[8];
+        uint64_t version;
+        uint64_t byteOrderMark;
+        uint64_t numberOfNodes;
+        uint64_t numberOfEdges;
+        uint64_t numberOfMaps;
+        uint64_t reserved[2];
+    };
+
+    struct SnapshotMapEntry{
+        char name[maxMapNameLength + 1];
+        uint64_t kind;
+        uint64_t typeCode;
+        uint64_t size;
+        uint64_t offset;
+    };
+
+    // type codes of the values that can be stored in maps
+    template<class T> struct TypeCode;
+    template<> struct TypeCode<uint8_t>  { static const uint64_t value = 0; };
+    template<> struct TypeCode<uint32_t> { static const uint64_t value = 1; };
+    template<> struct TypeCode<uint64_t> { static const uint64_t value = 2; };
+    template<> struct TypeCode<int32_t>  { static const uint64_t value = 3; };
+    template<> struct TypeCode<int64_t>  { static const uint64_t value = 4; };
+    template<> struct TypeCode<float>    { static const uint64_t value = 5; };
+    template<> struct TypeCode<double>   { static const uint64_t value = 6; };
+
+    inline uint64_t paddedSize(const uint64_t nBytes){
+        return (nBytes + 7) / 8 * 8;
+    }
+
+    inline void writePadding(std::ofstream & out, const uint64_t nBytes){
+        const char zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        out.write(zeros, paddedSize(nBytes) - nBytes);
+    }
+}
+
+
+// collect the graph and (optional) edge and node maps and write them as snapshot.
+// The maps are not copied, they must stay alive until `write` is called.
+template<class GRAPH>
+class GraphSnapshotWriter{
+public:
+    typedef GRAPH GraphType;
+
+    GraphSnapshotWriter(const GraphType & graph)
+    :   graph_(graph),
+        maps_()
+    {
+        NIFTY_CHECK_OP(static_cast<int64_t>(graph_.numberOfNodes()), ==, graph_.nodeIdUpperBound() + 1,
+                       "graph snapshots need contiguous node ids");
+        NIFTY_CHECK_OP(static_cast<int64_t>(graph_.numberOfEdges()), ==, graph_.edgeIdUpperBound() + 1,
+                       "graph snapshots need contiguous edge ids");
+    }
+
+    // add an edge map (contiguous storage with `data()` and `size()`)
+    template<class MAP>
+    void addEdgeMap(const std::string & name, const MAP & map){
+        NIFTY_CHECK_OP(map.size(), ==, graph_.numberOfEdges(), "edge map has wrong size");
+        addMap(name, detail_graph_snapshot::EdgeMapKind, map.data(), map.size());
+    }
+
+    // add a node map (contiguous storage with `data()` and `size()`)
+    template<class MAP>
+    void addNodeMap(const std::string & name, const MAP & map){
+        NIFTY_CHECK_OP(map.size(), ==, graph_.numberOfNodes(), "node map has wrong size");
+        addMap(name, detail_graph_snapshot::NodeMapKind, map.data(), map.size());
+    }
+
+    void write(const std::string & path) const;
+
+private:
+    struct MapRecord{
+        detail_graph_snapshot::SnapshotMapEntry entry;
+        const char * data;
+        uint64_t nBytes;
+    };
+
+    template<class T>
+    void addMap(const std::string & name, const uint64_t kind, const T * data, const uint64_t size){
+        typedef typename std::remove_cv<T>::type ValueType;
+        NIFTY_CHECK_OP(name.size(), <=, detail_graph_snapshot::maxMapNameLength, "map name is too long");
+        for(const auto & map : maps_){
+            NIFTY_CHECK(name != map.entry.name, "map names must be unique");
+        }
+        MapRecord record;
+        std::memset(&record.entry, 0, sizeof(record.entry));
+        std::copy(name.begin(), name.end(), record.entry.name);
+        record.entry.kind = kind;
+        record.entry.typeCode = detail_graph_snapshot::TypeCode<ValueType>::value;
+        record.entry.size = size;
+        record.data = reinterpret_cast<const char *>(data);
+        record.nBytes = size * sizeof(ValueType);
+        maps_.push_back(record);
+    }
+
+    const GraphType & graph_;
+    std::vector<MapRecord> maps_;
+};
+
+
+template<class GRAPH>
+void GraphSnapshotWriter<GRAPH>::
+write(const std::string & path) const{
+    using namespace detail_graph_snapshot;
+    typedef detail_graph::UndirectedAdjacency<int64_t, int64_t, int64_t, int64_t> NodeAdjacency;
+
+    const uint64_t numberOfNodes = graph_.numberOfNodes();
+    const uint64_t numberOfEdges = graph_.numberOfEdges();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    NIFTY_CHECK(out.good(), "cannot open " + path + " for writing");
+
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::copy(magic, magic + 8, header.magic);
+    header.version = currentVersion;
+    header.byteOrderMark = byteOrderMark;
+    header.numberOfNodes = numberOfNodes;
+    header.numberOfEdges = numberOfEdges;
+    header.numberOfMaps = maps_.size();
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    // csr offsets
+    int64_t offset = 0;
+    out.write(reinterpret_cast<const char *>(&offset), sizeof(int64_t));
+    for(uint64_t node = 0; node < numberOfNodes; ++node){
+        offset += std::distance(graph_.adjacencyBegin(node), graph_.adjacencyEnd(node));
+        out.write(reinterpret_cast<const char *>(&offset), sizeof(int64_t));
+    }
+    NIFTY_CHECK_OP(static_cast<uint64_t>(offset), ==, 2 * numberOfEdges, "adjacency does not match the number of edges");
+
+    // adjacency, sorted by node for each node
+    std::vector<NodeAdjacency> nodeAdjacency;
+    for(uint64_t node = 0; node < numberOfNodes; ++node){
+        nodeAdjacency.clear();
+        for(auto adjIt = graph_.adjacencyBegin(node); adjIt != graph_.adjacencyEnd(node); ++adjIt){
+            nodeAdjacency.emplace_back(adjIt->node(), adjIt->edge());
+        }
+        std::sort(nodeAdjacency.begin(), nodeAdjacency.end());
+        for(const auto & adj : nodeAdjacency){
+            const int64_t adjData[2] = {adj.node(), adj.edge()};
+            out.write(reinterpret_cast<const char *>(adjData), sizeof(adjData));
+        }
+    }
+
+    // uv ids
+    for(uint64_t edge = 0; edge < numberOfEdges; ++edge){
+        const int64_t uv[2] = {graph_.u(edge), graph_.v(edge)};
+        out.write(reinterpret_cast<const char *>(uv), sizeof(uv));
+    }
+
+    // map table and map data
+    uint64_t mapOffset = sizeof(SnapshotHeader)
+                       + (numberOfNodes + 1) * sizeof(int64_t)
+                       + 2 * numberOfEdges * sizeof(NodeAdjacency)
+                       + 2 * numberOfEdges * sizeof(int64_t)
+                       + maps_.size() * sizeof(SnapshotMapEntry);
+    for(const auto & map : maps_){
+        SnapshotMapEntry entry = map.entry;
+        entry.offset = mapOffset;
+        out.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+        mapOffset += paddedSize(map.nBytes);
+    }
+    for(const auto & map : maps_){
+        out.write(map.data, map.nBytes);
+        writePadding(out, map.nBytes);
+    }
+    NIFTY_CHECK(out.good(), "writing the graph snapshot " + path + " failed");
+}
+
+
+// write a graph without maps as snapshot
+template<class GRAPH>
+inline void writeGraphSnapshot(const GRAPH & graph, const std::string & path){
+    GraphSnapshotWriter<GRAPH>(graph).write(path);
+}
+
+
+// Read-only undirected graph on a memory-mapped snapshot.
+// Loading only maps the file, nothing is copied or rebuilt;
+// the adjacency is the mapped CSR array, so all graph algorithms
+// working on the graph API can run directly on the mapped view.
+class MappedUndirectedGraph : public
+    UndirectedGraphBase<
+        MappedUndirectedGraph,
+        boost::counting_iterator<int64_t>,
+        boost::counting_iterator<int64_t>,
+        const detail_graph::UndirectedAdjacency<int64_t, int64_t, int64_t, int64_t> *
+    >
+{
+public:
+    typedef detail_graph::UndirectedAdjacency<int64_t, int64_t, int64_t, int64_t> NodeAdjacency;
+    typedef boost::counting_iterator<int64_t> NodeIter;
+    typedef boost::counting_iterator<int64_t> EdgeIter;
+    typedef const NodeAdjacency * AdjacencyIter;
+
+    typedef ContiguousTag EdgeIdTag;
+    typedef ContiguousTag NodeIdTag;
+
+    typedef SortedTag EdgeIdOrderTag;
+    typedef SortedTag NodeIdOrderTag;
+
+    MappedUndirectedGraph(const std::string & path)
+    :   file_(path.c_str(), boost::interprocess::read_only),
+        region_(file_, boost::interprocess::read_only)
+    {
+        using namespace detail_graph_snapshot;
+        static_assert(sizeof(NodeAdjacency) == 2 * sizeof(int64_t), "unexpected adjacency layout");
+
+        const char * begin = static_cast<const char *>(region_.get_address());
+        const uint64_t fileSize = region_.get_size();
+        NIFTY_CHECK_OP(fileSize, >=, sizeof(SnapshotHeader), "not a graph snapshot");
+
+        const auto & header = *reinterpret_cast<const SnapshotHeader *>(begin);
+        NIFTY_CHECK(std::equal(magic, magic + 8, header.magic), "not a graph snapshot");
+        NIFTY_CHECK_OP(header.byteOrderMark, ==, byteOrderMark, "graph snapshot has a different byte order");
+        NIFTY_CHECK_OP(header.version, ==, currentVersion, "unsupported graph snapshot version");
+        numberOfNodes_ = header.numberOfNodes;
+        numberOfEdges_ = header.numberOfEdges;
+        numberOfMaps_ = header.numberOfMaps;
+
+        const char * ptr = begin + sizeof(SnapshotHeader);
+        offsets_ = reinterpret_cast<const int64_t *>(ptr);
+        ptr += (numberOfNodes_ + 1) * sizeof(int64_t);
+        adjacency_ = reinterpret_cast<const NodeAdjacency *>(ptr);
+        ptr += 2 * numberOfEdges_ * sizeof(NodeAdjacency);
+        uvs_ = reinterpret_cast<const int64_t *>(ptr);
+        ptr += 2 * numberOfEdges_ * sizeof(int64_t);
+        maps_ = reinterpret_cast<const SnapshotMapEntry *>(ptr);
+        ptr += numberOfMaps_ * sizeof(SnapshotMapEntry);
+        NIFTY_CHECK_OP(static_cast<uint64_t>(ptr - begin), <=, fileSize, "graph snapshot is truncated");
+        for(uint64_t mapId = 0; mapId < numberOfMaps_; ++mapId){
+            NIFTY_CHECK_OP(maps_[mapId].offset, <=, fileSize, "graph snapshot is truncated");
+        }
+    }
+
+    // MUST IMPL INTERFACE
+    int64_t u(const int64_t e)const{
+        NIFTY_ASSERT_OP(e,<,numberOfEdges());
+        return uvs_[2 * e];
+    }
+    int64_t v(const int64_t e)const{
+        NIFTY_ASSERT_OP(e,<,numberOfEdges());
+        return uvs_[2 * e + 1];
+    }
+
+    // binary search in the (sorted) adjacency of the node with smaller degree
+    int64_t findEdge(const int64_t u, const int64_t v)const{
+        const bool uSmaller = offsets_[u + 1] - offsets_[u] <= offsets_[v + 1] - offsets_[v];
+        const int64_t source = uSmaller ? u : v;
+        const int64_t target = uSmaller ? v : u;
+        const auto end = adjacencyEnd(source);
+        const auto it = std::lower_bound(adjacencyBegin(source), end, NodeAdjacency(target));
+        if(it != end && it->node() == target){
+            return it->edge();
+        }
+        return -1;
+    }
+
+    int64_t nodeIdUpperBound() const{
+        return numberOfNodes_ - 1;
+    }
+    int64_t edgeIdUpperBound() const{
+        return numberOfEdges_ - 1;
+    }
+    uint64_t numberOfEdges() const{
+        return numberOfEdges_;
+    }
+    uint64_t numberOfNodes() const{
+        return numberOfNodes_;
+    }
+
+    NodeIter nodesBegin()const{
+        return NodeIter(0);
+    }
+    NodeIter nodesEnd()const{
+        return NodeIter(numberOfNodes_);
+    }
+    EdgeIter edgesBegin()const{
+        return EdgeIter(0);
+    }
+    EdgeIter edgesEnd()const{
+        return EdgeIter(numberOfEdges_);
+    }
+
+    AdjacencyIter adjacencyBegin(const int64_t node)const{
+        return adjacency_ + offsets_[node];
+    }
+    AdjacencyIter adjacencyEnd(const int64_t node)const{
+        return adjacency_ + offsets_[node + 1];
+    }
+    AdjacencyIter adjacencyOutBegin(const int64_t node)const{
+        return adjacencyBegin(node);
+    }
+
+    // direct access to the mapped arrays
+    const int64_t * uvIdsData() const{
+        return uvs_;
+    }
+    const int64_t * adjacencyOffsetsData() const{
+        return offsets_;
+    }
+
+    // maps stored in the snapshot (read-only views into the mapped file)
+    bool hasEdgeMap(const std::string & name) const{
+        return findMap(name, detail_graph_snapshot::EdgeMapKind) != nullptr;
+    }
+    bool hasNodeMap(const std::string & name) const{
+        return findMap(name, detail_graph_snapshot::NodeMapKind) != nullptr;
+    }
+    template<class T>
+    const T * edgeMap(const std::string & name) const{
+        return mapData<T>(name, detail_graph_snapshot::EdgeMapKind);
+    }
+    template<class T>
+    const T * nodeMap(const std::string & name) const{
+        return mapData<T>(name, detail_graph_snapshot::NodeMapKind);
+    }
+
+    // names and type codes of all maps
+    void mapNames(std::vector<std::string> & edgeMapNames,
+                  std::vector<std::string> & nodeMapNames) const{
+        edgeMapNames.clear();
+        nodeMapNames.clear();
+        for(uint64_t mapId = 0; mapId < numberOfMaps_; ++mapId){
+            const auto & entry = maps_[mapId];
+            auto & names = entry.kind == detail_graph_snapshot::EdgeMapKind ? edgeMapNames : nodeMapNames;
+            names.emplace_back(entry.name);
+        }
+    }
+
+    uint64_t mapTypeCode(const std::string & name, const bool isEdgeMap) const{
+        const auto entry = findMap(name, isEdgeMap ? detail_graph_snapshot::EdgeMapKind
+                                                   : detail_graph_snapshot::NodeMapKind);
+        NIFTY_CHECK(entry != nullptr, "graph snapshot has no map " + name);
+        return entry->typeCode;
+    }
+
+private:
+    const detail_graph_snapshot::SnapshotMapEntry * findMap(const std::string & name,
+                                                            const uint64_t kind) const{
+        for(uint64_t mapId = 0; mapId < numberOfMaps_; ++mapId){
+            const auto & entry = maps_[mapId];
+            if(entry.kind == kind && name == entry.name){
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    template<class T>
+    const T * mapData(const std::string & name, const uint64_t kind) const{
+        const auto entry = findMap(name, kind);
+        NIFTY_CHECK(entry != nullptr, "graph snapshot has no map " + name);
+        NIFTY_CHECK_OP(entry->typeCode, ==, detail_graph_snapshot::TypeCode<T>::value,
+                       "map " + name + " has a different value type");
+        NIFTY_CHECK_OP(entry->offset + entry->size * sizeof(T), <=, region_.get_size(),
+                       "graph snapshot is truncated");
+        return reinterpret_cast<const T *>(static_cast<const char *>(region_.get_address()) + entry->offset);
+    }
+
+    boost::interprocess::file_mapping file_;
+    boost::interprocess::mapped_region region_;
+
+    uint64_t numberOfNodes_;
+    uint64_t numberOfEdges_;
+    uint64_t numberOfMaps_;
+    const int64_t * offsets_;
+    const NodeAdjacency * adjacency_;
+    const int64_t * uvs_;
+    const detail_graph_snapshot::SnapshotMapEntry * maps_;
+};
+
+
+} // namespace nifty::graph
+} // namespace nifty
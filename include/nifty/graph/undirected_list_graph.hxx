@@ -135,7 +135,9 @@ public:
         std::vector<EDGE_INTERNAL_TYPE> &) const;
 
     // extract all the edges that connect nodes in the node list
-    void edgesFromNodeList(const std::vector<NODE_INTERNAL_TYPE> & nodeList,
+    // (any container of node ids, e.g. std::vector or a numpy array)
+    template<class NODE_LIST>
+    void edgesFromNodeList(const NODE_LIST & nodeList,
             std::vector<EDGE_INTERNAL_TYPE> & edges) {
         std::unordered_set<EDGE_INTERNAL_TYPE> edgesTmp;
         NODE_INTERNAL_TYPE v;
@@ -55,44 +55,68 @@ namespace graph{
 
                 nifty::parallel::ParallelOptions pOpts(numberOfThreads);
                 nifty::parallel::ThreadPool threadpool(pOpts);
-                const std::size_t actualNumberOfThreads = pOpts.getActualNumThreads();
-
-                nifty::tools::parallelForEachCoordinate(threadpool,
-                    shape,
-                    [&](const auto threadId, const auto & coordP){
-                        const auto u = graph.coordianteToNode(coordP);
-                        for(int io=0; io<offsets.size(); ++io){
-                            const auto offset = offsets[io];
-                            const auto coordQ = offset + coordP;
-                            // Check if both coordinates are in the volume:
-                            if(coordQ.allInsideShape(shape)){
-                                const auto v = graph.coordianteToNode(coordQ);
-
-                                // Check if the edge is valid
-                                bool isValidEdge = true;
-                                if (not isLocalOffset[io]) {
-                                    // Check the longRangeStrides:
-                                    for(int d=0; d<DIM; ++d){
-                                        if (coordP[d] % graph.longRangeStrides()[d] != 0) {
-                                            isValidEdge = false;
-                                        }
-                                    }
-                                    // Check if the edge should be added according to the probability:
-                                    array::StaticArray<int64_t, DIM + 1> noise_index;
-                                    std::copy(std::begin(coordP), std::end(coordP), std::begin(noise_index));
-                                    noise_index[DIM] = io;
-                                    if (randomProbs[noise_index] >= offsets_probs[io])
-                                        isValidEdge = false;
-                                }
 
-                                // Insert new edge in graph:
-                                if (isValidEdge) {
-                                    const auto e = graph.insertEdge(u, v);
+                typedef array::StaticArray<int64_t, DIM> Coord;
+                const std::size_t nOffsets = offsets.size();
+                const auto & longRangeStrides = graph.longRangeStrides();
+
+                // node ids are the c-order linear offsets of the coordinates,
+                // so the neighbor along an offset has a constant id difference
+                const Coord strides = nifty::tools::rowMajorStrides<DIM>(shape);
+                std::vector<int64_t> nodeOffsets(nOffsets, 0);
+                for(std::size_t io = 0; io < nOffsets; ++io){
+                    for(int d = 0; d < DIM; ++d){
+                        nodeOffsets[io] += offsets[io][d] * strides[d];
+                    }
+                }
+
+                // the validity of the edges is determined in parallel (over tiles),
+                // inserting the edges is not thread safe and done afterwards in
+                // the same order as a serial pass over the coordinates
+                std::vector<uint8_t> isValidEdge(graph.numberOfNodes() * nOffsets, 0);
+                nifty::tools::parallelForEachCoordinateTiled(threadpool,
+                    shape, strides,
+                    [&](const int threadId, const Coord & coordP, const int64_t u){
+                        bool onLongRangeStride = true;
+                        for(int d=0; d<DIM; ++d){
+                            if (coordP[d] % longRangeStrides[d] != 0) {
+                                onLongRangeStride = false;
+                                break;
+                            }
+                        }
+                        for(std::size_t io=0; io<nOffsets; ++io){
+                            const auto coordQ = offsets[io] + coordP;
+                            // Check if both coordinates are in the volume:
+                            if(!coordQ.allInsideShape(shape)){
+                                continue;
+                            }
+                            // Check if the edge is valid
+                            if (not isLocalOffset[io]) {
+                                // Check the longRangeStrides:
+                                if(!onLongRangeStride){
+                                    continue;
                                 }
+                                // Check if the edge should be added according to the probability:
+                                array::StaticArray<int64_t, DIM + 1> noise_index;
+                                std::copy(std::begin(coordP), std::end(coordP), std::begin(noise_index));
+                                noise_index[DIM] = io;
+                                if (randomProbs[noise_index] >= offsets_probs[io])
+                                    continue;
                             }
+                            isValidEdge[u * nOffsets + io] = 1;
                         }
                     }
                 );
+
+                // Insert new edges in graph:
+                const int64_t nNodes = graph.numberOfNodes();
+                for(int64_t u = 0; u < nNodes; ++u){
+                    for(std::size_t io = 0; io < nOffsets; ++io){
+                        if(isValidEdge[u * nOffsets + io]){
+                            graph.insertEdge(u, u + nodeOffsets[io]);
+                        }
+                    }
+                }
             }
         };
     }
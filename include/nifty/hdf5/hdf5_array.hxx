@@ -1,18 +1,135 @@
 #pragma once
 
 #include <cstddef>
+#include <cstring>
 #include <string>
 #include <vector>
+#include <mutex>
+
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef WITH_BLOSC
+#include <blosc.h>
+#endif
 
 #include "xtensor/xarray.hpp"
 
 #include "nifty/hdf5/hdf5.hxx"
 #include "nifty/tools/block_access.hxx"
 #include "nifty/tools/runtime_check.hxx"
+#include "nifty/parallel/threadpool.hxx"
+#include "nifty/xtensor/xtensor.hxx"
+
+// H5Dread_chunk is available since 1.10.3
+#if H5_VERSION_GE(1, 10, 3)
+#define NIFTY_HDF5_HAVE_READ_CHUNK
+#endif
 
 namespace nifty{
 namespace hdf5{
 
+    ///\cond
+    namespace detail_hdf5{
+
+        // the raw chunk reads in the direct chunk read mode are
+        // serialized with this lock, decompression and copying are not
+        inline std::mutex & chunkReadMutex(){
+            static std::mutex mut;
+            return mut;
+        }
+
+        // hdf5 filter id of blosc (registered by the blosc hdf5 plugin)
+        const H5Z_filter_t H5Z_FILTER_BLOSC_ID = 32001;
+
+        // copy the intersection of a contiguous (c-order) block [blockBegin, blockBegin + blockShape)
+        // into out, which holds the roi [roiBegin, roiBegin + roiShape) with the given element strides
+        template<class T>
+        inline void copyBlockToRoi(const T * block,
+                                   const std::vector<uint64_t> & blockBegin,
+                                   const std::vector<uint64_t> & blockShape,
+                                   const std::vector<uint64_t> & roiBegin,
+                                   const std::vector<uint64_t> & roiShape,
+                                   T * out,
+                                   const std::vector<int64_t> & outStrides){
+            const std::size_t dim = blockShape.size();
+
+            // the intersection in global coordinates
+            std::vector<uint64_t> begin(dim), end(dim), blockStrides(dim);
+            for(std::size_t d = 0; d < dim; ++d){
+                begin[d] = std::max(blockBegin[d], roiBegin[d]);
+                end[d] = std::min(blockBegin[d] + blockShape[d], roiBegin[d] + roiShape[d]);
+                if(end[d] <= begin[d]){
+                    return;
+                }
+            }
+            uint64_t stride = 1;
+            for(int d = int(dim) - 1; d >= 0; --d){
+                blockStrides[d] = stride;
+                stride *= blockShape[d];
+            }
+
+            // copy line by line along the last axis
+            const uint64_t lineLength = end[dim - 1] - begin[dim - 1];
+            const bool contiguousLines = lineLength == 1 || outStrides[dim - 1] == 1;
+            std::vector<uint64_t> coord(begin);
+            while(true){
+                int64_t blockOffset = 0, outOffset = 0;
+                for(std::size_t d = 0; d < dim; ++d){
+                    blockOffset += (coord[d] - blockBegin[d]) * blockStrides[d];
+                    outOffset += int64_t(coord[d] - roiBegin[d]) * outStrides[d];
+                }
+                if(contiguousLines){
+                    std::memcpy(out + outOffset, block + blockOffset, lineLength * sizeof(T));
+                }
+                else{
+                    for(uint64_t i = 0; i < lineLength; ++i){
+                        out[outOffset + i * outStrides[dim - 1]] = block[blockOffset + i];
+                    }
+                }
+
+                // next line
+                int d = int(dim) - 2;
+                for(; d >= 0; --d){
+                    if(++coord[d] < end[d]){
+                        break;
+                    }
+                    coord[d] = begin[d];
+                }
+                if(d < 0){
+                    break;
+                }
+            }
+        }
+
+        // element strides of an array
+        template<class ARRAY>
+        inline std::vector<int64_t> elementStrides(const ARRAY & array){
+            const std::size_t dim = array.dimension();
+            std::vector<int64_t> strides(dim);
+            for(std::size_t d = 0; d < dim; ++d){
+                strides[d] = array.strides()[d];
+            }
+            return strides;
+        }
+
+        template<class ARRAY>
+        inline bool isCOrderContiguous(const ARRAY & array){
+            const std::size_t dim = array.dimension();
+            int64_t stride = 1;
+            for(int d = int(dim) - 1; d >= 0; --d){
+                if(array.shape()[d] != 1 && int64_t(array.strides()[d]) != stride){
+                    return false;
+                }
+                stride *= array.shape()[d];
+            }
+            return true;
+        }
+
+    } // namespace nifty::hdf5::detail_hdf5
+    ///\endcond
+
     template<class T>
     class Hdf5Array{
     public:
@@ -32,7 +149,10 @@ namespace hdf5{
         :   groupHandle_(groupHandle),
             dataset_(),
             datatype_(),
-            isChunked_(true)
+            isChunked_(true),
+            directChunkRead_(false),
+            canReadChunksDirectly_(false),
+            fillValue_(0)
         {
             datatype_ = H5Tcopy(hdf5Type<T>());
             const auto dim = std::distance(shapeBegin, shapeEnd);
@@ -81,6 +201,8 @@ namespace hdf5{
             // close the dataspace and the chunk properties
             H5Sclose(dataspace);
             H5Pclose(dcplId);
+
+            this->loadFilters();
         }
 
 
@@ -95,7 +217,10 @@ namespace hdf5{
         :   groupHandle_(groupHandle),
             dataset_(),
             datatype_(),
-            isChunked_(false)
+            isChunked_(false),
+            directChunkRead_(false),
+            canReadChunksDirectly_(false),
+            fillValue_(0)
         {
             datatype_ = H5Tcopy(hdf5Type<T>());
             const auto dim = std::distance(shapeBegin, shapeEnd);
@@ -127,6 +252,8 @@ namespace hdf5{
             // close the dataspace and the chunk properties
             H5Sclose(dataspace);
             H5Pclose(dcplId);
+
+            this->loadFilters();
         }
 
         Hdf5Array(
@@ -136,7 +263,10 @@ namespace hdf5{
         :   groupHandle_(groupHandle),
             dataset_(),
             datatype_(),
-            isChunked_(true)
+            isChunked_(true),
+            directChunkRead_(false),
+            canReadChunksDirectly_(false),
+            fillValue_(0)
         {
 
             dataset_ = H5Dopen(groupHandle_, datasetName.c_str(), H5P_DEFAULT);
@@ -153,6 +283,7 @@ namespace hdf5{
 
             this->loadShape(shape_);
             this->loadChunkShape(chunkShape_);
+            this->loadFilters();
         }
 
         int setCache(){
@@ -188,6 +319,26 @@ namespace hdf5{
             return isChunked_;
         }
 
+        // In the direct chunk read mode, the raw (compressed) chunks are fetched with
+        // H5Dread_chunk while holding a lock, and decompressed and copied outside of the
+        // lock, so that reads from many threads don't serialize on the hdf5 library.
+        // This is only used if the dataset is chunked and all its filters are supported
+        // (gzip, shuffle and blosc), otherwise we fall back to hyperslab reads.
+        void setDirectChunkRead(const bool directChunkRead){
+            directChunkRead_ = directChunkRead;
+        }
+
+        bool directChunkRead()const{
+            return directChunkRead_;
+        }
+
+        bool canReadChunksDirectly()const{
+            return canReadChunksDirectly_;
+        }
+
+        // read the roi starting at roiBeginIter with the shape of out;
+        // out may be a strided view (e.g. from tools::BlockStorage),
+        // the data is written into it directly
         template<class ITER, class ARRAY>
         void readSubarray(
             ITER roiBeginIter,
@@ -196,9 +347,34 @@ namespace hdf5{
             NIFTY_CHECK_OP(out.dimension(),==,
                            this->dimension(),
                            "out has wrong dimension");
-            this->loadHyperslab(roiBeginIter,
-                                roiBeginIter + out.dimension(),
-                                out.shape().begin(), out);
+            if(directChunkRead_ && canReadChunksDirectly_){
+                this->readChunksDirectly(roiBeginIter, out, nullptr);
+            }
+            else{
+                this->loadHyperslab(roiBeginIter,
+                                    roiBeginIter + out.dimension(),
+                                    out.shape().begin(), out);
+            }
+        }
+
+        // same as above, but the chunks are decompressed in parallel
+        template<class ITER, class ARRAY>
+        void readSubarray(
+            ITER roiBeginIter,
+            ARRAY & out,
+            parallel::ThreadPool & threadpool
+        )const{
+            NIFTY_CHECK_OP(out.dimension(),==,
+                           this->dimension(),
+                           "out has wrong dimension");
+            if(directChunkRead_ && canReadChunksDirectly_){
+                this->readChunksDirectly(roiBeginIter, out, &threadpool);
+            }
+            else{
+                this->loadHyperslab(roiBeginIter,
+                                    roiBeginIter + out.dimension(),
+                                    out.shape().begin(), out);
+            }
         }
 
         template<class ITER, class ARRAY>
@@ -213,6 +389,225 @@ namespace hdf5{
         }
 
     private:
+        template<class ITER, class ARRAY>
+        void readChunksDirectly(
+            ITER roiBeginIter,
+            ARRAY & out,
+            parallel::ThreadPool * threadpool
+        ) const {
+            const std::size_t dim = this->dimension();
+            std::vector<uint64_t> roiBegin(dim), roiShape(dim);
+            std::vector<uint64_t> chunkBegin(dim), chunksPerAxis(dim);
+            uint64_t nChunks = 1;
+            for(std::size_t d = 0; d < dim; ++d){
+                roiBegin[d] = *roiBeginIter;
+                ++roiBeginIter;
+                roiShape[d] = out.shape()[d];
+                if(roiShape[d] == 0){
+                    return;
+                }
+                NIFTY_CHECK_OP(roiBegin[d] + roiShape[d], <=, shape_[d], "roi is out of range");
+                chunkBegin[d] = roiBegin[d] / chunkShape_[d];
+                chunksPerAxis[d] = (roiBegin[d] + roiShape[d] - 1) / chunkShape_[d] - chunkBegin[d] + 1;
+                nChunks *= chunksPerAxis[d];
+            }
+
+            T * outPtr = xtensor::dataPointer(out);
+            const auto outStrides = detail_hdf5::elementStrides(out);
+
+            // scratch buffers for the compressed and decompressed chunk
+            struct Buffers{
+                std::vector<char> raw;
+                std::vector<char> tmp;
+            };
+
+            auto readChunk = [&](Buffers & buffers, const uint64_t chunkIndex){
+                std::vector<uint64_t> blockBegin(dim);
+                uint64_t rest = chunkIndex;
+                for(int d = int(dim) - 1; d >= 0; --d){
+                    blockBegin[d] = (chunkBegin[d] + rest % chunksPerAxis[d]) * chunkShape_[d];
+                    rest /= chunksPerAxis[d];
+                }
+                const T * chunk = this->readChunk(blockBegin, buffers.raw, buffers.tmp);
+                detail_hdf5::copyBlockToRoi(chunk, blockBegin, chunkShape_,
+                                            roiBegin, roiShape, outPtr, outStrides);
+            };
+
+            if(threadpool == nullptr || nChunks == 1){
+                Buffers buffers;
+                for(uint64_t chunkIndex = 0; chunkIndex < nChunks; ++chunkIndex){
+                    readChunk(buffers, chunkIndex);
+                }
+            }
+            else{
+                std::vector<Buffers> perThreadBuffers(threadpool->nThreads());
+                parallel::parallel_foreach(*threadpool, nChunks, [&](const int tid, const int64_t chunkIndex){
+                    readChunk(perThreadBuffers[tid], chunkIndex);
+                });
+            }
+        }
+
+        // read and decode the chunk starting at blockBegin,
+        // returns a pointer to the decoded (c-order) chunk, which lives in raw or tmp
+        const T * readChunk(
+            const std::vector<uint64_t> & blockBegin,
+            std::vector<char> & raw,
+            std::vector<char> & tmp
+        ) const {
+            const std::size_t dim = this->dimension();
+            uint64_t chunkSize = 1;
+            std::vector<hsize_t> offset(dim);
+            for(std::size_t d = 0; d < dim; ++d){
+                offset[d] = blockBegin[d];
+                chunkSize *= chunkShape_[d];
+            }
+            const std::size_t chunkBytes = chunkSize * sizeof(T);
+
+            // fetch the raw chunk, this is the only part that needs the lock
+            uint32_t filterMask = 0;
+            bool isAllocated = false;
+            #ifdef NIFTY_HDF5_HAVE_READ_CHUNK
+            {
+                std::lock_guard<std::mutex> lock(detail_hdf5::chunkReadMutex());
+                hsize_t storageSize = 0;
+                #if H5_VERSION_GE(1, 10, 5)
+                // the storage size alone does not tell us if the chunk was written
+                haddr_t address = HADDR_UNDEF;
+                if(H5Dget_chunk_info_by_coord(dataset_, offset.data(), &filterMask, &address, &storageSize) < 0 ||
+                   address == HADDR_UNDEF){
+                    storageSize = 0;
+                }
+                #else
+                if(H5Dget_chunk_storage_size(dataset_, offset.data(), &storageSize) < 0){
+                    storageSize = 0;
+                }
+                #endif
+                if(storageSize > 0){
+                    raw.resize(storageSize);
+                    if(H5Dread_chunk(dataset_, H5P_DEFAULT, offset.data(), &filterMask, raw.data()) < 0){
+                        throw std::runtime_error("Cannot read chunk from dataset.");
+                    }
+                    isAllocated = true;
+                }
+            }
+            #endif
+
+            // chunks that were never written contain the fill value
+            if(!isAllocated){
+                raw.resize(chunkBytes);
+                T * data = reinterpret_cast<T *>(raw.data());
+                std::fill(data, data + chunkSize, fillValue_);
+                return data;
+            }
+
+            // undo the filters in reverse order, unless they were skipped for this chunk
+            std::vector<char> * current = &raw;
+            std::vector<char> * next = &tmp;
+            for(int i = int(filters_.size()) - 1; i >= 0; --i){
+                if(filterMask & (1u << i)){
+                    continue;
+                }
+                next->resize(chunkBytes);
+                this->decodeFilter(filters_[i], *current, *next, chunkBytes);
+                std::swap(current, next);
+            }
+            if(current->size() != chunkBytes){
+                throw std::runtime_error("Decoded chunk has the wrong size.");
+            }
+            return reinterpret_cast<const T *>(current->data());
+        }
+
+        void decodeFilter(
+            const H5Z_filter_t filter,
+            const std::vector<char> & in,
+            std::vector<char> & out,
+            const std::size_t chunkBytes
+        ) const {
+            if(filter == H5Z_FILTER_SHUFFLE){
+                // the shuffle filter stores the i-th byte of all elements contiguously
+                const std::size_t nElements = chunkBytes / sizeof(T);
+                for(std::size_t b = 0; b < sizeof(T); ++b){
+                    const char * src = in.data() + b * nElements;
+                    for(std::size_t i = 0; i < nElements; ++i){
+                        out[i * sizeof(T) + b] = src[i];
+                    }
+                }
+            }
+            #ifdef WITH_ZLIB
+            else if(filter == H5Z_FILTER_DEFLATE){
+                uLongf outSize = chunkBytes;
+                const auto status = uncompress(reinterpret_cast<Bytef *>(out.data()), &outSize,
+                                               reinterpret_cast<const Bytef *>(in.data()), in.size());
+                if(status != Z_OK || outSize != chunkBytes){
+                    throw std::runtime_error("Cannot decompress gzip chunk.");
+                }
+            }
+            #endif
+            #ifdef WITH_BLOSC
+            else if(filter == detail_hdf5::H5Z_FILTER_BLOSC_ID){
+                const int outSize = blosc_decompress_ctx(in.data(), out.data(), chunkBytes, 1);
+                if(outSize != int(chunkBytes)){
+                    throw std::runtime_error("Cannot decompress blosc chunk.");
+                }
+            }
+            #endif
+            else{
+                throw std::runtime_error("Unsupported hdf5 filter.");
+            }
+        }
+
+        static bool isFilterSupported(const H5Z_filter_t filter){
+            if(filter == H5Z_FILTER_SHUFFLE){
+                return true;
+            }
+            #ifdef WITH_ZLIB
+            if(filter == H5Z_FILTER_DEFLATE){
+                return true;
+            }
+            #endif
+            #ifdef WITH_BLOSC
+            if(filter == detail_hdf5::H5Z_FILTER_BLOSC_ID){
+                return true;
+            }
+            #endif
+            return false;
+        }
+
+        // load the filter pipeline and the fill value and check
+        // if we can decode the chunks ourselves
+        void loadFilters(){
+            filters_.clear();
+            canReadChunksDirectly_ = false;
+            auto plist = H5Dget_create_plist(dataset_);
+            if(plist < 0){
+                return;
+            }
+
+            T fill;
+            if(H5Pget_fill_value(plist, hdf5Type<T>(), &fill) >= 0){
+                fillValue_ = fill;
+            }
+
+            bool supported = isChunked_;
+            const int nFilters = H5Pget_nfilters(plist);
+            for(int i = 0; i < nFilters; ++i){
+                unsigned int flags;
+                std::size_t nElements = 0;
+                unsigned int filterConfig;
+                const H5Z_filter_t filter = H5Pget_filter2(plist, unsigned(i), &flags, &nElements,
+                                                           NULL, 0, NULL, &filterConfig);
+                filters_.push_back(filter);
+                if(!isFilterSupported(filter)){
+                    supported = false;
+                }
+            }
+            H5Pclose(plist);
+
+            #ifdef NIFTY_HDF5_HAVE_READ_CHUNK
+            canReadChunksDirectly_ = supported;
+            #endif
+        }
+
         template<class BaseIterator, class ShapeIterator, class ARRAY>
         void loadHyperslab(
             BaseIterator baseBegin,
@@ -258,9 +653,21 @@ namespace hdf5{
                 throw std::runtime_error("Cannot select hyperslab. Check offset and shape s!");
             }
 
+            // if out is not contiguous (e.g. a view into a larger block storage),
+            // we read into a buffer and copy
+            const bool isContiguous = detail_hdf5::isCOrderContiguous(out);
+            std::vector<T> buffer;
+            if(!isContiguous) {
+                std::size_t bufferSize = 1;
+                for(std::size_t j = 0; j < size; ++j) {
+                    bufferSize *= arrayShape[j];
+                }
+                buffer.resize(bufferSize);
+            }
+
             // read from dataspace into memspace
             status = H5Dread(dataset_, datatype_, memspace, dataspace,
-                             H5P_DEFAULT, &(out(0)));
+                             H5P_DEFAULT, isContiguous ? xtensor::dataPointer(out) : buffer.data());
 
             // clean up
             H5Sclose(memspace);
@@ -268,6 +675,13 @@ namespace hdf5{
             if(status < 0) {
                 throw std::runtime_error("Cannot read from dataset.");
             }
+
+            if(!isContiguous) {
+                const std::vector<uint64_t> roiBegin(offset.begin(), offset.end());
+                const std::vector<uint64_t> roiShape(arrayShape.begin(), arrayShape.end());
+                detail_hdf5::copyBlockToRoi(buffer.data(), roiBegin, roiShape, roiBegin, roiShape,
+                                            xtensor::dataPointer(out), detail_hdf5::elementStrides(out));
+            }
         }
 
         template<class BaseIterator, class ShapeIterator, class ARRAY>
@@ -385,6 +799,10 @@ namespace hdf5{
         std::vector<uint64_t> shape_;
         std::vector<uint64_t> chunkShape_;
         bool isChunked_;
+        bool directChunkRead_;
+        bool canReadChunksDirectly_;
+        std::vector<H5Z_filter_t> filters_;
+        T fillValue_;
     };
 } // namespace nifty::hdf5
 
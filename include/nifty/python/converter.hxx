@@ -3,6 +3,7 @@
 #include <cctype>
 #include <type_traits>
 #include <initializer_list>
+#include <vector>
 #include <iostream>
 
 #include <pybind11/pybind11.h>
@@ -21,6 +22,32 @@ namespace nifty{
         r[0] = std::tolower(name[0]);
         return r;
     }
+
+    // move the vector into a numpy array without copying:
+    // the vector is owned by a capsule that is freed with the array
+    template<class T>
+    inline py::array_t<T> vectorToNumpy(std::vector<T> && vec,
+                                        std::vector<std::size_t> shape = std::vector<std::size_t>()) {
+        if(shape.empty()) {
+            shape.push_back(vec.size());
+        }
+        auto owner = new std::vector<T>(std::move(vec));
+        py::capsule capsule(owner, [](void * ptr) {
+            delete reinterpret_cast<std::vector<T> *>(ptr);
+        });
+        return py::array_t<T>(shape, owner->data(), capsule);
+    }
+
+    // read-only numpy view of external memory, 'base' keeps the owner of the memory alive
+    template<class T>
+    inline py::array_t<T> readOnlyView(const T * data,
+                                       const std::vector<std::size_t> & shape,
+                                       const std::vector<std::size_t> & strides,
+                                       py::handle base) {
+        py::array_t<T> view(shape, strides, data, base);
+        py::detail::array_proxy(view.ptr())->flags &= ~py::detail::npy_api::NPY_ARRAY_WRITEABLE_;
+        return view;
+    }
 }
 
 namespace pybind11{
@@ -4,28 +4,184 @@
 
 #include "xtensor/xtensor.hpp"
 #include "nifty/tools/for_each_coordinate.hxx"
+#include "nifty/xtensor/xtensor.hxx"
 
 namespace nifty {
 namespace segmentation {
 
+    ///\cond
+    namespace detail_affinities {
+
+        // generic implementation for arbitrary dimension and memory layout
+        template<class LABELS, class AFFS, class MASK>
+        void compute_affinities_generic(const LABELS & labels,
+                                        const std::vector<std::vector<int>> & offsets,
+                                        AFFS & affs,
+                                        MASK & mask,
+                                        const bool have_ignore_label,
+                                        const uint64_t ignore_label) {
+            typedef typename AFFS::value_type AffinityType;
+            typedef typename LABELS::value_type LabelType;
+
+            const unsigned ndim = labels.dimension();
+            const xt::xindex shape(labels.shape().begin(), labels.shape().end());
+            const xt::xindex aff_shape(affs.shape().begin(), affs.shape().end());
+
+            // initialize coordinates
+            xt::xindex coord(ndim), ngb_coord(ndim);
+
+            // get the affinity and mask value for each affinity coordinate
+            nifty::tools::forEachCoordinate(aff_shape, [&](const xt::xindex & aff_coord){
+
+                // set the spatial coordinates
+                std::copy(aff_coord.begin() + 1, aff_coord.end(), coord.begin());
+                ngb_coord = coord;
+                // set the spatial coords from the offsets
+                const auto & offset = offsets[aff_coord[0]];
+
+                bool out_of_range = false;
+                for(unsigned d = 0; d < ndim; ++d) {
+                    ngb_coord[d] += offset[d];
+                    if(ngb_coord[d] < 0 || ngb_coord[d] >= shape[d]) {
+                        out_of_range = true;
+                        mask[aff_coord] = 0;
+                        break;
+                    }
+                }
+
+                if(out_of_range) {
+                    return;
+                }
+
+                const LabelType label = labels[coord];
+                const LabelType label_ngb = labels[ngb_coord];
+
+                if(have_ignore_label) {
+                    if(label == ignore_label || label_ngb == ignore_label) {
+                        mask[aff_coord] = 0;
+                        return;
+                    }
+                }
+
+                affs[aff_coord] = static_cast<AffinityType>(label == label_ngb);
+                mask[aff_coord] = 1;
+            });
+        }
+
+
+        // implementation for fixed dimension, if the spatial strides of labels,
+        // affinities and mask agree; pixels are accessed via their linear offset
+        // and the tiles are processed in parallel
+        template<std::size_t DIM, class LABELS, class AFFS, class MASK>
+        void compute_affinities_nd(const LABELS & labels,
+                                   const std::vector<std::vector<int>> & offsets,
+                                   AFFS & affs,
+                                   MASK & mask,
+                                   const bool have_ignore_label,
+                                   const uint64_t ignore_label,
+                                   const int number_of_threads) {
+            typedef typename AFFS::value_type AffinityType;
+            typedef typename MASK::value_type MaskType;
+            typedef typename LABELS::value_type LabelType;
+            typedef array::StaticArray<int64_t, DIM> Coord;
+
+            Coord shape, strides;
+            for(unsigned d = 0; d < DIM; ++d) {
+                shape[d] = labels.shape()[d];
+                strides[d] = labels.strides()[d];
+            }
+            const int64_t channel_stride = affs.strides()[0];
+
+            // for each channel: the neighbor offset and the range of
+            // coordinates that have their neighbor inside of the volume
+            const std::size_t n_channels = offsets.size();
+            std::vector<int64_t> ngb_offsets(n_channels, 0);
+            std::vector<Coord> begin_valid(n_channels), end_valid(n_channels);
+            for(std::size_t c = 0; c < n_channels; ++c) {
+                for(unsigned d = 0; d < DIM; ++d) {
+                    const int64_t off = offsets[c][d];
+                    ngb_offsets[c] += off * strides[d];
+                    begin_valid[c][d] = std::max<int64_t>(0, -off);
+                    end_valid[c][d] = std::min<int64_t>(shape[d], shape[d] - off);
+                }
+            }
+
+            const LabelType * labels_ptr = xtensor::dataPointer(labels);
+            AffinityType * affs_ptr = xtensor::dataPointer(affs);
+            MaskType * mask_ptr = xtensor::dataPointer(mask);
+
+            nifty::parallel::ParallelOptions p_opts(number_of_threads);
+            nifty::parallel::ThreadPool threadpool(p_opts);
+            nifty::tools::parallelForEachCoordinateTiled(threadpool, shape, strides,
+            [&](const int tid, const Coord & coord, const int64_t offset){
+                const LabelType label = labels_ptr[offset];
+                for(std::size_t c = 0; c < n_channels; ++c) {
+                    const int64_t aff_offset = c * channel_stride + offset;
+
+                    bool out_of_range = false;
+                    for(unsigned d = 0; d < DIM; ++d) {
+                        if(coord[d] < begin_valid[c][d] || coord[d] >= end_valid[c][d]) {
+                            out_of_range = true;
+                            break;
+                        }
+                    }
+                    if(out_of_range) {
+                        mask_ptr[aff_offset] = 0;
+                        continue;
+                    }
+
+                    const LabelType label_ngb = labels_ptr[offset + ngb_offsets[c]];
+                    if(have_ignore_label) {
+                        if(label == ignore_label || label_ngb == ignore_label) {
+                            mask_ptr[aff_offset] = 0;
+                            continue;
+                        }
+                    }
+
+                    affs_ptr[aff_offset] = static_cast<AffinityType>(label == label_ngb);
+                    mask_ptr[aff_offset] = 1;
+                }
+            });
+        }
+
+
+        template<class LABELS, class AFFS, class MASK>
+        inline bool have_matching_strides(const LABELS & labels, const AFFS & affs, const MASK & mask) {
+            const unsigned ndim = labels.dimension();
+            if(affs.strides()[0] != mask.strides()[0]) {
+                return false;
+            }
+            for(unsigned d = 0; d < ndim; ++d) {
+                if(labels.shape()[d] == 1) {
+                    continue;
+                }
+                if(int64_t(labels.strides()[d]) != int64_t(affs.strides()[d + 1]) ||
+                   int64_t(labels.strides()[d]) != int64_t(mask.strides()[d + 1])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    }
+    ///\endcond
+
+
     template<class LABELS, class AFFS, class MASK>
     void compute_affinities(const xt::xexpression<LABELS> & labels_exp,
                             const std::vector<std::vector<int>> & offsets,
                             xt::xexpression<AFFS> & affs_exp,
                             xt::xexpression<MASK> & mask_exp,
                             const bool have_ignore_label=false,
-                            const uint64_t ignore_label=0) {
+                            const uint64_t ignore_label=0,
+                            const int number_of_threads=1) {
         const auto & labels = labels_exp.derived_cast();
         auto & affs = affs_exp.derived_cast();
         auto & mask = mask_exp.derived_cast();
 
-        typedef typename AFFS::value_type AffinityType;
-        typedef typename LABELS::value_type LabelType;
-
         // get the number of dimensions, and the shapes of
         // labels and affinities
         const unsigned ndim = labels.dimension();
-        const xt::xindex shape(labels.shape().begin(), labels.shape().end());
         // check that dimensions agree
         if(ndim + 1 != affs.dimension()) {
             throw std::runtime_error("Dimensions of labels and affinities do not agree.");
@@ -40,45 +196,28 @@ namespace segmentation {
             throw std::runtime_error("Number of channels in affinities and offsets do not agree.");
         }
 
-        // initialize coordinates
-        xt::xindex coord(ndim), ngb_coord(ndim);
-
-        // get the affinity and mask value for each affinity coordinate
-        nifty::tools::forEachCoordinate(aff_shape, [&](const xt::xindex & aff_coord){
-
-            // set the spatial coordinates
-            std::copy(aff_coord.begin() + 1, aff_coord.end(), coord.begin());
-            ngb_coord = coord;
-            // set the spatial coords from the offsets
-            const auto & offset = offsets[aff_coord[0]];
-
-            bool out_of_range = false;
-            for(unsigned d = 0; d < ndim; ++d) {
-                ngb_coord[d] += offset[d];
-                if(ngb_coord[d] < 0 || ngb_coord[d] >= shape[d]) {
-                    out_of_range = true;
-                    mask[aff_coord] = 0;
-                    break;
-                }
-            }
+        if(labels.size() == 0 || n_channels == 0) {
+            return;
+        }
 
-            if(out_of_range) {
+        // fast path for 2d and 3d with matching memory layout
+        if(detail_affinities::have_matching_strides(labels, affs, mask)) {
+            if(ndim == 2) {
+                detail_affinities::compute_affinities_nd<2>(labels, offsets, affs, mask,
+                                                            have_ignore_label, ignore_label,
+                                                            number_of_threads);
                 return;
             }
-
-            const LabelType label = labels[coord];
-            const LabelType label_ngb = labels[ngb_coord];
-
-            if(have_ignore_label) {
-                if(label == ignore_label || label_ngb == ignore_label) {
-                    mask[aff_coord] = 0;
-                    return;
-                }
+            else if(ndim == 3) {
+                detail_affinities::compute_affinities_nd<3>(labels, offsets, affs, mask,
+                                                            have_ignore_label, ignore_label,
+                                                            number_of_threads);
+                return;
             }
+        }
 
-            affs[aff_coord] = static_cast<AffinityType>(label == label_ngb);
-            mask[aff_coord] = 1;
-        });
+        detail_affinities::compute_affinities_generic(labels, offsets, affs, mask,
+                                                      have_ignore_label, ignore_label);
     }
 
 }
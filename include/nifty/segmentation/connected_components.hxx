@@ -1,91 +1,106 @@
 #include "boost/pending/disjoint_sets.hpp"
 #include "xtensor/xtensor.hpp"
 #include "nifty/tools/for_each_coordinate.hxx"
+#include "nifty/parallel/threadpool.hxx"
+#include "nifty/ufd/concurrent_ufd.hxx"
 
 #include <boost/container/flat_set.hpp>
 #include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 
 namespace nifty {
 namespace segmentation {
 
 
-    template<class AFFS, class LABELS>
-    inline size_t connected_components(const xt::xexpression<AFFS> & affinities_exp,
-                                       xt::xexpression<LABELS> & labels_exp,
-                                       const float threshold) {
-
-        typedef typename LABELS::value_type LabelType;
-        const auto & affs = affinities_exp.derived_cast();
-        auto & labels = labels_exp.derived_cast();
+    namespace detail_cc {
 
-        const auto & shape = labels.shape();
-        const unsigned dim = shape.size();
+        template<class AFFS, class COORD, std::size_t ... I>
+        inline auto readAffinity(const AFFS & affs, const std::size_t channel,
+                                 const COORD & coord, std::index_sequence<I...>) {
+            return affs(channel, coord[I]...);
+        }
 
-        // create and initialise union find
-        const size_t n_nodes = labels.size();
-        std::vector<LabelType> rank(n_nodes);
-        std::vector<LabelType> parent(n_nodes);
-        boost::disjoint_sets<LabelType*, LabelType*> sets(&rank[0], &parent[0]);
-        for(LabelType node_id = 0; node_id < n_nodes; ++node_id) {
-            sets.make_set(node_id);
+        template<class LABELS, class COORD, class T, std::size_t ... I>
+        inline void writeLabel(LABELS & labels, const COORD & coord,
+                               const T label, std::index_sequence<I...>) {
+            labels(coord[I]...) = label;
         }
 
-        // First pass:
-        // iterate over each coordinate and create new label at coordinate
-        // or assign representative of the neighbor label
-        LabelType current_label = 0;
-        nifty::tools::forEachCoordinate(shape, [&](const xt::xindex & coord){
-
-            // get the spatial part of the affinity coordinate
-            xt::xindex aff_coord(affs.dimension());
-            std::copy(coord.begin(), coord.end(), aff_coord.begin() + 1);
-
-            // iterate over all neighbors with smaller coordiates
-            // (corresponding to affinity neighbors) and collect the labels
-            // if neighbors that are connected
-            std::set<LabelType> ngb_labels;
-            for(unsigned d = 0; d < dim; ++d) {
-                xt::xindex ngb_coord = coord;
-                ngb_coord[d] -= 1;
-                // perform range check
-                if(ngb_coord[d] < 0 || ngb_coord[d] >= shape[d]) {
-                    continue;  // continue if out of range
+        template<std::size_t DIM, class AFFS, class LABELS>
+        inline std::size_t connected_components(const AFFS & affs,
+                                                LABELS & labels,
+                                                const float threshold,
+                                                const int number_of_threads) {
+            typedef typename LABELS::value_type LabelType;
+            typedef array::StaticArray<int64_t, DIM> Coord;
+            typedef std::make_index_sequence<DIM> Indices;
+
+            Coord shape;
+            for(unsigned d = 0; d < DIM; ++d) {
+                shape[d] = labels.shape()[d];
+            }
+            const Coord strides = tools::rowMajorStrides<DIM>(shape);
+            const std::size_t n_nodes = labels.size();
+
+            parallel::ThreadPool threadpool(number_of_threads);
+
+            // merge all pixels that are connected to their lower neighbors,
+            // the ufd is concurrent, so all threads can merge at once
+            ufd::ConcurrentUfd<uint64_t> sets(n_nodes);
+            tools::parallelForEachCoordinateTiled(threadpool, shape,
+            [&](const int tid, const Coord & coord, const int64_t offset){
+                for(unsigned d = 0; d < DIM; ++d) {
+                    if(coord[d] == 0) {
+                        continue;
+                    }
+                    if(readAffinity(affs, d, coord, Indices()) > threshold) {
+                        sets.merge(offset, offset - strides[d]);
+                    }
                 }
-                // set the proper dimension in the affinity coordinate
-                aff_coord[0] = d;
-                // check if the neighbor is connected and appen its label if so
-                if(affs[aff_coord] > threshold) {
-                    ngb_labels.insert(labels[ngb_coord]);
+            });
+
+            // the representative is the smallest pixel index of a component,
+            // so enumerating them gives consecutive labels in scan order
+            std::vector<LabelType> dense_labels(n_nodes);
+            LabelType current_label = 0;
+            for(std::size_t node = 0; node < n_nodes; ++node) {
+                if(sets.isRepresentative(node)) {
+                    dense_labels[node] = ++current_label;
                 }
             }
 
-            // check if we are connected to any of the neighbors
-            // and if the neighbor labels need to be merged
-            if(ngb_labels.size() == 0) {
-                // no connection -> make new label @ current pixel
-                labels[coord] = ++current_label;
-            } else if (ngb_labels.size() == 1) {
-                // only single label -> we assign its representative to the current pixel
-                labels[coord] = sets.find_set(*ngb_labels.begin());
-            } else {
-                // multiple labels -> we merge them and assign representative to the current pixel
-                std::vector<LabelType> tmp_labels(ngb_labels.begin(), ngb_labels.end());
-                for(unsigned ii = 1; ii < tmp_labels.size(); ++ii) {
-                    sets.link(tmp_labels[ii - 1], tmp_labels[ii]);
-                }
-                labels[coord] = sets.find_set(tmp_labels[0]);
-            }
-        });
+            tools::parallelForEachCoordinateTiled(threadpool, shape,
+            [&](const int tid, const Coord & coord, const int64_t offset){
+                writeLabel(labels, coord, dense_labels[sets.find(offset)], Indices());
+            });
+            return current_label;
+        }
 
-        // Second pass:
-        // Assign representative to each pixel
-        nifty::tools::forEachCoordinate(shape, [&](const xt::xindex & coord){
-            labels[coord] = sets.find_set(labels[coord]);
-        });
+    }
 
-        // FIXME this is not necessarily the correct max value !!!
-        return current_label;
+
+    // label the connected components of the pixel grid;
+    // a pixel is connected to its lower neighbor along axis d if
+    // affinities(d, pixel) > threshold.
+    // the labels start at 1 and are consecutive, the number of components is returned
+    template<class AFFS, class LABELS>
+    inline size_t connected_components(const xt::xexpression<AFFS> & affinities_exp,
+                                       xt::xexpression<LABELS> & labels_exp,
+                                       const float threshold,
+                                       const int number_of_threads=1) {
+        const auto & affs = affinities_exp.derived_cast();
+        auto & labels = labels_exp.derived_cast();
+
+        switch(labels.shape().size()) {
+            case 1: return detail_cc::connected_components<1>(affs, labels, threshold, number_of_threads);
+            case 2: return detail_cc::connected_components<2>(affs, labels, threshold, number_of_threads);
+            case 3: return detail_cc::connected_components<3>(affs, labels, threshold, number_of_threads);
+            case 4: return detail_cc::connected_components<4>(affs, labels, threshold, number_of_threads);
+            default: throw std::runtime_error("connected_components: only up to 4 dimensions are supported");
+        }
     }
 
     template<class EDGE_ARRAY, class WEIGHT_ARRAY, class NODE_ARRAY>
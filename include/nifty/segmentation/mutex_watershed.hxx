@@ -2,9 +2,14 @@
 #include <boost/pending/disjoint_sets.hpp>
 #include <boost/container/flat_set.hpp>
 #include "xtensor/xtensor.hpp"
+#include <algorithm>
 #include <queue>
 #include <functional>
 #include <iostream>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace nifty {
 namespace segmentation {
@@ -64,6 +69,251 @@ namespace segmentation {
     }
 
 
+    ///\cond
+    namespace detail_mws {
+
+        inline void prefetch_address(const void * address) {
+            #if defined(__GNUC__)
+            __builtin_prefetch(address);
+            #endif
+        }
+
+        // insert a sorted range into a mutex set
+        template<class MUTEX_SET, class ITER>
+        inline void insert_range(MUTEX_SET & mutexes, ITER begin, ITER end) {
+            mutexes.insert(begin, end);
+        }
+
+        template<class ITER>
+        inline void insert_range(boost::container::flat_set<uint64_t> & mutexes, ITER begin, ITER end) {
+            mutexes.insert(boost::container::ordered_unique_range, begin, end);
+        }
+
+
+        // Union find with the mutex constraints between the roots stored per root.
+        // Linking follows boost::disjoint_sets (union by rank), hence the
+        // representatives are the same as for the boost implementation.
+        // The default flat sets are compact for the few constraints per cluster of
+        // the kruskal mws; hash sets keep lookups and updates constant when
+        // clusters collect many constraints (divisive mws).
+        template<class MUTEX_SET = boost::container::flat_set<uint64_t>>
+        class MutexUnionFind {
+        public:
+            typedef MUTEX_SET MutexSet;
+
+            MutexUnionFind(const uint64_t number_of_nodes)
+            :   parents_(number_of_nodes),
+                ranks_(number_of_nodes, 0),
+                mutexes_(number_of_nodes){
+                std::iota(parents_.begin(), parents_.end(), uint64_t(0));
+            }
+
+            // find with full path compression
+            inline uint64_t find(const uint64_t node) {
+                uint64_t root = node;
+                while(parents_[root] != root) {
+                    root = parents_[root];
+                }
+                uint64_t current = node;
+                while(current != root) {
+                    const uint64_t next = parents_[current];
+                    parents_[current] = root;
+                    current = next;
+                }
+                return root;
+            }
+
+            inline void prefetch(const uint64_t node) const {
+                prefetch_address(&parents_[node]);
+            }
+
+            // check if there is a mutex constraint between the roots 'ru' and 'rv'
+            inline bool check_mutex(const uint64_t ru, const uint64_t rv) const {
+                const auto & mutexes_u = mutexes_[ru];
+                const auto & mutexes_v = mutexes_[rv];
+                if(mutexes_u.size() < mutexes_v.size()) {
+                    return mutexes_u.find(rv) != mutexes_u.end();
+                }
+                return mutexes_v.find(ru) != mutexes_v.end();
+            }
+
+            // constrain the roots 'ru' and 'rv'
+            inline void insert_mutex(const uint64_t ru, const uint64_t rv) {
+                mutexes_[ru].insert(rv);
+                mutexes_[rv].insert(ru);
+            }
+
+            // link the roots 'ru' and 'rv' and merge their mutex constraints
+            // (the roots may be constrained), returns the new root
+            inline uint64_t merge(const uint64_t ru, const uint64_t rv) {
+                uint64_t root_to = rv, root_from = ru;
+                if(ranks_[ru] > ranks_[rv]) {
+                    std::swap(root_to, root_from);
+                }
+                else if(ranks_[ru] == ranks_[rv]) {
+                    ++ranks_[rv];
+                }
+                parents_[root_from] = root_to;
+                merge_mutexes(root_from, root_to);
+                return root_to;
+            }
+
+        private:
+            inline void merge_mutexes(const uint64_t root_from, const uint64_t root_to) {
+                auto & mutexes_from = mutexes_[root_from];
+                if(mutexes_from.empty()) {
+                    return;
+                }
+                // the clusters constrained with 'root_from' are now constrained with 'root_to'
+                for(const auto v : mutexes_from) {
+                    if(v != root_to) {
+                        auto & mutexes_v = mutexes_[v];
+                        mutexes_v.erase(root_from);
+                        mutexes_v.insert(root_to);
+                    }
+                }
+                // insert the smaller set into the larger one
+                auto & mutexes_to = mutexes_[root_to];
+                if(mutexes_to.size() < mutexes_from.size()) {
+                    mutexes_to.swap(mutexes_from);
+                }
+                insert_range(mutexes_to, mutexes_from.begin(), mutexes_from.end());
+                mutexes_to.erase(root_from);
+                mutexes_to.erase(root_to);
+                MutexSet().swap(mutexes_from);
+            }
+
+            std::vector<uint64_t> parents_;
+            std::vector<uint8_t> ranks_;
+            std::vector<MutexSet> mutexes_;
+        };
+
+
+        // Decode the flat edge ids (channel * number_of_nodes + node) of affinities
+        // into the nodes (u, v) using the precomputed linear offset strides.
+        class FlatEdgeDecoder {
+        public:
+            FlatEdgeDecoder(const std::vector<int64_t> & offset_strides, const uint64_t number_of_nodes)
+            :   number_of_nodes_(number_of_nodes),
+                offset_strides_(offset_strides){
+            }
+            inline void uv(const uint64_t edge_id, uint64_t & u, uint64_t & v) const {
+                u = edge_id % number_of_nodes_;
+                v = u + offset_strides_[edge_id / number_of_nodes_];
+            }
+        private:
+            uint64_t number_of_nodes_;
+            std::vector<int64_t> offset_strides_;
+        };
+
+
+        // The mutex watershed visits the edges in the order of their weights, hence the
+        // union find lookups are random accesses; prefetching the nodes of an edge
+        // a few iterations ahead hides a good part of the cache misses.
+        template<class INDICES, class VALID_ARRAY, class UFD>
+        inline void prefetch_edge(const INDICES & sorted_flat_indices,
+                                  const VALID_ARRAY & valid_edges,
+                                  const size_t i,
+                                  const FlatEdgeDecoder & decoder,
+                                  const UFD & ufd) {
+            const size_t prefetch_distance = 16;
+            if(i + prefetch_distance < sorted_flat_indices.size()) {
+                const uint64_t edge_id = sorted_flat_indices(i + prefetch_distance);
+                // semantic edges are not decoded
+                if(edge_id >= valid_edges.size()) {
+                    return;
+                }
+                uint64_t u, v;
+                decoder.uv(edge_id, u, v);
+                prefetch_address(&valid_edges(edge_id));
+                ufd.prefetch(u);
+                ufd.prefetch(v);
+            }
+        }
+
+
+        // linear strides of the offsets in a c-order image
+        inline std::vector<int64_t> compute_offset_strides(const std::vector<std::vector<int>> & offsets,
+                                                           const std::vector<int> & image_shape) {
+            const int ndims = image_shape.size();
+            std::vector<int64_t> array_stride(ndims);
+            int64_t current_stride = 1;
+            for(int i = ndims - 1; i >= 0; --i) {
+                array_stride[i] = current_stride;
+                current_stride *= image_shape[i];
+            }
+            std::vector<int64_t> offset_strides;
+            offset_strides.reserve(offsets.size());
+            for(const auto & offset : offsets) {
+                int64_t stride = 0;
+                for(int i = 0; i < offset.size(); ++i) {
+                    stride += offset[i] * array_stride[i];
+                }
+                offset_strides.push_back(stride);
+            }
+            return offset_strides;
+        }
+
+
+        // Kruskal mws for clusters that can carry a label (semantic class or seed, 0 = no label).
+        // Clusters with different labels are mutually exclusive. The flat indices after the
+        // affinity edges are semantic edges (label - 1) * number_of_nodes + node, which label
+        // the cluster of the node if it has no label yet.
+        template<class INDICES, class VALID_ARRAY>
+        inline void labeled_mws_kruskal(const INDICES & sorted_flat_indices,
+                                        const VALID_ARRAY & valid_edges,
+                                        const FlatEdgeDecoder & decoder,
+                                        const uint64_t number_of_nodes,
+                                        const uint64_t number_of_attractive_edges,
+                                        MutexUnionFind<> & ufd,
+                                        std::vector<uint64_t> & root_labels) {
+            const uint64_t number_of_affinity_edges = valid_edges.size();
+            const size_t number_of_sorted_edges = sorted_flat_indices.size();
+            for(size_t i = 0; i < number_of_sorted_edges; ++i) {
+                prefetch_edge(sorted_flat_indices, valid_edges, i, decoder, ufd);
+
+                const uint64_t edge_id = sorted_flat_indices(i);
+
+                if(edge_id >= number_of_affinity_edges) {
+                    const uint64_t semantic_id = edge_id - number_of_affinity_edges;
+                    const uint64_t ru = ufd.find(semantic_id % number_of_nodes);
+                    if(root_labels[ru] == 0) {
+                        root_labels[ru] = semantic_id / number_of_nodes + 1;
+                    }
+                    continue;
+                }
+
+                if(!valid_edges(edge_id)){
+                    continue;
+                }
+
+                uint64_t u, v;
+                decoder.uv(edge_id, u, v);
+                const uint64_t ru = ufd.find(u);
+                const uint64_t rv = ufd.find(v);
+                if(ru == rv || ufd.check_mutex(ru, rv)) {
+                    continue;
+                }
+
+                if(edge_id >= number_of_attractive_edges) {
+                    ufd.insert_mutex(ru, rv);
+                    continue;
+                }
+
+                // clusters with different labels are never merged
+                const uint64_t lu = root_labels[ru];
+                const uint64_t lv = root_labels[rv];
+                if(lu != 0 && lv != 0 && lu != lv) {
+                    continue;
+                }
+                root_labels[ufd.merge(ru, rv)] = std::max(lu, lv);
+            }
+        }
+
+    }
+    ///\endcond
+
+
     // compute mutex clustering for a graph with attrative and mutex edges
     template<class EDGE_ARRAY, class WEIGHT_ARRAY, class NODE_ARRAY>
     void compute_mws_clustering(const size_t number_of_labels,
@@ -175,95 +425,53 @@ namespace segmentation {
         // determine number of nodes and attractive edges (considering all edges, not only valid ones)
         const size_t number_of_nodes = node_labeling.size();
         const size_t number_of_attractive_edges = number_of_nodes * number_of_attractive_channels;
-        const size_t number_of_offsets = offsets.size();
-        const size_t ndims = offsets[0].size();
 
-        // Define helper vector to find pair (u,v) from edge_id:
-        std::vector<int64_t> array_stride(ndims);
-        int64_t current_stride = 1;
-        for (int i = ndims-1; i >= 0; --i){
-            array_stride[i] = current_stride;
-            current_stride *= image_shape[i];
-//            std::cout << i << " " << array_stride[i] << "\n";
-        }
-        std::vector<int64_t> offset_strides;
-        for (const auto & offset: offsets){
-            int64_t stride = 0;
-            for (int i = 0; i < offset.size(); ++i){
-                stride += offset[i] * array_stride[i];
-            }
-            offset_strides.push_back(stride);
-//            std::cout << stride << "\n";
-        }
+        // linear strides to find the pair (u,v) from the edge_id
+        const auto offset_strides = detail_mws::compute_offset_strides(offsets, image_shape);
 
-        // make ufd
-        std::vector<uint64_t> ranks(number_of_nodes);
-        std::vector<uint64_t> parents(number_of_nodes);
-        boost::disjoint_sets<uint64_t*, uint64_t*> ufd(&ranks[0], &parents[0]);
-        for(uint64_t label = 0; label < number_of_nodes; ++label) {
-            ufd.make_set(label);
-        }
-
-        // New data structure for storing mutex edges:
-        typedef boost::container::flat_set<uint64_t> SetType;
-        typedef std::vector<SetType> MutexStorage;
-        MutexStorage mutexes(number_of_nodes);
+        const detail_mws::FlatEdgeDecoder decoder(offset_strides, number_of_nodes);
+        detail_mws::MutexUnionFind<> ufd(number_of_nodes);
 
         // iterate over all edges
-        for(const size_t edge_id : sorted_flat_indices) {
+        const size_t number_of_sorted_edges = sorted_flat_indices.size();
+        for(size_t i = 0; i < number_of_sorted_edges; ++i) {
+            detail_mws::prefetch_edge(sorted_flat_indices, valid_edges, i, decoder, ufd);
 
+            const uint64_t edge_id = sorted_flat_indices(i);
             if(!valid_edges(edge_id)){
                 continue;
             }
 
-            // check whether this edge is mutex via the edge offset
-            const bool is_mutex_edge = edge_id >= number_of_attractive_edges;
-
             // get nodes connected by edge of edge_id
-
-            // const auto affCoord_ = xt::unravel_from_strides(edge_id, strides, layout);
-            const uint64_t u = edge_id % number_of_nodes;
-            const uint64_t v = u + offset_strides[edge_id / number_of_nodes];
-//            std::cout << u << " " << v << " " << is_mutex_edge << " ";
+            uint64_t u, v;
+            decoder.uv(edge_id, u, v);
 
             // find the current representatives
-            uint64_t ru = ufd.find_set(u);
-            uint64_t rv = ufd.find_set(v);
-
-            // if the nodes are already connected, do nothing
+            // and skip if the nodes are already connected
+            const uint64_t ru = ufd.find(u);
+            const uint64_t rv = ufd.find(v);
             if(ru == rv) {
-//                std::cout << " --> Connected \n";
                 continue;
             }
 
             // if we already have a mutex, we do not need to do anything
             // (if this is a regular edge, we do not link, if it is a mutex edge
             //  we do not need to insert the redundant mutex constraint)
-            if(check_mutex(ru, rv, mutexes)) {
-//                std::cout << " --> Already mutex \n";
+            if(ufd.check_mutex(ru, rv)) {
                 continue;
             }
 
-            if(is_mutex_edge) {
-//                std::cout << " --> Add mutex \n";
-                // insert the mutex edge into both mutex edge storages
-                insert_mutex(ru, rv, mutexes);
-
+            // check whether this edge is mutex via the edge offset
+            if(edge_id >= number_of_attractive_edges) {
+                ufd.insert_mutex(ru, rv);
             } else {
-//                std::cout << " --> Merge \n";
-                ufd.link(u, v);
-                // check  if we have to swap the roots
-                if(ufd.find_set(ru) == rv) {
-                    std::swap(ru, rv);
-                }
-                // merge mutexes from rv -> ru
-                merge_mutexes(rv, ru, mutexes);
+                ufd.merge(ru, rv);
             }
         }
 
         // get node labeling into output
         for(size_t label = 0; label < number_of_nodes; ++label) {
-            node_labeling[label] = ufd.find_set(label);
+            node_labeling[label] = ufd.find(label);
         }
     }
 
@@ -284,171 +492,183 @@ namespace segmentation {
         // determine number of nodes and attractive edges (considering all edges, not only valid ones)
         const size_t number_of_nodes = node_labeling.size();
         const size_t number_of_attractive_edges = number_of_nodes * number_of_attractive_channels;
-        const size_t number_of_offsets = offsets.size();
-        const size_t ndims = offsets[0].size();
 
-        // Define helper vector to find pair (u,v) from edge_id:
-        std::vector<int64_t> array_stride(ndims);
-        int64_t current_stride = 1;
-        for (int i = ndims-1; i >= 0; --i){
-            array_stride[i] = current_stride;
-            current_stride *= image_shape[i];
-//            std::cout << i << " " << array_stride[i] << "\n";
-        }
-        std::vector<int64_t> offset_strides;
-        for (const auto & offset: offsets){
-            int64_t stride = 0;
-            for (int i = 0; i < offset.size(); ++i){
-                stride += offset[i] * array_stride[i];
-            }
-            offset_strides.push_back(stride);
-//            std::cout << stride << "\n";
-        }
+        // linear strides to find the pair (u,v) from the edge_id
+        const auto offset_strides = detail_mws::compute_offset_strides(offsets, image_shape);
 
-        // Phase 1: build minimum spanning forest
+        const detail_mws::FlatEdgeDecoder decoder(offset_strides, number_of_nodes);
 
-        // arrays storing the Minimum Spanning Forest:
-        const size_t number_of_edges = number_of_nodes * number_of_offsets;
-        std::vector<uint64_t> MSF(number_of_edges);
+        // Phase 1: build minimum spanning forest
 
+        // the attractive edges in the Minimum Spanning Forest:
+        std::vector<uint8_t> MSF(number_of_attractive_edges, 0);
         {
-            // make ufd
-            std::vector <uint64_t> ranks(number_of_nodes);
-            std::vector <uint64_t> parents(number_of_nodes);
-            boost::disjoint_sets < uint64_t * , uint64_t * > ufd(&ranks[0], &parents[0]);
-            for (uint64_t label = 0; label < number_of_nodes; ++label) {
-                ufd.make_set(label);
-            }
-
-            // data-structure storing mutex edges
-            typedef boost::container::flat_set<uint64_t> SetType;
-            typedef std::vector<SetType> MutexStorage;
-            MutexStorage mutexes(number_of_nodes);
+            detail_mws::MutexUnionFind<std::unordered_set<uint64_t>> ufd(number_of_nodes);
 
             // iterate over all edges
-            int number_of_clusters = number_of_nodes;
-            int nb_conn = 0;
-            int nb_add_mtx = 0;
-            int nb_mrg_not = 0;
-            int nb_mrg = 0;
-            int counter = 0;
-
-            for (const size_t edge_id : sorted_flat_indices) {
-                // Initialize value
-                MSF[edge_id] = 0;
-                counter++;
-                if (counter % 5000000 == 0) {
-                    std::cout << "nb_conn " << nb_conn << "\n";
-                    std::cout << "nb_add_mtx " << nb_add_mtx << "\n";
-                    std::cout << "nb_mrg_not " << nb_mrg_not << "\n";
-                    std::cout << "nb_mrg " << nb_mrg << "\n";
-                    std::cout << "number_of_clusters " << number_of_clusters << "\n";
-                    std::cout << "-----\n";
-                }
+            size_t number_of_clusters = number_of_nodes;
+            const size_t number_of_sorted_edges = sorted_flat_indices.size();
+            for (size_t i = 0; i < number_of_sorted_edges; ++i) {
+                detail_mws::prefetch_edge(sorted_flat_indices, valid_edges, i, decoder, ufd);
+
+                const uint64_t edge_id = sorted_flat_indices(i);
                 if (!valid_edges(edge_id)) {
                     continue;
                 }
 
-                // check whether this edge is mutex via the edge offset
-                const bool is_mutex_edge = edge_id >= number_of_attractive_edges;
-
                 // get nodes connected by edge of edge_id
-
-                // const auto affCoord_ = xt::unravel_from_strides(edge_id, strides, layout);
-                const uint64_t u = edge_id % number_of_nodes;
-                const uint64_t v = u + offset_strides[edge_id / number_of_nodes];
-                //            std::cout << u << " " << v << " " << is_mutex_edge << " ";
+                uint64_t u, v;
+                decoder.uv(edge_id, u, v);
 
                 // find the current representatives
-                uint64_t ru = ufd.find_set(u);
-                uint64_t rv = ufd.find_set(v);
-
-                // if the nodes are already connected, do nothing
+                // and skip if the nodes are already connected
+                const uint64_t ru = ufd.find(u);
+                const uint64_t rv = ufd.find(v);
                 if (ru == rv) {
-                    nb_conn++;
-                    //                std::cout << " --> Connected \n";
                     continue;
                 }
 
-                const auto is_constrained = check_mutex(ru, rv, mutexes);
+                const bool is_constrained = ufd.check_mutex(ru, rv);
 
-                // insert the mutex edge into both mutex edge storages only if it was not already added:
-                if (is_mutex_edge && not is_constrained) {
-//                                    std::cout << " --> Add mutex \n";
-                    insert_mutex(ru, rv, mutexes);
-                    nb_add_mtx++;
+                // insert the mutex edge only if the clusters are not constrained yet
+                if (edge_id >= number_of_attractive_edges) {
+                    if (!is_constrained) {
+                        ufd.insert_mutex(ru, rv);
+                    }
                     continue;
                 }
-                // If not a mutex edge, then merge:
-                if (not is_mutex_edge) {
-                    // If the edge is not constrained, we add it to the MSF:
-                    if (not is_constrained) {
-                        nb_mrg_not++;
-                        MSF[edge_id] = 1;
-                    } else {
-                        nb_mrg++;
-                    }
-                    // And now we merge anyway:
-                    number_of_clusters--;
-//                    if (number_of_clusters % 200 == 0)
-//                        std::cout << "." << number_of_clusters;
-                    //                std::cout << " --> Merge \n";
-                    ufd.link(u, v);
-                    // check  if we have to swap the roots
-                    if (ufd.find_set(ru) == rv) {
-                        std::swap(ru, rv);
-                    }
-                    // merge mutexes from rv -> ru
-                    merge_mutexes(rv, ru, mutexes);
+
+                // If the edge is not constrained, we add it to the MSF:
+                if (!is_constrained) {
+                    MSF[edge_id] = 1;
                 }
+                // And now we merge anyway:
+                ufd.merge(ru, rv);
 
                 // Stop when we have merged everything in one cluster:
-                if (number_of_clusters <= 1) {
-                    std::cout << "Iterations " << counter << "\n";
-                    std::cout << "Total edges (including not valid) " << number_of_edges << "\n";
+                if (--number_of_clusters <= 1) {
                     break;
                 }
             }
-            std::cout << "nb_conn " << nb_conn << "\n";
-            std::cout << "nb_add_mtx " << nb_add_mtx << "\n";
-            std::cout << "nb_mrg_not " << nb_mrg_not << "\n";
-            std::cout << "nb_mrg " << nb_mrg << "\n";
-            std::cout << "number_of_clusters " << number_of_clusters << "\n";
-            std::cout << "--DONE---\n";
-//            // get node labeling into output
-//            for(size_t label = 0; label < number_of_nodes; ++label) {
-//                node_labeling[label] = ufd.find_set(label);
-//            }
-
         }
 
         // PHASE 2: get node labeling by running connected components on the built forest:
-        // make new ufd
-        std::vector <uint64_t> ranks(number_of_nodes);
-        std::vector <uint64_t> parents(number_of_nodes);
-        boost::disjoint_sets < uint64_t * , uint64_t * > ufd(&ranks[0], &parents[0]);
-        for (uint64_t label = 0; label < number_of_nodes; ++label) {
-            ufd.make_set(label);
-        }
-
-        // loop over attractive edges
-        for (size_t edge_id = 0; edge_id < number_of_attractive_edges; ++edge_id) {
-            if (MSF[edge_id] == 1 && valid_edges(edge_id)) {
-                const uint64_t u = edge_id % number_of_nodes;
-                const uint64_t v = u + offset_strides[edge_id / number_of_nodes];
-                // find the current representatives
-                uint64_t ru = ufd.find_set(u);
-                uint64_t rv = ufd.find_set(v);
+        detail_mws::MutexUnionFind<> ufd(number_of_nodes);
+        for (uint64_t edge_id = 0; edge_id < number_of_attractive_edges; ++edge_id) {
+            if (MSF[edge_id] == 1) {
+                uint64_t u, v;
+                decoder.uv(edge_id, u, v);
+                const uint64_t ru = ufd.find(u);
+                const uint64_t rv = ufd.find(v);
                 if (ru != rv) {
-                    ufd.link(u, v);
+                    ufd.merge(ru, rv);
                 }
             }
+        }
 
+        // get node labeling into output
+        for(size_t label = 0; label < number_of_nodes; ++label) {
+            node_labeling[label] = ufd.find(label);
         }
+    }
+
+    // compute semantic mutex segmentation via kruskal:
+    // the sorted flat indices contain the affinity edges (channel * number_of_nodes + node)
+    // and the semantic edges (number_of_affinity_edges + class * number_of_nodes + node),
+    // where number_of_affinity_edges is the size of 'valid_edges'.
+    // Every cluster gets the class of its strongest semantic edge that was sorted
+    // before the cluster got a class by merging; clusters of different classes are not merged.
+    // Nodes of clusters without any semantic edge get the class -1.
+    template<class WEIGHT_ARRAY, class NODE_ARRAY, class INDICATOR_ARRAY, class SEMANTIC_ARRAY>
+    void compute_semantic_mws_segmentation(const xt::xexpression<WEIGHT_ARRAY> & sorted_flat_indices_exp,
+                                           const xt::xexpression<INDICATOR_ARRAY> & valid_edges_exp,
+                                           const std::vector<std::vector<int>> & offsets,
+                                           const size_t number_of_attractive_channels,
+                                           const std::vector<int> & image_shape,
+                                           xt::xexpression<NODE_ARRAY> & node_labeling_exp,
+                                           xt::xexpression<SEMANTIC_ARRAY> & semantic_labeling_exp) {
+
+        // casts
+        const auto & sorted_flat_indices = sorted_flat_indices_exp.derived_cast();
+        const auto & valid_edges = valid_edges_exp.derived_cast();
+        auto & node_labeling = node_labeling_exp.derived_cast();
+        auto & semantic_labeling = semantic_labeling_exp.derived_cast();
+
+        const size_t number_of_nodes = node_labeling.size();
+        const size_t number_of_attractive_edges = number_of_nodes * number_of_attractive_channels;
+        const auto offset_strides = detail_mws::compute_offset_strides(offsets, image_shape);
+        const detail_mws::FlatEdgeDecoder decoder(offset_strides, number_of_nodes);
+
+        detail_mws::MutexUnionFind<> ufd(number_of_nodes);
+        std::vector<uint64_t> root_labels(number_of_nodes, 0);
+        detail_mws::labeled_mws_kruskal(sorted_flat_indices, valid_edges, decoder,
+                                        number_of_nodes, number_of_attractive_edges,
+                                        ufd, root_labels);
+
+        // get node and semantic labeling into output
+        for(size_t label = 0; label < number_of_nodes; ++label) {
+            const uint64_t root = ufd.find(label);
+            node_labeling[label] = root;
+            semantic_labeling[label] = static_cast<int64_t>(root_labels[root]) - 1;
+        }
+    }
+
+    // compute mutex segmentation via kruskal with seeds:
+    // all nodes with the same seed (> 0) form one cluster from the start and
+    // clusters with different seeds are mutually exclusive.
+    // Seeded clusters are labeled with their seed, the other clusters
+    // with max_seed + 1 + representative.
+    template<class WEIGHT_ARRAY, class NODE_ARRAY, class INDICATOR_ARRAY, class SEED_ARRAY>
+    void compute_seeded_mws_segmentation(const xt::xexpression<WEIGHT_ARRAY> & sorted_flat_indices_exp,
+                                         const xt::xexpression<INDICATOR_ARRAY> & valid_edges_exp,
+                                         const std::vector<std::vector<int>> & offsets,
+                                         const size_t number_of_attractive_channels,
+                                         const std::vector<int> & image_shape,
+                                         const xt::xexpression<SEED_ARRAY> & seeds_exp,
+                                         xt::xexpression<NODE_ARRAY> & node_labeling_exp) {
+
+        // casts
+        const auto & sorted_flat_indices = sorted_flat_indices_exp.derived_cast();
+        const auto & valid_edges = valid_edges_exp.derived_cast();
+        const auto & seeds = seeds_exp.derived_cast();
+        auto & node_labeling = node_labeling_exp.derived_cast();
+
+        const size_t number_of_nodes = node_labeling.size();
+        const size_t number_of_attractive_edges = number_of_nodes * number_of_attractive_channels;
+        const auto offset_strides = detail_mws::compute_offset_strides(offsets, image_shape);
+        const detail_mws::FlatEdgeDecoder decoder(offset_strides, number_of_nodes);
+
+        detail_mws::MutexUnionFind<> ufd(number_of_nodes);
+        std::vector<uint64_t> root_labels(number_of_nodes, 0);
+
+        // pin the seeds: merge all nodes of a seed into one labeled cluster
+        std::unordered_map<uint64_t, uint64_t> seed_roots;
+        uint64_t max_seed = 0;
+        for(size_t node = 0; node < number_of_nodes; ++node) {
+            const uint64_t seed = seeds(node);
+            if(seed == 0) {
+                continue;
+            }
+            max_seed = std::max(max_seed, seed);
+            auto it = seed_roots.find(seed);
+            if(it == seed_roots.end()) {
+                seed_roots.emplace(seed, node);
+                root_labels[node] = seed;
+            } else {
+                const uint64_t root = ufd.merge(ufd.find(it->second), node);
+                root_labels[root] = seed;
+                it->second = root;
+            }
+        }
+
+        detail_mws::labeled_mws_kruskal(sorted_flat_indices, valid_edges, decoder,
+                                        number_of_nodes, number_of_attractive_edges,
+                                        ufd, root_labels);
 
         // get node labeling into output
         for(size_t label = 0; label < number_of_nodes; ++label) {
-            node_labeling[label] = ufd.find_set(label);
+            const uint64_t root = ufd.find(label);
+            node_labeling[label] = root_labels[root] == 0 ? max_seed + 1 + root : root_labels[root];
         }
     }
 
@@ -1,3 +1,6 @@
+#include <array>
+#include <algorithm>
+
 #include "boost/geometry.hpp"
 #include "boost/geometry/index/rtree.hpp"
 #include "boost/serialization/map.hpp"
@@ -25,12 +28,27 @@ namespace skeletons {
         // store coordinates of a single (sub-) skeleton
         typedef xt::xtensor<std::size_t, 2> CoordinateArray;
         typedef typename CoordinateArray::shape_type ArrayShape;
-        // store tmp coordinates as vector
-        typedef std::vector<std::size_t> CoordinateVector;
         // store (sub-) skeleton id to coordinates assignment
         typedef std::map<std::size_t, CoordinateArray> SkeletonStorage;
         // store (sub-) skeletons for all blocks
         typedef std::map<std::size_t, SkeletonStorage> SkeletonBlockStorage;
+
+        // single skeleton node with its coordinate relative to the
+        // segmentation chunk it falls into
+        struct SkeletonPoint {
+            std::size_t chunkId;
+            std::size_t skeletonIndex;
+            std::size_t nodeId;
+            std::array<uint32_t, 3> coordinate;
+        };
+        // flat table of the points of all skeletons, bucketed by chunk:
+        // the points of chunkIds[i] are in [chunkOffsets[i], chunkOffsets[i + 1]),
+        // sorted by skeleton and node
+        struct SkeletonPointTable {
+            std::vector<std::size_t> chunkIds;
+            std::vector<std::size_t> chunkOffsets;
+            std::vector<SkeletonPoint> points;
+        };
         // assignmet of skeleton nodes to segmentation nodes
         typedef std::unordered_map<std::size_t, std::size_t> SkeletonNodeAssignment;
         typedef std::map<std::size_t, SkeletonNodeAssignment> SkeletonDictionary;
@@ -146,8 +164,10 @@ namespace skeletons {
     private:
         // initialize the metrics class from data
         void init(const std::size_t numberOfThreads);
-        // extract the node assignment for a single block
-        void extractNodeAssignmentsForBlock(const std::size_t, const SkeletonStorage & skeletons, SkeletonDictionary &);
+        // read all skeletons and bucket their points by segmentation chunk
+        void buildSkeletonPointTable(SkeletonPointTable &, parallel::ThreadPool &) const;
+        // stream over the chunks and find the label for all skeleton points
+        void extractNodeAssignments(const SkeletonPointTable &, std::vector<uint64_t> &, parallel::ThreadPool &) const;
         // build r-trees for merge heuristics
         template<class TREE>
         void buildRTrees(const std::array<double, 3> &,
@@ -170,51 +190,57 @@ namespace skeletons {
 
         parallel::ThreadPool tp(numberOfThreads);
 
-        // group the skeleton parts by the chunks of the segmentation
+        // group the skeleton points by the chunks of the segmentation
         // dataset they fall into
-        SkeletonBlockStorage skeletonsToBlocks;
-        std::vector<std::size_t> nonEmptyChunks;
-        groupSkeletonBlocks(skeletonsToBlocks, nonEmptyChunks, tp);
+        SkeletonPointTable table;
+        buildSkeletonPointTable(table, tp);
 
-        // extract the node assignments for all blocks in parallel
-        const std::size_t nThreads = tp.nThreads();
-        std::vector<SkeletonDictionary> perThreadData(nThreads);
+        // stream over the non-empty chunks and look up the label of each point;
+        // only one chunk per thread is held in memory
+        std::vector<uint64_t> pointLabels(table.points.size());
+        extractNodeAssignments(table, pointLabels, tp);
 
-        const std::size_t nChunks = nonEmptyChunks.size();
-        parallel::parallel_foreach(tp, nChunks, [&](const int tid, const std::size_t chunkIndex){
-            const std::size_t chunkId = nonEmptyChunks[chunkIndex];
-            auto & threadData = perThreadData[tid];
-            extractNodeAssignmentsForBlock(chunkId, skeletonsToBlocks[chunkId], threadData);
-        });
+        // bucket the points by skeleton (counting sort over the skeleton index)
+        const std::size_t nSkeletons = skeletonIds_.size();
+        const std::size_t nPoints = table.points.size();
+        std::vector<std::size_t> skeletonOffsets(nSkeletons + 1, 0);
+        for(const auto & point : table.points) {
+            ++skeletonOffsets[point.skeletonIndex + 1];
+        }
+        for(std::size_t skeletonIndex = 0; skeletonIndex < nSkeletons; ++skeletonIndex) {
+            skeletonOffsets[skeletonIndex + 1] += skeletonOffsets[skeletonIndex];
+        }
+        std::vector<std::size_t> pointsBySkeleton(nPoints);
+        {
+            std::vector<std::size_t> pos(skeletonOffsets.begin(), skeletonOffsets.end() - 1);
+            for(std::size_t pointIndex = 0; pointIndex < nPoints; ++pointIndex) {
+                pointsBySkeleton[pos[table.points[pointIndex].skeletonIndex]++] = pointIndex;
+            }
+        }
 
         // initialize the skeleton dictionary
         for(const std::size_t skeletonId : skeletonIds_) {
             skeletonDict_.insert(std::make_pair(skeletonId, SkeletonNodeAssignment()));
         }
 
-        // merge the node assignments for all skeletons
-        const std::size_t nSkeletons = skeletonIds_.size();
+        // fill the node assignments for all skeletons in parallel
         parallel::parallel_foreach(tp, nSkeletons, [&](const int tid, const std::size_t skeletonIndex) {
             const std::size_t skeletonId = skeletonIds_[skeletonIndex];
             auto & nodeAssignment = skeletonDict_[skeletonId];
-            // iterate over all threads and
-            for(std::size_t t = 0; t < nThreads; ++t) {
-                const auto & threadData = perThreadData[t];
-                auto skelIt = threadData.find(skeletonId);
-                if(skelIt == threadData.end()) {
-                    continue;
-                }
-                // could use merge implementation if we had C++ 17 ;(
-                nodeAssignment.insert(skelIt->second.begin(), skelIt->second.end());
+            const std::size_t begin = skeletonOffsets[skeletonIndex];
+            const std::size_t end = skeletonOffsets[skeletonIndex + 1];
+            nodeAssignment.reserve(end - begin);
+            for(std::size_t ii = begin; ii < end; ++ii) {
+                const std::size_t pointIndex = pointsBySkeleton[ii];
+                nodeAssignment[table.points[pointIndex].nodeId] = pointLabels[pointIndex];
             }
         });
 
     }
 
-    // TODO de-spaghettify
-    void SkeletonMetrics::groupSkeletonBlocks(SkeletonBlockStorage & out,
-                                              std::vector<std::size_t> & nonEmptyChunks,
-                                              parallel::ThreadPool & tp) {
+
+    void SkeletonMetrics::buildSkeletonPointTable(SkeletonPointTable & table,
+                                                  parallel::ThreadPool & tp) const {
 
         std::vector<std::size_t> zeroCoord = {0, 0};
 
@@ -226,18 +252,14 @@ namespace skeletons {
         // a flat chunk index
         const auto & chunksPerDimension = segmentation->chunksPerDimension();
         std::vector<std::size_t> chunkStrides = {chunksPerDimension[1] * chunksPerDimension[2], chunksPerDimension[2], 1};
+        const auto & chunking = segmentation->chunking();
+        const auto & chunkShape = segmentation->maxChunkShape();
 
-        // go over all skeletons in parallel
-        // and extract the sub skeletons for each block
         const std::size_t nSkeletons = skeletonIds_.size();
         const std::size_t nThreads = tp.nThreads();
 
-        // temporary block data for the threads
-        std::vector<SkeletonBlockStorage> perThreadData(nThreads);
-
-        const auto & chunking = segmentation->chunking();
-
-        // go over all skeletons in parallel and extract the parts overlapping with chunks
+        // go over all skeletons in parallel and append their points to flat per thread tables
+        std::vector<std::vector<SkeletonPoint>> perThreadPoints(nThreads);
         parallel::parallel_foreach(tp, nSkeletons, [&](const int tId, const std::size_t skeletonIndex){
             // open the coordinate dataset for this particular skeleton
             const std::size_t skeletonId = skeletonIds_[skeletonIndex];
@@ -250,161 +272,164 @@ namespace skeletons {
             ArrayShape coordShape = {nPoints, coordinateSet->shape(1)};
             CoordinateArray coords(coordShape);
             z5::multiarray::readSubarray<uint64_t>(coordinateSet, coords, zeroCoord.begin());
-            // loop over all coordinates, and find the corresponding chunk
-            std::map<std::size_t, std::vector<CoordinateVector>> blocksToCoordinates; // maping of coordinates to chunks
+
+            auto & threadPoints = perThreadPoints[tId];
+            threadPoints.reserve(threadPoints.size() + nPoints);
+            std::vector<std::size_t> coordinate(3), chunkIds(3);
             for(std::size_t point = 0; point < nPoints; ++point) {
                 // we assume to have four entries per coordinate, the first is the skeleton node index,
                 // the rest are the coordinates
-
-                CoordinateVector coordinate = {coords(point, 1), coords(point, 2), coords(point, 3)};
-                // get the indices of this chunk and concert them to a flat index
-                std::vector<std::size_t> chunkIds;
-                chunking.coordinateToBlockCoordinate(coordinate, chunkIds);
-                std::size_t chunkId = 0;
                 for(unsigned dim = 0; dim < 3; ++dim) {
-                    chunkId += chunkIds[dim] * chunkStrides[dim];
-                }
-
-                // prepend the skeleton index to the coordinate
-                coordinate.insert(coordinate.begin(), coords(point, 0));
-                // see if we already have coordinates in this block and add them
-                auto blockIt = blocksToCoordinates.find(chunkId);
-                if(blockIt == blocksToCoordinates.end()) {
-                    std::vector<CoordinateVector> newCoordinates = {coordinate};
-                    blocksToCoordinates.insert(blockIt, std::make_pair(chunkId, newCoordinates));
-                } else {
-                    blockIt->second.emplace_back(coordinate);
+                    coordinate[dim] = coords(point, dim + 1);
                 }
-            }
-
-            // write the result to our per thread data
-            auto & threadData = perThreadData[tId];
-            for(const auto & elem : blocksToCoordinates) {
-                const std::size_t chunkId = elem.first;
-
-                // go from flat chunk index to chunk indices
-                std::vector<std::size_t> chunkIds(3);
-                std::size_t tmpIdx = chunkId;
+                // get the indices of this chunk and convert them to a flat index
+                chunking.coordinateToBlockCoordinate(coordinate, chunkIds);
+                SkeletonPoint skeletonPoint;
+                skeletonPoint.chunkId = 0;
                 for(unsigned dim = 0; dim < 3; ++dim) {
-                    chunkIds[dim] = tmpIdx / chunkStrides[dim];
-                    tmpIdx -= chunkIds[dim] * chunkStrides[dim];
-                }
-
-                // find the offset of this chunk
-                std::vector<std::size_t> chunkOffset;
-                segmentation->getChunkOffset(chunkIds, chunkOffset);
-
-                auto threadIt = threadData.find(chunkId);
-                if(threadIt == threadData.end()) {
-                    threadIt = threadData.insert(threadIt,
-                                                 std::make_pair(chunkId, SkeletonStorage()));
+                    skeletonPoint.chunkId += chunkIds[dim] * chunkStrides[dim];
+                    // coordinate relative to the chunk
+                    skeletonPoint.coordinate[dim] = coordinate[dim] - chunkIds[dim] * chunkShape[dim];
                 }
-
-                // crop and copy coordinates
-                ArrayShape coordShape = {elem.second.size(), 4};
-                CoordinateArray coordArray(coordShape);
-                std::size_t ii = 0;
-                for(const auto & coord : elem.second) {
-                    coordArray(ii, 0) = coord[0];
-                    coordArray(ii, 1) = coord[1] - chunkOffset[0];
-                    coordArray(ii, 2) = coord[2] - chunkOffset[1];
-                    coordArray(ii, 3) = coord[3] - chunkOffset[2];
-                    ++ii;
-                }
-                // insert in thread data
-                threadIt->second.insert(std::make_pair(skeletonId, coordArray));
+                skeletonPoint.skeletonIndex = skeletonIndex;
+                skeletonPoint.nodeId = coords(point, 0);
+                threadPoints.push_back(skeletonPoint);
             }
-
         });
 
-        // find all nonempty chunks
-        std::set<std::size_t> nonEmptyChunkSet;
-        for(std::size_t t = 0; t < nThreads; ++t) {
-            auto & threadData = perThreadData[t];
-            for(auto it = threadData.begin(); it != threadData.end(); ++it) {
-                nonEmptyChunkSet.insert(it->first);
+        // bucket the points by chunk (counting sort over the flat chunk index)
+        std::vector<std::size_t> chunkCounts(nChunks + 1, 0);
+        std::size_t nPoints = 0;
+        for(const auto & threadPoints : perThreadPoints) {
+            for(const auto & point : threadPoints) {
+                ++chunkCounts[point.chunkId + 1];
             }
+            nPoints += threadPoints.size();
         }
-        const std::size_t nNonEmpty = nonEmptyChunkSet.size();
-        nonEmptyChunks.resize(nNonEmpty);
-        std::copy(nonEmptyChunkSet.begin(), nonEmptyChunkSet.end(), nonEmptyChunks.begin());
 
-        // create empty entries for all non-empty chunks
-        for(const std::size_t chunkId : nonEmptyChunks) {
-            out.insert(std::make_pair(chunkId, SkeletonStorage()));
+        table.chunkIds.clear();
+        table.chunkOffsets.assign(1, 0);
+        for(std::size_t chunkId = 0; chunkId < nChunks; ++chunkId) {
+            const std::size_t count = chunkCounts[chunkId + 1];
+            chunkCounts[chunkId + 1] += chunkCounts[chunkId];
+            if(count > 0) {
+                table.chunkIds.push_back(chunkId);
+                table.chunkOffsets.push_back(chunkCounts[chunkId + 1]);
+            }
         }
 
-        // go over all non-empty blocks in parallel and assemble all the sub-skeletons
-        parallel::parallel_foreach(tp, nNonEmpty, [&](const int tId, const std::size_t nonEmptyIndex){
-            const std::size_t chunkId = nonEmptyChunks[nonEmptyIndex];
-            auto & outChunk = out[chunkId];
-
-            // go over all the thread data and insert sub-skeletons of this chunk
-            for(std::size_t t = 0; t < nThreads; ++t) {
-                auto & threadData = perThreadData[t];
-                auto threadIt = threadData.find(chunkId);
-                if(threadIt == threadData.end()) {
-                    continue;
-                }
-                outChunk.insert(threadIt->second.begin(), threadIt->second.end());
+        table.points.resize(nPoints);
+        for(auto & threadPoints : perThreadPoints) {
+            for(const auto & point : threadPoints) {
+                table.points[chunkCounts[point.chunkId]++] = point;
             }
+            // free the thread data early
+            std::vector<SkeletonPoint>().swap(threadPoints);
+        }
+
+        // sort the points within the chunk buckets by (skeleton, node)
+        const std::size_t nNonEmpty = table.chunkIds.size();
+        parallel::parallel_foreach(tp, nNonEmpty, [&](const int tId, const std::size_t chunkIndex){
+            std::sort(table.points.begin() + table.chunkOffsets[chunkIndex],
+                      table.points.begin() + table.chunkOffsets[chunkIndex + 1],
+                      [](const SkeletonPoint & a, const SkeletonPoint & b){
+                          return a.skeletonIndex < b.skeletonIndex ||
+                                 (a.skeletonIndex == b.skeletonIndex && a.nodeId < b.nodeId);
+                      });
         });
     }
 
 
-    inline void SkeletonMetrics::extractNodeAssignmentsForBlock(const std::size_t chunkId,
-                                                                const SkeletonStorage & skeletons,
-                                                                SkeletonDictionary & out) {
+    void SkeletonMetrics::extractNodeAssignments(const SkeletonPointTable & table,
+                                                 std::vector<uint64_t> & pointLabels,
+                                                 parallel::ThreadPool & tp) const {
+        typedef typename xt::xtensor<uint64_t, 3> ::shape_type LabelsShape;
+
         // open the segmentation dataset and get the shape and chunks
         auto segmentation = z5::openDataset(segmentationPath_);
-        const std::size_t nChunks = segmentation->numberOfChunks();
-
-        // we could do all that outside of the function only once,
-        // but it shouldn't matter at all for performance
 
         // get chunk strides for conversion from n-dim chunk indices to
         // a flat chunk index
         const auto & chunksPerDimension = segmentation->chunksPerDimension();
         std::vector<std::size_t> chunkStrides = {chunksPerDimension[1] * chunksPerDimension[2], chunksPerDimension[2], 1};
 
-        // go from the chunk id to chunk index vector
-        std::vector<std::size_t> chunkIds(3);
-        std::size_t tmpIdx = chunkId;
-        for(unsigned dim = 0; dim < 3; ++dim) {
-            chunkIds[dim] = tmpIdx / chunkStrides[dim];
-            tmpIdx -= chunkIds[dim] * chunkStrides[dim];
-        }
+        // label buffer per thread, that is only re-allocated for chunks at the border
+        const std::size_t nThreads = tp.nThreads();
+        std::vector<xt::xtensor<uint64_t, 3>> perThreadLabels(nThreads);
 
-        // load the chunk data
-        std::vector<std::size_t> chunkOffset;
-        segmentation->getChunkOffset(chunkIds, chunkOffset);
-        std::vector<std::size_t> chunkShape;
-        segmentation->getChunkShape(chunkIds, chunkShape);
+        const std::size_t nNonEmpty = table.chunkIds.size();
+        parallel::parallel_foreach(tp, nNonEmpty, [&](const int tId, const std::size_t chunkIndex){
+            const std::size_t chunkId = table.chunkIds[chunkIndex];
 
-        typedef typename xt::xtensor<uint64_t, 3> ::shape_type LabelsShape;
-        LabelsShape labelsShape = {chunkShape[0], chunkShape[1], chunkShape[2]};
-        xt::xtensor<uint64_t, 3> labels(labelsShape);
-        z5::multiarray::readSubarray<uint64_t>(segmentation, labels, chunkOffset.begin());
-
-        // iterate over all the skeletons in this chunks and extract the node assignment
-        for(const auto & skel : skeletons) {
-            const std::size_t skeletonId = skel.first;
-
-            // check if the skeleton dictionary (out) already has this skeleton id
-            auto skelIt = out.find(skeletonId);
-            if(skelIt == out.end()) {
-                skelIt = out.insert(skelIt, std::make_pair(skeletonId, SkeletonNodeAssignment()));
+            // go from the chunk id to chunk index vector
+            std::vector<std::size_t> chunkIds(3);
+            std::size_t tmpIdx = chunkId;
+            for(unsigned dim = 0; dim < 3; ++dim) {
+                chunkIds[dim] = tmpIdx / chunkStrides[dim];
+                tmpIdx -= chunkIds[dim] * chunkStrides[dim];
             }
-            auto & nodeAssignment = skelIt->second;
 
-            const auto & skelCoordinates = skel.second;
-            const std::size_t nPoints = skelCoordinates.shape()[0];
-            for(std::size_t point = 0; point < nPoints; ++point) {
-                nodeAssignment[skelCoordinates(point, 0)] = labels(skelCoordinates(point, 1),
-                                                                   skelCoordinates(point, 2),
-                                                                   skelCoordinates(point, 3));
+            // load the chunk data
+            std::vector<std::size_t> chunkOffset;
+            segmentation->getChunkOffset(chunkIds, chunkOffset);
+            std::vector<std::size_t> chunkShape;
+            segmentation->getChunkShape(chunkIds, chunkShape);
+
+            auto & labels = perThreadLabels[tId];
+            LabelsShape labelsShape = {chunkShape[0], chunkShape[1], chunkShape[2]};
+            if(!std::equal(labelsShape.begin(), labelsShape.end(), labels.shape().begin())) {
+                labels.resize(labelsShape);
+            }
+            z5::multiarray::readSubarray<uint64_t>(segmentation, labels, chunkOffset.begin());
+
+            // look up the labels of all points in this chunk
+            for(std::size_t pointIndex = table.chunkOffsets[chunkIndex];
+                pointIndex < table.chunkOffsets[chunkIndex + 1]; ++pointIndex) {
+                const auto & coord = table.points[pointIndex].coordinate;
+                pointLabels[pointIndex] = labels(coord[0], coord[1], coord[2]);
             }
+        });
+    }
+
+
+    void SkeletonMetrics::groupSkeletonBlocks(SkeletonBlockStorage & out,
+                                              std::vector<std::size_t> & nonEmptyChunks,
+                                              parallel::ThreadPool & tp) {
+        SkeletonPointTable table;
+        buildSkeletonPointTable(table, tp);
+        nonEmptyChunks = table.chunkIds;
+
+        // create empty entries for all non-empty chunks
+        for(const std::size_t chunkId : nonEmptyChunks) {
+            out.insert(std::make_pair(chunkId, SkeletonStorage()));
         }
+
+        // go over all non-empty chunks in parallel and copy the sub-skeletons,
+        // the points of one skeleton are contiguous in the chunk bucket
+        const std::size_t nNonEmpty = nonEmptyChunks.size();
+        parallel::parallel_foreach(tp, nNonEmpty, [&](const int tId, const std::size_t chunkIndex){
+            auto & outChunk = out[nonEmptyChunks[chunkIndex]];
+            std::size_t begin = table.chunkOffsets[chunkIndex];
+            const std::size_t end = table.chunkOffsets[chunkIndex + 1];
+            while(begin < end) {
+                const std::size_t skeletonIndex = table.points[begin].skeletonIndex;
+                std::size_t skelEnd = begin;
+                while(skelEnd < end && table.points[skelEnd].skeletonIndex == skeletonIndex) {
+                    ++skelEnd;
+                }
+                ArrayShape coordShape = {skelEnd - begin, 4};
+                CoordinateArray coordArray(coordShape);
+                for(std::size_t ii = begin; ii < skelEnd; ++ii) {
+                    const auto & point = table.points[ii];
+                    coordArray(ii - begin, 0) = point.nodeId;
+                    coordArray(ii - begin, 1) = point.coordinate[0];
+                    coordArray(ii - begin, 2) = point.coordinate[1];
+                    coordArray(ii - begin, 3) = point.coordinate[2];
+                }
+                outChunk.insert(std::make_pair(skeletonIds_[skeletonIndex], coordArray));
+                begin = skelEnd;
+            }
+        });
     }
 
 
@@ -3,6 +3,7 @@
 #include <sstream>
 #include <chrono>
 #include <array>
+#include <algorithm>
 
 #include "nifty/parallel/threadpool.hxx"
 #include "nifty/array/arithmetic_array.hxx"
@@ -424,6 +425,171 @@ namespace tools{
         }
     }
 
+
+
+    // ----------------------------------------------------
+    // TILED VERSION WITH LINEAR OFFSETS
+    // ----------------------------------------------------
+
+    // The loops over the axes are expanded at compile time,
+    // so the innermost loop only increments one coordinate and the
+    // linear offset and calls the functor with both.
+    // The parallel version splits the shape into tiles along all axes,
+    // hence there are enough work items even if shape[0] is small
+    // (e.g. a stack of few large slices) and each tile stays in cache.
+
+    ///\cond
+    namespace detail_for_each_coordinate{
+
+        template<std::size_t AXIS, std::size_t DIM, bool IS_LAST = (AXIS + 1 == DIM)>
+        struct TileLoop{
+            template<class F>
+            static inline void run(const array::StaticArray<int64_t, DIM> & begin,
+                                   const array::StaticArray<int64_t, DIM> & end,
+                                   const array::StaticArray<int64_t, DIM> & strides,
+                                   array::StaticArray<int64_t, DIM> & coord,
+                                   int64_t offset,
+                                   F && f){
+                offset += begin[AXIS] * strides[AXIS];
+                for(coord[AXIS] = begin[AXIS]; coord[AXIS] < end[AXIS]; ++coord[AXIS]){
+                    TileLoop<AXIS + 1, DIM>::run(begin, end, strides, coord, offset, f);
+                    offset += strides[AXIS];
+                }
+            }
+        };
+
+        template<std::size_t AXIS, std::size_t DIM>
+        struct TileLoop<AXIS, DIM, true>{
+            template<class F>
+            static inline void run(const array::StaticArray<int64_t, DIM> & begin,
+                                   const array::StaticArray<int64_t, DIM> & end,
+                                   const array::StaticArray<int64_t, DIM> & strides,
+                                   array::StaticArray<int64_t, DIM> & coord,
+                                   int64_t offset,
+                                   F && f){
+                const int64_t stride = strides[AXIS];
+                offset += begin[AXIS] * stride;
+                for(coord[AXIS] = begin[AXIS]; coord[AXIS] < end[AXIS]; ++coord[AXIS]){
+                    f(static_cast<const array::StaticArray<int64_t, DIM> &>(coord), offset);
+                    offset += stride;
+                }
+            }
+        };
+
+    } // end namespace detail_for_each_coordinate
+    ///\endcond
+
+
+    // row-major strides (in elements) for a shape
+    template<std::size_t DIM, class SHAPE>
+    inline array::StaticArray<int64_t, DIM> rowMajorStrides(const SHAPE & shape){
+        array::StaticArray<int64_t, DIM> strides;
+        int64_t s = 1;
+        for(int d = int(DIM) - 1; d >= 0; --d){
+            strides[d] = s;
+            s *= shape[d];
+        }
+        return strides;
+    }
+
+
+    // call f(coord, offset) for all coordinates in [begin, end) in c-order,
+    // where offset is the linear offset of coord w.r.t. strides
+    template<std::size_t DIM, class F>
+    inline void forEachCoordinateWithOffset(const array::StaticArray<int64_t, DIM> & begin,
+                                            const array::StaticArray<int64_t, DIM> & end,
+                                            const array::StaticArray<int64_t, DIM> & strides,
+                                            F && f){
+        for(std::size_t d = 0; d < DIM; ++d){
+            if(end[d] <= begin[d]){
+                return;
+            }
+        }
+        array::StaticArray<int64_t, DIM> coord;
+        detail_for_each_coordinate::TileLoop<0, DIM>::run(begin, end, strides, coord, 0, f);
+    }
+
+
+    // default tile shape with roughly tileSize elements:
+    // the tile is filled starting from the last axis,
+    // but the last axis is capped so that large 2d / 3d shapes are
+    // split along all axes
+    template<class SHAPE_T, std::size_t DIM>
+    inline array::StaticArray<int64_t, DIM> defaultTileShape(const array::StaticArray<SHAPE_T, DIM> & shape,
+                                                              const int64_t tileSize = 1 << 15,
+                                                              const int64_t maxLineLength = 512){
+        array::StaticArray<int64_t, DIM> tileShape;
+        int64_t remaining = tileSize;
+        for(int d = int(DIM) - 1; d >= 0; --d){
+            int64_t t = std::min<int64_t>(shape[d], std::max<int64_t>(remaining, 1));
+            if(d == int(DIM) - 1 && DIM > 1){
+                t = std::min(t, maxLineLength);
+            }
+            tileShape[d] = std::max<int64_t>(t, 1);
+            remaining /= tileShape[d];
+        }
+        return tileShape;
+    }
+
+
+    // call f(tid, coord, offset) for all coordinates in shape in parallel,
+    // offset is the linear offset of coord w.r.t. strides.
+    // The order within a tile is c-order, the order of the tiles is arbitrary.
+    template<class SHAPE_T, std::size_t DIM, class F>
+    void parallelForEachCoordinateTiled(
+        nifty::parallel::ThreadPool & threadpool,
+        const array::StaticArray<SHAPE_T, DIM> & shape,
+        const array::StaticArray<int64_t, DIM> & strides,
+        const array::StaticArray<int64_t, DIM> & tileShape,
+        F && f
+    ){
+        typedef array::StaticArray<int64_t, DIM> Coord;
+
+        Coord tilesPerAxis;
+        int64_t nTiles = 1;
+        for(std::size_t d = 0; d < DIM; ++d){
+            if(shape[d] <= 0){
+                return;
+            }
+            NIFTY_CHECK_OP(tileShape[d], >, 0, "tile shape must be positive");
+            tilesPerAxis[d] = (shape[d] + tileShape[d] - 1) / tileShape[d];
+            nTiles *= tilesPerAxis[d];
+        }
+
+        parallel_foreach(threadpool, nTiles, [&](const int tid, const int64_t tileIndex){
+            Coord begin, end;
+            auto rest = tileIndex;
+            for(int d = int(DIM) - 1; d >= 0; --d){
+                begin[d] = (rest % tilesPerAxis[d]) * tileShape[d];
+                end[d] = std::min<int64_t>(begin[d] + tileShape[d], shape[d]);
+                rest /= tilesPerAxis[d];
+            }
+            forEachCoordinateWithOffset(begin, end, strides, [&](const Coord & coord, const int64_t offset){
+                f(tid, coord, offset);
+            });
+        });
+    }
+
+    template<class SHAPE_T, std::size_t DIM, class F>
+    void parallelForEachCoordinateTiled(
+        nifty::parallel::ThreadPool & threadpool,
+        const array::StaticArray<SHAPE_T, DIM> & shape,
+        const array::StaticArray<int64_t, DIM> & strides,
+        F && f
+    ){
+        parallelForEachCoordinateTiled(threadpool, shape, strides, defaultTileShape(shape), f);
+    }
+
+    // offsets w.r.t. the row-major strides of shape
+    template<class SHAPE_T, std::size_t DIM, class F>
+    void parallelForEachCoordinateTiled(
+        nifty::parallel::ThreadPool & threadpool,
+        const array::StaticArray<SHAPE_T, DIM> & shape,
+        F && f
+    ){
+        parallelForEachCoordinateTiled(threadpool, shape, rowMajorStrides<DIM>(shape), defaultTileShape(shape), f);
+    }
+
 } // end namespace nifty::tools
 } // end namespace nifty
 
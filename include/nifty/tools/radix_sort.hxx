@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+namespace nifty{
+namespace tools{
+
+    ///
+    // Stable lsd radix sort of 'values' by the 64 bit key returned by 'getKey'.
+    // The counts of all 8 digits are computed in one pass,
+    // digits that are the same for all values are skipped,
+    // so keys from a small range (e.g. the labels of a block) only need a few passes.
+    // 'buffer' is resized and used as scratch space.
+    ///
+    template<class T, class KEY_FUNCTOR>
+    inline void radixSort(std::vector<T> & values,
+                          std::vector<T> & buffer,
+                          KEY_FUNCTOR && getKey){
+        typedef std::array<std::size_t, 256> Histogram;
+        const std::size_t size = values.size();
+        if(size < 2){
+            return;
+        }
+
+        std::array<Histogram, 8> histograms;
+        for(auto & histogram : histograms){
+            histogram.fill(0);
+        }
+        for(const auto & val : values){
+            const uint64_t key = getKey(val);
+            for(std::size_t digit = 0; digit < 8; ++digit){
+                ++histograms[digit][(key >> (8 * digit)) & 0xff];
+            }
+        }
+
+        buffer.resize(size);
+        for(std::size_t digit = 0; digit < 8; ++digit){
+            auto & histogram = histograms[digit];
+            const uint64_t someKey = getKey(values.front());
+            if(histogram[(someKey >> (8 * digit)) & 0xff] == size){
+                continue;
+            }
+            // histogram to bucket offsets
+            std::size_t offset = 0;
+            for(auto & count : histogram){
+                const std::size_t tmp = count;
+                count = offset;
+                offset += tmp;
+            }
+            for(const auto & val : values){
+                buffer[histogram[(getKey(val) >> (8 * digit)) & 0xff]++] = val;
+            }
+            values.swap(buffer);
+        }
+    }
+
+
+    // radix sort of unsigned integers
+    template<class T>
+    inline void radixSort(std::vector<T> & values){
+        std::vector<T> buffer;
+        radixSort(values, buffer, [](const T val){return static_cast<uint64_t>(val);});
+    }
+
+
+    // lexicographical radix sort of pairs of unsigned integers
+    template<class T>
+    inline void radixSort(std::vector<std::pair<T, T>> & values){
+        std::vector<std::pair<T, T>> buffer;
+        radixSort(values, buffer, [](const std::pair<T, T> & val){return static_cast<uint64_t>(val.second);});
+        radixSort(values, buffer, [](const std::pair<T, T> & val){return static_cast<uint64_t>(val.first);});
+    }
+
+
+    // sort and remove duplicates
+    template<class T>
+    inline void radixSortUnique(std::vector<T> & values){
+        radixSort(values);
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+    }
+
+}
+}
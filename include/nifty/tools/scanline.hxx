@@ -0,0 +1,211 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+#include "nifty/array/arithmetic_array.hxx"
+#include "nifty/tools/for_each_coordinate.hxx"
+
+namespace nifty{
+namespace tools{
+
+    // Scanline iteration over contiguous (row-major) blocks.
+    //
+    // Instead of visiting every coordinate and recomputing the
+    // strided offset of the pixel and its neighbors, we iterate over
+    // the lines along the last (contiguous) axis and compare
+    // whole lines with the neighboring line along each axis.
+    // The comparison finds runs of equal labels with SIMD
+    // (AVX2 if available at compile time, otherwise SSE2, otherwise scalar),
+    // so the interior of segments is skipped at memory bandwidth and
+    // the functor is only called for the label transitions.
+
+
+    // \cond SUPPRESS_DOXYGEN
+    namespace detail_scanline{
+
+        inline std::size_t lowestSetBit(const uint64_t mask){
+            #if defined(__GNUC__) || defined(__clang__)
+            return __builtin_ctzll(mask);
+            #else
+            std::size_t bit = 0;
+            while(!((mask >> bit) & 1)){
+                ++bit;
+            }
+            return bit;
+            #endif
+        }
+
+        // call f(i) for all bits set in a mask of element-wise differences,
+        // where every element occupies BYTES bits of the byte mask
+        template<std::size_t BYTES, class MASK, class F>
+        inline void forEachDifferentElement(MASK diffMask, const std::size_t offset, F && f){
+            const MASK elementMask = (MASK(1) << BYTES) - 1;
+            while(diffMask){
+                // lowest set bit gives the first differing byte
+                const std::size_t element = lowestSetBit(diffMask) / BYTES;
+                f(offset + element);
+                diffMask &= ~(elementMask << (element * BYTES));
+            }
+        }
+
+        template<class T>
+        struct SimdComparable{
+            static const bool value = std::is_integral<T>::value &&
+                                      (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+        };
+
+    } // end namespace detail_scanline
+    // \endcond
+
+
+    // call f(i) for every i in [0, n) with a[i] != b[i]
+    template<class T, class F>
+    inline typename std::enable_if<detail_scanline::SimdComparable<T>::value>::type
+    forEachDifference(const T * a, const T * b, const std::size_t n, F && f){
+        std::size_t i = 0;
+        const std::size_t nBytes = n * sizeof(T);
+        const char * ca = reinterpret_cast<const char *>(a);
+        const char * cb = reinterpret_cast<const char *>(b);
+
+        #if defined(__AVX2__)
+        // 64 bytes per iteration, i.e. 16 32-bit labels or 8 64-bit labels
+        std::size_t byte = 0;
+        for(; byte + 64 <= nBytes; byte += 64){
+            const __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ca + byte));
+            const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cb + byte));
+            const __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ca + byte + 32));
+            const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cb + byte + 32));
+            const __m256i eq0 = _mm256_cmpeq_epi8(a0, b0);
+            const __m256i eq1 = _mm256_cmpeq_epi8(a1, b1);
+            if(_mm256_movemask_epi8(_mm256_and_si256(eq0, eq1)) == -1){
+                continue;
+            }
+            const uint64_t diff0 = ~uint32_t(_mm256_movemask_epi8(eq0));
+            const uint64_t diff1 = ~uint32_t(_mm256_movemask_epi8(eq1));
+            detail_scanline::forEachDifferentElement<sizeof(T)>(
+                (diff0 & 0xFFFFFFFFull) | (diff1 << 32), byte / sizeof(T), f
+            );
+        }
+        i = byte / sizeof(T);
+        #elif defined(__SSE2__) || defined(_M_X64)
+        // 32 bytes per iteration, i.e. 8 32-bit labels or 4 64-bit labels
+        std::size_t byte = 0;
+        for(; byte + 32 <= nBytes; byte += 32){
+            const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ca + byte));
+            const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(cb + byte));
+            const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ca + byte + 16));
+            const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(cb + byte + 16));
+            const __m128i eq0 = _mm_cmpeq_epi8(a0, b0);
+            const __m128i eq1 = _mm_cmpeq_epi8(a1, b1);
+            if(_mm_movemask_epi8(_mm_and_si128(eq0, eq1)) == 0xFFFF){
+                continue;
+            }
+            const uint32_t diff = ~(uint32_t(_mm_movemask_epi8(eq0)) | (uint32_t(_mm_movemask_epi8(eq1)) << 16));
+            detail_scanline::forEachDifferentElement<sizeof(T)>(diff, byte / sizeof(T), f);
+        }
+        i = byte / sizeof(T);
+        #else
+        (void)nBytes; (void)ca; (void)cb;
+        #endif
+
+        // scalar remainder
+        for(; i < n; ++i){
+            if(a[i] != b[i]){
+                f(i);
+            }
+        }
+    }
+
+    // scalar fallback for all other types
+    template<class T, class F>
+    inline typename std::enable_if<!detail_scanline::SimdComparable<T>::value>::type
+    forEachDifference(const T * a, const T * b, const std::size_t n, F && f){
+        for(std::size_t i = 0; i < n; ++i){
+            if(a[i] != b[i]){
+                f(i);
+            }
+        }
+    }
+
+
+    // iterate over all lines along the last axis within shape;
+    // f(coord, offset) gets the coordinate of the first element
+    // of the line and its offset w.r.t. the strides
+    template<std::size_t DIM, class F>
+    inline void forEachScanline(const array::StaticArray<int64_t, DIM> & shape,
+                                const array::StaticArray<int64_t, DIM> & strides,
+                                F && f){
+        array::StaticArray<int64_t, DIM> coord;
+        for(int d = 0; d < DIM; ++d){
+            if(shape[d] <= 0){
+                return;
+            }
+            coord[d] = 0;
+        }
+        int64_t offset = 0;
+        for(;;){
+            f(coord, offset);
+            // advance all but the last axis
+            int d = int(DIM) - 2;
+            for(; d >= 0; --d){
+                ++coord[d];
+                offset += strides[d];
+                if(coord[d] < shape[d]){
+                    break;
+                }
+                offset -= coord[d] * strides[d];
+                coord[d] = 0;
+            }
+            if(d < 0){
+                return;
+            }
+        }
+    }
+
+
+    // Find all pairs of neighboring pixels (u, u + e_axis) with different labels.
+    // u is in [0, coreShape), u + e_axis must be in [0, shape).
+    // labels points to the first element of a block with the given strides,
+    // the last axis has to be contiguous (strides[DIM-1] == 1).
+    //
+    // f(coordU, offsetU, axis, lU, lV) is called for every transition;
+    // the offset of v is offsetU + strides[axis].
+    template<std::size_t DIM, class T, class F>
+    inline void forEachLabelTransition(const T * labels,
+                                       const array::StaticArray<int64_t, DIM> & strides,
+                                       const array::StaticArray<int64_t, DIM> & shape,
+                                       const array::StaticArray<int64_t, DIM> & coreShape,
+                                       F && f){
+        const auto lineLength = coreShape[DIM - 1];
+        array::StaticArray<int64_t, DIM> coordU;
+        forEachScanline(coreShape, strides, [&](const array::StaticArray<int64_t, DIM> & lineCoord,
+                                                const int64_t lineOffset){
+            const T * lineU = labels + lineOffset;
+            for(std::size_t axis = 0; axis < DIM; ++axis){
+                std::size_t n = lineLength;
+                if(axis + 1 == DIM){
+                    n = std::min(lineLength, shape[DIM - 1] - 1);
+                }
+                else if(lineCoord[axis] + 1 >= shape[axis]){
+                    continue;
+                }
+                const T * lineV = lineU + strides[axis];
+                forEachDifference(lineU, lineV, n, [&](const std::size_t i){
+                    coordU = lineCoord;
+                    coordU[DIM - 1] = i;
+                    f(coordU, lineOffset + int64_t(i), axis, lineU[i], lineV[i]);
+                });
+            }
+        });
+    }
+
+
+} // end namespace nifty::tools
+} // end namespace nifty
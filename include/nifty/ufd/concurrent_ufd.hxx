@@ -0,0 +1,319 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "nifty/parallel/threadpool.hxx"
+
+
+namespace nifty {
+namespace ufd{
+
+/// Disjoint set data structure that supports concurrent merge and find.
+///
+/// The parents are stored as atomics and are only modified with
+/// compare-and-swap: find compresses the search path by path halving,
+/// merge links the root with the larger index to the root with the smaller index.
+/// Hence, merge and find can be called from several threads at the same time,
+/// and the representative of a set is always its smallest element,
+/// independent of the order of the merges.
+///
+/// Resetting and assigning are not thread safe.
+///
+template<class T = uint64_t>
+class ConcurrentUfd {
+public:
+    typedef T Index;
+
+    ConcurrentUfd(const Index = 0);
+    void assign(const Index = 0);
+    void reset();
+    void reset(parallel::ThreadPool &);
+
+    Index find(const Index) const;
+    bool merge(Index, Index);
+    bool sameSet(Index, Index) const;
+
+    Index numberOfElements() const;
+    Index numberOfSets() const;
+    bool isRepresentative(const Index element) const;
+
+    template<class Iterator>
+        void representatives(Iterator) const;
+    template<class MAP_LIKE>
+        void representativeLabeling(MAP_LIKE &) const;
+    template<class VECTOR>
+        Index representativeLabeling(VECTOR &, parallel::ThreadPool &) const;
+
+private:
+    std::unique_ptr<std::atomic<Index>[]> parents_;
+    Index numberOfElements_;
+    std::atomic<Index> numberOfSets_;
+};
+
+/// Construct a concurrent ufd (with a number of sets each containing one element).
+///
+/// \param size Number of distinct sets.
+///
+template<class T>
+inline
+ConcurrentUfd<T>::ConcurrentUfd(
+    const Index size
+)
+:   parents_(),
+    numberOfElements_(0),
+    numberOfSets_(0)
+{
+    assign(size);
+}
+
+/// Reset the ufd (to a number of sets each containing one element).
+///
+/// \param size Number of distinct sets.
+///
+template<class T>
+inline void
+ConcurrentUfd<T>::assign(
+    const Index size
+) {
+    if(size != numberOfElements_) {
+        parents_.reset(new std::atomic<Index>[static_cast<uint64_t>(size)]);
+        numberOfElements_ = size;
+    }
+    for(Index j = 0; j < size; ++j) {
+        parents_[static_cast<uint64_t>(j)].store(j, std::memory_order_relaxed);
+    }
+    numberOfSets_ = size;
+}
+
+/// Reset all elements to singleton sets.
+///
+template<class T>
+inline void
+ConcurrentUfd<T>::reset() {
+    if(numberOfSets_.load() == numberOfElements_) {
+        return;
+    }
+    for(Index j = 0; j < numberOfElements_; ++j) {
+        parents_[static_cast<uint64_t>(j)].store(j, std::memory_order_relaxed);
+    }
+    numberOfSets_ = numberOfElements_;
+}
+
+/// Reset all elements to singleton sets in parallel.
+///
+template<class T>
+inline void
+ConcurrentUfd<T>::reset(
+    parallel::ThreadPool & threadpool
+) {
+    if(numberOfSets_.load() == numberOfElements_) {
+        return;
+    }
+    parallel::parallel_foreach(threadpool, numberOfElements_, [&](const int tid, const int64_t j){
+        parents_[static_cast<uint64_t>(j)].store(Index(j), std::memory_order_relaxed);
+    });
+    numberOfSets_ = numberOfElements_;
+}
+
+template<class T>
+inline typename ConcurrentUfd<T>::Index
+ConcurrentUfd<T>::numberOfElements() const {
+    return numberOfElements_;
+}
+
+/// Number of sets, only exact if no merge is running concurrently.
+///
+template<class T>
+inline typename ConcurrentUfd<T>::Index
+ConcurrentUfd<T>::numberOfSets() const {
+    return numberOfSets_.load();
+}
+
+template<class T>
+inline bool
+ConcurrentUfd<T>::isRepresentative(
+    const Index element
+) const {
+    return parents_[static_cast<uint64_t>(element)].load(std::memory_order_relaxed) == element;
+}
+
+/// Find the representative element of the set that contains the given element.
+///
+/// The search path is compressed by path halving, which is safe to do concurrently:
+/// a failed compare-and-swap only means that another thread has already
+/// shortened the path (or linked the root).
+///
+/// \param element Element.
+///
+template<class T>
+inline typename ConcurrentUfd<T>::Index
+ConcurrentUfd<T>::find(
+    Index element
+) const {
+    for(;;) {
+        Index parent = parents_[static_cast<uint64_t>(element)].load(std::memory_order_acquire);
+        if(parent == element) {
+            return element;
+        }
+        const Index grandParent = parents_[static_cast<uint64_t>(parent)].load(std::memory_order_acquire);
+        if(parent != grandParent) {
+            parents_[static_cast<uint64_t>(element)].compare_exchange_weak(
+                parent, grandParent, std::memory_order_acq_rel, std::memory_order_relaxed
+            );
+        }
+        element = grandParent;
+    }
+}
+
+/// Merge two sets.
+///
+/// \param element1 Element in the first set.
+/// \param element2 Element in the second set.
+/// \return True if the sets were disjoint before.
+///
+template<class T>
+inline bool
+ConcurrentUfd<T>::merge(
+    Index element1,
+    Index element2
+) {
+    for(;;) {
+        element1 = find(element1);
+        element2 = find(element2);
+        if(element1 == element2) {
+            return false;
+        }
+        // union by index: the larger root is linked to the smaller one
+        if(element1 < element2) {
+            std::swap(element1, element2);
+        }
+        Index expected = element1;
+        // this fails iff element1 is not a root anymore, then we search again
+        if(parents_[static_cast<uint64_t>(element1)].compare_exchange_strong(
+            expected, element2, std::memory_order_acq_rel, std::memory_order_relaxed
+        )) {
+            numberOfSets_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+}
+
+/// Check whether two elements are in the same set.
+///
+/// Concurrent merges are taken into account: false is only returned
+/// if the first root was still a root after the second root was found.
+///
+template<class T>
+inline bool
+ConcurrentUfd<T>::sameSet(
+    Index element1,
+    Index element2
+) const {
+    for(;;) {
+        element1 = find(element1);
+        element2 = find(element2);
+        if(element1 == element2) {
+            return true;
+        }
+        if(isRepresentative(element1)) {
+            return false;
+        }
+    }
+}
+
+/// Output all elements which are set representatives (in ascending order).
+///
+/// \param it (Output) Iterator.
+///
+template<class T>
+template<class Iterator>
+inline void
+ConcurrentUfd<T>::representatives(
+    Iterator it
+) const {
+    for(Index j = 0; j < numberOfElements_; ++j) {
+        if(isRepresentative(j)) {
+            *it = j;
+            ++it;
+        }
+    }
+}
+
+/// Output a contiguous labeling of the representative elements.
+///
+/// \param out (Output) A map that assigns each representative element to an integer label.
+///
+template<class T>
+template<class MAP_LIKE>
+inline void
+ConcurrentUfd<T>::representativeLabeling(
+    MAP_LIKE & out
+) const {
+    out.clear();
+    Index label = 0;
+    for(Index j = 0; j < numberOfElements_; ++j) {
+        if(isRepresentative(j)) {
+            out[j] = label;
+            ++label;
+        }
+    }
+}
+
+/// Output a contiguous labeling of the representative elements in parallel.
+///
+/// The labels are the same as for the serial representativeLabeling,
+/// i.e. the representatives are labeled in ascending order.
+/// The element range is split into one block per thread, the representatives
+/// are counted per block and the block offsets are given by the prefix sum of the counts.
+/// Must not be called while merges are running.
+///
+/// \param out (Output) Random access container with numberOfElements() entries,
+/// only the entries of the representative elements are written.
+/// \param threadpool Thread pool.
+/// \return Number of representatives.
+///
+template<class T>
+template<class VECTOR>
+inline typename ConcurrentUfd<T>::Index
+ConcurrentUfd<T>::representativeLabeling(
+    VECTOR & out,
+    parallel::ThreadPool & threadpool
+) const {
+    const std::size_t nBlocks = std::max<std::size_t>(threadpool.nThreads(), 1);
+    const Index blockSize = (numberOfElements_ + Index(nBlocks) - 1) / Index(nBlocks);
+    const auto blockBegin = [&](const int64_t block){
+        return std::min(Index(block) * blockSize, numberOfElements_);
+    };
+
+    std::vector<Index> blockOffsets(nBlocks + 1, 0);
+    parallel::parallel_foreach(threadpool, nBlocks, [&](const int tid, const int64_t block){
+        Index count = 0;
+        for(Index j = blockBegin(block); j < blockBegin(block + 1); ++j) {
+            if(isRepresentative(j)) {
+                ++count;
+            }
+        }
+        blockOffsets[block + 1] = count;
+    });
+    std::partial_sum(blockOffsets.begin(), blockOffsets.end(), blockOffsets.begin());
+
+    parallel::parallel_foreach(threadpool, nBlocks, [&](const int tid, const int64_t block){
+        Index label = blockOffsets[block];
+        for(Index j = blockBegin(block); j < blockBegin(block + 1); ++j) {
+            if(isRepresentative(j)) {
+                out[static_cast<uint64_t>(j)] = label;
+                ++label;
+            }
+        }
+    });
+    return blockOffsets.back();
+}
+
+} // namespace ufd
+} // namespace nifty
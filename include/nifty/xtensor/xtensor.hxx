@@ -30,6 +30,14 @@ namespace xtensor {
     }
 
 
+    // pointer to the first element of a contiguous array
+    // (data() returns the storage instead of a pointer in older xtensor versions)
+    template<class ARRAY>
+    inline auto * dataPointer(ARRAY & array) {
+        return &(*array.begin());
+    }
+
+
     // helper function to squeeze along given dimension
     template<class ARRAY>
     inline auto squeezedView(xt::xexpression<ARRAY> & arrayExp) {
@@ -1,9 +1,17 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #include "z5/multiarray/xtensor_access.hxx"
 #include "z5/dataset_factory.hxx"
 #include "nifty/parallel/threadpool.hxx"
 #include "nifty/tools/for_each_block.hxx"
+#include "nifty/tools/for_each_coordinate.hxx"
+#include "nifty/tools/scanline.hxx"
 #include "nifty/xtensor/xtensor.hxx"
 
 #include "xtensor/xeval.hpp"
@@ -11,137 +19,302 @@
 namespace nifty{
 namespace nz5 {
 
-    // TODO this should be moved to z5 itself
-    // TODO make n-dimensional
-    // we just support simple nearest upsampling
-    template<class T>
-    void nearestUpsampling(const std::string & inPath,
-                           const std::vector<int> & samplingFactor,
-                           const std::string & outPath,
-                           const int numberOfThreads) {
+    // Resampling of label volumes stored in z5 datasets by integer factors.
+    //
+    // Both functions are driven by the chunks of the output dataset:
+    // every thread computes one output chunk at a time from the
+    // (small) region of the input it depends on, so the input is streamed
+    // and never loaded as a whole, and every output chunk is written exactly once.
+    // Chunks that contain only zeros are not written.
 
-        typedef T ValueType;
-        typedef xt::xtensor<ValueType, 3> ArrayType;
-        typedef typename ArrayType::shape_type ShapeType;
-        std::vector<std::size_t> zeroCoord = {0, 0, 0};
+    // \cond SUPPRESS_DOXYGEN
+    namespace detail_upsampling {
 
-        parallel::ThreadPool tp(numberOfThreads);
+        template<std::size_t DIM>
+        using Coord = array::StaticArray<int64_t, DIM>;
 
-        auto dsIn = z5::openDataset(inPath);
-        const auto & smallShape = dsIn->shape();
-        const std::size_t nPix = std::accumulate(smallShape.begin(), smallShape.end(), 1, std::multiplies<std::size_t>());
-        const std::vector<std::size_t> strides = {smallShape[2] * smallShape[1], smallShape[2], 1};
+        template<std::size_t DIM, class DS>
+        inline void checkSampling(const DS & dsIn, const DS & dsOut, const std::vector<int> & samplingFactor) {
+            if(dsIn->shape().size() != DIM || dsOut->shape().size() != DIM || samplingFactor.size() != DIM) {
+                throw std::runtime_error("Input, output and sampling factor must have the same dimension");
+            }
+            for(const int f : samplingFactor) {
+                if(f < 1) {
+                    throw std::runtime_error("Sampling factors must be positive");
+                }
+            }
+        }
+
+        // begin and shape of the chunk with the given (row-major) index
+        template<std::size_t DIM, class DS>
+        inline void chunkBeginAndShape(const DS & ds, std::size_t chunkIndex,
+                                       std::vector<std::size_t> & chunkId,
+                                       Coord<DIM> & chunkBegin, Coord<DIM> & chunkShape) {
+            const auto & chunksPerDimension = ds->chunksPerDimension();
+            const auto & maxChunkShape = ds->maxChunkShape();
+            const auto & shape = ds->shape();
+            chunkId.resize(DIM);
+            for(int d = DIM - 1; d >= 0; --d) {
+                chunkId[d] = chunkIndex % chunksPerDimension[d];
+                chunkIndex /= chunksPerDimension[d];
+                chunkBegin[d] = chunkId[d] * maxChunkShape[d];
+                chunkShape[d] = std::min(int64_t(maxChunkShape[d]), int64_t(shape[d]) - chunkBegin[d]);
+            }
+        }
+
+        template<class ARRAY>
+        inline bool isAllZero(const ARRAY & array) {
+            return std::all_of(array.begin(), array.end(), [](const typename ARRAY::value_type v){
+                return v == 0;
+            });
+        }
+
+        template<class T, std::size_t DIM>
+        void nearestUpsampling(const std::string & inPath,
+                               const std::vector<int> & samplingFactor,
+                               const std::string & outPath,
+                               const int numberOfThreads) {
+            typedef xt::xtensor<T, DIM> ArrayType;
+            typedef typename ArrayType::shape_type ShapeType;
+
+            auto dsIn = z5::openDataset(inPath);
+            auto dsOut = z5::openDataset(outPath);
+            checkSampling<DIM>(dsIn, dsOut, samplingFactor);
+            const auto & smallShape = dsIn->shape();
+
+            parallel::ThreadPool tp(numberOfThreads);
+            const std::size_t nThreads = std::max<std::size_t>(tp.nThreads(), 1);
+
+            struct PerThread {
+                ArrayType source;
+                ArrayType chunk;
+                // for every axis and output position within the chunk:
+                // offset of the nearest source pixel in the source buffer
+                std::array<std::vector<int64_t>, DIM> sourceOffsets;
+                std::vector<std::size_t> chunkId;
+            };
+            std::vector<PerThread> perThread(nThreads);
+
+            parallel::parallel_foreach(tp, dsOut->numberOfChunks(), [&](const int tid, const std::size_t chunkIndex){
+                auto & data = perThread[tid];
+
+                Coord<DIM> chunkBegin, chunkShape;
+                chunkBeginAndShape<DIM>(dsOut, chunkIndex, data.chunkId, chunkBegin, chunkShape);
+
+                // the source roi covering this chunk; output pixels beyond
+                // the upsampled input repeat the last source pixel
+                std::vector<std::size_t> sourceBegin(DIM);
+                ShapeType sourceShape;
+                for(std::size_t d = 0; d < DIM; ++d) {
+                    const int64_t f = samplingFactor[d];
+                    const int64_t last = int64_t(smallShape[d]) - 1;
+                    const int64_t b = std::min(chunkBegin[d] / f, last);
+                    const int64_t e = std::min((chunkBegin[d] + chunkShape[d] - 1) / f, last) + 1;
+                    sourceBegin[d] = b;
+                    sourceShape[d] = e - b;
+                }
+                data.source.resize(sourceShape);
+                z5::multiarray::readSubarray<T>(dsIn, data.source, sourceBegin.begin());
+
+                const auto sourceStrides = tools::rowMajorStrides<DIM>(sourceShape);
+                for(std::size_t d = 0; d < DIM; ++d) {
+                    const int64_t f = samplingFactor[d];
+                    auto & offsets = data.sourceOffsets[d];
+                    offsets.resize(chunkShape[d]);
+                    for(int64_t i = 0; i < chunkShape[d]; ++i) {
+                        const int64_t s = std::min((chunkBegin[d] + i) / f - int64_t(sourceBegin[d]),
+                                                   int64_t(sourceShape[d]) - 1);
+                        offsets[i] = s * sourceStrides[d];
+                    }
+                }
 
-        // read all the input data
-        ShapeType arrayShape = {smallShape[0], smallShape[1], smallShape[2]};
-        ArrayType data(arrayShape);
-        z5::multiarray::readSubarray<ValueType>(dsIn, data, zeroCoord.begin());
+                ShapeType outShape;
+                std::copy(chunkShape.begin(), chunkShape.end(), outShape.begin());
+                data.chunk.resize(outShape);
+                const auto chunkStrides = tools::rowMajorStrides<DIM>(outShape);
+
+                // fill the chunk line by line along the last axis
+                const T * src = xtensor::dataPointer(data.source);
+                T * out = xtensor::dataPointer(data.chunk);
+                const auto & lastOffsets = data.sourceOffsets[DIM - 1];
+                tools::forEachScanline(chunkShape, chunkStrides, [&](const Coord<DIM> & coord, const int64_t offset){
+                    int64_t sourceLine = 0;
+                    for(std::size_t d = 0; d + 1 < DIM; ++d) {
+                        sourceLine += data.sourceOffsets[d][coord[d]];
+                    }
+                    const T * srcLine = src + sourceLine;
+                    T * outLine = out + offset;
+                    for(int64_t i = 0; i < chunkShape[DIM - 1]; ++i) {
+                        outLine[i] = srcLine[lastOffsets[i]];
+                    }
+                });
 
-        auto dsOut = z5::openDataset(outPath);
-        const auto & shape = dsOut->shape();
-        const auto & chunkShape = dsOut->maxChunkShape();
-        const std::size_t nChunks = dsOut->numberOfChunks();
+                if(!isAllZero(data.chunk)) {
+                    dsOut->writeChunk(data.chunkId, xtensor::dataPointer(data.chunk));
+                }
+            });
+        }
+
+        template<class T, std::size_t DIM>
+        void majorityVoteDownsampling(const std::string & inPath,
+                                      const std::vector<int> & samplingFactor,
+                                      const std::string & outPath,
+                                      const int numberOfThreads) {
+            typedef xt::xtensor<T, DIM> ArrayType;
+            typedef typename ArrayType::shape_type ShapeType;
+
+            auto dsIn = z5::openDataset(inPath);
+            auto dsOut = z5::openDataset(outPath);
+            checkSampling<DIM>(dsIn, dsOut, samplingFactor);
+            const auto & largeShape = dsIn->shape();
+            const auto & shape = dsOut->shape();
+            for(std::size_t d = 0; d < DIM; ++d) {
+                if(shape[d] * samplingFactor[d] < largeShape[d] ||
+                   (shape[d] - 1) * samplingFactor[d] >= largeShape[d]) {
+                    throw std::runtime_error("Output shape does not match the downsampled input shape");
+                }
+            }
 
-        const auto & chunksPerDimension = dsOut->chunksPerDimension();
-        const std::vector<std::size_t> chunkStrides = {chunksPerDimension[1] * chunksPerDimension[2], chunksPerDimension[2], 1};
+            Coord<DIM> factor, zeros;
+            std::copy(samplingFactor.begin(), samplingFactor.end(), factor.begin());
+            std::fill(zeros.begin(), zeros.end(), 0);
+
+            parallel::ThreadPool tp(numberOfThreads);
+            const std::size_t nThreads = std::max<std::size_t>(tp.nThreads(), 1);
+
+            struct PerThread {
+                ArrayType source;
+                ArrayType chunk;
+                std::vector<T> values;
+                std::vector<int64_t> blockOffsets;
+                std::vector<std::size_t> chunkId;
+            };
+            std::vector<PerThread> perThread(nThreads);
+
+            parallel::parallel_foreach(tp, dsOut->numberOfChunks(), [&](const int tid, const std::size_t chunkIndex){
+                auto & data = perThread[tid];
+
+                Coord<DIM> chunkBegin, chunkShape;
+                chunkBeginAndShape<DIM>(dsOut, chunkIndex, data.chunkId, chunkBegin, chunkShape);
+
+                std::vector<std::size_t> sourceBegin(DIM);
+                ShapeType sourceShape, outShape;
+                for(std::size_t d = 0; d < DIM; ++d) {
+                    sourceBegin[d] = chunkBegin[d] * factor[d];
+                    sourceShape[d] = std::min(int64_t(largeShape[d]),
+                                              (chunkBegin[d] + chunkShape[d]) * factor[d]) - sourceBegin[d];
+                    outShape[d] = chunkShape[d];
+                }
+                data.source.resize(sourceShape);
+                z5::multiarray::readSubarray<T>(dsIn, data.source, sourceBegin.begin());
+                data.chunk.resize(outShape);
+
+                const auto sourceStrides = tools::rowMajorStrides<DIM>(sourceShape);
+                const auto chunkStrides = tools::rowMajorStrides<DIM>(outShape);
+
+                // offsets of a complete block w.r.t. its first pixel
+                data.blockOffsets.clear();
+                tools::forEachCoordinateWithOffset(zeros, factor, sourceStrides, [&](const Coord<DIM> &, const int64_t o){
+                    data.blockOffsets.push_back(o);
+                });
+
+                const T * src = xtensor::dataPointer(data.source);
+                T * out = xtensor::dataPointer(data.chunk);
+                auto & values = data.values;
+                Coord<DIM> blockShape;
+                tools::forEachScanline(chunkShape, chunkStrides, [&](Coord<DIM> coord, const int64_t offset){
+                    for(int64_t i = 0; i < chunkShape[DIM - 1]; ++i) {
+                        coord[DIM - 1] = i;
+                        int64_t blockBegin = 0;
+                        bool complete = true;
+                        for(std::size_t d = 0; d < DIM; ++d) {
+                            blockBegin += coord[d] * factor[d] * sourceStrides[d];
+                            blockShape[d] = std::min(factor[d], int64_t(sourceShape[d]) - coord[d] * factor[d]);
+                            complete = complete && blockShape[d] == factor[d];
+                        }
+
+                        values.clear();
+                        if(complete) {
+                            for(const int64_t o : data.blockOffsets) {
+                                values.push_back(src[blockBegin + o]);
+                            }
+                        }
+                        else {
+                            // truncated block at the border of the volume
+                            tools::forEachCoordinateWithOffset(zeros, blockShape, sourceStrides,
+                                                               [&](const Coord<DIM> &, const int64_t o){
+                                values.push_back(src[blockBegin + o]);
+                            });
+                        }
+
+                        // most frequent value, ties are broken towards the smaller value
+                        std::sort(values.begin(), values.end());
+                        T best = values.front();
+                        std::size_t bestCount = 0;
+                        for(std::size_t j = 0; j < values.size();) {
+                            std::size_t k = j + 1;
+                            while(k < values.size() && values[k] == values[j]) {
+                                ++k;
+                            }
+                            if(k - j > bestCount) {
+                                bestCount = k - j;
+                                best = values[j];
+                            }
+                            j = k;
+                        }
+                        out[offset + i] = best;
+                    }
+                });
 
-        std::unordered_map<std::size_t, ArrayType> chunkStorage;
-        std::vector<std::size_t> chunkProgress(nChunks, 0);
+                if(!isAllZero(data.chunk)) {
+                    dsOut->writeChunk(data.chunkId, xtensor::dataPointer(data.chunk));
+                }
+            });
+        }
 
-        std::mutex m;
+    } // end namespace detail_upsampling
+    // \endcond
 
-        // std::cout << "Here !" << std::endl;
-        parallel::parallel_foreach(tp, nPix, [&](const int tId, const std::size_t pixId){
-            // find the coordinates
-            std::size_t index = pixId;
-            std::size_t posAtAxis;
-            std::vector<std::size_t> coord(3);
-            for(unsigned d = 0; d < 3; ++d) {
-                posAtAxis = index / strides[d];
-                index -= posAtAxis * strides[d];
-                coord[d] = posAtAxis;
-            }
 
-            // std::cout << "AAA" << std::endl;
-            const ValueType val = data(coord[0], coord[1], coord[2]);
+    #define NIFTY_NZ5_DISPATCH_DIMENSION(FUNCTION, T, DIM, ...)                                \
+        switch(DIM) {                                                                           \
+            case 1: detail_upsampling::FUNCTION<T, 1>(__VA_ARGS__); break;                      \
+            case 2: detail_upsampling::FUNCTION<T, 2>(__VA_ARGS__); break;                      \
+            case 3: detail_upsampling::FUNCTION<T, 3>(__VA_ARGS__); break;                      \
+            case 4: detail_upsampling::FUNCTION<T, 4>(__VA_ARGS__); break;                      \
+            case 5: detail_upsampling::FUNCTION<T, 5>(__VA_ARGS__); break;                      \
+            default: throw std::runtime_error("Only datasets with up to 5 dimensions are supported"); \
+        }
 
-            // upsample the coordinates
-            std::vector<std::size_t> pixBegin(3), pixShape(3);
-            for(unsigned d = 0; d < 3; ++d) {
-                pixBegin[d] = coord[d] * samplingFactor[d];
-                const std::size_t pixEnd = std::min((coord[d] + 1) * samplingFactor[d], shape[d]);
-                pixShape[d] = pixEnd - pixBegin[d];
-            }
 
-            std::vector<std::vector<std::size_t>> chunkIds;
-            const auto & chunking = dsOut->chunking();
-            chunking.getBlocksOverlappingRoi(pixBegin, pixShape, chunkIds);
-
-            // std::cout << "BBB" << std::endl;
-            for(const auto & chunkId : chunkIds) {
-                // std::cout << "CCC" << std::endl;
-                // see if the chunk is already in the storage
-                const std::size_t chunkIndex = chunkId[0] * chunkStrides[0] + chunkId[1] * chunkStrides[1] + chunkId[2] * chunkStrides[2];
-                auto chunkIt = chunkStorage.begin();
-                {
-                    std::lock_guard<std::mutex> lock(m);
-                    chunkIt = chunkStorage.find(chunkIndex);
-                    // if it isn't, make the chunk array
-                    if(chunkIt == chunkStorage.end()) {
-                        std::vector<std::size_t> chunkShape;
-                        dsOut->getChunkShape(chunkId, chunkShape);
-                        ShapeType arrayShape = {chunkShape[0], chunkShape[1], chunkShape[2]};
-                        chunkIt = chunkStorage.emplace(chunkIndex, ArrayType(arrayShape)).first;
-                    }
-                }
-                // std::cout << "CCC " << chunkIndex << std::endl;
-
-                // find the local coordinates in the chunk and write the value and mask
-                std::vector<std::size_t> offsetInRequest, shapeInRequest, offsetInChunk;
-                // std::cout << "C1" << std::endl;
-                chunking.getCoordinatesInRoi(chunkId, pixBegin, pixShape,
-                                             offsetInRequest, shapeInRequest, offsetInChunk);
-                // std::cout << offsetInChunk[0] << " " << offsetInChunk[1] << " " << offsetInChunk[2] << std::endl;
-                // std::cout << shapeInRequest[0] << " " << shapeInRequest[1] << " " << shapeInRequest[2] << std::endl;
-                // std::cout << "C2" << std::endl;
-                auto & chunkArray = chunkIt->second;
-                // std::cout << "C3" << std::endl;
-                xt::slice_vector offsetSlice;
-                // std::cout << "C4" << std::endl;
-                xtensor::sliceFromOffset(offsetSlice, offsetInChunk, shapeInRequest);
-                // std::cout << "C5" << std::endl;
-                auto view = xt::strided_view(chunkArray, offsetSlice);
-                // std::cout << "C6" << std::endl;
-                // std::cout << view.shape()[0] << " " << view.shape()[1] << " " << view.shape()[2] << std::endl;
-                view = val;
-
-                // std::cout << "DDD" << std::endl;
-                // check if the chunk is complete and write out if it is
-                const std::size_t requestSize = std::accumulate(shapeInRequest.begin(), shapeInRequest.end(), 1, std::multiplies<std::size_t>());
-                const std::size_t totalSize = dsOut->getChunkSize(chunkId);
-                bool chunkFinished = false;
-                {
-                    std::lock_guard<std::mutex> lock(m);
-                    auto & progress = chunkProgress[chunkIndex];
-                    progress += requestSize;
-                    // this should never be bigger, but just to be sure...
-                    if(progress >= totalSize) {
-                        chunkFinished = true;
-                    }
-                }
+    // nearest upsampling of the dataset at inPath by samplingFactor
+    // into the (existing) dataset at outPath
+    template<class T>
+    void nearestUpsampling(const std::string & inPath,
+                           const std::vector<int> & samplingFactor,
+                           const std::string & outPath,
+                           const int numberOfThreads) {
+        const std::size_t dim = z5::openDataset(inPath)->shape().size();
+        NIFTY_NZ5_DISPATCH_DIMENSION(nearestUpsampling, T, dim,
+                                     inPath, samplingFactor, outPath, numberOfThreads)
+    }
 
-                // std::cout << "EEE" << std::endl;
-                if(chunkFinished) {
-                    //don't write chunk if it is all zeros
-                    auto chunkSum = xt::eval(xt::sum(chunkArray));
-                    if(chunkSum(0) > 0) {
-                        dsOut->writeChunk(chunkId, &chunkArray(0));
-                    }
-                }
-            }
-        });
+
+    // downsampling of the dataset at inPath by samplingFactor into the (existing)
+    // dataset at outPath, every output pixel gets the most frequent value of its block;
+    // this is the inverse of nearestUpsampling
+    template<class T>
+    void majorityVoteDownsampling(const std::string & inPath,
+                                  const std::vector<int> & samplingFactor,
+                                  const std::string & outPath,
+                                  const int numberOfThreads) {
+        const std::size_t dim = z5::openDataset(inPath)->shape().size();
+        NIFTY_NZ5_DISPATCH_DIMENSION(majorityVoteDownsampling, T, dim,
+                                     inPath, samplingFactor, outPath, numberOfThreads)
     }
 
+    #undef NIFTY_NZ5_DISPATCH_DIMENSION
+
 
     inline void intersectMasks(const std::string & maskAPath,
                                const std::string & maskBPath,
@@ -0,0 +1,54 @@
+from __future__ import print_function
+
+import time
+import numpy
+import nifty.graph.rag as nrag
+from nifty.carving import carvingSegmenter
+
+# replay a scripted carving session (one seed edit at a time)
+# with the full kruskal flood and with the incremental mode
+
+shape = (100, 500, 500)
+nLabels = 1000000
+nEdits = 200
+
+numpy.random.seed(42)
+labels = numpy.random.randint(0, nLabels, size=shape, dtype='uint32')
+rag = nrag.gridRag(labels, numberOfLabels=nLabels)
+edgeWeights = numpy.random.rand(rag.numberOfEdges).astype('float32')
+print("nodes", rag.numberOfNodes, "edges", rag.numberOfEdges)
+
+t0 = time.time()
+segmenter = carvingSegmenter(rag, edgeWeights)
+print("construction (sorting edges) %8.3f s" % (time.time() - t0))
+
+# the script: first a background seed, then alternating object and background strokes,
+# with every 10th edit removing an earlier seed
+script = []
+placed = []
+for step in range(nEdits):
+    if step % 10 == 9:
+        node = placed[numpy.random.randint(0, len(placed))]
+        script.append((node, 0))
+    else:
+        node = numpy.random.randint(0, rag.numberOfNodes)
+        script.append((node, 1 if step % 2 == 0 else 2))
+        placed.append(node)
+
+seeds = numpy.zeros(rag.numberOfNodes, dtype='uint8')
+t0 = time.time()
+for node, seed in script:
+    seeds[node] = seed
+    out = segmenter(seeds.copy(), 1., 0.)
+tFull = time.time() - t0
+print("full kruskal   %8.3f s   %8.3f ms / edit" % (tFull, 1000 * tFull / nEdits))
+
+t0 = time.time()
+segmenter.setSeed(0, 0)
+print("merge tree     %8.3f s" % (time.time() - t0))
+t0 = time.time()
+for node, seed in script:
+    segmenter.setSeed(int(node), int(seed))
+tInc = time.time() - t0
+print("incremental    %8.3f s   %8.3f ms / edit  speedup %6.1f" % (tInc, 1000 * tInc / nEdits, tFull / tInc))
+assert numpy.array_equal(segmenter.labels, out)
@@ -0,0 +1,45 @@
+from __future__ import print_function
+
+import time
+import numpy
+import nifty.ufd as nufd
+import nifty.segmentation as nseg
+
+# strong scaling of the concurrent union find
+# for random merges and for connected components of a 3d affinity map
+
+nElements = 50000000
+nMerges = 40000000
+shape = (200, 1024, 1024)
+threadList = [1, 2, 4, 8, 16, 32, 64]
+
+
+def timeit(f):
+    t0 = time.time()
+    res = f()
+    return time.time() - t0, res
+
+
+numpy.random.seed(42)
+mergeIndices = numpy.random.randint(0, nElements, size=(nMerges, 2), dtype='uint64')
+
+print("serial ufd")
+serialUfd = nufd.ufd(nElements)
+t, _ = timeit(lambda: serialUfd.merge(mergeIndices))
+print("time %8.3f s  sets %i" % (t, serialUfd.numberOfSets))
+
+print("concurrent ufd, %i elements %i merges" % (nElements, nMerges))
+tRef = None
+for nThreads in threadList:
+    ufd = nufd.concurrent_ufd(nElements)
+    t, _ = timeit(lambda: ufd.merge(mergeIndices, numberOfThreads=nThreads))
+    tRef = t if tRef is None else tRef
+    print("threads %3i  time %8.3f s  speedup %6.2f  sets %i" % (nThreads, t, tRef / t, ufd.numberOfSets))
+
+affinities = numpy.random.random_sample((3,) + shape).astype('float32')
+print("connected components, shape", shape)
+tRef = None
+for nThreads in threadList:
+    t, (_, nLabels) = timeit(lambda: nseg.connected_components(affinities, 0.6, number_of_threads=nThreads))
+    tRef = t if tRef is None else tRef
+    print("threads %3i  time %8.3f s  speedup %6.2f  labels %i" % (nThreads, t, tRef / t, nLabels))
@@ -74,4 +74,28 @@ if True:
                 val += long(_val)
 
         nifty.tools.parallelForEach(range(numberOfBlocks),f=f, nWorkers=nThreads)
-        print("val",val)
\ No newline at end of file
+        print("val",val)
+
+print()
+
+if True:
+    # direct chunk reads: only fetching the raw chunks is serialized,
+    # decompression happens in parallel
+    h5File = nifty.hdf5.openFile(fileName)
+    array = nifty.hdf5.Hdf5ArrayUInt32(h5File, dsetName)
+    array.directChunkRead = True
+    print("can read chunks directly", array.canReadChunksDirectly)
+    lock = threading.Lock()
+    with nifty.Timer("c++ python direct chunk read"):
+        val = long(0)
+        def f(blockIndex):
+            global val
+            block = blocking.getBlock(blockIndex)
+            b,e = block.begin, block.end
+            subarray = array.readSubarray(b, e)
+            with lock:
+                _val = subarray[0,0,0]
+                val += long(_val)
+
+        nifty.tools.parallelForEach(range(numberOfBlocks),f=f, nWorkers=nThreads)
+        print("val",val)
@@ -0,0 +1,48 @@
+from __future__ import print_function
+
+import time
+import numpy
+import nifty
+import nifty.graph
+import nifty.graph.opt.lifted_multicut as nlmc
+
+# strong scaling of the lifted kernighan lin
+# for a fixed grid model and an increasing number of threads
+
+shape = [500, 500]
+bfsDistance = 3
+threadList = [1, 2, 4, 8, 16, 32, 64]
+
+
+def gridUvIds(shape):
+    ids = numpy.arange(shape[0] * shape[1], dtype='uint64').reshape(shape)
+    uvX = numpy.stack([ids[:-1, :].ravel(), ids[1:, :].ravel()], axis=1)
+    uvY = numpy.stack([ids[:, :-1].ravel(), ids[:, 1:].ravel()], axis=1)
+    return numpy.concatenate([uvX, uvY], axis=0)
+
+
+numpy.random.seed(42)
+g = nifty.graph.UndirectedGraph(shape[0] * shape[1])
+g.insertEdges(gridUvIds(shape))
+
+obj = nlmc.liftedMulticutObjective(g)
+obj.insertLiftedEdgesBfs(bfsDistance)
+uvIds = obj.liftedUvIds()
+costs = numpy.random.uniform(-1.5, 1., size=len(uvIds))
+obj.setCosts(uvIds, costs, overwrite=True)
+print("nodes", g.numberOfNodes, "lifted edges", obj.numberOfLiftedEdges)
+
+# warm start from greedy additive
+solver = obj.liftedMulticutGreedyAdditiveFactory().create(obj)
+start = solver.optimize()
+print("greedy additive energy", obj.evalNodeLabels(start))
+
+tRef = None
+for nThreads in threadList:
+    solver = obj.liftedMulticutKernighanLinFactory(numberOfThreads=nThreads).create(obj)
+    t0 = time.time()
+    labels = solver.optimize(start.copy())
+    t = time.time() - t0
+    tRef = t if tRef is None else tRef
+    print("threads %3i  time %8.3f s  speedup %6.2f  energy %f" % (nThreads, t, tRef / t,
+                                                                    obj.evalNodeLabels(labels)))
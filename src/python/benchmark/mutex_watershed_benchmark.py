@@ -0,0 +1,48 @@
+from __future__ import print_function
+
+import time
+import numpy
+import nifty
+import nifty.segmentation
+
+# kruskal and divisive mutex watershed on 3d affinities
+# with the standard 12 offsets (3 attractive, 9 repulsive channels)
+
+shape = (48, 160, 160)
+offsets = [[-1, 0, 0], [0, -1, 0], [0, 0, -1],
+           [-2, 0, 0], [0, -3, 0], [0, 0, -3],
+           [-3, 0, 0], [0, -9, 0], [0, 0, -9],
+           [-4, 0, 0], [0, -27, 0], [0, 0, -27]]
+nAttractive = 3
+nReps = 3
+
+numpy.random.seed(42)
+
+# blocky ground truth and noisy affinities derived from it
+blocks = [numpy.random.randint(0, 10, size=s) for s in shape]
+gt = blocks[0][:, None, None] * 100 + blocks[1][None, :, None] * 10 + blocks[2][None, None, :]
+weights = numpy.zeros((len(offsets),) + shape, dtype='float32')
+for c, offset in enumerate(offsets):
+    shifted = numpy.roll(gt, [-o for o in offset], axis=(0, 1, 2))
+    weights[c] = (gt == shifted)
+weights += 0.4 * numpy.random.rand(*weights.shape).astype('float32')
+weights /= weights.max()
+print("nodes", gt.size, "edges", weights.size)
+
+validEdges = nifty.segmentation.get_valid_edges(weights.shape, offsets, nAttractive, None, False)
+weights[nAttractive:] *= -1
+weights[nAttractive:] += 1
+t0 = time.time()
+sortedFlatIndices = numpy.argsort(numpy.ma.masked_array(weights, mask=numpy.logical_not(validEdges)),
+                                  axis=None)[::-1].astype('int64')
+print("sorting      time %8.3f s" % (time.time() - t0))
+validEdges = validEdges.ravel().astype('bool')
+
+for name, impl in (('kruskal', nifty.segmentation.compute_mws_segmentation_impl),
+                   ('divisive', nifty.segmentation.compute_divisive_mws_segmentation_impl)):
+    times = []
+    for _ in range(nReps):
+        t0 = time.time()
+        labels = impl(sortedFlatIndices, validEdges, offsets, nAttractive, list(shape))
+        times.append(time.time() - t0)
+    print("%-10s   time %8.3f s  segments %i" % (name, min(times), len(numpy.unique(labels))))
@@ -0,0 +1,52 @@
+from __future__ import print_function
+
+import time
+import numpy
+import nifty
+import nifty.graph
+
+# batched shortest paths from many sources with a bounded radius
+# and single pair queries on a grid graph
+
+shape = [1000, 1000]
+nSources = 2000
+maxDistance = 20.
+threadList = [1, 2, 4, 8, 16]
+
+
+numpy.random.seed(42)
+gridGraph = nifty.graph.undirectedGridGraph(shape)
+weights = numpy.random.uniform(0.5, 2., size=gridGraph.numberOfEdges).astype('float32')
+g = nifty.graph.UndirectedGraph(gridGraph.numberOfNodes)
+g.insertEdges(gridGraph.uvIds())
+print("nodes", g.numberOfNodes, "edges", g.numberOfEdges)
+
+sources = numpy.random.randint(0, g.numberOfNodes, size=nSources).tolist()
+weightList = weights.tolist()
+
+tRef = None
+for nThreads in threadList:
+    t0 = time.time()
+    res = nifty.graph.shortestPathDistancesParallel(g, weightList, sources,
+                                                    maxDistance=maxDistance,
+                                                    numberOfThreads=nThreads)
+    t = time.time() - t0
+    tRef = t if tRef is None else tRef
+    print("bounded radius, threads %3i  time %8.3f s  speedup %6.2f  mean nodes %.1f" % (
+        nThreads, t, tRef / t, numpy.mean([len(nodes) for nodes, _ in res])))
+
+
+nPairs = 20
+pairs = numpy.random.randint(0, g.numberOfNodes, size=(nPairs, 2))
+sp = nifty.graph.ShortestPathDijkstra(g)
+t0 = time.time()
+for source, target in pairs:
+    sp.runSingleSourceSingleTarget(weightList, int(source), int(target))
+print("single pair dijkstra       %8.3f s" % (time.time() - t0))
+
+for method in ('astar', 'bidirectional'):
+    t0 = time.time()
+    for source, target in pairs:
+        nifty.graph.shortestPathSinglePair(gridGraph, weights, int(source), int(target),
+                                           method=method)
+    print("single pair %-14s %8.3f s" % (method, time.time() - t0))
@@ -0,0 +1,32 @@
+from __future__ import print_function
+
+import time
+import numpy
+import nifty
+import nifty.graph
+
+# kruskal vs. parallel edge weighted watersheds on a 3d grid graph
+
+shape = [200, 512, 512]
+nSeeds = 50000
+threadList = [1, 2, 4, 8, 16, 32]
+
+numpy.random.seed(42)
+g = nifty.graph.undirectedGridGraph(shape)
+weights = numpy.random.rand(g.numberOfEdges).astype('float32')
+seeds = numpy.zeros(g.numberOfNodes, dtype='uint64')
+seeds[numpy.random.choice(g.numberOfNodes, nSeeds, replace=False)] = numpy.arange(1, nSeeds + 1)
+print("nodes", g.numberOfNodes, "edges", g.numberOfEdges)
+
+t0 = time.time()
+expected = nifty.graph.edgeWeightedWatershedsSegmentation(g, seeds, weights)
+tRef = time.time() - t0
+print("kruskal      time %8.3f s" % tRef)
+
+for nThreads in threadList:
+    labels, stats = nifty.graph.parallelEdgeWeightedWatershedsSegmentation(g, seeds, weights,
+                                                                           numberOfThreads=nThreads,
+                                                                           returnStatistics=True)
+    assert numpy.array_equal(labels, expected)
+    print("threads %3i  time %8.3f s  speedup %6.2f  rounds %2i  %8.2f M edges / s" % (
+        nThreads, stats.seconds, tRef / stats.seconds, stats.numberOfRounds, stats.edgesPerSecond / 1e6))
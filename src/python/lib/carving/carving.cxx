@@ -12,6 +12,15 @@ namespace nifty{
 namespace carving{
 
 
+    inline xt::pytensor<uint64_t, 1> labelsToArray(const std::vector<uint64_t> & labels) {
+        typedef typename xt::pytensor<uint64_t, 1>::shape_type ShapeType;
+        ShapeType shape = {static_cast<int64_t>(labels.size())};
+        xt::pytensor<uint64_t, 1> out(shape);
+        std::copy(labels.begin(), labels.end(), out.begin());
+        return out;
+    }
+
+
     template<class GRAPH>
     void exportCarvingT(py::module & module,
                         const std::string & graphName) {
@@ -40,6 +49,26 @@ namespace carving{
             }, py::arg("seeds"),
                py::arg("bias"),
                py::arg("noBiasBelow"))
+
+            // incremental mode (kruskal without bias), only the changed seeds are updated
+            .def("updateSeeds", [](CarvingType & self,
+                                   const xt::pytensor<uint64_t, 1> & seeds){
+                {
+                    py::gil_scoped_release allowThreads;
+                    self.updateSeeds(seeds);
+                }
+                return labelsToArray(self.labels());
+            }, py::arg("seeds"))
+
+            .def("setSeed", [](CarvingType & self, const std::size_t node, const uint64_t seed){
+                NIFTY_CHECK_OP(node, <, self.nNodes(), "Node is out of range");
+                py::gil_scoped_release allowThreads;
+                self.setSeed(node, seed);
+            }, py::arg("node"), py::arg("seed"))
+
+            .def_property_readonly("labels", [](const CarvingType & self){
+                return labelsToArray(self.labels());
+            })
         ;
 
     }
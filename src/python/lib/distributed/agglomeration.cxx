@@ -0,0 +1,54 @@
+#ifdef WITH_Z5
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "nifty/distributed/agglomeration.hxx"
+
+namespace py = pybind11;
+
+namespace nifty {
+namespace distributed {
+
+
+    void exportAgglomeration(py::module & module) {
+
+        module.def("agglomerateInBlocks", [](
+            const std::string & graphBlockPrefix,
+            const std::string & edgeFeaturesPath,
+            const std::vector<std::size_t> & blockIds,
+            const std::string & nodeLabelingOut,
+            const double threshold,
+            const int numberOfThreads
+        ) {
+            py::gil_scoped_release allowThreads;
+            agglomerateInBlocks(graphBlockPrefix, edgeFeaturesPath,
+                                blockIds, nodeLabelingOut,
+                                threshold, numberOfThreads);
+        }, py::arg("graphBlockPrefix"), py::arg("edgeFeaturesPath"),
+           py::arg("blockIds"), py::arg("nodeLabelingOut"),
+           py::arg("threshold")=0.5, py::arg("numberOfThreads")=1);
+
+
+        module.def("agglomerateAlongBlockBoundaries", [](
+            const std::string & graphPath,
+            const std::string & edgeFeaturesPath,
+            const std::string & nodeLabelingPath,
+            const std::string & tmpPath,
+            const double threshold,
+            const std::size_t maxNumberOfEdges,
+            const int numberOfThreads
+        ) {
+            py::gil_scoped_release allowThreads;
+            agglomerateAlongBlockBoundaries(graphPath, edgeFeaturesPath,
+                                            nodeLabelingPath, tmpPath,
+                                            threshold, maxNumberOfEdges,
+                                            numberOfThreads);
+        }, py::arg("graphPath"), py::arg("edgeFeaturesPath"),
+           py::arg("nodeLabelingPath"), py::arg("tmpPath"),
+           py::arg("threshold")=0.5, py::arg("maxNumberOfEdges")=100000000,
+           py::arg("numberOfThreads")=1);
+    }
+
+}
+}
+#endif
@@ -22,6 +22,7 @@ namespace distributed{
     void exportDistributedUtils(py::module &);
     void exportLiftedUtils(py::module &);
     void exportMorphology(py::module &);
+    void exportAgglomeration(py::module &);
 
 }
 }
@@ -43,5 +44,6 @@ PYBIND11_MODULE(_distributed, module) {
     exportDistributedUtils(module);
     exportLiftedUtils(module);
     exportMorphology(module);
+    exportAgglomeration(module);
 }
 #endif
@@ -213,14 +213,16 @@ namespace distributed {
 
         module.def("connectedComponents", [](const Graph & graph,
                                              const xt::pytensor<bool, 1> & edgeLabels,
-                                             const bool ignoreLabel){
+                                             const bool ignoreLabel,
+                                             const int numberOfThreads){
             xt::pytensor<NodeType, 1> labels = xt::zeros<NodeType>({graph.nodeMaxId() + 1});
             {
                 py::gil_scoped_release allowThreads;
-                connectedComponents(graph, edgeLabels, ignoreLabel, labels);
+                connectedComponents(graph, edgeLabels, ignoreLabel, labels, numberOfThreads);
             }
             return labels;
-        }, py::arg("graph"), py::arg("edgeLabels"), py::arg("ignoreLabel"));
+        }, py::arg("graph"), py::arg("edgeLabels"), py::arg("ignoreLabel"),
+           py::arg("numberOfThreads")=1);
     }
 }
 }
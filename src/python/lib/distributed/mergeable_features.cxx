@@ -23,20 +23,23 @@ namespace distributed {
                                        const std::string & tmpFeatureStorage,
                                        const FeatureType dataMin,
                                        const FeatureType dataMax,
-                                       const bool increaseRoi) {
+                                       const bool increaseRoi,
+                                       const bool asSketches,
+                                       const bool vigraFeatures) {
             py::gil_scoped_release allowThreads;
             extractBlockFeaturesFromBoundaryMaps<T>(blockPrefix, dataPath, dataKey,
                                                     labelPath, labelKey, blockIds,
                                                     tmpFeatureStorage,
                                                     dataMin, dataMax,
-                                                    increaseRoi);
+                                                    increaseRoi, asSketches, vigraFeatures);
 
         }, py::arg("blockPrefix"),
            py::arg("dataPath"), py::arg("dataKey"),
            py::arg("labelPath"), py::arg("labelKey"),
            py::arg("blockIds"), py::arg("tmpFeatureStorage"),
            py::arg("dataMin")=0., py::arg("dataMax")=1.,
-           py::arg("increaseRoi")=false);
+           py::arg("increaseRoi")=false, py::arg("asSketches")=false,
+           py::arg("vigraFeatures")=false);
 
 
         const std::string fuName2 = "extractBlockFeaturesFromAffinityMaps" + typeName;
@@ -49,18 +52,21 @@ namespace distributed {
                                        const std::string & tmpFeatureStorage,
                                        const std::vector<OffsetType> & offsets,
                                        const FeatureType dataMin,
-                                       const FeatureType dataMax) {
+                                       const FeatureType dataMax,
+                                       const bool asSketches,
+                                       const bool vigraFeatures) {
             py::gil_scoped_release allowthreads;
             extractBlockFeaturesFromAffinityMaps<T>(blockPrefix, dataPath, dataKey,
                                                     labelPath, labelKey, blockIds,
                                                     tmpFeatureStorage, offsets,
-                                                    dataMin, dataMax);
+                                                    dataMin, dataMax, asSketches, vigraFeatures);
 
         }, py::arg("blockPrefix"),
            py::arg("dataPath"), py::arg("dataKey"),
            py::arg("labelPath"), py::arg("labelKey"),
            py::arg("blockIds"), py::arg("tmpFeatureStorage"), py::arg("offsets"),
-           py::arg("dataMin")=0., py::arg("dataMax")=1.);
+           py::arg("dataMin")=0., py::arg("dataMax")=1., py::arg("asSketches")=false,
+           py::arg("vigraFeatures")=false);
     }
 
 
@@ -112,6 +118,27 @@ namespace distributed {
         }, py::arg("graphBlockPrefix"), py::arg("featureBlockPrefix"),
            py::arg("featuresOut"), py::arg("blockIds"), py::arg("edgeIdBegin"),
            py::arg("edgeIdEnd"), py::arg("numberOfThreads")=1);
+
+
+        module.def("mergeFeatureSketchBlocks", [](const std::string & graphBlockPrefix,
+                                                  const std::string & featureBlockPrefix,
+                                                  const std::string & featuresOut,
+                                                  const std::vector<std::size_t> & blockIds,
+                                                  const std::size_t edgeIdBegin,
+                                                  const std::size_t edgeIdEnd,
+                                                  const int numberOfThreads) {
+            py::gil_scoped_release allowThreads;
+            mergeFeatureSketchBlocks(graphBlockPrefix,
+                                     featureBlockPrefix,
+                                     featuresOut,
+                                     blockIds,
+                                     edgeIdBegin,
+                                     edgeIdEnd,
+                                     numberOfThreads);
+
+        }, py::arg("graphBlockPrefix"), py::arg("featureBlockPrefix"),
+           py::arg("featuresOut"), py::arg("blockIds"), py::arg("edgeIdBegin"),
+           py::arg("edgeIdEnd"), py::arg("numberOfThreads")=1);
     }
 
 
@@ -24,15 +24,19 @@ namespace graph{
             const GRAPH & graph,
             xt::pytensor<uint64_t, 1> nodeLabels,
             const bool dense = true,
-            const bool ignoreBackground = false
+            const bool ignoreBackground = false,
+            const int numberOfThreads = -1
         ){
 
             xt::pytensor<uint64_t, 1> ccLabels = xt::zeros<uint64_t>({nodeLabels.shape()[0]});
+            parallel::ThreadPool threadpool(numberOfThreads);
             ComponentsUfd<GRAPH> componentsUfd(graph);
-            componentsUfd.buildFromLabels(nodeLabels);
+            componentsUfd.buildFromLabels(nodeLabels, threadpool);
 
-            for(const auto node : graph.nodes()){
-                ccLabels[node] = componentsUfd.componentLabel(node);
+            if(!dense || ignoreBackground){
+                for(const auto node : graph.nodes()){
+                    ccLabels[node] = componentsUfd.componentLabel(node);
+                }
             }
 
             if(dense && ignoreBackground){
@@ -60,7 +64,7 @@ namespace graph{
                 }
             }
             else if(dense  && !ignoreBackground){
-                componentsUfd.denseRelabeling(ccLabels);
+                componentsUfd.denseRelabeling(ccLabels, threadpool);
             }
             else if(ignoreBackground){
                 for(const auto node : graph.nodes()){
@@ -79,6 +83,7 @@ namespace graph{
             py::arg("nodeLabels"),
             py::arg("dense")=true,
             py::arg("ignoreBackground")=false,
+            py::arg("numberOfThreads")=1,
             "compute connected component labels of a node labeling\n\n"
             ""
             "All nodes which have zero as nodeLabel will keep a zero"
@@ -88,6 +93,7 @@ namespace graph{
             "   nodeLabels (numpy.ndarray): node labeling\n"
             "   dense (bool): should the returned labeling be dense (default {True})\n\n"
             "   ignoreBackground (bool): if true, all input zeros are mapped to zeros (default {False})\n\n"
+            "   numberOfThreads (int): number of threads, the result does not depend on it (default {1})\n\n"
             "Returns:\n\n"
             "   numpy.ndarray : connected components labels"
         );
@@ -115,16 +121,22 @@ namespace graph{
         })
         .def("buildFromNodeLabels",[](
             ComponentsType & self,
-            xt::pytensor<uint64_t, 1> labels
+            xt::pytensor<uint64_t, 1> labels,
+            const int numberOfThreads
         ){
-            self.buildFromLabels(labels);
-        })
+            py::gil_scoped_release allowThreads;
+            parallel::ThreadPool threadpool(numberOfThreads);
+            self.buildFromLabels(labels, threadpool);
+        }, py::arg("labels"), py::arg("numberOfThreads")=1)
         .def("buildFromEdgeLabels",[](
             ComponentsType & self,
-            xt::pytensor<uint8_t, 1> labels
+            xt::pytensor<uint8_t, 1> labels,
+            const int numberOfThreads
         ){
-            self.buildFromEdgeLabels(labels);
-        })
+            py::gil_scoped_release allowThreads;
+            parallel::ThreadPool threadpool(numberOfThreads);
+            self.buildFromEdgeLabels(labels, threadpool);
+        }, py::arg("labels"), py::arg("numberOfThreads")=1)
         .def("componentLabels",[](
             ComponentsType & self
         ){
@@ -7,6 +7,7 @@
 #include "nifty/python/graph/undirected_list_graph.hxx"
 #include "nifty/python/graph/undirected_grid_graph.hxx"
 #include "nifty/graph/edge_weighted_watersheds.hxx"
+#include "nifty/graph/parallel_watersheds.hxx"
 
 namespace py = pybind11;
 
@@ -43,10 +44,60 @@ namespace graph{
             "Returns:\n\n"
             "   numpy.ndarray : the segmentation"
         );
+
+        module.def("parallelEdgeWeightedWatershedsSegmentation",
+            [](
+                const GRAPH & graph,
+                const xt::pytensor<uint64_t, 1> & seeds,
+                const xt::pytensor<float, 1> & edgeWeights,
+                const int numberOfThreads,
+                const bool returnStatistics
+            ){
+                xt::pytensor<uint64_t, 1> labels({uint64_t(seeds.shape()[0])});
+                WatershedsStatistics statistics;
+                {
+                    py::gil_scoped_release allowThreads;
+                    parallelEdgeWeightedWatershedsSegmentation(graph, edgeWeights, seeds, labels,
+                                                               numberOfThreads, &statistics);
+                }
+                if(returnStatistics){
+                    return py::object(py::make_tuple(labels, statistics));
+                }
+                return py::object(py::cast(labels));
+            },
+            py::arg("graph"),
+            py::arg("seeds"),
+            py::arg("edgeWeights"),
+            py::arg("numberOfThreads")=-1,
+            py::arg("returnStatistics")=false,
+            "Parallel edge weighted watershed on a graph\n\n"
+            "The result is identical to edgeWeightedWatershedsSegmentation.\n\n"
+            "Arguments:\n\n"
+            "  graph : the input graph\n"
+            "   seeds (numpy.ndarray): the seeds\n"
+            "   edgeWeights (numpy.ndarray): the edge weights\n"
+            "   numberOfThreads (int): number of threads, -1 means all\n"
+            "   returnStatistics (bool): also return the WatershedsStatistics\n\n"
+            "Returns:\n\n"
+            "   numpy.ndarray : the segmentation"
+        );
     }
 
     void exportEdgeWeightedWatersheds(py::module & module) {
 
+        py::class_<WatershedsStatistics>(module, "WatershedsStatistics")
+            .def_readonly("numberOfNodes", &WatershedsStatistics::numberOfNodes)
+            .def_readonly("numberOfEdges", &WatershedsStatistics::numberOfEdges)
+            .def_readonly("numberOfRounds", &WatershedsStatistics::numberOfRounds)
+            .def_readonly("numberOfForestEdges", &WatershedsStatistics::numberOfForestEdges)
+            .def_readonly("secondsInitialization", &WatershedsStatistics::secondsInitialization)
+            .def_readonly("secondsRounds", &WatershedsStatistics::secondsRounds)
+            .def_readonly("secondsLabeling", &WatershedsStatistics::secondsLabeling)
+            .def_property_readonly("seconds", &WatershedsStatistics::seconds)
+            .def_property_readonly("edgesPerSecond", &WatershedsStatistics::edgesPerSecond)
+            .def_property_readonly("nodesPerSecond", &WatershedsStatistics::nodesPerSecond)
+        ;
+
         {
             typedef UndirectedGraph<> GraphType;
             exportEdgeWeightedWatershedsT<GraphType>(module);
@@ -1,16 +1,24 @@
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 
+#include "xtensor-python/pytensor.hpp"
+
 #include "nifty/python/converter.hxx"
+#include "nifty/tools/runtime_check.hxx"
 #include "nifty/graph/shortest_path_dijkstra.hxx"
+#include "nifty/graph/shortest_path_batch.hxx"
+#include "nifty/graph/shortest_path_single_pair.hxx"
 #include "nifty/graph/undirected_list_graph.hxx"
-#include "nifty/parallel/threadpool.hxx"
+#include "nifty/graph/undirected_grid_graph.hxx"
 
 namespace py = pybind11;
 
-// TODO we need a grid graph to use this for false merge stuff
-// -> best to implement a wrapper for some grid graph in a different module
-
 namespace nifty{
 namespace graph{
 
@@ -156,7 +164,8 @@ namespace graph{
 
         typedef UndirectedGraph<> GraphType;
         typedef WEIGHT_TYPE WeightType;
-        typedef ShortestPathDijkstra<GraphType, WeightType> ShortestPathType;
+        typedef BatchedShortestPathDijkstra<GraphType, WeightType> BatchedShortestPathType;
+        typedef typename BatchedShortestPathType::ShortestPathType ShortestPathType;
         typedef std::vector<WeightType> EdgeWeightsType;
         typedef std::vector<int64_t> NodeVector;
 
@@ -173,14 +182,9 @@ namespace graph{
 
                 {
                     py::gil_scoped_release allowThreads;
-
-                    parallel::ThreadPool threadpool(numberOfThreads);
-                    // initialize a shortest path class for each thread
-                    std::vector<ShortestPathType> shortestPathThreads( threadpool.nThreads(), ShortestPathType(graph) );
-
-                    parallel::parallel_foreach(threadpool, sources.size(), [&](const int tid, const int ii) {
-                        auto & sp = shortestPathThreads[tid];
-                        sp.runSingleSourceSingleTarget(edgeWeights, sources[ii], targets[ii]);
+                    BatchedShortestPathType batched(graph, numberOfThreads);
+                    batched.runSingleSourceSingleTarget(edgeWeights, sources, targets,
+                        [&](const int tid, const int64_t ii, const ShortestPathType & sp) {
                         if(returnNodes)
                             pathsFromPredecessors(sp, sources[ii], targets[ii], paths[ii]);
                         else
@@ -209,16 +213,9 @@ namespace graph{
 
                 {
                     py::gil_scoped_release allowThreads;
-
-                    parallel::ThreadPool threadpool(numberOfThreads);
-                    // initialize a shortest path class for each thread
-                    std::vector<ShortestPathType> shortestPathThreads(threadpool.nThreads(), ShortestPathType(graph));
-
-                    parallel::parallel_foreach(threadpool, sources.size(), [&](const int tid, const int ii) {
-                        auto & sp = shortestPathThreads[tid];
-                        sp.runSingleSourceMultiTarget(edgeWeights,
-                                                      sources[ii],
-                                                      targetVectors[ii]);
+                    BatchedShortestPathType batched(graph, numberOfThreads);
+                    batched.runSingleSourceMultiTarget(edgeWeights, sources, targetVectors,
+                        [&](const int tid, const int64_t ii, const ShortestPathType & sp) {
                         if(returnNodes)
                             pathsFromPredecessors(sp, sources[ii],
                                                   targetVectors[ii], paths[ii]);
@@ -233,12 +230,137 @@ namespace graph{
             py::arg("sources"), py::arg("targetVectors"),
             py::arg("returnNodes")=true, py::arg("numberOfThreads")=-1
         );
+
+
+        graphModule.def("shortestPathDistancesParallel",
+            [](
+                const GraphType & graph,
+                const EdgeWeightsType & edgeWeights,
+                const NodeVector & sources,
+                const WeightType maxDistance,
+                const int numberOfThreads) {
+
+                std::vector<NodeVector> nodes(sources.size());
+                std::vector<std::vector<WeightType>> distances(sources.size());
+                {
+                    py::gil_scoped_release allowThreads;
+                    BatchedShortestPathType batched(graph, numberOfThreads);
+                    batched.runSingleSource(edgeWeights, sources, maxDistance,
+                        [&](const int tid, const int64_t ii, const ShortestPathType & sp) {
+                        const auto & predecessors = sp.predecessors();
+                        const auto & spDistances = sp.distances();
+                        for(const auto node : sp.touchedNodes()){
+                            if(predecessors[node] != -1){
+                                nodes[ii].push_back(node);
+                                distances[ii].push_back(spDistances[node]);
+                            }
+                        }
+                    });
+                }
+
+                py::list out;
+                for(std::size_t ii = 0; ii < sources.size(); ++ii) {
+                    out.append(py::make_tuple(
+                        py::array_t<int64_t>(nodes[ii].size(), nodes[ii].data()),
+                        py::array_t<WeightType>(distances[ii].size(), distances[ii].data())
+                    ));
+                }
+                return out;
+            },
+            py::arg("graph"), py::arg("edgeWeights"), py::arg("sources"),
+            py::arg("maxDistance")=std::numeric_limits<WeightType>::infinity(),
+            py::arg("numberOfThreads")=-1,
+            "For each source, the nodes within maxDistance (in the order they were reached) and their distances."
+        );
+    }
+
+
+    // single pair queries with A* or bidirectional dijkstra,
+    // the heuristic for A* is made from the graph and the minimal edge weight
+    template<class GRAPH, class WEIGHT_TYPE, class HEURISTIC_FACTORY>
+    void exportSinglePairShortestPathT(py::module & graphModule, HEURISTIC_FACTORY heuristicFactory) {
+
+        typedef GRAPH GraphType;
+        typedef WEIGHT_TYPE WeightType;
+        typedef xt::pytensor<WeightType, 1> EdgeWeightsType;
+
+        graphModule.def("shortestPathSinglePair",
+            [heuristicFactory](
+                const GraphType & graph,
+                const EdgeWeightsType & edgeWeights,
+                const int64_t source,
+                const int64_t target,
+                const std::string & method,
+                const bool returnNodes) {
+
+                NIFTY_CHECK_OP(edgeWeights.shape()[0], ==, graph.edgeIdUpperBound() + 1, "wrong number of edge weights");
+                Path nodes;
+                WeightType distance = std::numeric_limits<WeightType>::infinity();
+                {
+                    py::gil_scoped_release allowThreads;
+                    if(method == "astar") {
+                        // a graph without edges has no weights to check
+                        const WeightType minWeight = edgeWeights.size() == 0 ?
+                            WeightType(0) : *std::min_element(edgeWeights.begin(), edgeWeights.end());
+                        NIFTY_CHECK_OP(minWeight, >=, 0, "edge weights must be non-negative");
+                        ShortestPathAStar<GraphType, WeightType> sp(graph);
+                        if(sp.run(edgeWeights, source, target, heuristicFactory(graph, minWeight))) {
+                            sp.path(nodes);
+                            distance = sp.distance();
+                        }
+                    }
+                    else if(method == "bidirectional") {
+                        ShortestPathBidirectionalDijkstra<GraphType, WeightType> sp(graph);
+                        if(sp.run(edgeWeights, source, target)) {
+                            sp.path(nodes);
+                            distance = sp.distance();
+                        }
+                    }
+                    else {
+                        throw std::runtime_error("unknown method " + method + ", use 'astar' or 'bidirectional'");
+                    }
+                }
+
+                // same order as the dijkstra paths: target -> source
+                std::reverse(nodes.begin(), nodes.end());
+                if(returnNodes) {
+                    return std::make_pair(nodes, distance);
+                }
+                Path edges;
+                for(std::size_t ii = 0; ii + 1 < nodes.size(); ++ii) {
+                    edges.push_back(graph.findEdge(nodes[ii], nodes[ii + 1]));
+                }
+                return std::make_pair(edges, distance);
+            },
+            py::arg("graph"), py::arg("edgeWeights"),
+            py::arg("source"), py::arg("target"),
+            py::arg("method")="bidirectional", py::arg("returnNodes")=true,
+            "Shortest path (target -> source) and its length for a single pair of nodes, "
+            "the path is empty if the target is not reachable."
+        );
     }
 
 
     void exportShortestPathDijkstra(py::module & graphModule) {
         exportShortestPathDijkstraT<float>(graphModule);
         exportParallelShortestPathT<float>(graphModule);
+
+        // without geometry, A* degenerates to a dijkstra with early stopping
+        exportSinglePairShortestPathT<UndirectedGraph<>, float>(graphModule,
+            [](const UndirectedGraph<> &, const float){
+                return [](const int64_t, const int64_t){ return 0.0f; };
+            }
+        );
+        exportSinglePairShortestPathT<UndirectedGridGraph<2, true>, float>(graphModule,
+            [](const UndirectedGridGraph<2, true> & g, const float minWeight){
+                return GridGraphL1Heuristic<UndirectedGridGraph<2, true>, float>(g, minWeight);
+            }
+        );
+        exportSinglePairShortestPathT<UndirectedGridGraph<3, true>, float>(graphModule,
+            [](const UndirectedGridGraph<3, true> & g, const float minWeight){
+                return GridGraphL1Heuristic<UndirectedGridGraph<3, true>, float>(g, minWeight);
+            }
+        );
         // TODO this does not work
         //exportShortestPathDijkstraT<double>(graphModule);
     }
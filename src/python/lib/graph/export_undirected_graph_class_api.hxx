@@ -112,15 +112,43 @@ namespace graph{
 
     };
 
+    // graph maps are contiguous (std::vector based),
+    // so we expose their storage via the buffer protocol:
+    // numpy.asarray(map) is a (writable) view and does not copy
+    template<class MAP_TYPE>
+    void exportGraphMapBuffer(py::class_<MAP_TYPE> & cls){
+        typedef typename MAP_TYPE::value_type ValueType;
+        cls
+            .def("__len__", [](const MAP_TYPE & map){
+                return map.size();
+            })
+            .def_buffer([](MAP_TYPE & map) -> py::buffer_info {
+                return py::buffer_info(
+                    map.data(),
+                    sizeof(ValueType),
+                    py::format_descriptor<ValueType>::format(),
+                    1,
+                    {map.size()},
+                    {sizeof(ValueType)}
+                );
+            })
+        ;
+    }
+
     template<class G, class MAP_TYPE>
     void exportEdgeMap(
         py::module & graphModule,
         const std::string & clsName
     ){
-
-        py::class_<MAP_TYPE>(graphModule, clsName.c_str())
+        typedef typename MAP_TYPE::value_type ValueType;
+        py::class_<MAP_TYPE> cls(graphModule, clsName.c_str(), py::buffer_protocol());
+        cls
+            .def(py::init<const G &, const ValueType &>(),
+                py::arg("graph"),
+                py::arg("value") = ValueType()
+            )
         ;
-
+        exportGraphMapBuffer(cls);
     }
 
     template<class G, class MAP_TYPE>
@@ -128,10 +156,15 @@ namespace graph{
         py::module & graphModule,
         const std::string & clsName
     ){
-
-        py::class_<MAP_TYPE>(graphModule, clsName.c_str())
+        typedef typename MAP_TYPE::value_type ValueType;
+        py::class_<MAP_TYPE> cls(graphModule, clsName.c_str(), py::buffer_protocol());
+        cls
+            .def(py::init<const G &, const ValueType &>(),
+                py::arg("graph"),
+                py::arg("value") = ValueType()
+            )
         ;
-
+        exportGraphMapBuffer(cls);
     }
 
     template<class G, class CLS_T>
@@ -169,7 +202,7 @@ namespace graph{
         exportEdgeMap<G, EdgeMapFloat64>(graphModule, clsName + std::string("EdgeMapFloat64"));
 
         typedef typename G:: template NodeMap<double> NodeMapFloat64;
-        exportEdgeMap<G, NodeMapFloat64>(graphModule, clsName + std::string("NodeMapFloat64"));
+        exportNodeMap<G, NodeMapFloat64>(graphModule, clsName + std::string("NodeMapFloat64"));
 
         cls
             .def_property_readonly("numberOfNodes",&G::numberOfNodes)
@@ -202,11 +235,13 @@ namespace graph{
                     const G & self,
                     xt::pytensor<uint64_t, 2> uv
                 ){
-                    xt::pytensor<int64_t, 1> edgeIds = xt::zeros<int64_t>({uv.shape()[0]});
                     NIFTY_CHECK_OP(uv.shape()[1],==,2,"uv.shape(1) must be 2");
-
-                    for(auto i=0; i<uv.shape()[0]; ++i){
-                       edgeIds(i) = self.findEdge(uv(i, 0), uv(i, 1));
+                    xt::pytensor<int64_t, 1> edgeIds({uv.shape()[0]});
+                    {
+                        py::gil_scoped_release allowThreads;
+                        for(auto i=0; i<uv.shape()[0]; ++i){
+                           edgeIds(i) = self.findEdge(uv(i, 0), uv(i, 1));
+                        }
                     }
                     return edgeIds;
                 },
@@ -247,32 +282,27 @@ namespace graph{
 
             .def("bfsEdges",[](G & g, const std::size_t maxDistance){
 
-
-                BreadthFirstSearch<G> bfs(g);
-                std::vector<std::pair<uint64_t, uint64_t>> pairs;
-                g.forEachNode([&](const uint64_t sourceNode){
-                    bfs.graphNeighbourhood(sourceNode, maxDistance,
-
-                        [&](const uint64_t targetNode, const uint64_t distance){
-//                            const std::pair<uint64_t, uint64_t> newPair (targetNode, sourceNode);
-//                            pairs.push_back(newPair);
-                            const auto edge = g.findEdge(sourceNode, targetNode);
-                            // Detect only not-existing edges:
-                            if (edge<0)
-                                pairs.emplace_back(targetNode, sourceNode);
-                        }
-                    );
-                });
-
-                xt::pytensor<uint64_t, 2> out({int64_t(pairs.size()), int64_t(2)});
-
-                auto c=0;
-                for(const auto & uv : pairs){
-                    out(c,0) = uv.first;
-                    out(c,1) = uv.second;
-                    c++;
+                // flat (target, source) pairs, moved to numpy without copy
+                std::vector<uint64_t> pairs;
+                {
+                    py::gil_scoped_release allowThreads;
+                    BreadthFirstSearch<G> bfs(g);
+                    g.forEachNode([&](const uint64_t sourceNode){
+                        bfs.graphNeighbourhood(sourceNode, maxDistance,
+
+                            [&](const uint64_t targetNode, const uint64_t distance){
+                                const auto edge = g.findEdge(sourceNode, targetNode);
+                                // Detect only not-existing edges:
+                                if (edge<0){
+                                    pairs.push_back(targetNode);
+                                    pairs.push_back(sourceNode);
+                                }
+                            }
+                        );
+                    });
                 }
-                return out;
+                const std::size_t nPairs = pairs.size() / 2;
+                return vectorToNumpy(std::move(pairs), {nPairs, std::size_t(2)});
 
             },
                 py::arg("maxDistance")
@@ -282,11 +312,14 @@ namespace graph{
                              const G & g,
                              xt::pytensor<uint64_t, 1> nodeLabels
                      ){
-                         xt::pytensor<uint8_t, 1> edgeLabels = xt::zeros<uint8_t>({int64_t(g.numberOfEdges())});
                          NIFTY_CHECK_OP(nodeLabels.shape()[0],==,g.numberOfNodes(),"Array should have shape (numberOfNodes, )");
-                         for(const auto edge : g.edges()){
-                             const auto uv = g.uv(edge);
-                             edgeLabels(edge) = nodeLabels(uv.first) != nodeLabels(uv.second) ? 1 : 0;
+                         xt::pytensor<uint8_t, 1> edgeLabels({int64_t(g.numberOfEdges())});
+                         {
+                             py::gil_scoped_release allowThreads;
+                             for(const auto edge : g.edges()){
+                                 const auto uv = g.uv(edge);
+                                 edgeLabels(edge) = nodeLabels(uv.first) != nodeLabels(uv.second) ? 1 : 0;
+                             }
                          }
                          return edgeLabels;
                      },
@@ -299,12 +332,15 @@ namespace graph{
                 .def("uvIds",
                 [](G & g) {
                     xt::pytensor<uint64_t, 2> out({int64_t(g.numberOfEdges()), int64_t(2)});
-                    auto c = 0 ;
-                    for(const auto edge : g.edges()){
-                        const auto uv = g.uv(edge);
-                        out(c,0) = uv.first;
-                        out(c,1) = uv.second;
-                        ++c;
+                    {
+                        py::gil_scoped_release allowThreads;
+                        auto c = 0 ;
+                        for(const auto edge : g.edges()){
+                            const auto uv = g.uv(edge);
+                            out(c,0) = uv.first;
+                            out(c,1) = uv.second;
+                            ++c;
+                        }
                     }
                     return out;
                 },
@@ -18,6 +18,7 @@ namespace graph{
 
 
     void exportUndirectedListGraph(py::module &);
+    void exportUndirectedGraphSnapshot(py::module &);
     void exportUndirectedGridGraph(py::module &);
     void exportUndirectedLongRangeGridGraph(py::module &);
     void exportEdgeContractionGraphUndirectedGraph(py::module & );
@@ -42,6 +43,7 @@ PYBIND11_MODULE(_graph, module) {
     using namespace nifty::graph;
 
     exportUndirectedListGraph(module);
+    exportUndirectedGraphSnapshot(module);
     exportUndirectedGridGraph(module);
     exportUndirectedLongRangeGridGraph(module);
     exportEdgeContractionGraphUndirectedGraph(module);
@@ -8,6 +8,7 @@
 #include "nifty/python/graph/undirected_grid_graph.hxx"
 
 #include "nifty/graph/node_weighted_watersheds.hxx"
+#include "nifty/graph/parallel_watersheds.hxx"
 
 
 namespace py = pybind11;
@@ -41,6 +42,45 @@ namespace graph{
             "Returns:\n\n"
             "   numpy.ndarray : the segmentation"
         );
+
+        module.def("parallelNodeWeightedWatershedsSegmentation",
+        [](
+            const GRAPH & graph,
+            const xt::pytensor<uint64_t, 1> & seeds,
+            const xt::pytensor<float, 1> & nodeWeights,
+            const int numberOfThreads,
+            const bool returnStatistics
+        ){
+            xt::pytensor<uint64_t, 1> labels({uint64_t(seeds.shape()[0])});
+            WatershedsStatistics statistics;
+            {
+                py::gil_scoped_release allowThreads;
+                parallelNodeWeightedWatershedsSegmentation(graph, nodeWeights, seeds, labels,
+                                                           numberOfThreads, &statistics);
+            }
+            if(returnStatistics){
+                return py::object(py::make_tuple(labels, statistics));
+            }
+            return py::object(py::cast(labels));
+        },
+            py::arg("graph"),
+            py::arg("seeds"),
+            py::arg("nodeWeights"),
+            py::arg("numberOfThreads")=-1,
+            py::arg("returnStatistics")=false,
+            "Parallel node weighted watershed on a graph\n\n"
+            "Kruskal watershed on the edge weights max(w(u), w(v)), seeds do not contribute\n"
+            "their weight. Unlike nodeWeightedWatershedsSegmentation, the result does\n"
+            "not depend on the processing order of equal weights.\n\n"
+            "Arguments:\n\n"
+            "  graph : the input graph\n"
+            "   seeds (numpy.ndarray): the seeds\n"
+            "   nodeWeights (numpy.ndarray): the node weights\n"
+            "   numberOfThreads (int): number of threads, -1 means all\n"
+            "   returnStatistics (bool): also return the WatershedsStatistics\n\n"
+            "Returns:\n\n"
+            "   numpy.ndarray : the segmentation"
+        );
     }
 
     void exportNodeWeightedWatersheds(py::module & module) {
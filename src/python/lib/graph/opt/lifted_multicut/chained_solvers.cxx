@@ -35,7 +35,9 @@ namespace lifted_multicut{
         docHelper.mainText =  
             "Chain multiple solvers\n"
             "such that each successor is warm-started with \n"
-            "its predecessor solver.\n";
+            "its predecessor solver.\n"
+            "The chain stops early once a time limit or a target energy\n"
+            "is reached or the solvers stop improving.\n";
         docHelper.note = "The solvers should be able to be warm started. (Except the first one)";
         
 
@@ -48,6 +50,11 @@ namespace lifted_multicut{
         exportLiftedMulticutSolver<Solver>(liftedMulticutModule, solverName.c_str())
             .def(py::init<>())
             .def_readwrite("factories", &SettingsType::factories)
+            .def_readwrite("timeLimit", &SettingsType::timeLimit)
+            .def_readwrite("targetEnergy", &SettingsType::targetEnergy)
+            .def_readwrite("maxNumberOfStagesWithoutImprovement", &SettingsType::maxNumberOfStagesWithoutImprovement)
+            .def_readwrite("minImprovement", &SettingsType::minImprovement)
+            .def_readwrite("restoreBest", &SettingsType::restoreBest)
 
         ; 
     }
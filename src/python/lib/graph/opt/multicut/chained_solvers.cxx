@@ -36,7 +36,9 @@ namespace multicut{
         docHelper.mainText =  
             "Chain multiple solvers\n"
             "such that each successor is warm-started with \n"
-            "its predecessor solver.\n";
+            "its predecessor solver.\n"
+            "The chain stops early once a time limit or a target energy\n"
+            "is reached or the solvers stop improving.\n";
         docHelper.note = "The solvers should be able to be warm started. (Except the first one)";
         
 
@@ -49,6 +51,11 @@ namespace multicut{
         exportMulticutSolver<Solver>(multicutModule, solverName.c_str(), docHelper)
             .def(py::init<>())
             .def_readwrite("multicutFactories", &SettingsType::multicutFactories)
+            .def_readwrite("timeLimit", &SettingsType::timeLimit)
+            .def_readwrite("targetEnergy", &SettingsType::targetEnergy)
+            .def_readwrite("maxNumberOfStagesWithoutImprovement", &SettingsType::maxNumberOfStagesWithoutImprovement)
+            .def_readwrite("minImprovement", &SettingsType::minImprovement)
+            .def_readwrite("restoreBest", &SettingsType::restoreBest)
 
         ; 
     }
@@ -0,0 +1,82 @@
+#include <pybind11/pybind11.h>
+
+#include "nifty/graph/opt/multicut/multicut_objective.hxx"
+#include "nifty/graph/opt/multicut/multicut_approximate_greedy_additive.hxx"
+
+#include "nifty/python/graph/undirected_list_graph.hxx"
+#include "nifty/python/graph/edge_contraction_graph.hxx"
+#include "nifty/python/graph/opt/multicut/multicut_objective.hxx"
+#include "nifty/python/converter.hxx"
+
+#include "nifty/python/graph/opt/solver_docstring.hxx"
+#include "nifty/python/graph/opt/multicut/export_multicut_solver.hxx"
+
+namespace py = pybind11;
+
+PYBIND11_DECLARE_HOLDER_TYPE(T, std::shared_ptr<T>);
+
+namespace nifty{
+namespace graph{
+namespace opt{
+namespace multicut{
+
+    template<class OBJECTIVE>
+    void exportMulticutApproximateGreedyAdditiveT(py::module & multicutModule) {
+
+
+        ///////////////////////////////////////////////////////////////
+        // DOCSTRING HELPER
+        ///////////////////////////////////////////////////////////////
+        nifty::graph::opt::SolverDocstringHelper docHelper;
+        docHelper.objectiveName =
+            "multicut objective";
+        docHelper.objectiveClsName = 
+            MulticutObjectiveName<OBJECTIVE>::name();
+        docHelper.name = 
+            "approximate greedy additive";
+        docHelper.mainText =  
+            "Find approximate solutions via\n"
+            "agglomerative clustering as in :cite:`beier_15_funsion`.\n"
+            "Instead of the single heaviest edge, a matching of edges\n"
+            "which are the heaviest edges within their neighborhood\n"
+            "(up to a factor of 1 - epsilon) is contracted in parallel rounds.\n";
+        docHelper.cites.emplace_back("beier_15_funsion");
+        docHelper.note = 
+            "This solver should be used to\n"        
+            "warm start other solvers with\n"
+            "on very large graphs.\n";
+
+
+
+        typedef OBJECTIVE ObjectiveType;
+        typedef MulticutApproximateGreedyAdditive<ObjectiveType> Solver;
+        typedef typename Solver::SettingsType SettingsType;
+        
+        exportMulticutSolver<Solver>(multicutModule,"MulticutApproximateGreedyAdditive",docHelper)
+            .def(py::init<>())
+            .def_readwrite("nodeNumStopCond", &SettingsType::nodeNumStopCond)
+            .def_readwrite("weightStopCond", &SettingsType::weightStopCond)
+            .def_readwrite("epsilon", &SettingsType::epsilon)
+            .def_readwrite("numberOfThreads", &SettingsType::numberOfThreads)
+            .def_readwrite("visitNth", &SettingsType::visitNth)
+        ;
+     
+    }
+
+    void exportMulticutApproximateGreedyAdditive(py::module & multicutModule) {
+        {
+            typedef PyUndirectedGraph GraphType;
+            typedef MulticutObjective<GraphType, double> ObjectiveType;
+            exportMulticutApproximateGreedyAdditiveT<ObjectiveType>(multicutModule);
+        }
+        {
+            typedef PyContractionGraph<PyUndirectedGraph> GraphType;
+            typedef MulticutObjective<GraphType, double> ObjectiveType;
+            exportMulticutApproximateGreedyAdditiveT<ObjectiveType>(multicutModule);
+        }
+    }
+
+} // namespace nifty::graph::opt::multicut
+} // namespace nifty::graph::opt
+}
+}
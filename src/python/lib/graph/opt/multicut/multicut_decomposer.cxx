@@ -39,7 +39,9 @@ namespace multicut{
                 "sub-models  as described in :cite:`alush_2013_simbad`.\n"
                 "If a model decomposes into components such that there are no\n"
                 "positive weighted edges between the components one can\n"
-                "optimize each model separately.\n";
+                "optimize each model separately.\n"
+                "Components without repulsive edges are solved in closed form,\n"
+                "the other components are solved in parallel, largest first.\n";
 
         
             docHelper.cites.emplace_back("alush_2013_simbad");
@@ -59,6 +61,9 @@ namespace multicut{
             .def(py::init<>())
             .def_readwrite("submodelFactory",   &SettingsType::submodelFactory)
             .def_readwrite("fallthroughFactory",&SettingsType::fallthroughFactory)
+            .def_readwrite("smallSubmodelFactory",&SettingsType::smallSubmodelFactory)
+            .def_readwrite("smallSubmodelSize",&SettingsType::smallSubmodelSize)
+            .def_readwrite("numberOfThreads",&SettingsType::numberOfThreads)
         ; 
     }
 
@@ -32,13 +32,14 @@ namespace graph{
             const int numberOfThreads
         ){
 
-            // TODO
-            //{
-            //    py::gil_scoped_release allowThreads;
-            //}
-            LiftedNh<RAG> lnh(
-                rag, offsets.begin(), offsets.end(), numberOfThreads
-            );
+            std::unique_ptr<LiftedNh<RAG>> lnhPtr;
+            {
+                py::gil_scoped_release allowThreads;
+                lnhPtr = std::make_unique<LiftedNh<RAG>>(
+                    rag, offsets.begin(), offsets.end(), numberOfThreads
+                );
+            }
+            const auto & lnh = *lnhPtr;
 
             const int64_t nLocal  = rag.numberOfEdges();
             int64_t nLifted = lnh.numberOfEdges();
@@ -0,0 +1,131 @@
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "nifty/graph/undirected_list_graph.hxx"
+#include "nifty/graph/undirected_graph_snapshot.hxx"
+
+#include "export_undirected_graph_class_api.hxx"
+#include "xtensor-python/pytensor.hpp"
+
+namespace py = pybind11;
+
+namespace nifty{
+namespace graph{
+
+
+    // read-only numpy view of a map stored in the snapshot,
+    // the view keeps the mapped graph (and hence the file mapping) alive
+    template<class T>
+    py::object mappedMapView(py::object self, const std::string & name, const bool isEdgeMap){
+        const auto & g = self.cast<const MappedUndirectedGraph &>();
+        const T * data = isEdgeMap ? g.edgeMap<T>(name) : g.nodeMap<T>(name);
+        const std::size_t size = isEdgeMap ? g.numberOfEdges() : g.numberOfNodes();
+        return readOnlyView(data, {size}, {sizeof(T)}, self);
+    }
+
+    py::object mappedMapView(py::object self, const std::string & name, const bool isEdgeMap){
+        using namespace detail_graph_snapshot;
+        const auto & g = self.cast<const MappedUndirectedGraph &>();
+        switch(g.mapTypeCode(name, isEdgeMap)){
+            case TypeCode<uint8_t>::value:
+                return mappedMapView<uint8_t>(self, name, isEdgeMap);
+            case TypeCode<uint32_t>::value:
+                return mappedMapView<uint32_t>(self, name, isEdgeMap);
+            case TypeCode<uint64_t>::value:
+                return mappedMapView<uint64_t>(self, name, isEdgeMap);
+            case TypeCode<int32_t>::value:
+                return mappedMapView<int32_t>(self, name, isEdgeMap);
+            case TypeCode<int64_t>::value:
+                return mappedMapView<int64_t>(self, name, isEdgeMap);
+            case TypeCode<float>::value:
+                return mappedMapView<float>(self, name, isEdgeMap);
+            case TypeCode<double>::value:
+                return mappedMapView<double>(self, name, isEdgeMap);
+            default:
+                throw std::runtime_error("unknown value type of map " + name);
+        }
+    }
+
+
+    void exportUndirectedGraphSnapshot(py::module & graphModule) {
+
+        typedef MappedUndirectedGraph GraphType;
+        const auto clsName = std::string("MappedUndirectedGraph");
+        auto mappedGraphCls = py::class_<GraphType>(graphModule, clsName.c_str());
+
+        mappedGraphCls
+            .def(py::init<const std::string &>(),
+                py::arg("path"),
+                "Memory-map a graph snapshot (read-only, nothing is copied)\n\n"
+                "Args:\n"
+                "   path (str): path of a snapshot written by writeGraphSnapshot"
+            )
+            .def("uvIdsView",
+                [](py::object self) {
+                    const auto & g = self.cast<const GraphType &>();
+                    return readOnlyView(reinterpret_cast<const uint64_t *>(g.uvIdsData()),
+                                        {g.numberOfEdges(), std::size_t(2)},
+                                        {2 * sizeof(uint64_t), sizeof(uint64_t)},
+                                        self);
+                },
+                "Get the uv-ids as read-only view of the mapped file (no copy)."
+            )
+            .def("edgeMap",
+                [](py::object self, const std::string & name) {
+                    return mappedMapView(self, name, true);
+                },
+                py::arg("name"),
+                "Get an edge map stored in the snapshot as read-only view of the mapped file."
+            )
+            .def("nodeMap",
+                [](py::object self, const std::string & name) {
+                    return mappedMapView(self, name, false);
+                },
+                py::arg("name"),
+                "Get a node map stored in the snapshot as read-only view of the mapped file."
+            )
+            .def_property_readonly("edgeMapNames", [](const GraphType & g) {
+                std::vector<std::string> edgeMapNames, nodeMapNames;
+                g.mapNames(edgeMapNames, nodeMapNames);
+                return edgeMapNames;
+            })
+            .def_property_readonly("nodeMapNames", [](const GraphType & g) {
+                std::vector<std::string> edgeMapNames, nodeMapNames;
+                g.mapNames(edgeMapNames, nodeMapNames);
+                return nodeMapNames;
+            })
+        ;
+
+        graphModule.def("writeGraphSnapshot",
+            [](const UndirectedGraph<> & graph,
+               const std::string & path,
+               const std::map<std::string, xt::pytensor<double, 1>> & edgeMaps,
+               const std::map<std::string, xt::pytensor<double, 1>> & nodeMaps) {
+                GraphSnapshotWriter<UndirectedGraph<>> writer(graph);
+                for(const auto & map : edgeMaps) {
+                    writer.addEdgeMap(map.first, map.second);
+                }
+                for(const auto & map : nodeMaps) {
+                    writer.addNodeMap(map.first, map.second);
+                }
+                py::gil_scoped_release allowThreads;
+                writer.write(path);
+            },
+            py::arg("graph"),
+            py::arg("path"),
+            py::arg("edgeMaps") = py::dict(),
+            py::arg("nodeMaps") = py::dict(),
+            "Write a graph (and float64 edge / node maps) as binary snapshot\n\n"
+            "The snapshot can be loaded without rebuilding the graph via MappedUndirectedGraph.\n\n"
+            "Args:\n"
+            "   graph (UndirectedGraph): the graph (or region adjacency graph)\n"
+            "   path (str): output path\n"
+            "   edgeMaps (dict): named edge maps\n"
+            "   nodeMaps (dict): named node maps"
+        );
+
+        // export the base graph API
+        exportUndirectedGraphClassAPI<GraphType>(graphModule, mappedGraphCls, clsName);
+    }
+}
+}
@@ -40,8 +40,11 @@ namespace graph{
                 [](const GraphType & g) {
                     typename xt::pytensor<uint64_t, 1>::shape_type shape = {static_cast<int64_t>(g.serializationSize())};
                     xt::pytensor<uint64_t, 1> out(shape);
-                    auto ptr = &out(0);
-                    g.serialize(ptr);
+                    {
+                        py::gil_scoped_release allowThreads;
+                        auto ptr = &out(0);
+                        g.serialize(ptr);
+                    }
                     return out;
                 }
             )
@@ -54,6 +57,7 @@ namespace graph{
 
                     NIFTY_CHECK_OP(d,==,serialization.size(),
                                    "serialization must be contiguous");
+                    py::gil_scoped_release allowThreads;
                     g.deserialize(startPtr);
                 }
             )
@@ -67,30 +71,19 @@ namespace graph{
                                                    innerEdgesVec,
                                                    outerEdgesVec);
                     }
-                    xt::pytensor<int64_t, 1> innerEdges = xt::zeros<int64_t>({static_cast<int64_t>(innerEdgesVec.size())});
-                    xt::pytensor<int64_t, 1> outerEdges = xt::zeros<int64_t>({static_cast<int64_t>(outerEdgesVec.size())});
-                    {
-                        py::gil_scoped_release allowThreads;
-                        for(std::size_t i = 0; i < innerEdgesVec.size(); ++i) {
-                            innerEdges(i) = innerEdgesVec[i];
-                        }
-                        for(std::size_t i = 0; i < outerEdgesVec.size(); ++i) {
-                            outerEdges(i) = outerEdgesVec[i];
-                        }
-
-                    }
-                    return std::make_pair(innerEdges, outerEdges);
+                    return std::make_pair(vectorToNumpy(std::move(innerEdgesVec)),
+                                          vectorToNumpy(std::move(outerEdgesVec)));
                 }
             )
             .def("edgesFromNodeList",
-                [](GraphType & g, const std::vector<int64_t> & nodeList) {
+                [](GraphType & g, const xt::pytensor<int64_t, 1> & nodeList) {
 
                     std::vector<int64_t> edges;
                     {
                         py::gil_scoped_release allowThreads;
                         g.edgesFromNodeList(nodeList, edges);
                     }
-                    return edges;
+                    return vectorToNumpy(std::move(edges));
                 }
             )
             .def("shrinkToFit",&GraphType::shrinkToFit)
@@ -103,28 +96,31 @@ namespace graph{
                 const xt::pytensor<int64_t, 2> &   offsets,
                 const xt::pytensor<float, 4> &   affinities
             ){
-                g.assign(shape[0]*shape[1]*shape[2]);
-
                 uint64_t u=0;
-                for(int p0=0; p0<shape[0]; ++p0)
-                for(int p1=0; p1<shape[1]; ++p1)
-                for(int p2=0; p2<shape[2]; ++p2){
+                {
+                    py::gil_scoped_release allowThreads;
+                    g.assign(shape[0]*shape[1]*shape[2]);
 
-                    for(int io=0; io<offsets.shape()[0]; ++io){
+                    for(int p0=0; p0<shape[0]; ++p0)
+                    for(int p1=0; p1<shape[1]; ++p1)
+                    for(int p2=0; p2<shape[2]; ++p2){
 
-                        const int q0 = p0 + offsets(io, 0);
-                        const int q1 = p1 + offsets(io, 1);
-                        const int q2 = p2 + offsets(io, 2);
+                        for(int io=0; io<offsets.shape()[0]; ++io){
 
-                        if(q0>=0 && q0<shape[0] &&
-                           q1>=0 && q1<shape[1] &&
-                           q2>=0 && q2<shape[2]){
+                            const int q0 = p0 + offsets(io, 0);
+                            const int q1 = p1 + offsets(io, 1);
+                            const int q2 = p2 + offsets(io, 2);
 
-                            const auto v = q0*shape[1]*shape[2] + q1*shape[2] + q2;
-                            const auto e = g.insertEdge(u, v);
+                            if(q0>=0 && q0<shape[0] &&
+                               q1>=0 && q1<shape[1] &&
+                               q2>=0 && q2<shape[2]){
+
+                                const auto v = q0*shape[1]*shape[2] + q1*shape[2] + q2;
+                                const auto e = g.insertEdge(u, v);
+                            }
                         }
+                        ++u;
                     }
-                    ++u;
                 }
 
                 typedef typename xt::pytensor<uint32_t, 1>::shape_type TensorShapeType;
@@ -133,27 +129,30 @@ namespace graph{
                 xt::pytensor<float, 1>      aff({tensorShape});
 
                 u=0;
-                for(int p0=0; p0<shape[0]; ++p0)
-                for(int p1=0; p1<shape[1]; ++p1)
-                for(int p2=0; p2<shape[2]; ++p2){
-
-                    for(int io=0; io<offsets.shape()[0]; ++io){
-
-                        const int q0 = p0 + offsets(io, 0);
-                        const int q1 = p1 + offsets(io, 1);
-                        const int q2 = p2 + offsets(io, 2);
-
-                        if(q0>=0 && q0<shape[0] &&
-                           q1>=0 && q1<shape[1] &&
-                           q2>=0 && q2<shape[2]){
-
-                            const auto v = q0*shape[1]*shape[2] + q1*shape[2] + q2;
-                            const auto e = g.findEdge(u, v);
-                            offsetsIndex(e) = io;
-                            aff(e) = affinities(io, p0, p1, p2);
+                {
+                    py::gil_scoped_release allowThreads;
+                    for(int p0=0; p0<shape[0]; ++p0)
+                    for(int p1=0; p1<shape[1]; ++p1)
+                    for(int p2=0; p2<shape[2]; ++p2){
+
+                        for(int io=0; io<offsets.shape()[0]; ++io){
+
+                            const int q0 = p0 + offsets(io, 0);
+                            const int q1 = p1 + offsets(io, 1);
+                            const int q2 = p2 + offsets(io, 2);
+
+                            if(q0>=0 && q0<shape[0] &&
+                               q1>=0 && q1<shape[1] &&
+                               q2>=0 && q2<shape[2]){
+
+                                const auto v = q0*shape[1]*shape[2] + q1*shape[2] + q2;
+                                const auto e = g.findEdge(u, v);
+                                offsetsIndex(e) = io;
+                                aff(e) = affinities(io, p0, p1, p2);
+                            }
                         }
+                        ++u;
                     }
-                    ++u;
                 }
                 return std::make_pair(aff, offsetsIndex);
             }
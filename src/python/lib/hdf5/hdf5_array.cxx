@@ -50,10 +50,16 @@ namespace hdf5{
             .def_property_readonly("chunkShape", [](const Hdf5ArrayType & array){
                 return array.chunkShape();
             })
+            .def_property("directChunkRead",
+                &Hdf5ArrayType::directChunkRead,
+                &Hdf5ArrayType::setDirectChunkRead
+            )
+            .def_property_readonly("canReadChunksDirectly", &Hdf5ArrayType::canReadChunksDirectly)
             .def("readSubarray",[](
                 const Hdf5ArrayType & array,
                 std::vector<std::size_t> roiBegin,
-                std::vector<std::size_t> roiEnd
+                std::vector<std::size_t> roiEnd,
+                const int numberOfThreads
             ){
                 typedef typename xt::pyarray<T>::shape_type ShapeType;
                 const auto dim = array.dimension();
@@ -69,10 +75,20 @@ namespace hdf5{
                 xt::pyarray<T> out(shape);
                 {
                     py::gil_scoped_release liftGil;
-                    array.readSubarray(roiBegin.begin(), out);
+                    if(numberOfThreads == 1){
+                        array.readSubarray(roiBegin.begin(), out);
+                    }
+                    else{
+                        parallel::ThreadPool threadpool(numberOfThreads);
+                        array.readSubarray(roiBegin.begin(), out, threadpool);
+                    }
                 }
                 return out;
-            })
+            },
+                py::arg("roiBegin"),
+                py::arg("roiEnd"),
+                py::arg("numberOfThreads")=1
+            )
 
             .def("writeSubarray",[](
                 Hdf5ArrayType & array,
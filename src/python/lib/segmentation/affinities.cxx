@@ -17,7 +17,8 @@ namespace nifty {
             m.def("compute_affinities", [](const xt::pyarray<T> & labels,
                                            const std::vector<std::vector<int>> & offsets,
                                            const bool have_ignore_label,
-                                           const T ignore_label) {
+                                           const T ignore_label,
+                                           const int number_of_threads) {
                     // compute the out shape
                     typedef typename xt::pyarray<float>::shape_type ShapeType;
                     const auto & shape = labels.shape();
@@ -35,13 +36,15 @@ namespace nifty {
                         py::gil_scoped_release allowThreads;
                         compute_affinities(labels, offsets,
                                                        affs, mask,
-                                                       have_ignore_label, ignore_label);
+                                                       have_ignore_label, ignore_label,
+                                                       number_of_threads);
                     }
                     return std::make_pair(affs, mask);
                 }, py::arg("labels").noconvert(),
                    py::arg("offset"),
                    py::arg("have_ignore_label")=false,
-                   py::arg("ignore_label")=0);
+                   py::arg("ignore_label")=0,
+                   py::arg("number_of_threads")=-1);
         }
 
         void exportAffinities(py::module & m) {
@@ -13,18 +13,20 @@ namespace nifty {
 
         void exportConnectedComponents(py::module & m) {
             m.def("connected_components", [](const xt::pyarray<float> & affinities,
-                                             const float threshold) {
+                                             const float threshold,
+                                             const int number_of_threads) {
                       typedef xt::pyarray<uint64_t>::shape_type ShapeType;
                       ShapeType shape(affinities.shape().begin() + 1, affinities.shape().end());
                       xt::pyarray<uint64_t> labels = xt::zeros<uint64_t>(shape);
                       size_t max_label;
                       {
                           py::gil_scoped_release allowThreads;
-                          max_label = connected_components(affinities, labels, threshold);
+                          max_label = connected_components(affinities, labels, threshold, number_of_threads);
                       }
                       return std::make_pair(labels, max_label);
                   }, py::arg("affinities"),
-                  py::arg("threshold")
+                  py::arg("threshold"),
+                  py::arg("number_of_threads")=-1
             );
 
 
@@ -0,0 +1,79 @@
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <xtensor-python/pytensor.hpp>
+#include "nifty/ufd/concurrent_ufd.hxx"
+#include "nifty/parallel/threadpool.hxx"
+
+namespace py = pybind11;
+
+
+namespace nifty{
+namespace ufd{
+
+    template<class T>
+    void exportConcurrentUfdT(py::module & ufdModule, const std::string & clsName) {
+
+        typedef ConcurrentUfd<T> UfdType;
+        typedef typename UfdType::Index IndexType;
+
+        py::class_<UfdType>(ufdModule, clsName.c_str())
+            .def(py::init<const IndexType>(),
+               py::arg("numberOfIndices"),
+                "Union find that supports merging and finding from several threads at once.\n\n"
+                "The representative of a set is always its smallest element."
+            )
+            .def("find", [](const UfdType & self, const T index) {
+                return self.find(index);
+            },
+                py::arg("element")
+            )
+            // find vectorized
+            .def("find", [](const UfdType & self, const xt::pytensor<T, 1> & indices, const int numberOfThreads) {
+                const int64_t nIndices = indices.shape()[0];
+                xt::pytensor<T, 1> out = xt::zeros<T>({nIndices});
+                {
+                    py::gil_scoped_release allowThreads;
+                    parallel::ThreadPool threadpool(numberOfThreads);
+                    parallel::parallel_foreach(threadpool, nIndices, [&](const int tid, const int64_t i){
+                        out(i) = self.find(indices(i));
+                    });
+                }
+                return out;
+            },
+                py::arg("elements"), py::arg("numberOfThreads")=-1
+            )
+            .def("merge", &UfdType::merge,
+                py::arg("element1"),
+                py::arg("element2")
+            )
+            // merge vectorized
+            .def("merge", [](UfdType & self, const xt::pytensor<T, 2> & mergeIndices, const int numberOfThreads) {
+                {
+                    py::gil_scoped_release allowThreads;
+                    parallel::ThreadPool threadpool(numberOfThreads);
+                    parallel::parallel_foreach(threadpool, mergeIndices.shape()[0], [&](const int tid, const int64_t i){
+                        self.merge(mergeIndices(i, 0), mergeIndices(i, 1));
+                    });
+                }
+            },
+                py::arg("mergeIndices"), py::arg("numberOfThreads")=-1
+            )
+            .def("assign", &UfdType::assign,
+                py::arg("size")
+            )
+            .def("reset", [](UfdType & self){
+                self.reset();
+            })
+            .def_property_readonly("numberOfElements", &UfdType::numberOfElements)
+            .def_property_readonly("numberOfSets", &UfdType::numberOfSets)
+        ;
+    }
+
+    void exportConcurrentUfd(py::module & ufdModule) {
+        exportConcurrentUfdT<uint32_t>(ufdModule, "ConcurrentUfd_UInt32");
+        exportConcurrentUfdT<uint64_t>(ufdModule, "ConcurrentUfd_UInt64");
+    }
+
+}
+}
@@ -10,6 +10,7 @@ namespace nifty{
 namespace ufd{
     void exportUfd(py::module &);
     void exportBoostUfd(py::module &);
+    void exportConcurrentUfd(py::module &);
 }
 }
 
@@ -25,4 +26,5 @@ PYBIND11_MODULE(_ufd, ufdModule) {
 
     exportUfd(ufdModule);
     exportBoostUfd(ufdModule);
+    exportConcurrentUfd(ufdModule);
 }
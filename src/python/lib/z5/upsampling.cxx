@@ -11,7 +11,7 @@ namespace nz5 {
 
     template<class T>
     void exportUpsamplingT(py::module & m, const std::string & typeName) {
-        const std::string name = "nearestUpsampling" + typeName;
+        std::string name = "nearestUpsampling" + typeName;
         m.def(name.c_str(), [](const std::string & inPath,
                               const std::vector<int> & samplingFactor,
                               const std::string & outPath,
@@ -19,6 +19,15 @@ namespace nz5 {
             py::gil_scoped_release allowThreads;
             nearestUpsampling<T>(inPath, samplingFactor, outPath, numberOfThreads);
         }, py::arg("inPath"), py::arg("samplingFactor"), py::arg("outPath"), py::arg("numberOfThreads")=-1 );
+
+        name = "majorityVoteDownsampling" + typeName;
+        m.def(name.c_str(), [](const std::string & inPath,
+                              const std::vector<int> & samplingFactor,
+                              const std::string & outPath,
+                              const int numberOfThreads) {
+            py::gil_scoped_release allowThreads;
+            majorityVoteDownsampling<T>(inPath, samplingFactor, outPath, numberOfThreads);
+        }, py::arg("inPath"), py::arg("samplingFactor"), py::arg("outPath"), py::arg("numberOfThreads")=-1 );
     }
 
 
@@ -38,6 +47,8 @@ namespace nz5 {
     void exportUpsampling(py::module & m) {
         exportIntersectMask(m);
         exportUpsamplingT<uint8_t>(m, "Uint8");
+        exportUpsamplingT<uint32_t>(m, "Uint32");
+        exportUpsamplingT<uint64_t>(m, "Uint64");
     }
 
 
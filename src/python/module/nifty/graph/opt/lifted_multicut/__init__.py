@@ -111,9 +111,17 @@ def __extendLiftedMulticutObj(objectiveCls, objectiveName):
 
 
 
-    def chainedSolversFactory(factories):
+    def chainedSolversFactory(factories, timeLimit=float('inf'), targetEnergy=float('-inf'),
+                              maxNumberOfStagesWithoutImprovement=None, minImprovement=0.0,
+                              restoreBest=True):
         s,F = getSettingsAndFactoryCls("ChainedSolvers")
         s.factories = factories
+        s.timeLimit = timeLimit
+        s.targetEnergy = targetEnergy
+        if maxNumberOfStagesWithoutImprovement is not None:
+            s.maxNumberOfStagesWithoutImprovement = maxNumberOfStagesWithoutImprovement
+        s.minImprovement = minImprovement
+        s.restoreBest = restoreBest
         return F(s)
     O.chainedSolversFactory = staticmethod(chainedSolversFactory)
 
@@ -122,19 +130,23 @@ def __extendLiftedMulticutObj(objectiveCls, objectiveName):
         Chain multiple solvers
         such that each successor is warm-started with
         its predecessor solver.
+        The chain stops early once the time limit or the target energy
+        is reached or the solvers stop improving.
 
     Warning:
         The solvers should be able to be warm started.
 
     Args:
-        weightStopCond (float): stop clustering when the highest
-            weight in cluster-graph is lower as this value (default: {0.0})
-        nodeNumStopCond: stop clustering when a cluster-graph
-            reached a certain number of nodes.
-            Numbers smaller 1 are interpreted as fraction
-            of the graphs number of nodes.
-            If nodeNumStopCond is smaller 0 this
-            stopping condition is ignored  (default: {-1})
+        factories (list): the factories of the chained solvers
+        timeLimit (float): time limit in seconds for the whole chain,
+            it is also passed to the solvers via the visitor (default: {inf})
+        targetEnergy (float): stop once the energy is at most this value (default: {-inf})
+        maxNumberOfStagesWithoutImprovement (int): stop after this many consecutive
+            solvers which did not improve the energy by more than minImprovement
+            (default: {None}, never stop)
+        minImprovement (float): minimal improvement of a solver (default: {0.0})
+        restoreBest (bool): keep the warm start if a solver returns a worse
+            solution (default: {True})
     Returns:
         %s : multicut factory
     """%(factoryClsName("ChainedSolvers"),factoryClsName("ChainedSolvers"))
@@ -225,11 +237,13 @@ def __extendLiftedMulticutObj(objectiveCls, objectiveName):
 
     def liftedMulticutKernighanLinFactory(numberOfOuterIterations=1000000,
                                           numberOfInnerIterations=100,
-                                          epsilon=1e-7):
+                                          epsilon=1e-7,
+                                          numberOfThreads=1):
         s,F = getSettingsAndFactoryCls("LiftedMulticutKernighanLin")
         s.numberOfOuterIterations = int(numberOfOuterIterations)
         s.numberOfInnerIterations = int(numberOfInnerIterations)
         s.epsilon = float(epsilon)
+        s.numberOfThreads = int(numberOfThreads)
         return F(s)
     O.liftedMulticutKernighanLinFactory = staticmethod(liftedMulticutKernighanLinFactory)
 
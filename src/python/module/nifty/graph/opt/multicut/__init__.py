@@ -151,6 +151,52 @@ def __extendMulticutObj(objectiveCls, objectiveName, graphCls):
     """%(factoryClsName("MulticutGreedyAdditive"),factoryClsName("MulticutGreedyAdditive"))
 
 
+    def approximateGreedyAdditiveFactory(weightStopCond=0.0, nodeNumStopCond=-1.0, epsilon=0.25,
+                                         numberOfThreads=1, visitNth=1):
+        s,F = getSettingsAndFactoryCls("MulticutApproximateGreedyAdditive")
+        s.weightStopCond = float(weightStopCond)
+        s.nodeNumStopCond = float(nodeNumStopCond)
+        s.epsilon = float(epsilon)
+        s.numberOfThreads = int(numberOfThreads)
+        s.visitNth = int(visitNth)
+
+        return F(s)
+    O.approximateGreedyAdditiveFactory = staticmethod(approximateGreedyAdditiveFactory)
+    O.approximateGreedyAdditiveFactory.__doc__ = """ create an instance of :class:`%s`
+
+        Find approximate solutions via
+        agglomerative clustering as in :cite:`beier_15_funsion`.
+        Instead of the single heaviest edge, all edges which are
+        the heaviest edge of both of their clusters and
+        whose weight is within a factor of 1 - epsilon of the
+        heaviest weight in their neighborhood are contracted
+        in parallel rounds.
+
+    Warning:
+        This solver should be used to
+        warm start other solvers with
+        on very large graphs.
+
+    Args:
+        weightStopCond (float): stop clustering when the highest
+            weight in cluster-graph is lower as this value (default: {0.0})
+        nodeNumStopCond (float): stop clustering when a cluster-graph
+            reached a certain number of nodes.
+            Numbers smaller 1 are interpreted as fraction
+            of the graphs number of nodes.
+            If nodeNumStopCond is smaller 0 this
+            stopping condition is ignored  (default: {-1})
+        epsilon (float): width of the weight bucket in [0, 1],
+            larger values trade energy for speed.
+            For 0 the energy is close to :func:`greedyAdditiveFactory` (default: {0.25})
+        numberOfThreads (int): number of threads,
+            -1 means all available cores (default: {1})
+        visitNth (int) : only call the visitor each nth round (default: {1}).
+    Returns:
+        %s : multicut factory
+    """%(factoryClsName("MulticutApproximateGreedyAdditive"),factoryClsName("MulticutApproximateGreedyAdditive"))
+
+
 
     def warmStartGreeedyDecorator(func):
         def func_wrapper(*args, **kwargs):
@@ -171,9 +217,17 @@ def __extendMulticutObj(objectiveCls, objectiveName, graphCls):
 
 
 
-    def chainedSolversFactory(multicutFactories):
+    def chainedSolversFactory(multicutFactories, timeLimit=float('inf'), targetEnergy=float('-inf'),
+                              maxNumberOfStagesWithoutImprovement=None, minImprovement=0.0,
+                              restoreBest=True):
         s,F = getSettingsAndFactoryCls("ChainedSolvers")
         s.multicutFactories = multicutFactories
+        s.timeLimit = timeLimit
+        s.targetEnergy = targetEnergy
+        if maxNumberOfStagesWithoutImprovement is not None:
+            s.maxNumberOfStagesWithoutImprovement = maxNumberOfStagesWithoutImprovement
+        s.minImprovement = minImprovement
+        s.restoreBest = restoreBest
         return F(s)
     O.chainedSolversFactory = staticmethod(chainedSolversFactory)
 
@@ -182,19 +236,23 @@ def __extendMulticutObj(objectiveCls, objectiveName, graphCls):
         Chain multiple solvers
         such that each successor is warm-started with
         its predecessor solver.
+        The chain stops early once the time limit or the target energy
+        is reached or the solvers stop improving.
 
     Warning:
         The solvers should be able to be warm started.
 
     Args:
-        weightStopCond (float): stop clustering when the highest
-            weight in cluster-graph is lower as this value (default: {0.0})
-        nodeNumStopCond: stop clustering when a cluster-graph
-            reached a certain number of nodes.
-            Numbers smaller 1 are interpreted as fraction
-            of the graphs number of nodes.
-            If nodeNumStopCond is smaller 0 this
-            stopping condition is ignored  (default: {-1})
+        multicutFactories (list): the factories of the chained solvers
+        timeLimit (float): time limit in seconds for the whole chain,
+            it is also passed to the solvers via the visitor (default: {inf})
+        targetEnergy (float): stop once the energy is at most this value (default: {-inf})
+        maxNumberOfStagesWithoutImprovement (int): stop after this many consecutive
+            solvers which did not improve the energy by more than minImprovement
+            (default: {None}, never stop)
+        minImprovement (float): minimal improvement of a solver (default: {0.0})
+        restoreBest (bool): keep the warm start if a solver returns a worse
+            solution (default: {True})
     Returns:
         %s : multicut factory
     """%(factoryClsName("ChainedSolvers"),factoryClsName("ChainedSolvers"))
@@ -302,7 +360,9 @@ def __extendMulticutObj(objectiveCls, objectiveName, graphCls):
     """%tuple([factoryClsName("KernighanLin")]*2)
 
 
-    def multicutDecomposerFactory(submodelFactory=None, fallthroughFactory=None):
+    def multicutDecomposerFactory(submodelFactory=None, fallthroughFactory=None,
+                                  smallSubmodelFactory=None, smallSubmodelSize=0,
+                                  numberOfThreads=1):
 
         if submodelFactory is None:
            submodelFactory = MulticutObjectiveUndirectedGraph.defaultMulticutFactory()
@@ -314,6 +374,10 @@ def __extendMulticutObj(objectiveCls, objectiveName, graphCls):
         s,F = getSettingsAndFactoryCls("MulticutDecomposer")
         s.submodelFactory = submodelFactory
         s.fallthroughFactory = fallthroughFactory
+        if smallSubmodelFactory is not None:
+            s.smallSubmodelFactory = smallSubmodelFactory
+        s.smallSubmodelSize = smallSubmodelSize
+        s.numberOfThreads = numberOfThreads
         return F(s)
 
     O.multicutDecomposerFactory = staticmethod(multicutDecomposerFactory)
@@ -324,17 +388,26 @@ def __extendMulticutObj(objectiveCls, objectiveName, graphCls):
         If a model decomposes into components such that there are no
         positive weighted edges between the components one can
         optimize each model separately.
+        Components without repulsive edges are solved in closed form,
+        the other components are solved in parallel, largest first.
 
 
 
     Note:
         Models might not decompose at all.
+        With more than one thread the submodel factories are used concurrently,
+        so they must not be implemented in python.
 
     Args:
         submodelFactory: multicut factory for solving subproblems
             if model decomposes (default: {:func:`defaultMulticutFactory()`})
         fallthroughFactory: multicut factory for solving subproblems
             if model does not decompose (default: {:func:`defaultMulticutFactory()`})
+        smallSubmodelFactory: multicut factory for subproblems with at most
+            smallSubmodelSize nodes, e.g. an exact ilp (default: {None})
+        smallSubmodelSize (int): maximum number of nodes of subproblems
+            solved with the smallSubmodelFactory (default: {0})
+        numberOfThreads (int): number of threads for solving subproblems (default: {1})
 
     Returns:
         %s : multicut factory
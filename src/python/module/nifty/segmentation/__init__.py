@@ -153,6 +153,85 @@ def compute_mws_segmentation(weights, offsets, number_of_attractive_channels,
         labels += 1
         labels[inv_mask] = 0
     return labels
+
+
+def _sorted_mws_edges(weights, offsets, number_of_attractive_channels,
+                      strides, randomize_strides, invert_repulsive_weights,
+                      bias_cut, mask, semantic_weights=None):
+    # valid edges and the flat indices of the edges sorted by descending weight;
+    # the semantic weights (one channel per class) are appended after the affinities
+    ndim = len(offsets[0])
+    assert all(len(off) == ndim for off in offsets)
+    inv_mask = None if mask is None else np.logical_not(mask)
+    valid_edges = get_valid_edges(weights.shape, offsets, number_of_attractive_channels,
+                                  strides, randomize_strides, inv_mask)
+
+    weights = np.require(weights, dtype='float32').copy()
+    if invert_repulsive_weights:
+        weights[number_of_attractive_channels:] *= -1
+        weights[number_of_attractive_channels:] += 1
+    weights[:number_of_attractive_channels] += bias_cut
+
+    flat_weights = np.where(valid_edges, weights, -np.inf).ravel()
+    if semantic_weights is not None:
+        assert semantic_weights.shape[1:] == weights.shape[1:], "%s, %s" % (str(semantic_weights.shape),
+                                                                           str(weights.shape))
+        semantic_weights = np.require(semantic_weights, dtype='float32')
+        if inv_mask is not None:
+            semantic_weights = np.where(inv_mask[None], -np.inf, semantic_weights)
+        flat_weights = np.concatenate([flat_weights, semantic_weights.ravel()])
+
+    # stable sort, so ties are resolved by the edge index
+    sorted_flat_indices = np.argsort(-flat_weights, kind='stable')
+    sorted_flat_indices = sorted_flat_indices[np.isfinite(flat_weights[sorted_flat_indices])]
+    return sorted_flat_indices.astype('int64'), valid_edges.ravel()
+
+
+def compute_semantic_mws_segmentation(weights, offsets, number_of_attractive_channels,
+                                      semantic_weights, strides=None, randomize_strides=False,
+                                      invert_repulsive_weights=True, bias_cut=0., mask=None):
+    """ Semantic mutex watershed: the class scores of the pixels are sorted together with the
+    affinities, a cluster takes the class of its first semantic edge and clusters of different classes
+    are mutually exclusive.
+
+    Returns the instance labels and the class of each pixel (-1 for pixels in the mask).
+    """
+    image_shape = weights.shape[1:]
+    sorted_flat_indices, valid_edges = _sorted_mws_edges(weights, offsets, number_of_attractive_channels,
+                                                         strides, randomize_strides,
+                                                         invert_repulsive_weights, bias_cut, mask,
+                                                         semantic_weights)
+    labels, semantic_labels = compute_semantic_mws_segmentation_impl(sorted_flat_indices, valid_edges,
+                                                                     offsets, number_of_attractive_channels,
+                                                                     image_shape)
+    labels = labels.reshape(image_shape)
+    semantic_labels = semantic_labels.reshape(image_shape)
+    if mask is not None:
+        labels += 1
+        labels[np.logical_not(mask)] = 0
+    return labels, semantic_labels
+
+
+def compute_seeded_mws_segmentation(weights, offsets, number_of_attractive_channels, seeds,
+                                    strides=None, randomize_strides=False,
+                                    invert_repulsive_weights=True, bias_cut=0., mask=None):
+    """ Mutex watershed with seeds: all pixels of a seed (> 0) start in one cluster and
+    clusters of different seeds are mutually exclusive.
+
+    The seeded segments keep the seed id, the other segments get ids above the largest seed.
+    """
+    image_shape = weights.shape[1:]
+    assert seeds.shape == image_shape, "%s, %s" % (str(seeds.shape), str(image_shape))
+    sorted_flat_indices, valid_edges = _sorted_mws_edges(weights, offsets, number_of_attractive_channels,
+                                                         strides, randomize_strides,
+                                                         invert_repulsive_weights, bias_cut, mask)
+    labels = compute_seeded_mws_segmentation_impl(sorted_flat_indices, valid_edges,
+                                                  offsets, number_of_attractive_channels,
+                                                  image_shape, seeds.astype('uint64').ravel())
+    labels = labels.reshape(image_shape)
+    if mask is not None:
+        labels[np.logical_not(mask)] = 0
+    return labels
 #
 # # \\\\\\\\\\\\\\\\\\\\\
 # # Previous functions:
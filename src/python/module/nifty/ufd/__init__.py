@@ -20,6 +20,15 @@ def ufd(size, dtype='uint64'):
         return Ufd_UInt64(int(size))
 
 
+def concurrent_ufd(size, dtype='uint64'):
+    if dtype not in ['uint32','uint64']:
+        raise RuntimeError("dtype must be 'uint32' or 'uint64'")
+    if dtype == 'uint32':
+        return ConcurrentUfd_UInt32(int(size))
+    elif dtype == 'uint64':
+        return ConcurrentUfd_UInt64(int(size))
+
+
 def boost_ufd(elements, dtype='uint64'):
     if dtype not in ['uint32','uint64']:
         raise RuntimeError("dtype must be 'uint32' or 'uint64'")
@@ -56,5 +56,20 @@ if Configuration.WITH_Z5:
     def nearestUpsampling(dtype, inPath, samplingFactor, outPath, numberOfThreads=-1):
         if numpy.dtype(dtype) == numpy.dtype("uint8"):
             nearestUpsamplingUint8(inPath, samplingFactor, outPath, numberOfThreads)
+        elif numpy.dtype(dtype) == numpy.dtype("uint32"):
+            nearestUpsamplingUint32(inPath, samplingFactor, outPath, numberOfThreads)
+        elif numpy.dtype(dtype) == numpy.dtype("uint64"):
+            nearestUpsamplingUint64(inPath, samplingFactor, outPath, numberOfThreads)
+        else:
+            raise RuntimeError("Datatype %s not supported!" % (str(dtype),))
+
+
+    def majorityVoteDownsampling(dtype, inPath, samplingFactor, outPath, numberOfThreads=-1):
+        if numpy.dtype(dtype) == numpy.dtype("uint8"):
+            majorityVoteDownsamplingUint8(inPath, samplingFactor, outPath, numberOfThreads)
+        elif numpy.dtype(dtype) == numpy.dtype("uint32"):
+            majorityVoteDownsamplingUint32(inPath, samplingFactor, outPath, numberOfThreads)
+        elif numpy.dtype(dtype) == numpy.dtype("uint64"):
+            majorityVoteDownsamplingUint64(inPath, samplingFactor, outPath, numberOfThreads)
         else:
             raise RuntimeError("Datatype %s not supported!" % (str(dtype),))
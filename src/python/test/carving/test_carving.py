@@ -26,6 +26,35 @@ class TestCarving(unittest.TestCase):
             self.assertEqual(len(out), rag.numberOfNodes)
             self.assertTrue(np.allclose(np.unique(out), [1, 2]))
 
+    def _test_incremental_carving(self, ndim):
+        from nifty.carving import carvingSegmenter
+        x = self.make_labels(ndim)
+        rag = nrag.gridRag(x, numberOfLabels=int(x.max()) + 1)
+        edgeWeights = 128 * np.random.rand(rag.numberOfEdges).astype('float32')
+        segmenter = carvingSegmenter(rag, edgeWeights)
+
+        # add and remove seeds one by one, the incremental labels
+        # must agree with kruskal from scratch
+        seeds = np.zeros(rag.numberOfNodes, dtype='uint64')
+        for step in range(25):
+            node = np.random.randint(0, rag.numberOfNodes)
+            seeds[node] = 0 if step % 5 == 4 else np.random.randint(1, 3)
+            segmenter.setSeed(node, int(seeds[node]))
+            expected = segmenter(seeds.astype('uint8'), 1., 0.)
+            self.assertTrue(np.array_equal(segmenter.labels, expected))
+
+        # many seeds at once
+        seeds = np.random.randint(0, 3, size=rag.numberOfNodes).astype('uint64')
+        labels = segmenter.updateSeeds(seeds)
+        expected = segmenter(seeds.astype('uint8'), 1., 0.)
+        self.assertTrue(np.array_equal(labels, expected))
+
+    def test_incremental_carving_2d(self):
+        self._test_incremental_carving(2)
+
+    def test_incremental_carving_3d(self):
+        self._test_incremental_carving(3)
+
     def test_carving_2d(self):
         self._test_carving(2)
 
@@ -158,6 +158,24 @@ class TestLiftedMulticutSolver(unittest.TestCase):
 
                 self.assertAlmostEqual(ekl, eakl)
 
+    def testLiftedMulticutKernighanLinParallel(self):
+        gridSize = [20, 20]
+        for x in range(4):
+            obj,nid = self.gridLiftedModel(gridSize=gridSize , bfsRadius=3, weightRange=[-3,1])
+            arg = numpy.arange(gridSize[0]*gridSize[1])
+            e0 = obj.evalNodeLabels(arg)
+
+            energies = []
+            for nThreads in (2, 4):
+                solverFactory = obj.liftedMulticutKernighanLinFactory(numberOfThreads=nThreads)
+                solver = solverFactory.create(obj)
+                arg2 = solver.optimize(arg.copy())
+                energies.append(obj.evalNodeLabels(arg2))
+                self.assertLessEqual(energies[-1], e0)
+
+            # the schedule of the pairs does not depend on the number of threads
+            self.assertAlmostEqual(energies[0], energies[1])
+
     def testLiftedMulticutSolverFm(self):
         random.seed(0)
         for x in range(1):
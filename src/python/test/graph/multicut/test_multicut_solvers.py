@@ -81,6 +81,18 @@ class TestLiftedMulticutSolver(unittest.TestCase):
         Obj = nifty.graph.UndirectedGraph.MulticutObjective
         self._testGridModelImpl(Obj.greedyAdditiveFactory(), gridSize=[6,6])
 
+    def testApproximateGreedyAdditive(self):
+        Obj = nifty.graph.UndirectedGraph.MulticutObjective
+        self._testGridModelImpl(Obj.approximateGreedyAdditiveFactory(), gridSize=[6,6])
+
+        # for epsilon = 0 the energy is close to the exact greedy additive energy
+        objective = self.gridModel(gridSize=[20,20], weightRange=[-1,1])
+        greedyEnergy = objective.evalNodeLabels(Obj.greedyAdditiveFactory().create(objective).optimize())
+        for epsilon in (0.0, 0.5):
+            factory = Obj.approximateGreedyAdditiveFactory(epsilon=epsilon, numberOfThreads=2)
+            energy = objective.evalNodeLabels(factory.create(objective).optimize())
+            self.assertLessEqual(energy, greedyEnergy + 0.05 * abs(greedyEnergy))
+
     def testDefault(self):
         Obj = nifty.graph.UndirectedGraph.MulticutObjective
         self._testGridModelImpl(Obj.defaultFactory(), gridSize=[6,6])
@@ -89,6 +101,13 @@ class TestLiftedMulticutSolver(unittest.TestCase):
         Obj = nifty.graph.UndirectedGraph.MulticutObjective
         self._testGridModelImpl(Obj.multicutDecomposerFactory(), gridSize=[6,6])
 
+    def testMulticutDecomposerParallel(self):
+        Obj = nifty.graph.UndirectedGraph.MulticutObjective
+        factory = Obj.multicutDecomposerFactory(smallSubmodelFactory=Obj.greedyAdditiveFactory(),
+                                                smallSubmodelSize=10,
+                                                numberOfThreads=4)
+        self._testGridModelImpl(factory, gridSize=[6,6])
+
     def testChainedSolvers(self):
         Obj = nifty.graph.UndirectedGraph.MulticutObjective
         a = Obj.greedyAdditiveFactory()
@@ -96,6 +115,45 @@ class TestLiftedMulticutSolver(unittest.TestCase):
         c = Obj.multicutDecomposerFactory()
         self._testGridModelImpl(Obj.chainedSolversFactory([a,b,c]), gridSize=[6,6])
 
+    def testChainedSolversEarlyStop(self):
+        Obj = nifty.graph.UndirectedGraph.MulticutObjective
+        objective = self.gridModel(gridSize=[10,10])
+        greedy = Obj.greedyAdditiveFactory()
+        kl = Obj.kernighanLinFactory()
+        greedyEnergy = objective.evalNodeLabels(greedy.create(objective).optimize())
+        numberOfNodes = objective.graph.numberOfNodes
+
+        # with an exhausted time budget the warm start is returned unchanged
+        factory = Obj.chainedSolversFactory([greedy, kl], timeLimit=0.0)
+        warmStart = numpy.arange(numberOfNodes, dtype='uint64')
+        arg = factory.create(objective).optimize(warmStart.copy())
+        self.assertTrue(numpy.array_equal(arg, warmStart))
+
+        # kernighan lin warm started with greedy additive is at least as good as greedy additive,
+        # greedy additive ignores its warm start
+        klLabels = kl.create(objective).optimize(greedy.create(objective).optimize())
+        klEnergy = objective.evalNodeLabels(klLabels)
+        self.assertLessEqual(klEnergy, greedyEnergy)
+
+        # restoreBest discards the greedy additive stage if it is worse than the warm start
+        factory = Obj.chainedSolversFactory([greedy], restoreBest=True)
+        arg = factory.create(objective).optimize(klLabels.copy())
+        self.assertAlmostEqual(objective.evalNodeLabels(arg), klEnergy)
+        factory = Obj.chainedSolversFactory([greedy], restoreBest=False)
+        arg = factory.create(objective).optimize(klLabels.copy())
+        self.assertAlmostEqual(objective.evalNodeLabels(arg), greedyEnergy)
+
+        # a warm start at the target energy keeps any solver from running
+        factory = Obj.chainedSolversFactory([greedy], targetEnergy=klEnergy, restoreBest=False)
+        arg = factory.create(objective).optimize(klLabels.copy())
+        self.assertTrue(numpy.array_equal(arg, klLabels))
+
+        # the chain never gets worse than its first solver
+        factory = Obj.chainedSolversFactory([greedy, kl, kl, kl],
+                                            maxNumberOfStagesWithoutImprovement=1)
+        arg = factory.create(objective).optimize()
+        self.assertLessEqual(objective.evalNodeLabels(arg), greedyEnergy)
+
     def testCcFusionMoveBasedFactory(self):
         Obj = nifty.graph.UndirectedGraph.MulticutObjective
         self._testGridModelImpl(Obj.ccFusionMoveBasedFactory(), gridSize=[10,10])
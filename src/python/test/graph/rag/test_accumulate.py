@@ -23,6 +23,38 @@ class TestAccumulate(unittest.TestCase):
         res = nrag.accumulateEdgeMeanAndLength(rag, data)
         self.assertTrue(np.sum(res) != 0)
 
+    @staticmethod
+    def _lifted_nh_reference(labels, offsets, local_uvs):
+        uvs = []
+        for offset in offsets:
+            slice_u = tuple(slice(max(0, -o), s - max(0, o)) for o, s in zip(offset, labels.shape))
+            slice_v = tuple(slice(max(0, o), s - max(0, -o)) for o, s in zip(offset, labels.shape))
+            lu, lv = labels[slice_u].ravel(), labels[slice_v].ravel()
+            diff = lu != lv
+            uvs.append(np.stack([np.minimum(lu[diff], lv[diff]),
+                                 np.maximum(lu[diff], lv[diff])], axis=1))
+        uvs = np.unique(np.concatenate(uvs, axis=0).astype('int64'), axis=0)
+        local = set(map(tuple, local_uvs))
+        return np.array([uv for uv in uvs if tuple(uv) not in local], dtype='int64')
+
+    def test_features_and_nh_from_affinities(self):
+        # piecewise constant labels, so that we get local and lifted edges
+        labels = np.random.randint(0, 200, size=(8, 8, 8), dtype='uint32')
+        labels = np.repeat(np.repeat(np.repeat(labels, 4, axis=0), 5, axis=1), 6, axis=2)[:30, :37, :41]
+        labels = np.ascontiguousarray(labels)
+        rag = nrag.gridRag(labels, numberOfLabels=200)
+        offsets = [[-1, 0, 0], [0, -1, 0], [0, 0, -1], [-3, 0, 0], [0, -9, 0], [2, 4, -7]]
+        affs = np.random.random_sample((len(offsets),) + labels.shape).astype('float32')
+
+        expected = self._lifted_nh_reference(labels, offsets, rag.uvIds())
+        for n_threads in (1, 4):
+            lnh, local_feats, lifted_feats = nrag.computeFeaturesAndNhFromAffinities(rag, affs, offsets,
+                                                                                     numberOfThreads=n_threads)
+            self.assertEqual(lnh.shape, expected.shape)
+            self.assertTrue(np.array_equal(lnh, expected))
+            self.assertEqual(local_feats.shape, (rag.numberOfEdges, 10))
+            self.assertEqual(lifted_feats.shape, (len(expected), 10))
+
 
 
 if __name__ == '__main__':
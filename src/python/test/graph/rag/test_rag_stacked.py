@@ -204,6 +204,78 @@ class TestRagStacked(TestRagBase):
         self.big_array_test(nifty.z5.datasetWrapper('uint32', os.path.join(self.path, 'data')),
                             nrag.gridRagStacked2DZ5)
 
+    # reference edges and edge lengths, in-slice edges sorted per slice,
+    # followed by the between-slice edges sorted per pair of slices
+    @staticmethod
+    def reference_edges(labels, ignoreLabel=None):
+        inSlice, betweenSlices = [], []
+        for z in range(labels.shape[0]):
+            faces = [(labels[z, :-1, :], labels[z, 1:, :]),
+                     (labels[z, :, :-1], labels[z, :, 1:])]
+            edges = numpy.concatenate([numpy.stack([a.ravel(), b.ravel()], axis=1)
+                                       for a, b in faces], axis=0)
+            edges = edges[edges[:, 0] != edges[:, 1]]
+            inSlice.append(edges)
+            if z + 1 < labels.shape[0]:
+                betweenSlices.append(numpy.stack([labels[z].ravel(),
+                                                  labels[z + 1].ravel()], axis=1))
+        uvIds, lengths = [], []
+        for edges in inSlice + betweenSlices:
+            if ignoreLabel is not None:
+                edges = edges[(edges != ignoreLabel).all(axis=1)]
+            edges = numpy.sort(edges, axis=1)
+            uniqueEdges, counts = numpy.unique(edges, axis=0, return_counts=True)
+            uvIds.append(uniqueEdges.reshape((-1, 2)))
+            lengths.append(counts)
+        return numpy.concatenate(uvIds, axis=0), numpy.concatenate(lengths)
+
+    def random_stacked_labels(self, shape, labelsPerSlice, withIgnoreLabel=False):
+        numpy.random.seed(42)
+        labels = numpy.zeros(shape, dtype='uint32')
+        offset = 1 if withIgnoreLabel else 0
+        for z in range(shape[0]):
+            # blocky segments so that edges have varying lengths
+            sliceLabels = numpy.random.randint(0, labelsPerSlice, size=(shape[1] // 8 + 1,
+                                                                         shape[2] // 8 + 1))
+            sliceLabels = sliceLabels.repeat(8, axis=0).repeat(8, axis=1)[:shape[1], :shape[2]]
+            # make sure every label of the slice occurs
+            sliceLabels.ravel()[:labelsPerSlice] = numpy.arange(labelsPerSlice)
+            sliceLabels += offset
+            if withIgnoreLabel:
+                ignoreMask = numpy.random.rand(*sliceLabels.shape) < 0.1
+                ignoreMask.ravel()[:labelsPerSlice] = False
+                sliceLabels[ignoreMask] = 0
+            labels[z] = sliceLabels
+            offset += labelsPerSlice
+        return labels
+
+    def test_grid_rag_stacked2d_random(self):
+        # more than 100 rows, so the slices are split into several tiles
+        shape = (5, 250, 77)
+        labels = self.random_stacked_labels(shape, 40)
+        uvIds, lengths = self.reference_edges(labels)
+        for nThreads in (1, 4):
+            rag = nrag.gridRagStacked2D(labels,
+                                        numberOfLabels=int(labels.max()) + 1,
+                                        numberOfThreads=nThreads)
+            self.assertEqual(rag.numberOfEdges, len(uvIds))
+            self.assertTrue((rag.uvIds() == uvIds).all())
+            self.assertTrue((rag.edgeLengths() == lengths).all())
+            self.assertEqual(rag.totalNumberOfInSliceEdges + rag.totalNumberOfInBetweenSliceEdges,
+                             rag.numberOfEdges)
+
+    def test_grid_rag_stacked2d_random_ignore(self):
+        shape = (4, 180, 63)
+        labels = self.random_stacked_labels(shape, 30, withIgnoreLabel=True)
+        uvIds, lengths = self.reference_edges(labels, ignoreLabel=0)
+        rag = nrag.gridRagStacked2D(labels,
+                                    numberOfLabels=int(labels.max()) + 1,
+                                    ignoreLabel=0,
+                                    numberOfThreads=-1)
+        self.assertEqual(rag.numberOfEdges, len(uvIds))
+        self.assertTrue((rag.uvIds() == uvIds).all())
+        self.assertTrue((rag.edgeLengths() == lengths).all())
+
     def serialization_test(self, array, ragFunction):
         ragA = ragFunction(array,
                            numberOfLabels=self.bigLabels.max() + 1,
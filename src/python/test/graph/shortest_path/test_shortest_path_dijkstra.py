@@ -126,6 +126,75 @@ class TestShortesetPath(unittest.TestCase):
         path = sp.runSingleSourceSingleTarget(weights, 0, 3)
         self.assertTrue(not path) # make sure that the path is invalid
 
+        path, dist = nifty.graph.shortestPathSinglePair(g, numpy.array(weights, dtype='float32'), 0, 3)
+        self.assertTrue(not path)
+
+    def testShortestPathDistancesParallel(self):
+        g, weights = self.graphAndWeights()
+        # distances from 0: 0, 1, 2, 2, 2, 5
+        expected = numpy.array([0., 1., 2., 2., 2., 5.])
+        results = nifty.graph.shortestPathDistancesParallel(g, weights.tolist(), [0, 0, 5],
+                                                            maxDistance=2.,
+                                                            numberOfThreads=2)
+        self.assertEqual(len(results), 3)
+        for nodes, distances in results[:2]:
+            self.assertEqual(sorted(nodes.tolist()), [0, 1, 2, 3, 4])
+            self.assertTrue(numpy.allclose(distances, expected[nodes]))
+        # from 5, the direct edge to 0 is too long
+        nodes, distances = results[2]
+        self.assertEqual(nodes.tolist(), [5])
+
+        # unbounded
+        results = nifty.graph.shortestPathDistancesParallel(g, weights.tolist(), [0],
+                                                            numberOfThreads=0)
+        nodes, distances = results[0]
+        self.assertEqual(sorted(nodes.tolist()), list(range(6)))
+        self.assertTrue(numpy.allclose(distances, expected[nodes]))
+
+    def testShortestPathSinglePair(self):
+        g, weights = self.graphAndWeights()
+        sp = nifty.graph.ShortestPathDijkstra(g)
+        for method in ('astar', 'bidirectional'):
+            for target in range(6):
+                expected = sp.runSingleSourceSingleTarget(weights, 0, target)
+                path, dist = nifty.graph.shortestPathSinglePair(g, weights, 0, target, method=method)
+                # equal weights make some paths ambiguous, so only compare the lengths
+                self.assertEqual(path[0], target)
+                self.assertEqual(path[-1], 0)
+                self.assertAlmostEqual(dist, sum(weights[g.findEdge(u, v)]
+                                                 for u, v in zip(expected[:-1], expected[1:])))
+
+    def testShortestPathSinglePairNoEdges(self):
+        g = nifty.graph.UndirectedGraph(3)
+        weights = numpy.ones(g.edgeIdUpperBound + 1, dtype='float32')
+        for method in ('astar', 'bidirectional'):
+            path, dist = nifty.graph.shortestPathSinglePair(g, weights, 0, 2, method=method)
+            self.assertTrue(not len(path))
+            self.assertEqual(dist, float('inf'))
+
+    def testShortestPathSinglePairGridGraph(self):
+        shape = (30, 40)
+        g = nifty.graph.undirectedGridGraph(shape)
+        numpy.random.seed(42)
+        weights = numpy.random.uniform(0.5, 2., size=g.numberOfEdges).astype('float32')
+        # dijkstra on the same graph as reference
+        listGraph = nifty.graph.UndirectedGraph(g.numberOfNodes)
+        listGraph.insertEdges(g.uvIds())
+        sp = nifty.graph.ShortestPathDijkstra(listGraph)
+        for _ in range(10):
+            source, target = numpy.random.randint(0, g.numberOfNodes, size=2)
+            expected = sp.runSingleSourceSingleTarget(weights, int(source), int(target), returnNodes=False)
+            expected = weights[expected].sum()
+            for method in ('astar', 'bidirectional'):
+                path, dist = nifty.graph.shortestPathSinglePair(g, weights, int(source), int(target),
+                                                                method=method)
+                self.assertEqual(path[0], target)
+                self.assertEqual(path[-1], source)
+                self.assertAlmostEqual(dist, expected, places=3)
+            edges, dist = nifty.graph.shortestPathSinglePair(g, weights, int(source), int(target),
+                                                             returnNodes=False)
+            self.assertAlmostEqual(weights[edges].sum(), dist, places=4)
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,86 @@
+from __future__ import print_function
+import nifty
+import numpy
+import unittest
+import os
+import shutil
+import tempfile
+
+
+class TestUndirectedGraphInterop(unittest.TestCase):
+
+    def make_graph(self):
+        g = nifty.graph.undirectedGraph(5)
+        g.insertEdges(numpy.array([[0, 1], [1, 2], [2, 3], [3, 4], [0, 4]], dtype='uint64'))
+        return g
+
+    def testUvIdsView(self):
+        g = self.make_graph()
+        # the edge storage of a mutable graph is invalidated by inserting edges,
+        # so there is only a view for the immutable mapped graph
+        self.assertFalse(hasattr(g, 'uvIdsView'))
+        tmp_dir = tempfile.mkdtemp()
+        try:
+            path = os.path.join(tmp_dir, 'graph.snapshot')
+            nifty.graph.writeGraphSnapshot(g, path)
+            mapped = nifty.graph.MappedUndirectedGraph(path)
+            view = mapped.uvIdsView()
+            self.assertEqual(view.shape, (5, 2))
+            self.assertTrue(numpy.array_equal(view, g.uvIds()))
+            # the view is read-only
+            self.assertFalse(view.flags.writeable)
+            with self.assertRaises(ValueError):
+                view[0, 0] = 3
+            # the view keeps the mapped graph alive
+            del mapped
+            self.assertEqual(view[4, 1], 4)
+            del view
+        finally:
+            shutil.rmtree(tmp_dir)
+
+    def testEdgeMapBuffer(self):
+        g = self.make_graph()
+        edgeMap = nifty.graph.UndirectedGraphEdgeMapFloat64(g, 1.)
+        self.assertEqual(len(edgeMap), g.numberOfEdges)
+        values = numpy.asarray(edgeMap)
+        self.assertTrue(numpy.allclose(values, 1.))
+        # the array is a view of the map storage
+        values[2] = 5.
+        self.assertEqual(numpy.asarray(edgeMap)[2], 5.)
+
+        nodeMap = nifty.graph.UndirectedGraphNodeMapFloat64(g)
+        self.assertEqual(numpy.asarray(nodeMap).shape, (g.numberOfNodes,))
+
+    def testMovedResults(self):
+        g = self.make_graph()
+        edges = g.edgesFromNodeList(numpy.array([0, 1, 2], dtype='int64'))
+        self.assertIsInstance(edges, numpy.ndarray)
+        self.assertEqual(sorted(edges.tolist()), [0, 1])
+
+        inner, outer = g.extractSubgraphFromNodes(numpy.array([0, 1, 2], dtype='uint64'))
+        self.assertEqual(sorted(inner.tolist()), [0, 1])
+        self.assertEqual(sorted(outer.tolist()), [2, 4])
+
+    def testSnapshot(self):
+        g = self.make_graph()
+        weights = numpy.arange(g.numberOfEdges, dtype='float64')
+        tmp_dir = tempfile.mkdtemp()
+        try:
+            path = os.path.join(tmp_dir, 'graph.snapshot')
+            nifty.graph.writeGraphSnapshot(g, path, edgeMaps={'weights': weights})
+            mapped = nifty.graph.MappedUndirectedGraph(path)
+            self.assertEqual(mapped.numberOfNodes, g.numberOfNodes)
+            self.assertEqual(mapped.numberOfEdges, g.numberOfEdges)
+            self.assertTrue(numpy.array_equal(mapped.uvIdsView(), g.uvIds()))
+            self.assertEqual(mapped.findEdge(3, 2), g.findEdge(2, 3))
+            self.assertEqual(mapped.edgeMapNames, ['weights'])
+            mappedWeights = mapped.edgeMap('weights')
+            self.assertTrue(numpy.array_equal(mappedWeights, weights))
+            self.assertFalse(mappedWeights.flags.writeable)
+            del mapped, mappedWeights
+        finally:
+            shutil.rmtree(tmp_dir)
+
+
+if __name__ == '__main__':
+    unittest.main()
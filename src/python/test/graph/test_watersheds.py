@@ -0,0 +1,52 @@
+from __future__ import print_function
+import unittest
+import numpy
+import nifty
+import nifty.graph
+
+
+class TestWatersheds(unittest.TestCase):
+
+    def gridAndSeeds(self, shape, nSeeds=10):
+        g = nifty.graph.undirectedGridGraph(shape)
+        numpy.random.seed(42)
+        seeds = numpy.zeros(g.numberOfNodes, dtype='uint64')
+        seeds[numpy.random.choice(g.numberOfNodes, nSeeds, replace=False)] = numpy.arange(1, nSeeds + 1)
+        return g, seeds
+
+    def testParallelEdgeWeightedWatersheds(self):
+        for shape in ((40, 50), (10, 20, 30)):
+            g, seeds = self.gridAndSeeds(shape)
+            # quantized weights to have ties
+            weights = numpy.random.randint(0, 5, size=g.numberOfEdges).astype('float32')
+            expected = nifty.graph.edgeWeightedWatershedsSegmentation(g, seeds, weights)
+            for nThreads in (0, 1, 4):
+                labels = nifty.graph.parallelEdgeWeightedWatershedsSegmentation(g, seeds, weights,
+                                                                                numberOfThreads=nThreads)
+                self.assertTrue(numpy.array_equal(labels, expected))
+
+            labels, stats = nifty.graph.parallelEdgeWeightedWatershedsSegmentation(g, seeds, weights,
+                                                                                   returnStatistics=True)
+            self.assertTrue(numpy.array_equal(labels, expected))
+            self.assertEqual(stats.numberOfEdges, g.numberOfEdges)
+            self.assertGreater(stats.numberOfRounds, 0)
+            self.assertGreaterEqual(stats.edgesPerSecond, 0)
+
+    def testParallelNodeWeightedWatersheds(self):
+        g, seeds = self.gridAndSeeds((40, 50))
+        nodeWeights = numpy.random.rand(g.numberOfNodes).astype('float32')
+        labels = nifty.graph.parallelNodeWeightedWatershedsSegmentation(g, seeds, nodeWeights)
+
+        # the same as the edge weighted watershed on max(w(u), w(v)),
+        # where seeds do not contribute their weight
+        uvs = g.uvIds()
+        w = nodeWeights.copy()
+        w[seeds != 0] = -numpy.inf
+        edgeWeights = numpy.maximum(w[uvs[:, 0]], w[uvs[:, 1]])
+        expected = nifty.graph.edgeWeightedWatershedsSegmentation(g, seeds, edgeWeights)
+        self.assertTrue(numpy.array_equal(labels, expected))
+        self.assertEqual(set(numpy.unique(labels)), set(numpy.unique(seeds[seeds != 0])))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -89,6 +89,47 @@ class TestHDF5(unittest.TestCase):
         self.assertEqual(subarray.shape, expected.shape)
         self.assertTrue(numpy.allclose(subarray, expected))
 
+    @unittest.skipUnless(WITH_HDF5 and WITH_H5PY,
+                         "Need nifty-hdf5 and h5py")
+    def test_hdf5_direct_chunk_read(self):
+        import nifty.hdf5 as nhdf5
+        fpath = os.path.join(self.tempFolder, '_nifty_test_array_direct_.h5')
+
+        shape = (101, 102, 103)
+        chunks = (10, 20, 30)
+        data = numpy.random.randint(0, 1000, size=shape).astype('uint64')
+        with h5py.File(fpath) as f:
+            f.create_dataset("gzip", data=data, chunks=chunks,
+                             compression='gzip', shuffle=True)
+            # only partially written, the other chunks must be read as fill value
+            ds = f.create_dataset("partial", shape, dtype='uint64', chunks=chunks, fillvalue=42)
+            ds[:50] = data[:50]
+
+        hidT = nhdf5.openFile(fpath)
+        for key in ("gzip", "partial"):
+            array = nhdf5.Hdf5ArrayUInt64(hidT, key)
+            expected_data = data.copy()
+            if key == "partial":
+                expected_data[50:] = 42
+
+            self.assertTrue(array.canReadChunksDirectly)
+            self.assertFalse(array.directChunkRead)
+            array.directChunkRead = True
+            self.assertTrue(array.directChunkRead)
+
+            rois = [([0, 0, 0], [10, 20, 30]),
+                    ([5, 7, 9], [95, 83, 101]),
+                    ([0, 0, 0], list(shape))]
+            for roiBegin, roiEnd in rois:
+                expected = expected_data[roiBegin[0]:roiEnd[0],
+                                         roiBegin[1]:roiEnd[1],
+                                         roiBegin[2]:roiEnd[2]]
+                for numberOfThreads in (1, 4):
+                    subarray = array.readSubarray(roiBegin, roiEnd,
+                                                  numberOfThreads=numberOfThreads)
+                    self.assertEqual(subarray.shape, expected.shape)
+                    self.assertTrue(numpy.array_equal(subarray, expected))
+
     @unittest.skipUnless(WITH_HDF5, "Need nifty-hdf5")
     def test_create_chunked_array(self):
         import nifty.hdf5 as nhdf5
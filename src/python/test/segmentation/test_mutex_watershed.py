@@ -0,0 +1,109 @@
+import unittest
+import numpy as np
+
+
+class TestMutexWatershed(unittest.TestCase):
+    offsets = [[-1, 0], [0, -1], [-3, 0], [0, -3]]
+
+    # the repulsive weights get inverted, so high values mean weak repulsion
+    def make_weights(self, shape, attractive=.9, repulsive=.9):
+        weights = np.zeros((len(self.offsets),) + shape, dtype='float32')
+        weights[:2] = attractive
+        weights[2:] = repulsive
+        weights += .01 * np.random.rand(*weights.shape)
+        return weights
+
+    # naive divisive mws: explicit cluster ids and mutex pairs, relabeled on every merge,
+    # the segmentation is given by the attractive edges which merged unconstrained clusters
+    @staticmethod
+    def naive_divisive_mws(sorted_flat_indices, valid_edges, strides,
+                           number_of_nodes, number_of_attractive_channels):
+        clusters = np.arange(number_of_nodes)
+        mutexes = set()
+        forest = []
+        for edge in sorted_flat_indices:
+            if not valid_edges[edge]:
+                continue
+            u = edge % number_of_nodes
+            v = u + strides[edge // number_of_nodes]
+            a, b = clusters[u], clusters[v]
+            if a == b:
+                continue
+            constrained = (min(a, b), max(a, b)) in mutexes
+            if edge >= number_of_nodes * number_of_attractive_channels:
+                mutexes.add((min(a, b), max(a, b)))
+                continue
+            if not constrained:
+                forest.append((u, v))
+            clusters[clusters == b] = a
+            mutexes = set((min(x, y), max(x, y))
+                          for x, y in ((a if x == b else x, a if y == b else y) for x, y in mutexes)
+                          if x != y)
+        clusters = np.arange(number_of_nodes)
+        for u, v in forest:
+            a, b = clusters[u], clusters[v]
+            if a != b:
+                clusters[clusters == b] = a
+        return clusters
+
+    def same_partition(self, labels_a, labels_b):
+        pairs = set(zip(labels_a.tolist(), labels_b.tolist()))
+        return len(pairs) == len(np.unique(labels_a)) == len(np.unique(labels_b))
+
+    def test_divisive_mws(self):
+        from nifty.segmentation import compute_divisive_mws_segmentation_impl, get_valid_edges
+        np.random.seed(42)
+        shape = (9, 11)
+        offsets = [[-1, 0], [0, -1], [-2, 0], [0, -3], [-3, -3], [0, -9]]
+        number_of_attractive_channels = 2
+        number_of_nodes = shape[0] * shape[1]
+        strides = [o[0] * shape[1] + o[1] for o in offsets]
+        for _ in range(20):
+            weights = np.random.rand(len(offsets), *shape).astype('float32')
+            valid_edges = get_valid_edges(weights.shape, offsets, number_of_attractive_channels,
+                                          None, False)
+            valid_edges[number_of_attractive_channels:] &= np.random.rand(len(offsets) - 2, *shape) < .5
+            sorted_flat_indices = np.argsort(-weights, axis=None, kind='stable').astype('int64')
+            valid_edges = valid_edges.ravel()
+            labels = compute_divisive_mws_segmentation_impl(sorted_flat_indices, valid_edges, offsets,
+                                                            number_of_attractive_channels, list(shape))
+            expected = self.naive_divisive_mws(sorted_flat_indices, valid_edges, strides,
+                                               number_of_nodes, number_of_attractive_channels)
+            self.assertTrue(self.same_partition(labels, expected))
+
+    def test_semantic_mws(self):
+        from nifty.segmentation import compute_semantic_mws_segmentation
+        shape = (20, 20)
+        weights = self.make_weights(shape)
+        # left half class 0, right half class 1
+        semantic_weights = np.zeros((2,) + shape, dtype='float32')
+        semantic_weights[0, :, :10] = .95
+        semantic_weights[1, :, 10:] = .95
+        labels, semantic_labels = compute_semantic_mws_segmentation(weights, self.offsets, 2,
+                                                                    semantic_weights)
+        self.assertEqual(labels.shape, shape)
+        self.assertTrue((semantic_labels[:, :10] == 0).all())
+        self.assertTrue((semantic_labels[:, 10:] == 1).all())
+        self.assertEqual(len(np.unique(labels[:, :10])), 1)
+        self.assertEqual(len(np.unique(labels[:, 10:])), 1)
+        self.assertNotEqual(labels[0, 0], labels[0, -1])
+
+    def test_seeded_mws(self):
+        from nifty.segmentation import compute_seeded_mws_segmentation
+        shape = (20, 20)
+        weights = self.make_weights(shape)
+        seeds = np.zeros(shape, dtype='uint64')
+        seeds[0, 0] = 1
+        seeds[-1, -1] = 2
+        # the seeds are pinned even if they are not connected
+        seeds[0, -1] = 1
+        labels = compute_seeded_mws_segmentation(weights, self.offsets, 2, seeds)
+        self.assertEqual(labels.shape, shape)
+        self.assertEqual(labels[0, 0], 1)
+        self.assertEqual(labels[0, -1], 1)
+        self.assertEqual(labels[-1, -1], 2)
+        self.assertTrue(np.isin(labels, [1, 2]).all())
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,73 @@
+from __future__ import print_function
+
+import os
+import unittest
+from shutil import rmtree
+
+import numpy
+import nifty
+WITH_Z5 = nifty.Configuration.WITH_Z5
+
+try:
+    import z5py
+    WITH_Z5PY = True
+except ImportError:
+    WITH_Z5PY = False
+
+
+@unittest.skipUnless(WITH_Z5 and WITH_Z5PY, "need z5 and z5py")
+class TestUpsampling(unittest.TestCase):
+    path = './tmp_upsampling.n5'
+
+    def tearDown(self):
+        try:
+            rmtree(self.path)
+        except OSError:
+            pass
+
+    def _createDataset(self, key, data, chunks):
+        f = z5py.File(self.path)
+        ds = f.create_dataset(key, shape=data.shape, chunks=chunks, dtype=data.dtype)
+        ds[:] = data
+        return os.path.join(self.path, key)
+
+    def _upsampleAndDownsample(self, shape, factor, chunks):
+        import nifty.z5 as nz5
+        data = numpy.random.randint(0, 10, size=shape).astype('uint64')
+        inPath = self._createDataset('small', data, chunks)
+
+        expected = data
+        for axis, f in enumerate(factor):
+            expected = numpy.repeat(expected, f, axis=axis)
+        outPath = self._createDataset('large', numpy.zeros_like(expected), chunks)
+        nz5.nearestUpsampling('uint64', inPath, factor, outPath, numberOfThreads=4)
+        upsampled = z5py.File(self.path)['large'][:]
+        self.assertTrue(numpy.array_equal(upsampled, expected))
+
+        backPath = self._createDataset('back', numpy.zeros_like(data), chunks)
+        nz5.majorityVoteDownsampling('uint64', outPath, factor, backPath, numberOfThreads=4)
+        downsampled = z5py.File(self.path)['back'][:]
+        self.assertTrue(numpy.array_equal(downsampled, data))
+
+    def test_upsampling_2d(self):
+        self._upsampleAndDownsample((37, 29), [2, 3], (16, 16))
+
+    def test_upsampling_3d(self):
+        self._upsampleAndDownsample((13, 21, 17), [1, 2, 2], (8, 8, 8))
+
+    def test_upsampling_4d(self):
+        self._upsampleAndDownsample((3, 9, 11, 7), [1, 2, 3, 2], (2, 4, 4, 4))
+
+    def test_majority_vote(self):
+        import nifty.z5 as nz5
+        data = numpy.array([[3, 2, 7, 7, 9],
+                            [3, 3, 2, 7, 4]], dtype='uint64')
+        inPath = self._createDataset('labels', data, (2, 2))
+        outPath = self._createDataset('votes', numpy.zeros((1, 3), dtype='uint64'), (1, 2))
+        nz5.majorityVoteDownsampling('uint64', inPath, [2, 2], outPath)
+        votes = z5py.File(self.path)['votes'][:]
+        self.assertTrue(numpy.array_equal(votes, numpy.array([[3, 7, 4]])))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,148 @@
+#include <random>
+#include <vector>
+#include <utility>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/parallel/threadpool.hxx"
+#include "nifty/ufd/ufd.hxx"
+#include "nifty/ufd/concurrent_ufd.hxx"
+#include "nifty/graph/undirected_list_graph.hxx"
+#include "nifty/graph/undirected_grid_graph.hxx"
+#include "nifty/graph/components.hxx"
+
+
+std::vector<std::pair<uint64_t, uint64_t>> randomPairs(const uint64_t n, const uint64_t nPairs){
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<uint64_t> dist(0, n - 1);
+    std::vector<std::pair<uint64_t, uint64_t>> pairs(nPairs);
+    for(auto & p : pairs){
+        p.first = dist(gen);
+        p.second = dist(gen);
+    }
+    return pairs;
+}
+
+
+void concurrentUfdTest()
+{
+    const uint64_t n = 100000;
+    const auto pairs = randomPairs(n, 60000);
+
+    nifty::ufd::Ufd<> serial(n);
+    for(const auto & p : pairs){
+        serial.merge(p.first, p.second);
+    }
+
+    nifty::parallel::ThreadPool threadpool(8);
+    nifty::ufd::ConcurrentUfd<> concurrent(n);
+    nifty::parallel::parallel_foreach(threadpool, pairs.size(), [&](const int tid, const int64_t i){
+        concurrent.merge(pairs[i].first, pairs[i].second);
+    });
+
+    NIFTY_TEST_OP(concurrent.numberOfSets(),==,serial.numberOfSets());
+
+    // same partition, the representative is the smallest element of each set
+    std::vector<uint64_t> minElement(n, n);
+    for(uint64_t i = 0; i < n; ++i){
+        auto & m = minElement[serial.find(i)];
+        m = std::min(m, i);
+    }
+    for(uint64_t i = 0; i < n; ++i){
+        NIFTY_TEST_OP(concurrent.find(i),==,minElement[serial.find(i)]);
+    }
+    for(const auto & p : pairs){
+        NIFTY_TEST(concurrent.sameSet(p.first, p.second));
+    }
+
+    concurrent.reset(threadpool);
+    NIFTY_TEST_OP(concurrent.numberOfSets(),==,n);
+    NIFTY_TEST(!concurrent.sameSet(pairs[0].first, pairs[0].second) || pairs[0].first == pairs[0].second);
+}
+
+
+void parallelComponentsTest()
+{
+    const uint64_t n = 20000;
+    const auto pairs = randomPairs(n, 15000);
+
+    nifty::graph::UndirectedGraph<> graph(n);
+    for(const auto & p : pairs){
+        if(p.first != p.second){
+            graph.insertEdge(p.first, p.second);
+        }
+    }
+    std::vector<uint8_t> edgeLabels(graph.numberOfEdges());
+    for(uint64_t e = 0; e < edgeLabels.size(); ++e){
+        edgeLabels[e] = e % 3 == 0;
+    }
+
+    nifty::graph::ComponentsUfd<nifty::graph::UndirectedGraph<>> serial(graph);
+    nifty::graph::ComponentsUfd<nifty::graph::UndirectedGraph<>> parallel(graph);
+    nifty::parallel::ThreadPool threadpool(8);
+
+    // build twice to check the reset
+    for(int i = 0; i < 2; ++i){
+        const auto nSerial = serial.buildFromEdgeLabels(edgeLabels);
+        const auto nParallel = parallel.buildFromEdgeLabels(edgeLabels, threadpool);
+        NIFTY_TEST_OP(nSerial,==,nParallel);
+        for(uint64_t node = 0; node < n; ++node){
+            NIFTY_TEST_OP(serial.componentLabel(node),==,parallel.componentLabel(node));
+        }
+    }
+
+    // the parallel dense relabeling gives the same labels as the serial one
+    std::vector<uint64_t> serialLabels(n), parallelLabels(n);
+    std::vector<uint64_t> serialSizes(n, 0), parallelSizes(n, 0);
+    serial.denseRelabeling(serialLabels, serialSizes);
+    parallel.denseRelabeling(parallelLabels, parallelSizes, threadpool);
+    NIFTY_TEST(serialLabels == parallelLabels);
+    NIFTY_TEST(serialSizes == parallelSizes);
+
+    // dense labels of the concurrent ufd
+    std::unordered_map<uint64_t, uint64_t> serialMap;
+    std::vector<uint64_t> parallelMap(n);
+    nifty::ufd::ConcurrentUfd<> ufd(n);
+    for(const auto & p : pairs){
+        ufd.merge(p.first, p.second);
+    }
+    ufd.representativeLabeling(serialMap);
+    NIFTY_TEST_OP(ufd.representativeLabeling(parallelMap, threadpool),==,ufd.numberOfSets());
+    for(const auto & rep : serialMap){
+        NIFTY_TEST_OP(parallelMap[rep.first],==,rep.second);
+    }
+}
+
+
+void parallelGridComponentsTest()
+{
+    typedef nifty::graph::UndirectedGridGraph<2, true> GraphType;
+    typedef nifty::array::StaticArray<int64_t, 2> ShapeType;
+    const GraphType graph(ShapeType({300, 200}));
+
+    // stripes of node labels
+    std::vector<uint64_t> nodeLabels(graph.numberOfNodes());
+    for(uint64_t node = 0; node < nodeLabels.size(); ++node){
+        nodeLabels[node] = (node / 200) / 7;
+    }
+
+    nifty::graph::ComponentsUfd<GraphType> serial(graph);
+    nifty::graph::ComponentsUfd<GraphType> parallel(graph);
+    nifty::parallel::ThreadPool threadpool(8);
+    NIFTY_TEST_OP(serial.buildFromLabels(nodeLabels),==,uint64_t((300 + 6) / 7));
+    NIFTY_TEST_OP(parallel.buildFromLabels(nodeLabels, threadpool),==,uint64_t((300 + 6) / 7));
+
+    std::vector<uint64_t> serialLabels(graph.numberOfNodes()), parallelLabels(graph.numberOfNodes());
+    serial.denseRelabeling(serialLabels);
+    parallel.denseRelabeling(parallelLabels, threadpool);
+    NIFTY_TEST(serialLabels == parallelLabels);
+    for(uint64_t node = 0; node < nodeLabels.size(); ++node){
+        NIFTY_TEST_OP(parallelLabels[node],==,nodeLabels[node]);
+    }
+}
+
+
+int main() {
+    concurrentUfdTest();
+    parallelComponentsTest();
+    parallelGridComponentsTest();
+}
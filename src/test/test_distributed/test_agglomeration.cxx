@@ -0,0 +1,182 @@
+#include <random>
+#include <set>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/distributed/agglomeration.hxx"
+
+namespace ndist = nifty::distributed;
+typedef ndist::NodeType NodeType;
+
+
+// 24 x 24 grid graph with ground-truth segments of 5 x 7 pixels
+// and 4 blocks of 12 x 12 pixels
+const int gridSize = 24;
+const std::size_t numberOfNodes = gridSize * gridSize;
+
+int groundTruth(const NodeType node) {
+    return (node / gridSize / 5) * 100 + (node % gridSize) / 7;
+}
+
+int blockId(const NodeType node) {
+    return (node / gridSize / 12) * 2 + (node % gridSize) / 12;
+}
+
+
+template<class T>
+void writeDataset(const std::string & path, const std::string & dtype,
+                  const xt::xtensor<T, 2> & data, const std::size_t chunkSize) {
+    const std::vector<std::size_t> shape(data.shape().begin(), data.shape().end());
+    const std::vector<std::size_t> chunks({std::min(chunkSize, shape[0]), shape[1]});
+    auto ds = z5::createDataset(path, dtype, shape, chunks, false);
+    const std::vector<std::size_t> zero2Coord({0, 0});
+    z5::multiarray::writeSubarray<T>(ds, data, zero2Coord.begin());
+}
+
+
+template<class T>
+void writeDataset(const std::string & path, const std::string & dtype,
+                  const xt::xtensor<T, 1> & data, const std::size_t chunkSize) {
+    const std::vector<std::size_t> shape({data.shape()[0]});
+    const std::vector<std::size_t> chunks({std::min(chunkSize, shape[0])});
+    auto ds = z5::createDataset(path, dtype, shape, chunks, false);
+    const std::vector<std::size_t> zero1Coord({0});
+    z5::multiarray::writeSubarray<T>(ds, data, zero1Coord.begin());
+}
+
+
+void writeGraph(const std::string & path, const std::vector<NodeType> & nodes,
+                const std::vector<ndist::EdgeType> & edges, const std::vector<std::size_t> & edgeIds) {
+    z5::handle::Group graph(path);
+    z5::createGroup(graph, false);
+
+    xt::xtensor<NodeType, 1> nodeData({nodes.size()});
+    std::copy(nodes.begin(), nodes.end(), nodeData.begin());
+    writeDataset(path + "/nodes", "uint64", nodeData, 100);
+
+    xt::xtensor<NodeType, 2> edgeData({edgeIds.size(), 2});
+    xt::xtensor<int64_t, 1> edgeIdData({edgeIds.size()});
+    for(std::size_t i = 0; i < edgeIds.size(); ++i) {
+        edgeData(i, 0) = edges[edgeIds[i]].first;
+        edgeData(i, 1) = edges[edgeIds[i]].second;
+        edgeIdData(i) = edgeIds[i];
+    }
+    writeDataset(path + "/edges", "uint64", edgeData, 41);
+    writeDataset(path + "/edgeIds", "int64", edgeIdData, 41);
+
+    nlohmann::json attrs;
+    attrs["numberOfEdges"] = edgeIds.size();
+    z5::writeAttributes(graph, attrs);
+}
+
+
+std::vector<NodeType> readLabeling(const std::string & path) {
+    auto ds = z5::openDataset(path);
+    xt::xtensor<NodeType, 1> labeling({numberOfNodes});
+    const std::vector<std::size_t> zero1Coord({0});
+    z5::multiarray::readSubarray<NodeType>(ds, labeling, zero1Coord.begin());
+    return std::vector<NodeType>(labeling.begin(), labeling.end());
+}
+
+
+void agglomerationTest() {
+    const std::string root = (fs::temp_directory_path() / fs::unique_path()).string();
+    fs::create_directories(root);
+
+    std::vector<ndist::EdgeType> edges;
+    for(int y = 0; y < gridSize; ++y) {
+        for(int x = 0; x < gridSize; ++x) {
+            const NodeType node = y * gridSize + x;
+            if(x + 1 < gridSize) {
+                edges.emplace_back(node, node + 1);
+            }
+            if(y + 1 < gridSize) {
+                edges.emplace_back(node, node + gridSize);
+            }
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    const std::size_t nEdges = edges.size();
+
+    // edge features: mean in the first, size in the last column,
+    // low weights inside and high weights between the ground-truth segments
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> weightDist(0., 0.3);
+    std::uniform_int_distribution<int> sizeDist(1, 5);
+    xt::xtensor<double, 2> features({nEdges, 10});
+    for(std::size_t edge = 0; edge < nEdges; ++edge) {
+        const bool inside = groundTruth(edges[edge].first) == groundTruth(edges[edge].second);
+        features(edge, 0) = inside ? weightDist(gen) : 0.7 + weightDist(gen);
+        features(edge, 9) = sizeDist(gen);
+    }
+    const std::string featurePath = root + "/features";
+    writeDataset(featurePath, "float64", features, 37);
+
+    std::vector<std::size_t> edgeIds(nEdges);
+    std::iota(edgeIds.begin(), edgeIds.end(), 0);
+    std::vector<NodeType> nodes(numberOfNodes);
+    std::iota(nodes.begin(), nodes.end(), 0);
+    const std::string graphPath = root + "/graph";
+    writeGraph(graphPath, nodes, edges, edgeIds);
+
+    const std::string blockPrefix = root + "/block_";
+    for(int block = 0; block < 4; ++block) {
+        std::vector<NodeType> blockNodes;
+        std::vector<std::size_t> blockEdgeIds;
+        for(const auto node : nodes) {
+            if(blockId(node) == block) {
+                blockNodes.push_back(node);
+            }
+        }
+        for(const auto edge : edgeIds) {
+            if(blockId(edges[edge].first) == block || blockId(edges[edge].second) == block) {
+                blockEdgeIds.push_back(edge);
+            }
+        }
+        writeGraph(blockPrefix + std::to_string(block), blockNodes, edges, blockEdgeIds);
+    }
+
+    // the large edge budget agglomerates the contracted graph in memory,
+    // the small ones shard it and need several levels
+    const std::string labelingPath = root + "/labeling";
+    for(const std::size_t maxNumberOfEdges : {std::size_t(100000), std::size_t(40), std::size_t(8)}) {
+        for(const int nThreads : {1, 3}) {
+            writeDataset(labelingPath, "uint64", xt::xtensor<NodeType, 1>({numberOfNodes}), 50);
+
+            // agglomerating in the blocks only merges inside of the blocks and ground-truth segments
+            ndist::agglomerateInBlocks(blockPrefix, featurePath, {0, 1, 2, 3}, labelingPath, 0.5, nThreads);
+            auto labeling = readLabeling(labelingPath);
+            for(const auto node : nodes) {
+                const NodeType rep = labeling[node];
+                NIFTY_TEST_OP(rep,<=,node);
+                NIFTY_TEST_OP(blockId(rep),==,blockId(node));
+                NIFTY_TEST_OP(groundTruth(rep),==,groundTruth(node));
+            }
+
+            // agglomerating along the block boundaries never merges different ground-truth segments,
+            // the labels are the smallest node of each segment
+            ndist::agglomerateAlongBlockBoundaries(graphPath, featurePath, labelingPath, root + "/tmp",
+                                                   0.5, maxNumberOfEdges, nThreads);
+            labeling = readLabeling(labelingPath);
+            std::set<NodeType> segments;
+            for(const auto node : nodes) {
+                const NodeType rep = labeling[node];
+                NIFTY_TEST_OP(rep,<=,node);
+                NIFTY_TEST_OP(labeling[rep],==,rep);
+                NIFTY_TEST_OP(groundTruth(rep),==,groundTruth(node));
+                segments.insert(rep);
+            }
+
+            // with enough memory, all ground-truth segments are recovered
+            if(maxNumberOfEdges > nEdges) {
+                NIFTY_TEST_OP(segments.size(),==,20);
+            }
+        }
+    }
+
+    fs::remove_all(root);
+}
+
+
+int main() {
+    agglomerationTest();
+}
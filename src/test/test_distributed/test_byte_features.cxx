@@ -0,0 +1,222 @@
+#include <random>
+#include <set>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/distributed/mergeable_features.hxx"
+
+namespace ndist = nifty::distributed;
+typedef ndist::NodeType NodeType;
+typedef ndist::EdgeType EdgeType;
+
+typedef xt::xtensor<uint8_t, 3> ByteArray;
+typedef xt::xtensor<uint8_t, 4> ByteAffinities;
+typedef xt::xtensor<NodeType, 3> LabelArray;
+
+const std::size_t numberOfFeatures = 10;
+
+
+// compare the features computed from the sketches accumulated by the integer kernel
+// with the vigra accumulators of the float path: mean, variance, min, max and count agree,
+// the quantiles are interpolated differently, but agree up to one histogram bin
+void checkFeatures(const ndist::ByteEdgeAccumulators & byteAccumulators,
+                   const ndist::AccumulatorVector & accumulators) {
+    ndist::EdgeFeatureSketches sketches(accumulators.size(), 0., 1.);
+    byteAccumulators.mergeInto(sketches);
+    xt::xtensor<double, 2> features({accumulators.size(), numberOfFeatures});
+    std::size_t nEdgesWithValues = 0;
+    for(std::size_t edge = 0; edge < accumulators.size(); ++edge) {
+        sketches.computeFeatures(edge, features, edge);
+        const auto & accumulator = accumulators[edge];
+        const double count = acc::get<acc::Count>(accumulator);
+        NIFTY_TEST_OP(features(edge, 9),==,count);
+        if(count == 0) {
+            continue;
+        }
+        ++nEdgesWithValues;
+        NIFTY_TEST(std::abs(features(edge, 0) - acc::get<acc::Mean>(accumulator)) < 1e-12);
+        NIFTY_TEST(std::abs(features(edge, 1) - acc::get<acc::Variance>(accumulator)) < 1e-12);
+        const auto & quantiles = acc::get<ndist::Quantiles>(accumulator);
+        NIFTY_TEST_OP(features(edge, 2),==,quantiles[0]);
+        NIFTY_TEST_OP(features(edge, 8),==,quantiles[6]);
+        for(std::size_t qi = 1; qi < 6; ++qi) {
+            NIFTY_TEST(std::abs(features(edge, 2 + qi) - quantiles[qi]) <= 1. / ndist::EdgeFeatureSketches::numberOfBins + 1e-9);
+        }
+    }
+    NIFTY_TEST(nEdgesWithValues > 0);
+}
+
+
+ndist::AccumulatorVector makeAccumulators(const std::size_t numberOfEdges) {
+    ndist::AccumulatorVector accumulators(numberOfEdges);
+    ndist::HistogramOptions histogramOpts;
+    histogramOpts = histogramOpts.setMinMax(0., 1.);
+    for(auto & accumulator : accumulators) {
+        accumulator.setHistogramOptions(histogramOpts);
+    }
+    return accumulators;
+}
+
+
+template<class T>
+std::unique_ptr<z5::Dataset> writeDataset(const std::string & path, const std::string & dtype,
+                                          const T & data) {
+    const std::vector<std::size_t> shape(data.shape().begin(), data.shape().end());
+    auto ds = z5::createDataset(path, dtype, shape, shape, false);
+    const std::vector<std::size_t> zeroCoord(shape.size(), 0);
+    z5::multiarray::writeSubarray<typename T::value_type>(ds, data, zeroCoord.begin());
+    return ds;
+}
+
+
+xt::xtensor<double, 2> readFeatures(const std::string & path) {
+    auto ds = z5::openDataset(path);
+    xt::xtensor<double, 2> features({ds->shape(0), ds->shape(1)});
+    const std::vector<std::size_t> zero2Coord({0, 0});
+    z5::multiarray::readSubarray<double>(ds, features, zero2Coord.begin());
+    return features;
+}
+
+
+void byteFeaturesTest() {
+    const std::string root = (fs::temp_directory_path() / fs::unique_path()).string();
+    fs::create_directories(root);
+
+    // blocky labels with an ignore label region
+    const std::vector<std::size_t> shape({8, 10, 12});
+    ndist::CoordType blockShape;
+    LabelArray labels({shape[0], shape[1], shape[2]});
+    for(std::size_t z = 0; z < shape[0]; ++z) {
+        for(std::size_t y = 0; y < shape[1]; ++y) {
+            for(std::size_t x = 0; x < shape[2]; ++x) {
+                labels(z, y, x) = (x < 2 && y < 3) ? 0 : 1 + (z / 3) * 12 + (y / 4) * 4 + x / 4;
+            }
+        }
+    }
+    for(unsigned axis = 0; axis < 3; ++axis) {
+        blockShape[axis] = shape[axis];
+    }
+
+    // the region graph: all pairs of labels that are adjacent or connected by one of the offsets
+    const std::vector<ndist::OffsetType> offsets = {{-1, 0, 0}, {0, -1, 0}, {0, 0, -1},
+                                                    {0, 0, 3}, {0, -4, 0}, {2, 0, 0}};
+    std::set<NodeType> nodes;
+    std::set<EdgeType> edges;
+    for(std::size_t z = 0; z < shape[0]; ++z) {
+        for(std::size_t y = 0; y < shape[1]; ++y) {
+            for(std::size_t x = 0; x < shape[2]; ++x) {
+                const NodeType lU = labels(z, y, x);
+                nodes.insert(lU);
+                for(const auto & offset : offsets) {
+                    const int64_t z2 = z + offset[0], y2 = y + offset[1], x2 = x + offset[2];
+                    if(z2 < 0 || y2 < 0 || x2 < 0 || z2 >= int64_t(shape[0]) ||
+                       y2 >= int64_t(shape[1]) || x2 >= int64_t(shape[2])) {
+                        continue;
+                    }
+                    const NodeType lV = labels(z2, y2, x2);
+                    if(lU != lV) {
+                        edges.insert(EdgeType(std::min(lU, lV), std::max(lU, lV)));
+                    }
+                }
+            }
+        }
+    }
+    const std::vector<std::size_t> roi({0, 0, 0});
+    ndist::serializeGraph(root, "graph", nodes, edges, roi, roi);
+    const ndist::Graph graph(root + "/graph");
+    const std::size_t nEdges = graph.numberOfEdges();
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> byteDist(0, 255);
+    ByteArray data({shape[0], shape[1], shape[2]});
+    for(auto & val : data) {
+        val = byteDist(gen);
+    }
+    ByteAffinities affs({offsets.size(), shape[0], shape[1], shape[2]});
+    for(auto & val : affs) {
+        val = byteDist(gen);
+    }
+    ndist::AffCoordType affBlockShape;
+    affBlockShape[0] = offsets.size();
+    for(unsigned axis = 0; axis < 3; ++axis) {
+        affBlockShape[axis + 1] = shape[axis];
+    }
+
+    for(const bool ignoreLabel : {false, true}) {
+        // boundary maps
+        {
+            ndist::ByteEdgeAccumulators byteAccumulators(nEdges, 0., 1.);
+            ndist::accumulateBoundariesImplByte(graph, data, labels, blockShape, ignoreLabel, byteAccumulators);
+            auto accumulators = makeAccumulators(nEdges);
+            ndist::accumulateBoundariesImplFloat(graph, data, labels, blockShape, ignoreLabel, accumulators);
+            checkFeatures(byteAccumulators, accumulators);
+        }
+
+        // affinity maps
+        {
+            ndist::ByteEdgeAccumulators byteAccumulators(nEdges, 0., 1.);
+            ndist::accumulateAffinitiesImplByte(graph, affs, labels, affBlockShape, offsets,
+                                                ignoreLabel, byteAccumulators);
+            auto accumulators = makeAccumulators(nEdges);
+            ndist::accumulateAffinitiesImplFloat(graph, affs, labels, affBlockShape, offsets,
+                                                 ignoreLabel, accumulators);
+            checkFeatures(byteAccumulators, accumulators);
+        }
+    }
+
+    // by default, the features of uint8 input are computed from the sketches of the integer kernel
+    // and agree with the features of the normalized float input up to one histogram bin for the quantiles;
+    // with 'vigraFeatures' they are the same as the features of the float input
+    xt::xtensor<double, 3> floatData({shape[0], shape[1], shape[2]});
+    std::transform(data.begin(), data.end(), floatData.begin(), [](const uint8_t val){return val / 255.;});
+    xt::xtensor<double, 4> floatAffs({offsets.size(), shape[0], shape[1], shape[2]});
+    std::transform(affs.begin(), affs.end(), floatAffs.begin(), [](const uint8_t val){return val / 255.;});
+    writeDataset(root + "/labels", "uint64", labels);
+    writeDataset(root + "/data", "uint8", data);
+    writeDataset(root + "/float_data", "float64", floatData);
+    writeDataset(root + "/affs", "uint8", affs);
+    writeDataset(root + "/float_affs", "float64", floatAffs);
+
+    const std::vector<std::size_t> halo({0, 0, 0});
+    for(const bool vigraFeatures : {false, true}) {
+        const std::string prefix = vigraFeatures ? "/vigra_" : "/";
+        ndist::accumulateBoundaryMap<uint8_t>(graph, z5::openDataset(root + "/data"), z5::openDataset(root + "/labels"),
+                                              roi, shape, root + prefix + "boundary_features", 0., 1., false,
+                                              false, false, vigraFeatures);
+        ndist::accumulateAffinityMap<uint8_t>(graph, z5::openDataset(root + "/affs"), z5::openDataset(root + "/labels"),
+                                              roi, shape, root + prefix + "affinity_features", offsets, halo, halo,
+                                              0., 1., false, false, vigraFeatures);
+    }
+    ndist::accumulateBoundaryMap<double>(graph, z5::openDataset(root + "/float_data"), z5::openDataset(root + "/labels"),
+                                         roi, shape, root + "/float_boundary_features", 0., 1., false);
+    ndist::accumulateAffinityMap<double>(graph, z5::openDataset(root + "/float_affs"), z5::openDataset(root + "/labels"),
+                                         roi, shape, root + "/float_affinity_features", offsets, halo, halo, 0., 1., false);
+    for(const std::string name : {"boundary_features", "affinity_features"}) {
+        const auto features = readFeatures(root + "/" + name);
+        const auto vigraFeatures = readFeatures(root + "/vigra_" + name);
+        const auto floatFeatures = readFeatures(root + "/float_" + name);
+        NIFTY_TEST_OP(features.shape()[0],==,nEdges);
+        NIFTY_TEST_OP(vigraFeatures.shape()[0],==,nEdges);
+        for(std::size_t edge = 0; edge < nEdges; ++edge) {
+            NIFTY_TEST_OP(features(edge, 9),==,floatFeatures(edge, 9));
+            if(floatFeatures(edge, 9) > 0) {
+                NIFTY_TEST(std::abs(features(edge, 0) - floatFeatures(edge, 0)) < 1e-12);
+                NIFTY_TEST(std::abs(features(edge, 1) - floatFeatures(edge, 1)) < 1e-12);
+                NIFTY_TEST_OP(features(edge, 2),==,floatFeatures(edge, 2));
+                NIFTY_TEST_OP(features(edge, 8),==,floatFeatures(edge, 8));
+                for(std::size_t featId = 3; featId < 8; ++featId) {
+                    NIFTY_TEST(std::abs(features(edge, featId) - floatFeatures(edge, featId)) <= 1. / ndist::EdgeFeatureSketches::numberOfBins + 1e-9);
+                }
+            }
+            for(std::size_t featId = 0; featId < numberOfFeatures; ++featId) {
+                NIFTY_TEST_OP(vigraFeatures(edge, featId),==,floatFeatures(edge, featId));
+            }
+        }
+    }
+
+    fs::remove_all(root);
+}
+
+
+int main() {
+    byteFeaturesTest();
+}
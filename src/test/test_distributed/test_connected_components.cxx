@@ -0,0 +1,56 @@
+#include <set>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/distributed/graph_tools.hxx"
+
+namespace ndist = nifty::distributed;
+typedef ndist::NodeType NodeType;
+typedef ndist::EdgeType EdgeType;
+
+
+void connectedComponentsTest() {
+    const std::string root = (fs::temp_directory_path() / fs::unique_path()).string();
+    fs::create_directories(root);
+
+    // path graph visiting the nodes in this order,
+    // so that the smallest node of a component is not at the start of its path segment
+    const std::vector<NodeType> path = {5, 9, 2, 8, 0, 6, 3, 7, 1, 4};
+    std::set<NodeType> nodes(path.begin(), path.end());
+    std::set<EdgeType> edges;
+    for(std::size_t i = 0; i + 1 < path.size(); ++i) {
+        edges.insert(EdgeType(std::min(path[i], path[i + 1]), std::max(path[i], path[i + 1])));
+    }
+    const std::vector<std::size_t> roi({0, 0, 0});
+    ndist::serializeGraph(root, "graph", nodes, edges, roi, roi);
+    const ndist::Graph graph(root + "/graph");
+
+    // cut the edges (8, 0) and (3, 7)
+    const std::set<EdgeType> cutEdges = {EdgeType(0, 8), EdgeType(3, 7)};
+    xt::xtensor<uint8_t, 1> edgeLabels({graph.numberOfEdges()});
+    for(std::size_t edge = 0; edge < graph.numberOfEdges(); ++edge) {
+        edgeLabels(edge) = cutEdges.count(graph.edges()[edge]);
+    }
+
+    // components {5, 9, 2, 8}, {0, 6, 3} and {7, 1, 4}
+    const std::vector<NodeType> expected = {0, 1, 2, 0, 1, 2, 0, 1, 2, 2};
+    // with the ignore label, node 0 is not connected to {6, 3}
+    const std::vector<NodeType> expectedIgnore = {0, 1, 2, 3, 1, 2, 3, 1, 2, 2};
+
+    for(const int nThreads : {1, 4}) {
+        for(const bool ignoreLabel : {false, true}) {
+            xt::xtensor<uint64_t, 1> labels({graph.nodeMaxId() + 1});
+            ndist::connectedComponents(graph, edgeLabels, ignoreLabel, labels, nThreads);
+            const auto & exp = ignoreLabel ? expectedIgnore : expected;
+            for(const auto node : nodes) {
+                NIFTY_TEST_OP(labels(node),==,exp[node]);
+            }
+        }
+    }
+
+    fs::remove_all(root);
+}
+
+
+int main() {
+    connectedComponentsTest();
+}
@@ -0,0 +1,155 @@
+#include <random>
+#include <set>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/distributed/mergeable_features.hxx"
+
+namespace ndist = nifty::distributed;
+typedef ndist::NodeType NodeType;
+typedef ndist::EdgeType EdgeType;
+typedef ndist::EdgeIndexType EdgeIndexType;
+
+
+const int gridSize = 20;
+const std::size_t numberOfBlocks = 4;
+const std::size_t numberOfFeatures = 10;
+
+int blockId(const NodeType node) {
+    return (node / gridSize / 10) * 2 + (node % gridSize) / 10;
+}
+
+
+// the old merge: load the full feature table of each block
+// and merge the rows of the edges in [edgeIdBegin, edgeIdEnd)
+xt::xtensor<double, 2> mergeFullTables(const std::string & graphBlockPrefix,
+                                       const std::string & featureBlockPrefix,
+                                       const std::size_t edgeIdBegin,
+                                       const std::size_t edgeIdEnd) {
+    const std::size_t nEdges = edgeIdEnd - edgeIdBegin;
+    xt::xtensor<double, 2> features({nEdges, numberOfFeatures});
+    std::vector<bool> hasFeatures(nEdges, false);
+    for(std::size_t block = 0; block < numberOfBlocks; ++block) {
+        std::vector<EdgeIndexType> edgeIds;
+        ndist::loadEdgeIndices(graphBlockPrefix + std::to_string(block), edgeIds, 0);
+        xt::xtensor<double, 2> blockFeatures({edgeIds.size(), numberOfFeatures});
+        ndist::loadBlockFeatures(featureBlockPrefix + std::to_string(block), blockFeatures);
+        for(std::size_t row = 0; row < edgeIds.size(); ++row) {
+            const EdgeIndexType edgeId = edgeIds[row];
+            if(edgeId >= static_cast<EdgeIndexType>(edgeIdBegin) && edgeId < static_cast<EdgeIndexType>(edgeIdEnd)) {
+                ndist::mergeFeaturesForSingleEdge(blockFeatures, features, row, edgeId - edgeIdBegin, hasFeatures);
+            }
+        }
+    }
+    return features;
+}
+
+
+void mergeFeatureBlocksTest() {
+    const std::string root = (fs::temp_directory_path() / fs::unique_path()).string();
+    fs::create_directories(root);
+
+    // grid graph with 4 blocks, the block graphs contain all edges touching the block
+    std::set<NodeType> nodes;
+    std::set<EdgeType> edges;
+    std::vector<std::set<NodeType>> blockNodes(numberOfBlocks);
+    std::vector<std::set<EdgeType>> blockEdges(numberOfBlocks);
+    for(int y = 0; y < gridSize; ++y) {
+        for(int x = 0; x < gridSize; ++x) {
+            const NodeType node = y * gridSize + x;
+            nodes.insert(node);
+            blockNodes[blockId(node)].insert(node);
+            for(const NodeType other : {node + 1, node + gridSize}) {
+                if((other == node + 1 && x + 1 == gridSize) || other >= gridSize * gridSize) {
+                    continue;
+                }
+                const EdgeType edge(node, other);
+                edges.insert(edge);
+                blockEdges[blockId(node)].insert(edge);
+                blockEdges[blockId(other)].insert(edge);
+            }
+        }
+    }
+    const std::size_t nEdges = edges.size();
+
+    const std::vector<std::size_t> roi({0, 0});
+    ndist::serializeGraph(root, "graph", nodes, edges, roi, roi);
+    std::vector<std::size_t> blockIds(numberOfBlocks);
+    std::iota(blockIds.begin(), blockIds.end(), 0);
+    for(const auto block : blockIds) {
+        ndist::serializeGraph(root, "block_" + std::to_string(block),
+                              blockNodes[block], blockEdges[block], roi, roi);
+    }
+    ndist::mapEdgeIds(root, "graph", "block_", blockIds, 3);
+
+    // the mapped block edge ids are sorted and map to the block edges,
+    // the stored edge id range agrees with them
+    const std::vector<EdgeType> edgeVector(edges.begin(), edges.end());
+    const std::string graphBlockPrefix = root + "/block_";
+    for(const auto block : blockIds) {
+        std::vector<EdgeIndexType> edgeIds;
+        NIFTY_TEST(ndist::loadEdgeIndices(graphBlockPrefix + std::to_string(block), edgeIds, 0));
+        NIFTY_TEST_OP(edgeIds.size(),==,blockEdges[block].size());
+        NIFTY_TEST(std::is_sorted(edgeIds.begin(), edgeIds.end()));
+        std::size_t row = 0;
+        for(const auto & edge : blockEdges[block]) {
+            NIFTY_TEST(edgeVector[edgeIds[row]] == edge);
+            ++row;
+        }
+        EdgeIndexType edgeIdBegin, edgeIdEnd;
+        NIFTY_TEST(ndist::loadEdgeIdRange(graphBlockPrefix + std::to_string(block), edgeIdBegin, edgeIdEnd));
+        NIFTY_TEST_OP(edgeIdBegin,==,edgeIds.front());
+        NIFTY_TEST_OP(edgeIdEnd,==,edgeIds.back() + 1);
+    }
+
+    // random block features, the last column is the count
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> featDist(0., 1.);
+    std::uniform_int_distribution<int> countDist(1, 100);
+    const std::string featureBlockPrefix = root + "/features_";
+    for(const auto block : blockIds) {
+        const std::size_t nBlockEdges = blockEdges[block].size();
+        xt::xtensor<double, 2> features({nBlockEdges, numberOfFeatures});
+        for(std::size_t edge = 0; edge < nBlockEdges; ++edge) {
+            for(std::size_t featId = 0; featId < numberOfFeatures - 1; ++featId) {
+                features(edge, featId) = featDist(gen);
+            }
+            features(edge, numberOfFeatures - 1) = countDist(gen);
+        }
+        const std::vector<std::size_t> shape({nBlockEdges, numberOfFeatures});
+        const std::vector<std::size_t> chunks({17, numberOfFeatures});
+        auto ds = z5::createDataset(featureBlockPrefix + std::to_string(block), "float64", shape, chunks, false);
+        const std::vector<std::size_t> zero2Coord({0, 0});
+        z5::multiarray::writeSubarray<double>(ds, features, zero2Coord.begin());
+    }
+
+    // the row range merge agrees with the full table merge
+    const std::string featuresOut = root + "/features";
+    const std::vector<std::size_t> outShape({nEdges, numberOfFeatures});
+    const std::vector<std::size_t> outChunks({25, numberOfFeatures});
+    const std::vector<std::pair<std::size_t, std::size_t>> ranges = {{0, nEdges}, {37, 151}, {200, nEdges}};
+    for(const auto & range : ranges) {
+        const auto expected = mergeFullTables(graphBlockPrefix, featureBlockPrefix, range.first, range.second);
+        for(const int nThreads : {0, 1, 3}) {
+            z5::createDataset(featuresOut, "float64", outShape, outChunks, false);
+            ndist::mergeFeatureBlocks(graphBlockPrefix, featureBlockPrefix, featuresOut, blockIds,
+                                      range.first, range.second, nThreads);
+
+            xt::xtensor<double, 2> features({range.second - range.first, numberOfFeatures});
+            auto ds = z5::openDataset(featuresOut);
+            const std::vector<std::size_t> offset({range.first, 0});
+            z5::multiarray::readSubarray<double>(ds, features, offset.begin());
+            for(std::size_t edge = 0; edge < features.shape()[0]; ++edge) {
+                for(std::size_t featId = 0; featId < numberOfFeatures; ++featId) {
+                    NIFTY_TEST(std::abs(features(edge, featId) - expected(edge, featId)) < 1e-9);
+                }
+            }
+        }
+    }
+
+    fs::remove_all(root);
+}
+
+
+int main() {
+    mergeFeatureBlocksTest();
+}
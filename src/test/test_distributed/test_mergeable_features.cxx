@@ -0,0 +1,181 @@
+#include <random>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/distributed/mergeable_features.hxx"
+
+namespace ndist = nifty::distributed;
+typedef ndist::EdgeFeatureSketches SketchesType;
+
+
+// accumulate random values, the first edge gets enough values to need counts above 255
+void accumulateRandom(const std::size_t numberOfEdges,
+                      SketchesType & whole,
+                      SketchesType & firstHalf,
+                      SketchesType & secondHalf) {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> countDist(0, 20);
+    std::normal_distribution<double> valDist(0.5, 0.3);
+    std::bernoulli_distribution halfDist(0.5);
+    for(std::size_t edge = 0; edge < numberOfEdges; ++edge) {
+        const int count = edge == 0 ? 5000 : countDist(gen);
+        for(int i = 0; i < count; ++i) {
+            // values outside of [dataMin, dataMax] go to the first / last bin
+            const double val = valDist(gen);
+            whole.update(edge, val);
+            (halfDist(gen) ? firstHalf : secondHalf).update(edge, val);
+        }
+    }
+}
+
+
+void checkSketches(const SketchesType & sketches, const SketchesType & expected) {
+    NIFTY_TEST_OP(sketches.numberOfEdges(),==,expected.numberOfEdges());
+    for(std::size_t edge = 0; edge < expected.numberOfEdges(); ++edge) {
+        for(std::size_t bin = 0; bin < SketchesType::numberOfBins; ++bin) {
+            NIFTY_TEST_OP(sketches.histograms()(edge, bin),==,expected.histograms()(edge, bin));
+        }
+        // the sums are merged in a different order, min and max are exact
+        for(std::size_t moment = 0; moment < 2; ++moment) {
+            const double exp = expected.moments()(edge, moment);
+            NIFTY_TEST(std::abs(sketches.moments()(edge, moment) - exp) <= 1e-12 * std::max(std::abs(exp), 1.));
+        }
+        for(std::size_t moment = 2; moment < 4; ++moment) {
+            NIFTY_TEST_OP(sketches.moments()(edge, moment),==,expected.moments()(edge, moment));
+        }
+    }
+}
+
+
+void sketchMergeTest() {
+    const std::size_t nEdges = 200;
+    SketchesType whole(nEdges, 0., 1.), firstHalf(nEdges, 0., 1.), secondHalf(nEdges, 0., 1.);
+    accumulateRandom(nEdges, whole, firstHalf, secondHalf);
+
+    SketchesType merged(nEdges, 0., 1.);
+    for(std::size_t edge = 0; edge < nEdges; ++edge) {
+        merged.merge(edge, firstHalf, edge);
+        merged.merge(edge, secondHalf, edge);
+    }
+    checkSketches(merged, whole);
+
+    // the features of the merged and the whole sketches agree
+    xt::xtensor<double, 2> mergedFeatures({nEdges, 10}), wholeFeatures({nEdges, 10});
+    for(std::size_t edge = 0; edge < nEdges; ++edge) {
+        merged.computeFeatures(edge, mergedFeatures, edge);
+        whole.computeFeatures(edge, wholeFeatures, edge);
+        for(std::size_t featId = 0; featId < 10; ++featId) {
+            NIFTY_TEST(std::abs(mergedFeatures(edge, featId) - wholeFeatures(edge, featId)) < 1e-9);
+        }
+    }
+}
+
+
+void sketchSerializationTest() {
+    const std::string root = (fs::temp_directory_path() / fs::unique_path()).string();
+    fs::create_directories(root);
+
+    // the two halves are the sketches of two blocks,
+    // the block edges are stored at the odd global edge ids
+    const std::size_t nEdges = 200;
+    SketchesType whole(nEdges, 0., 1.), firstHalf(nEdges, 0., 1.), secondHalf(nEdges, 0., 1.);
+    accumulateRandom(nEdges, whole, firstHalf, secondHalf);
+    firstHalf.serialize(root + "/block_0");
+    secondHalf.serialize(root + "/block_1");
+
+    std::vector<ndist::EdgeIndexType> blockEdgeIndices(nEdges);
+    for(std::size_t edge = 0; edge < nEdges; ++edge) {
+        blockEdgeIndices[edge] = 2 * edge + 1;
+    }
+
+    // merge all edges
+    SketchesType merged(2 * nEdges, 0., 1.);
+    merged.mergeSerialized(root + "/block_0", blockEdgeIndices, 0);
+    merged.mergeSerialized(root + "/block_1", blockEdgeIndices, 0);
+    SketchesType mergedOdd(nEdges, 0., 1.);
+    for(std::size_t edge = 0; edge < nEdges; ++edge) {
+        mergedOdd.merge(edge, merged, 2 * edge + 1);
+        // the even edges are empty
+        for(std::size_t bin = 0; bin < SketchesType::numberOfBins; ++bin) {
+            NIFTY_TEST_OP(merged.histograms()(2 * edge, bin),==,0);
+        }
+    }
+    checkSketches(mergedOdd, whole);
+
+    // merge a range of edges, which only contains part of the block edges
+    const std::size_t edgeIdBegin = 100;
+    const std::size_t nRangeEdges = 51;
+    SketchesType mergedRange(nRangeEdges, 0., 1.);
+    mergedRange.mergeSerialized(root + "/block_0", blockEdgeIndices, edgeIdBegin);
+    mergedRange.mergeSerialized(root + "/block_1", blockEdgeIndices, edgeIdBegin);
+    for(std::size_t edgeId = edgeIdBegin; edgeId < edgeIdBegin + nRangeEdges; ++edgeId) {
+        for(std::size_t bin = 0; bin < SketchesType::numberOfBins; ++bin) {
+            NIFTY_TEST_OP(mergedRange.histograms()(edgeId - edgeIdBegin, bin),==,
+                          merged.histograms()(edgeId, bin));
+        }
+        for(std::size_t moment = 0; moment < SketchesType::numberOfMoments; ++moment) {
+            NIFTY_TEST_OP(mergedRange.moments()(edgeId - edgeIdBegin, moment),==,
+                          merged.moments()(edgeId, moment));
+        }
+    }
+
+    fs::remove_all(root);
+}
+
+
+// the serialized size of an edge depends only on its own histogram
+void sketchSerializedSizeTest() {
+    const std::string root = (fs::temp_directory_path() / fs::unique_path()).string();
+    fs::create_directories(root);
+
+    const std::size_t nEdges = 200;
+    SketchesType whole(nEdges, 0., 1.), firstHalf(nEdges, 0., 1.), secondHalf(nEdges, 0., 1.);
+    accumulateRandom(nEdges, whole, firstHalf, secondHalf);
+    whole.serialize(root + "/block");
+
+    // float64 moments, uint8 histogram sizes and the uint8 encoded histograms
+    z5::handle::Group group(root + "/block");
+    auto momentDs = z5::openDataset(group, "moments");
+    auto sizeDs = z5::openDataset(group, "histogramSizes");
+    auto histogramDs = z5::openDataset(group, "histograms");
+    NIFTY_TEST_OP(momentDs->shape(0),==,nEdges);
+    NIFTY_TEST_OP(momentDs->shape(1),==,SketchesType::numberOfMoments);
+    NIFTY_TEST_OP(sizeDs->shape(0),==,nEdges);
+    xt::xtensor<uint8_t, 1> sizes({nEdges});
+    const std::vector<std::size_t> zero1Coord({0});
+    z5::multiarray::readSubarray<uint8_t>(sizeDs, sizes, zero1Coord.begin());
+
+    std::size_t histogramBytes = 0;
+    for(std::size_t edge = 0; edge < nEdges; ++edge) {
+        // the range of non-empty bins, one byte per count below 128 and two below 16384
+        std::size_t binBegin = SketchesType::numberOfBins, binEnd = 0, expectedSize = 0;
+        for(std::size_t bin = 0; bin < SketchesType::numberOfBins; ++bin) {
+            if(whole.histograms()(edge, bin) > 0) {
+                binBegin = std::min(binBegin, bin);
+                binEnd = bin + 1;
+            }
+        }
+        for(std::size_t bin = binBegin; bin < binEnd; ++bin) {
+            expectedSize += whole.histograms()(edge, bin) < 128 ? 1 : 2;
+        }
+        if(binEnd > 0) {
+            ++expectedSize;
+        }
+        NIFTY_TEST_OP(std::size_t(sizes(edge)),==,expectedSize);
+        histogramBytes += sizes(edge);
+    }
+    NIFTY_TEST_OP(histogramDs->shape(0),==,histogramBytes);
+
+    // smaller than the dense float64 table of the 10 features (80 bytes per edge),
+    // although the first edge has more than 255 values in a bin
+    const std::size_t bytesPerEdge = (8 * SketchesType::numberOfMoments * nEdges + nEdges + histogramBytes) / nEdges;
+    NIFTY_TEST(bytesPerEdge < 80);
+
+    fs::remove_all(root);
+}
+
+
+int main() {
+    sketchMergeTest();
+    sketchSerializationTest();
+    sketchSerializedSizeTest();
+}
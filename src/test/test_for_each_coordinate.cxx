@@ -0,0 +1,42 @@
+#include <vector>
+#include <atomic>
+
+#include "nifty/tools/for_each_coordinate.hxx"
+
+
+
+void parallelForEachCoordinateTiledTest()
+{
+    typedef nifty::array::StaticArray<int64_t, 3> Coord;
+
+    nifty::parallel::ThreadPool threadpool(4);
+    const Coord shape({10, 37, 53});
+    const Coord strides = nifty::tools::rowMajorStrides<3>(shape);
+    const int64_t size = shape[0] * shape[1] * shape[2];
+
+    std::vector<Coord> tileShapes({nifty::tools::defaultTileShape(shape), Coord({3, 5, 7}), Coord({1, 1, 1})});
+    for(const auto & tileShape : tileShapes){
+        std::vector<std::atomic<int>> visited(size);
+        for(auto & v : visited){
+            v = 0;
+        }
+        std::atomic<int> wrongOffsets(0);
+
+        nifty::tools::parallelForEachCoordinateTiled(threadpool, shape, strides, tileShape,
+        [&](const int tid, const Coord & coord, const int64_t offset){
+            if(offset != coord[0] * strides[0] + coord[1] * strides[1] + coord[2]){
+                ++wrongOffsets;
+            }
+            ++visited[offset];
+        });
+
+        NIFTY_TEST_OP(wrongOffsets.load(), ==, 0);
+        for(const auto & v : visited){
+            NIFTY_TEST_OP(v.load(), ==, 1);
+        }
+    }
+}
+
+int main() {
+    parallelForEachCoordinateTiledTest();
+}
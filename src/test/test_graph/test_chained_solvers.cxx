@@ -0,0 +1,164 @@
+#include <random>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/graph/undirected_grid_graph.hxx"
+#include "nifty/graph/opt/common/solver_factory.hxx"
+#include "nifty/graph/opt/multicut/multicut_objective.hxx"
+#include "nifty/graph/opt/multicut/multicut_greedy_additive.hxx"
+#include "nifty/graph/opt/multicut/chained_solvers.hxx"
+
+
+typedef nifty::graph::UndirectedGridGraph<2, true> GraphType;
+typedef nifty::graph::opt::multicut::MulticutObjective<GraphType, double> ObjectiveType;
+typedef nifty::graph::opt::multicut::MulticutBase<ObjectiveType> MulticutBaseType;
+typedef nifty::graph::opt::multicut::MulticutGreedyAdditive<ObjectiveType> GreedyType;
+typedef nifty::graph::opt::multicut::ChainedSolvers<ObjectiveType> ChainedSolversType;
+
+
+// puts all nodes into one cluster, which has energy zero
+// and hence is worse than greedy additive for mostly repulsive weights
+class JoinAll : public MulticutBaseType{
+public:
+    typedef MulticutBaseType BaseType;
+    typedef ObjectiveType::NodeLabelsType NodeLabelsType;
+    struct SettingsType{
+    };
+
+    JoinAll(const ObjectiveType & objective, const SettingsType & settings = SettingsType())
+    :   objective_(objective),
+        currentBest_(nullptr){
+    }
+    virtual void optimize(NodeLabelsType & nodeLabels, VisitorBaseType * visitor){
+        currentBest_ = &nodeLabels;
+        for(auto node : objective_.graph().nodes()){
+            nodeLabels[node] = 0;
+        }
+    }
+    virtual const ObjectiveType & objective() const{
+        return objective_;
+    }
+    virtual const NodeLabelsType & currentBestNodeLabels(){
+        return *currentBest_;
+    }
+    virtual std::string name() const{
+        return std::string("JoinAll");
+    }
+private:
+    const ObjectiveType & objective_;
+    NodeLabelsType * currentBest_;
+};
+
+
+// counts how often the chain creates a solver
+template<class SOLVER>
+class CountingFactory : public nifty::graph::opt::common::SolverFactory<SOLVER>{
+public:
+    typedef nifty::graph::opt::common::SolverFactory<SOLVER> BaseType;
+    typedef typename BaseType::SolverBaseType SolverBaseType;
+
+    CountingFactory(std::size_t & counter)
+    :   BaseType(),
+        counter_(counter){
+    }
+    virtual SolverBaseType * create(const ObjectiveType & objective){
+        ++counter_;
+        return BaseType::create(objective);
+    }
+private:
+    std::size_t & counter_;
+};
+
+
+void chainedSolversEarlyStopTest()
+{
+    typedef nifty::array::StaticArray<int64_t, 2> ShapeType;
+    const GraphType graph(ShapeType({30, 30}));
+    ObjectiveType objective(graph);
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> weightDist(-2.0, 1.0);
+    for(auto edge : graph.edges()){
+        objective.weights()[edge] = weightDist(gen);
+    }
+
+    ObjectiveType::NodeLabelsType greedyLabels(graph);
+    GreedyType(objective).optimize(greedyLabels, nullptr);
+    const double greedyEnergy = objective.evalNodeLabels(greedyLabels);
+    NIFTY_TEST(greedyEnergy < 0.0);
+
+    std::size_t greedyCount = 0;
+    std::size_t joinAllCount = 0;
+    auto greedyFactory = std::make_shared<CountingFactory<GreedyType> >(greedyCount);
+    auto joinAllFactory = std::make_shared<CountingFactory<JoinAll> >(joinAllCount);
+
+    auto runChain = [&](const ChainedSolversType::SettingsType & settings,
+                        ObjectiveType::NodeLabelsType & labels){
+        greedyCount = 0;
+        joinAllCount = 0;
+        ChainedSolversType chain(objective, settings);
+        chain.optimize(labels, nullptr);
+        return objective.evalNodeLabels(labels);
+    };
+
+    // a time limit of zero returns the warm start without creating any solver
+    {
+        ChainedSolversType::SettingsType settings;
+        settings.multicutFactories = {greedyFactory, joinAllFactory};
+        settings.timeLimit = 0.0;
+        ObjectiveType::NodeLabelsType labels(graph);
+        for(auto node : graph.nodes()){
+            labels[node] = node;
+        }
+        runChain(settings, labels);
+        NIFTY_TEST_OP(greedyCount,==,0);
+        NIFTY_TEST_OP(joinAllCount,==,0);
+        for(auto node : graph.nodes()){
+            NIFTY_TEST_OP(labels[node],==,node);
+        }
+    }
+
+    // reaching the target energy keeps the later solvers from running
+    {
+        ChainedSolversType::SettingsType settings;
+        settings.multicutFactories = {greedyFactory, joinAllFactory};
+        settings.targetEnergy = greedyEnergy;
+        settings.restoreBest = false;
+        ObjectiveType::NodeLabelsType labels(graph);
+        const double energy = runChain(settings, labels);
+        NIFTY_TEST_OP(greedyCount,==,1);
+        NIFTY_TEST_OP(joinAllCount,==,0);
+        NIFTY_TEST_OP(energy,==,greedyEnergy);
+    }
+
+    // a solver that does not improve stops the chain
+    {
+        ChainedSolversType::SettingsType settings;
+        settings.multicutFactories = {greedyFactory, greedyFactory, greedyFactory};
+        settings.maxNumberOfStagesWithoutImprovement = 1;
+        ObjectiveType::NodeLabelsType labels(graph);
+        const double energy = runChain(settings, labels);
+        NIFTY_TEST_OP(greedyCount,==,2);
+        NIFTY_TEST_OP(energy,==,greedyEnergy);
+    }
+
+    // restoreBest discards a worse stage, without it the worse stage is returned
+    {
+        ChainedSolversType::SettingsType settings;
+        settings.multicutFactories = {greedyFactory, joinAllFactory};
+        ObjectiveType::NodeLabelsType labels(graph);
+        const double energy = runChain(settings, labels);
+        NIFTY_TEST_OP(joinAllCount,==,1);
+        NIFTY_TEST_OP(energy,==,greedyEnergy);
+
+        settings.restoreBest = false;
+        ObjectiveType::NodeLabelsType worseLabels(graph);
+        const double worseEnergy = runChain(settings, worseLabels);
+        NIFTY_TEST_OP(joinAllCount,==,1);
+        NIFTY_TEST_OP(worseEnergy,==,0.0);
+    }
+}
+
+
+int main(){
+    chainedSolversEarlyStopTest();
+}
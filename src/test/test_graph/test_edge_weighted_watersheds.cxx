@@ -4,6 +4,7 @@
 #include "nifty/tools/runtime_check.hxx"
 #include "nifty/graph/undirected_list_graph.hxx"
 #include "nifty/graph/edge_weighted_watersheds.hxx"
+#include "nifty/graph/parallel_watersheds.hxx"
 
 
 void randomizedEdgeWeightedWatersheds()
@@ -47,6 +48,54 @@ void randomizedEdgeWeightedWatersheds()
 
 }
 
+void parallelEdgeWeightedWatersheds()
+{
+    std::mt19937 gen(42);
+    typedef nifty::graph::UndirectedGraph<> GraphType;
+
+    for(std::size_t trial=0; trial<20; ++trial){
+
+        // create a grid graph
+        const std::size_t s = 20 + trial;
+        GraphType g(s*s);
+        for(auto y=0; y<s; ++y)
+        for(auto x=0; x<s; ++x){
+            auto u = x + y*s;
+            if(x+1 < s){
+                g.insertEdge(u, u + 1);
+            }
+            if(y+1 < s){
+                g.insertEdge(u, u + s);
+            }
+        }
+
+        // few distinct weights to get many ties
+        std::uniform_int_distribution<int> dis(0, trial % 2 == 0 ? 3 : 1000);
+        std::vector<double> edgeWeights(g.numberOfEdges());
+        for(auto edge: g.edges())
+            edgeWeights[edge] = dis(gen);
+
+        std::vector<uint64_t> seeds(g.numberOfNodes(), 0);
+        std::uniform_int_distribution<uint64_t> nodeDis(0, g.numberOfNodes() - 1);
+        const std::size_t nSeeds = trial % 4;
+        for(std::size_t i=0; i<3*nSeeds; ++i)
+            seeds[nodeDis(gen)] = 1 + i % (nSeeds + 1);
+
+        std::vector<uint64_t> labels(g.numberOfNodes());
+        edgeWeightedWatershedsSegmentation(g, edgeWeights, seeds, labels);
+
+        for(const int nThreads : {0, 1, 4}){
+            std::vector<uint64_t> parallelLabels(g.numberOfNodes(), 0);
+            nifty::graph::WatershedsStatistics statistics;
+            nifty::graph::parallelEdgeWeightedWatershedsSegmentation(
+                g, edgeWeights, seeds, parallelLabels, nThreads, &statistics);
+            NIFTY_TEST(parallelLabels == labels);
+            NIFTY_TEST_OP(statistics.numberOfEdges,==,g.numberOfEdges());
+        }
+    }
+}
+
 int main(){
     randomizedEdgeWeightedWatersheds();
+    parallelEdgeWeightedWatersheds();
 }
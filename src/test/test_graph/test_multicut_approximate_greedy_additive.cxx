@@ -0,0 +1,101 @@
+#include <random>
+#include <map>
+#include <set>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/graph/undirected_grid_graph.hxx"
+#include "nifty/graph/opt/multicut/multicut_objective.hxx"
+#include "nifty/graph/opt/multicut/multicut_greedy_additive.hxx"
+#include "nifty/graph/opt/multicut/multicut_approximate_greedy_additive.hxx"
+
+
+typedef nifty::graph::UndirectedGridGraph<2, true> GraphType;
+typedef nifty::graph::opt::multicut::MulticutObjective<GraphType, double> ObjectiveType;
+typedef nifty::graph::opt::multicut::MulticutGreedyAdditive<ObjectiveType> GreedyType;
+typedef nifty::graph::opt::multicut::MulticutApproximateGreedyAdditive<ObjectiveType> ApproximateGreedyType;
+
+
+template<class SOLVER>
+double solve(const ObjectiveType & objective, const typename SOLVER::SettingsType & settings,
+             ObjectiveType::NodeLabelsType & labels){
+    SOLVER solver(objective, settings);
+    solver.optimize(labels, nullptr);
+    return objective.evalNodeLabels(labels);
+}
+
+
+void approximateGreedyAdditiveTest()
+{
+    typedef nifty::array::StaticArray<int64_t, 2> ShapeType;
+    const GraphType graph(ShapeType({200, 200}));
+    ObjectiveType objective(graph);
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> weightDist(-1.0, 1.0);
+    for(auto edge : graph.edges()){
+        objective.weights()[edge] = weightDist(gen);
+    }
+
+    ObjectiveType::NodeLabelsType exactLabels(graph);
+    const auto exactEnergy = solve<GreedyType>(objective, GreedyType::SettingsType(), exactLabels);
+
+    ApproximateGreedyType::SettingsType settings;
+    settings.numberOfThreads = 1;
+    for(const double epsilon : {0.0, 0.1, 0.25, 0.5}){
+        settings.epsilon = epsilon;
+        ObjectiveType::NodeLabelsType labels(graph);
+        const auto energy = solve<ApproximateGreedyType>(objective, settings, labels);
+
+        // close to the exact greedy additive energy
+        NIFTY_TEST(energy < 0.0);
+        NIFTY_TEST(energy <= exactEnergy + 0.05 * std::abs(exactEnergy));
+
+        // no edge with positive weight remains between two clusters
+        // after the contraction terminates, only repulsive ones
+        // (the merged weights are checked against the stop condition)
+        std::map<std::pair<uint64_t, uint64_t>, double> clusterWeights;
+        for(auto edge : graph.edges()){
+            const auto lu = labels[graph.u(edge)];
+            const auto lv = labels[graph.v(edge)];
+            if(lu != lv){
+                clusterWeights[std::make_pair(std::min(lu, lv), std::max(lu, lv))] += objective.weights()[edge];
+            }
+        }
+        for(const auto & cw : clusterWeights){
+            NIFTY_TEST(cw.second <= settings.weightStopCond);
+        }
+
+        // the labels do not depend on the number of threads
+        ObjectiveType::NodeLabelsType parallelLabels(graph);
+        settings.numberOfThreads = 4;
+        solve<ApproximateGreedyType>(objective, settings, parallelLabels);
+        settings.numberOfThreads = 1;
+        for(auto node : graph.nodes()){
+            NIFTY_TEST_OP(labels[node],==,parallelLabels[node]);
+        }
+    }
+
+    // the last round is capped such that the clustering stops
+    // at exactly the number of nodes of the stop condition
+    settings.epsilon = 0.25;
+    for(const double nodeNumStopCond : {0.9, 0.5, 30000.0}){
+        settings.nodeNumStopCond = nodeNumStopCond;
+        const uint64_t minNodeNum = nodeNumStopCond >= 1.0 ?
+            uint64_t(nodeNumStopCond) : uint64_t(double(graph.numberOfNodes()) * nodeNumStopCond + 0.5);
+        for(const int numberOfThreads : {1, 4}){
+            settings.numberOfThreads = numberOfThreads;
+            ObjectiveType::NodeLabelsType labels(graph);
+            solve<ApproximateGreedyType>(objective, settings, labels);
+            std::set<uint64_t> clusters;
+            for(auto node : graph.nodes()){
+                clusters.insert(labels[node]);
+            }
+            NIFTY_TEST_OP(clusters.size(),==,minNodeNum);
+        }
+    }
+}
+
+
+int main(){
+    approximateGreedyAdditiveTest();
+}
@@ -0,0 +1,94 @@
+#include <iostream>
+#include <random>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/graph/undirected_list_graph.hxx"
+#include "nifty/graph/opt/common/solver_factory.hxx"
+#include "nifty/graph/opt/multicut/multicut_objective.hxx"
+#include "nifty/graph/opt/multicut/multicut_greedy_additive.hxx"
+#include "nifty/graph/opt/multicut/multicut_decomposer.hxx"
+
+
+typedef nifty::graph::UndirectedGraph<> GraphType;
+typedef nifty::graph::opt::multicut::MulticutObjective<GraphType, double> ObjectiveType;
+typedef nifty::graph::opt::multicut::MulticutDecomposer<ObjectiveType> DecomposerType;
+typedef nifty::graph::opt::multicut::MulticutGreedyAdditive<ObjectiveType> GreedyType;
+typedef nifty::graph::opt::common::SolverFactory<GreedyType> GreedyFactoryType;
+typedef nifty::graph::opt::multicut::MulticutGreedyAdditive<DecomposerType::SubmodelObjective> SubmodelGreedyType;
+typedef nifty::graph::opt::common::SolverFactory<SubmodelGreedyType> SubmodelGreedyFactoryType;
+
+
+// chain of random cliques, which are only connected by repulsive edges
+void multicutDecomposerTest()
+{
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> weightDist(-1.0, 1.0);
+    std::uniform_int_distribution<uint64_t> sizeDist(1, 12);
+
+    std::vector<uint64_t> cliqueOffsets(1, 0);
+    for(int i = 0; i < 200; ++i){
+        cliqueOffsets.push_back(cliqueOffsets.back() + sizeDist(gen));
+    }
+
+    GraphType graph(cliqueOffsets.back());
+    std::vector<double> weights;
+    for(std::size_t i = 0; i + 1 < cliqueOffsets.size(); ++i){
+        // the first edge of each clique chain is attractive so the clique is
+        // connected by positive edges, every 4th clique has no repulsive edge at all
+        for(auto u = cliqueOffsets[i]; u < cliqueOffsets[i + 1]; ++u){
+            for(auto v = u + 1; v < cliqueOffsets[i + 1]; ++v){
+                graph.insertEdge(u, v);
+                const double w = v == u + 1 ? 1.0 : weightDist(gen);
+                weights.push_back(i % 4 == 0 ? std::abs(w) : w);
+            }
+        }
+        if(i + 2 < cliqueOffsets.size()){
+            graph.insertEdge(cliqueOffsets[i], cliqueOffsets[i + 1]);
+            weights.push_back(-1.0);
+        }
+    }
+
+    ObjectiveType objective(graph);
+    for(auto edge : graph.edges()){
+        objective.weights()[edge] = weights[edge];
+    }
+
+    DecomposerType::SettingsType settings;
+    settings.submodelFactory = std::make_shared<SubmodelGreedyFactoryType>();
+    settings.fallthroughFactory = std::make_shared<GreedyFactoryType>();
+
+    ObjectiveType::NodeLabelsType serialLabels(graph), parallelLabels(graph);
+    {
+        DecomposerType solver(objective, settings);
+        solver.optimize(serialLabels, nullptr);
+    }
+    {
+        settings.numberOfThreads = 4;
+        settings.smallSubmodelFactory = settings.submodelFactory;
+        settings.smallSubmodelSize = 4;
+        DecomposerType solver(objective, settings);
+        solver.optimize(parallelLabels, nullptr);
+    }
+
+    // the labels do not depend on the number of threads
+    for(auto node : graph.nodes()){
+        NIFTY_TEST_OP(serialLabels[node],==,parallelLabels[node]);
+    }
+
+    // repulsive edges between components are cut, cliques without repulsive edges are joined
+    for(std::size_t i = 0; i + 1 < cliqueOffsets.size(); ++i){
+        if(i + 2 < cliqueOffsets.size()){
+            NIFTY_TEST_OP(serialLabels[cliqueOffsets[i]],!=,serialLabels[cliqueOffsets[i + 1]]);
+        }
+        if(i % 4 == 0){
+            for(auto u = cliqueOffsets[i]; u < cliqueOffsets[i + 1]; ++u){
+                NIFTY_TEST_OP(serialLabels[u],==,serialLabels[cliqueOffsets[i]]);
+            }
+        }
+    }
+}
+
+
+int main(){
+    multicutDecomposerTest();
+}
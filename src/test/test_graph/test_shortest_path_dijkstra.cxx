@@ -1,9 +1,14 @@
 #include <iostream> 
+#include <random>
+#include <vector>
 
 #include "nifty/tools/runtime_check.hxx"
 #include "nifty/graph/undirected_list_graph.hxx"
+#include "nifty/graph/undirected_grid_graph.hxx"
 #include "nifty/graph/simple_directed_graph.hxx"
 #include "nifty/graph/shortest_path_dijkstra.hxx"
+#include "nifty/graph/shortest_path_batch.hxx"
+#include "nifty/graph/shortest_path_single_pair.hxx"
 
 
 void undirectedGraphShortestPathDijkstraTest()
@@ -143,7 +148,206 @@ void directedGraphShortestPathDijkstraTest()
 
 }
 
+
+void reusedShortestPathDijkstraTest()
+{
+    typedef nifty::graph::UndirectedGraph<>  GraphType;
+    GraphType g(6);
+    g.insertEdge(0,1);
+    g.insertEdge(0,2);
+    g.insertEdge(1,3);
+    g.insertEdge(2,3);
+    g.insertEdge(3,4);
+    g.insertEdge(4,5);
+    std::vector<float> ew = {10.0,2.0,3.0,4.0,20.0,1.0};
+
+    typedef nifty::graph::ShortestPathDijkstra<GraphType,float> Sp;
+    Sp pf(g);
+
+    // the second run must not see the predecessors of the first one
+    pf.runSingleSource(ew, 5);
+    pf.runSingleSourceSingleTarget(ew, 0, 2);
+    {
+        const auto & pmap = pf.predecessors();
+        NIFTY_TEST_OP(pmap[0],==,0);
+        NIFTY_TEST_OP(pmap[2],==,0);
+        NIFTY_TEST_OP(pmap[1],==,-1);
+        NIFTY_TEST_OP(pmap[3],==,-1);
+        NIFTY_TEST_OP(pmap[4],==,-1);
+        NIFTY_TEST_OP(pmap[5],==,-1);
+    }
+
+    // bounded radius
+    pf.runSingleSource(ew, 0, 6.0f);
+    {
+        const auto & pmap = pf.predecessors();
+        const auto & dmap = pf.distances();
+        NIFTY_TEST_OP(pmap[0],==,0);
+        NIFTY_TEST_OP(pmap[2],==,0);
+        NIFTY_TEST_OP(pmap[3],==,2);
+        NIFTY_TEST_OP(pmap[1],==,-1);
+        NIFTY_TEST_OP(pmap[4],==,-1);
+        NIFTY_TEST_OP(pmap[5],==,-1);
+        NIFTY_TEST_EQ_TOL(dmap[3],6.0f,0.00001);
+    }
+
+    // unbounded again
+    pf.runSingleSource(ew, 0);
+    {
+        const auto & pmap = pf.predecessors();
+        const auto & dmap = pf.distances();
+        NIFTY_TEST_OP(pmap[1],==,3);
+        NIFTY_TEST_OP(pmap[5],==,4);
+        NIFTY_TEST_EQ_TOL(dmap[5],27.0f,0.00001);
+    }
+}
+
+
+void batchedShortestPathDijkstraTest()
+{
+    typedef nifty::graph::UndirectedGraph<>  GraphType;
+    typedef nifty::graph::ShortestPathDijkstra<GraphType,float> Sp;
+    typedef nifty::graph::BatchedShortestPathDijkstra<GraphType,float> BatchedSp;
+
+    std::mt19937 gen(42);
+    const std::size_t nNodes = 200;
+    GraphType g(nNodes);
+    std::uniform_int_distribution<uint64_t> nodeDist(0, nNodes - 1);
+    for(std::size_t i=0; i<3*nNodes; ++i){
+        const auto u = nodeDist(gen);
+        const auto v = nodeDist(gen);
+        if(u != v){
+            g.insertEdge(u, v);
+        }
+    }
+    std::uniform_real_distribution<float> weightDist(0.1, 1.0);
+    std::vector<float> ew(g.numberOfEdges());
+    for(auto & w : ew){
+        w = weightDist(gen);
+    }
+
+    std::vector<int64_t> sources(nNodes);
+    for(std::size_t i=0; i<nNodes; ++i){
+        sources[i] = i;
+    }
+    const float maxDistance = 1.5;
+
+    std::vector<std::vector<float>> distances(nNodes, std::vector<float>(nNodes, -1.0f));
+    BatchedSp batched(g, 4);
+    batched.runSingleSource(ew, sources, maxDistance, [&](const int tid, const int64_t i, const Sp & sp){
+        for(const auto node : sp.touchedNodes()){
+            if(sp.predecessors()[node] != -1){
+                distances[i][node] = sp.distances()[node];
+            }
+        }
+    });
+
+    Sp sp(g);
+    for(const auto source : sources){
+        sp.runSingleSource(ew, source);
+        for(std::size_t node=0; node<nNodes; ++node){
+            const bool reached = sp.predecessors()[node] != -1 && sp.distances()[node] <= maxDistance;
+            if(reached){
+                NIFTY_TEST_EQ_TOL(distances[source][node], sp.distances()[node], 0.00001);
+            }
+            else{
+                NIFTY_TEST_OP(distances[source][node],==,-1.0f);
+            }
+        }
+    }
+}
+
+
+template<class GRAPH, class HEURISTIC>
+void checkSinglePair(const GRAPH & g, const std::vector<float> & ew, const HEURISTIC & heuristic, std::mt19937 & gen){
+    typedef nifty::graph::ShortestPathDijkstra<GRAPH,float> Sp;
+    typedef nifty::graph::ShortestPathAStar<GRAPH,float> AStar;
+    typedef nifty::graph::ShortestPathBidirectionalDijkstra<GRAPH,float> Bidirectional;
+
+    Sp sp(g);
+    AStar aStar(g);
+    Bidirectional bidirectional(g);
+    std::uniform_int_distribution<int64_t> nodeDist(0, g.numberOfNodes() - 1);
+    std::vector<int64_t> path;
+
+    auto checkPath = [&](const int64_t source, const int64_t target, const float distance){
+        NIFTY_TEST_OP(path.front(),==,source);
+        NIFTY_TEST_OP(path.back(),==,target);
+        float length = 0;
+        for(std::size_t i=0; i+1<path.size(); ++i){
+            const auto edge = g.findEdge(path[i], path[i+1]);
+            NIFTY_TEST_OP(edge,>=,0);
+            length += ew[edge];
+        }
+        NIFTY_TEST_EQ_TOL(length, distance, 0.0001);
+    };
+
+    for(std::size_t i=0; i<50; ++i){
+        const auto source = nodeDist(gen);
+        const auto target = nodeDist(gen);
+        sp.runSingleSourceSingleTarget(ew, source, target);
+        const bool reachable = sp.predecessors()[target] != -1;
+
+        NIFTY_TEST_OP(aStar.run(ew, source, target, heuristic),==,reachable);
+        NIFTY_TEST_OP(bidirectional.run(ew, source, target),==,reachable);
+        if(!reachable){
+            continue;
+        }
+        const float distance = sp.distances()[target];
+        NIFTY_TEST_EQ_TOL(aStar.distance(), distance, 0.0001);
+        NIFTY_TEST_EQ_TOL(bidirectional.distance(), distance, 0.0001);
+
+        aStar.path(path);
+        checkPath(source, target, distance);
+        bidirectional.path(path);
+        checkPath(source, target, distance);
+    }
+}
+
+
+void singlePairShortestPathTest()
+{
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> weightDist(0.5, 2.0);
+
+    // grid graph with l1 heuristic
+    {
+        typedef nifty::graph::UndirectedGridGraph<2,true> GraphType;
+        typedef nifty::graph::GridGraphL1Heuristic<GraphType,float> Heuristic;
+        GraphType g(nifty::array::StaticArray<int64_t, 2>({40, 30}));
+        std::vector<float> ew(g.numberOfEdges());
+        for(auto & w : ew){
+            w = weightDist(gen);
+        }
+        checkSinglePair(g, ew, Heuristic(g, 0.5), gen);
+    }
+
+    // sparse graph (with unreachable nodes) without heuristic
+    {
+        typedef nifty::graph::UndirectedGraph<>  GraphType;
+        const std::size_t nNodes = 300;
+        GraphType g(nNodes);
+        std::uniform_int_distribution<uint64_t> nodeDist(0, nNodes - 1);
+        for(std::size_t i=0; i<nNodes; ++i){
+            const auto u = nodeDist(gen);
+            const auto v = nodeDist(gen);
+            if(u != v){
+                g.insertEdge(u, v);
+            }
+        }
+        std::vector<float> ew(g.numberOfEdges());
+        for(auto & w : ew){
+            w = weightDist(gen);
+        }
+        checkSinglePair(g, ew, [](const int64_t, const int64_t){ return 0.0f; }, gen);
+    }
+}
+
+
 int main(){
     undirectedGraphShortestPathDijkstraTest();
     directedGraphShortestPathDijkstraTest();
+    reusedShortestPathDijkstraTest();
+    batchedShortestPathDijkstraTest();
+    singlePairShortestPathTest();
 }
@@ -0,0 +1,104 @@
+#include <iostream>
+#include <random>
+#include <cstdio>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/graph/undirected_list_graph.hxx"
+#include "nifty/graph/undirected_graph_snapshot.hxx"
+#include "nifty/graph/components.hxx"
+
+
+void undirectedGraphSnapshotTest()
+{
+    typedef nifty::graph::UndirectedGraph<> GraphType;
+    typedef nifty::graph::MappedUndirectedGraph MappedGraphType;
+
+    std::mt19937 gen(42);
+    const uint64_t numberOfNodes = 500;
+    std::uniform_int_distribution<uint64_t> nodeDist(0, numberOfNodes - 1);
+    GraphType graph(numberOfNodes);
+    for(int i = 0; i < 1500; ++i){
+        const auto u = nodeDist(gen);
+        const auto v = nodeDist(gen);
+        if(u != v){
+            graph.insertEdge(u, v);
+        }
+    }
+
+    GraphType::EdgeMap<double> edgeWeights(graph);
+    GraphType::EdgeMap<uint8_t> edgeLabels(graph);
+    for(auto edge : graph.edges()){
+        edgeWeights[edge] = 0.5 * edge;
+        edgeLabels[edge] = edge % 3 == 0 ? 1 : 0;
+    }
+    GraphType::NodeMap<uint64_t> nodeSizes(graph);
+    for(auto node : graph.nodes()){
+        nodeSizes[node] = node + 1;
+    }
+
+    const std::string path = "test_undirected_graph_snapshot.bin";
+    nifty::graph::GraphSnapshotWriter<GraphType> writer(graph);
+    writer.addEdgeMap("weights", edgeWeights);
+    writer.addEdgeMap("labels", edgeLabels);
+    writer.addNodeMap("sizes", nodeSizes);
+    writer.write(path);
+
+    {
+        MappedGraphType mapped(path);
+        NIFTY_TEST_OP(mapped.numberOfNodes(),==,graph.numberOfNodes());
+        NIFTY_TEST_OP(mapped.numberOfEdges(),==,graph.numberOfEdges());
+
+        // edges and adjacency
+        for(auto edge : mapped.edges()){
+            NIFTY_TEST_OP(mapped.u(edge),==,graph.u(edge));
+            NIFTY_TEST_OP(mapped.v(edge),==,graph.v(edge));
+            NIFTY_TEST_OP(mapped.findEdge(mapped.u(edge), mapped.v(edge)),==,edge);
+            NIFTY_TEST_OP(mapped.findEdge(mapped.v(edge), mapped.u(edge)),==,edge);
+        }
+        for(uint64_t u = 0; u < 50; ++u){
+            for(uint64_t v = 0; v < numberOfNodes; ++v){
+                NIFTY_TEST_OP(mapped.findEdge(u, v),==,graph.findEdge(u, v));
+            }
+        }
+        for(auto node : mapped.nodes()){
+            auto it = graph.adjacencyBegin(node);
+            for(auto adj : mapped.adjacency(node)){
+                NIFTY_TEST_OP(adj.node(),==,it->node());
+                NIFTY_TEST_OP(adj.edge(),==,it->edge());
+                ++it;
+            }
+            NIFTY_TEST(it == graph.adjacencyEnd(node));
+        }
+
+        // maps
+        NIFTY_TEST(mapped.hasEdgeMap("weights"));
+        NIFTY_TEST(!mapped.hasNodeMap("weights"));
+        const double * weights = mapped.edgeMap<double>("weights");
+        const uint8_t * labels = mapped.edgeMap<uint8_t>("labels");
+        const uint64_t * sizes = mapped.nodeMap<uint64_t>("sizes");
+        for(auto edge : graph.edges()){
+            NIFTY_TEST_OP(weights[edge],==,edgeWeights[edge]);
+            NIFTY_TEST_OP(labels[edge],==,edgeLabels[edge]);
+        }
+        for(auto node : graph.nodes()){
+            NIFTY_TEST_OP(sizes[node],==,nodeSizes[node]);
+        }
+
+        // graph algorithms run directly on the mapped graph
+        nifty::graph::ComponentsUfd<GraphType> components(graph);
+        nifty::graph::ComponentsUfd<MappedGraphType> mappedComponents(mapped);
+        MappedGraphType::EdgeMap<uint8_t> mappedEdgeLabels(mapped);
+        std::copy(labels, labels + mapped.numberOfEdges(), mappedEdgeLabels.begin());
+        NIFTY_TEST_OP(components.buildFromEdgeLabels(edgeLabels),==,
+                      mappedComponents.buildFromEdgeLabels(mappedEdgeLabels));
+        for(auto edge : graph.edges()){
+            NIFTY_TEST_OP(components.areConnected(graph.u(edge), graph.v(edge)),==,
+                          mappedComponents.areConnected(graph.u(edge), graph.v(edge)));
+        }
+    }
+    std::remove(path.c_str());
+}
+
+int main(){
+    undirectedGraphSnapshotTest();
+}
@@ -0,0 +1,70 @@
+#include <random>
+#include <vector>
+#include <utility>
+#include <limits>
+#include <algorithm>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/tools/radix_sort.hxx"
+
+
+template<class T>
+void checkSortUnique(std::vector<T> values){
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+    expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+
+    nifty::tools::radixSortUnique(values);
+    NIFTY_TEST_OP(values.size(),==,expected.size());
+    NIFTY_TEST(values == expected);
+}
+
+
+void radixSortKeysTest()
+{
+    std::mt19937 gen(42);
+
+    // keys from the full range and from a small range, where most digits are skipped
+    for(const uint64_t maxKey : {std::numeric_limits<uint64_t>::max(), uint64_t(1000), uint64_t(1) << 40}){
+        std::uniform_int_distribution<uint64_t> dist(0, maxKey);
+        std::vector<uint64_t> keys(10000);
+        for(auto & key : keys){
+            key = dist(gen);
+        }
+        checkSortUnique(keys);
+    }
+
+    checkSortUnique(std::vector<uint64_t>());
+    checkSortUnique(std::vector<uint64_t>({17}));
+    checkSortUnique(std::vector<uint64_t>(100, 17));
+    checkSortUnique(std::vector<uint32_t>({3, 1, 2, 3, 1}));
+}
+
+
+void radixSortPairsTest()
+{
+    typedef std::pair<uint64_t, uint64_t> PairType;
+    std::mt19937 gen(42);
+
+    for(const uint64_t maxKey : {std::numeric_limits<uint64_t>::max(), uint64_t(50)}){
+        std::uniform_int_distribution<uint64_t> dist(0, maxKey);
+        std::vector<PairType> pairs(10000);
+        for(auto & p : pairs){
+            p.first = dist(gen);
+            p.second = dist(gen);
+        }
+        checkSortUnique(pairs);
+    }
+
+    checkSortUnique(std::vector<PairType>());
+    checkSortUnique(std::vector<PairType>({PairType(4, 2)}));
+    checkSortUnique(std::vector<PairType>(100, PairType(4, 2)));
+    // same u, different v and vice versa
+    checkSortUnique(std::vector<PairType>({PairType(1, 3), PairType(1, 2), PairType(0, 3), PairType(1, 2)}));
+}
+
+
+int main(){
+    radixSortKeysTest();
+    radixSortPairsTest();
+}
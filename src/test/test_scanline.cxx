@@ -0,0 +1,129 @@
+#include <vector>
+#include <tuple>
+#include <random>
+#include <algorithm>
+
+#include "nifty/tools/runtime_check.hxx"
+#include "nifty/tools/scanline.hxx"
+
+
+// compare forEachDifference with a scalar loop for all lengths up to
+// a few vector widths, with differences at the first and last element
+template<class T>
+void forEachDifferenceTest()
+{
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> valueDist(0, 3);
+    std::uniform_real_distribution<double> changeDist(0., 1.);
+
+    for(std::size_t n = 0; n < 200; ++n){
+        for(const double changeProbability : {0.0, 0.05, 0.5, 1.0}){
+            std::vector<T> a(n), b(n);
+            for(std::size_t i = 0; i < n; ++i){
+                a[i] = static_cast<T>(valueDist(gen));
+                b[i] = changeDist(gen) < changeProbability ? static_cast<T>(a[i] + 1) : a[i];
+            }
+            // transitions at the first and last element
+            if(n > 0 && changeProbability > 0.){
+                b[0] = static_cast<T>(a[0] + 1);
+                b[n - 1] = static_cast<T>(a[n - 1] + 1);
+            }
+
+            std::vector<std::size_t> expected, found;
+            for(std::size_t i = 0; i < n; ++i){
+                if(a[i] != b[i]){
+                    expected.push_back(i);
+                }
+            }
+            nifty::tools::forEachDifference(a.data(), b.data(), n, [&](const std::size_t i){
+                found.push_back(i);
+            });
+            NIFTY_TEST_OP(found.size(), ==, expected.size());
+            for(std::size_t i = 0; i < found.size(); ++i){
+                NIFTY_TEST_OP(found[i], ==, expected[i]);
+            }
+        }
+    }
+
+    // a difference only in the highest byte of an element is found once
+    if(sizeof(T) > 1){
+        const std::size_t n = 67;
+        std::vector<T> a(n, 0), b(n, 0);
+        b[n - 1] = static_cast<T>(T(1) << (8 * (sizeof(T) - 1)));
+        std::vector<std::size_t> found;
+        nifty::tools::forEachDifference(a.data(), b.data(), n, [&](const std::size_t i){
+            found.push_back(i);
+        });
+        NIFTY_TEST_OP(found.size(), ==, 1);
+        NIFTY_TEST_OP(found[0], ==, n - 1);
+    }
+}
+
+
+// compare forEachLabelTransition with a loop over all pixels and axes
+template<class T>
+void forEachLabelTransitionTest()
+{
+    typedef nifty::array::StaticArray<int64_t, 3> Coord;
+    typedef std::tuple<int64_t, std::size_t, T, T> Transition;
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> labelDist(0, 2);
+    std::uniform_real_distribution<double> changeDist(0., 1.);
+
+    for(const int64_t lineLength : {1, 7, 31, 33, 67}){
+        const Coord shape({int64_t(4), int64_t(5), lineLength});
+        const Coord strides({shape[1] * shape[2], shape[2], int64_t(1)});
+        const int64_t size = shape[0] * shape[1] * shape[2];
+
+        // runs of equal labels
+        std::vector<T> labels(size);
+        T label = 0;
+        for(int64_t i = 0; i < size; ++i){
+            if(changeDist(gen) < 0.2){
+                label = static_cast<T>(labelDist(gen));
+            }
+            labels[i] = label;
+        }
+        // transitions at the first and last element of the lines
+        labels[0] = 7;
+        labels[size - 1] = 7;
+        labels[lineLength - 1] = 8;
+
+        const Coord innerShape({int64_t(3), int64_t(4), std::max<int64_t>(lineLength - 1, 1)});
+        for(const Coord & coreShape : {shape, innerShape}){
+            std::vector<Transition> expected, found;
+            nifty::tools::forEachCoordinate(coreShape, [&](const Coord & coord){
+                const int64_t offset = coord[0] * strides[0] + coord[1] * strides[1] + coord[2];
+                for(std::size_t axis = 0; axis < 3; ++axis){
+                    if(coord[axis] + 1 < shape[axis] && labels[offset] != labels[offset + strides[axis]]){
+                        expected.emplace_back(offset, axis, labels[offset], labels[offset + strides[axis]]);
+                    }
+                }
+            });
+
+            nifty::tools::forEachLabelTransition(labels.data(), strides, shape, coreShape,
+            [&](const Coord & coordU, const int64_t offsetU, const std::size_t axis, const T lU, const T lV){
+                NIFTY_TEST_OP(offsetU, ==, coordU[0] * strides[0] + coordU[1] * strides[1] + coordU[2]);
+                found.emplace_back(offsetU, axis, lU, lV);
+            });
+
+            std::sort(expected.begin(), expected.end());
+            std::sort(found.begin(), found.end());
+            NIFTY_TEST_OP(found.size(), ==, expected.size());
+            NIFTY_TEST(found == expected);
+        }
+    }
+}
+
+
+int main(){
+    forEachDifferenceTest<uint8_t>();
+    forEachDifferenceTest<uint16_t>();
+    forEachDifferenceTest<uint32_t>();
+    forEachDifferenceTest<uint64_t>();
+    forEachDifferenceTest<int64_t>();
+
+    forEachLabelTransitionTest<uint32_t>();
+    forEachLabelTransitionTest<uint64_t>();
+}